@@ -0,0 +1,382 @@
+#include "bench.h"
+
+#include "cli.h"
+#include "cvts.h"
+#include "die.h"
+#include "game.h"
+#include "generator.h"
+#include "report.h"
+#include "simulator.h"
+#include "statistics.h"
+#include "stopwatch.h"
+#include "tsrand48.h"
+
+#include <fcntl.h>
+#include <glob.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+volatile size_t bench_sink = 0;
+
+bench_t bench_create(size_t samples, const char* sals, const char* examples) {
+    return (bench_t){
+        .samples = samples > 0 ? samples : 1,
+        .sals = sals,
+        .examples = examples,
+        .results = array_create(0, sizeof(bench_result_t), 0)
+    };
+}
+
+void bench_free(bench_t* bench) {
+    if (!bench)
+        return;
+    array_free(&bench->results, 0);
+}
+
+int bench_compare_doubles(const void* a, const void* b) {
+    const double da = *(const double*)a;
+    const double db = *(const double*)b;
+    return da < db ? -1 : da > db;
+}
+
+void bench_summarize(bench_result_t* result, double* samples, size_t count) {
+    if (!result || !samples || count == 0)
+        return;
+    qsort(samples, count, sizeof(*samples), bench_compare_doubles);
+    result->samples = count;
+    result->median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+    result->min = samples[0];
+    result->max = samples[count - 1];
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++)
+        sum += samples[i];
+    result->mean = sum / count;
+    double squares = 0.0;
+    for (size_t i = 0; i < count; i++)
+        squares += (samples[i] - result->mean) * (samples[i] - result->mean);
+    result->variance = count > 1 ? squares / (count - 1) : 0.0;
+}
+
+bool bench_run(bench_t* bench, const char* name, bench_kind_t kind, bench_fn_t fn, void* context, size_t iterations) {
+    if (!bench || !name || !fn || iterations == 0)
+        return false;
+    double* samples = malloc(bench->samples * sizeof(*samples));
+    if (!samples)
+        return false;
+    bool success = true;
+    for (size_t i = 0; success && i < BENCH_WARMUP_SAMPLES + bench->samples; i++) {
+        // every sample rolls the same dices
+        tsseed48_t seed = tsderiveseed48(BENCH_SEED, 0);
+        tsseed48(&seed);
+        stopwatch_t stopwatch = stopwatch_start();
+        success = fn(context, iterations);
+        const double elapsed = stopwatch_elapsed(&stopwatch);
+        if (i >= BENCH_WARMUP_SAMPLES)
+            samples[i - BENCH_WARMUP_SAMPLES] = elapsed * 1e9 / iterations;
+    }
+    if (!success) {
+        fprintf(stderr, "%swarning:%s benchmark '%s' failed.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), name);
+        free(samples);
+        return false;
+    }
+    bench_result_t result = { .kind = kind, .iterations = iterations };
+    snprintf(result.name, sizeof(result.name), "%s", name);
+    bench_summarize(&result, samples, bench->samples);
+    free(samples);
+    fprintf(stderr, "  %-48s %16.1lf ns  %s+-%.1lf%s\n", result.name, result.median, FMT(FMTVAL_FG_BRIGHT_BLACK), sqrt(result.variance), FMT(FMTVAL_FG_DEFAULT));
+    return array_add(&bench->results, &result);
+}
+
+bool bench_dice(void* context, size_t iterations) {
+    const die_t* die = context;
+    size_t sum = 0;
+    for (size_t i = 0; i < iterations; i++)
+        sum += dice(die);
+    bench_sink = sum;
+    return true;
+}
+
+bool bench_simulation_run(void* context, size_t iterations) {
+    simulation_t* simulation = context;
+    size_t sum = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        if (simulation_run(simulation) != 0)
+            return false;
+        sum += simulation->dices.size;
+    }
+    bench_sink = sum;
+    return true;
+}
+
+bool bench_stats_add(void* context, size_t iterations) {
+    const bench_stats_t* recorded = context;
+    if (recorded->simcount == 0)
+        return false;
+    stats_t stats = stats_create();
+    bool success = stats_init(&stats, recorded->simulator);
+    for (size_t i = 0; success && i < iterations; i++)
+        success = stats_add(&stats, &recorded->sims[i % recorded->simcount]);
+    bench_sink = stats.sims;
+    stats_free(&stats);
+    return success;
+}
+
+bool bench_stats_analyze(void* context, size_t iterations) {
+    const simulator_t* simulator = context;
+    for (size_t i = 0; i < iterations; i++) {
+        stats_t stats = stats_analyze(simulator);
+        bench_sink = stats.sims;
+        stats_free(&stats);
+    }
+    return true;
+}
+
+bool bench_cli_parse(void* context, size_t iterations) {
+    const bench_args_t* args = context;
+    for (size_t i = 0; i < iterations; i++) {
+        cli_args_t cli_args = cli_parse(args->argc, args->argv);
+        bench_sink = cli_args.snakesandladders.size;
+        cli_args_free(&cli_args);
+    }
+    return true;
+}
+
+bool bench_game_setup(void* context, size_t iterations) {
+    cli_args_t* cli_args = context;
+    for (size_t i = 0; i < iterations; i++) {
+        game_t game = game_setup(cli_args);
+        bench_sink = game.edges.size;
+        game_free(&game);
+    }
+    return true;
+}
+
+bool bench_example(void* context, size_t iterations) {
+    const bench_example_t* example = context;
+    for (size_t i = 0; i < iterations; i++) {
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid < 0)
+            return false;
+        // run the config with the output discarded, hence the terminal doesn't slow down the run
+        if (pid == 0) {
+            int devnull = open("/dev/null", O_WRONLY);
+            if (devnull >= 0) {
+                dup2(devnull, STDOUT_FILENO);
+                dup2(devnull, STDERR_FILENO);
+            }
+            execl(example->sals, example->sals, "-c", example->config, (char*)0);
+            _exit(127);
+        }
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            return false;
+    }
+    return true;
+}
+
+size_t bench_suite_dice(bench_t* bench) {
+    const size_t sides[3] = { 6, 20, 100 };
+    size_t failed = 0;
+    for (size_t preset = DISTR_PRESET_UNIFORM; preset < DISTR_PRESET_COUNT; preset++) {
+        for (size_t i = 0; i < 3; i++) {
+            distribution_t distribution = distr_create(preset);
+            die_t die = distr_build(&distribution, sides[i]) == 0 ? die_create(&distribution) : die_create_empty();
+            char name[BENCH_NAME_LENGTH];
+            snprintf(name, sizeof(name), "dice/%s/%lu", distr_preset_infos[preset].name, sides[i]);
+            if (die_isempty(&die) || !bench_run(bench, name, BENCH_KIND_MICRO, bench_dice, &die, 1000000))
+                failed++;
+            die_free(&die);
+            distr_free(&distribution);
+        }
+    }
+    return failed;
+}
+
+size_t bench_suite_simulation(bench_t* bench) {
+    // the board of the examples
+    char* argv[] = { "sals", "-s", "6", "33-61", "72-14", "23-7", "28-5", "11-47", "9-3", "83-20", "51-55", "91-73", "4-12", "49-36", "38-19", "98-53", "16-41", "42-69" };
+    const int argc = sizeof(argv) / sizeof(*argv);
+    char* const sides[2] = { "6", "12" };
+    size_t failed = 0;
+    for (size_t i = 0; i < 2; i++) {
+        argv[2] = sides[i];
+        cli_args_t cli_args = cli_parse(argc, argv);
+        game_t game = game_setup(&cli_args);
+        simulator_t simulator;
+        simulator_init(&simulator, &game, 1, 1, cli_args.dicelimit, 0.0, 0.0);
+        simulation_t simulation = simulation_create(&simulator);
+        char name[BENCH_NAME_LENGTH];
+        snprintf(name, sizeof(name), "simulation_run/10x10/%s", sides[i]);
+        if (!simulation.simulator || !bench_run(bench, name, BENCH_KIND_MICRO, bench_simulation_run, &simulation, 10000))
+            failed++;
+        simulation_free(&simulation);
+        simulator_free(&simulator);
+        game_free(&game);
+        cli_args_free(&cli_args);
+    }
+    return failed;
+}
+
+size_t bench_suite_stats(bench_t* bench) {
+    char* argv[] = { "sals", "33-61", "72-14", "23-7", "28-5", "11-47", "9-3", "83-20", "51-55", "91-73", "4-12", "49-36", "38-19", "98-53", "16-41", "42-69" };
+    cli_args_t cli_args = cli_parse(sizeof(argv) / sizeof(*argv), argv);
+    game_t game = game_setup(&cli_args);
+    size_t failed = 0;
+
+    // record games once and add them in turns, hence only the accumulation of the games is measured which grows with their number
+    simulator_t simulator;
+    simulation_t sims[BENCH_STATS_GAMES];
+    size_t simcount = 0;
+    if (simulator_init(&simulator, &game, BENCH_STATS_GAMES, 1, cli_args.dicelimit, 0.0, 0.0)) {
+        for (; simcount < BENCH_STATS_GAMES; simcount++) {
+            tsseed48_t seed = tsderiveseed48(BENCH_SEED, simcount);
+            tsseed48(&seed);
+            sims[simcount] = simulation_create(&simulator);
+            if (!sims[simcount].simulator || simulation_run(&sims[simcount]) != 0) {
+                simulation_free(&sims[simcount]);
+                break;
+            }
+        }
+    }
+    const bench_stats_t recorded = { .simulator = &simulator, .sims = sims, .simcount = simcount };
+    const size_t games[2] = { 10000, 100000 };
+    for (size_t i = 0; i < 2; i++) {
+        char name[BENCH_NAME_LENGTH];
+        snprintf(name, sizeof(name), "stats_add/%lu", games[i]);
+        if (!bench_run(bench, name, BENCH_KIND_MICRO, bench_stats_add, (void*)&recorded, games[i]))
+            failed++;
+    }
+    for (size_t i = 0; i < simcount; i++)
+        simulation_free(&sims[i]);
+    simulator_free(&simulator);
+
+    // merge the partial statistics of a fixed number of workers, the number of games they simulated doesn't change the cost
+    const uint64_t seed = BENCH_SEED;
+    simulate_options_t options = simulate_options_create();
+    options.simcount = 100000;
+    options.workers = BENCH_STATS_WORKERS;
+    options.dicelimit = cli_args.dicelimit;
+    options.seed = &seed;
+    simulate(&simulator, &game, &options);
+    char name[BENCH_NAME_LENGTH];
+    snprintf(name, sizeof(name), "stats_analyze/%lu_workers", BENCH_STATS_WORKERS);
+    if (simulator.workers.size == 0 || !bench_run(bench, name, BENCH_KIND_MICRO, bench_stats_analyze, &simulator, 10))
+        failed++;
+    simulator_free(&simulator);
+    game_free(&game);
+    cli_args_free(&cli_args);
+    return failed;
+}
+
+size_t bench_suite_cli(bench_t* bench) {
+    size_t failed = 0;
+    char* argv[] = { "sals", "-x", "10", "-y", "10", "-s", "6", "-d", "uniform", "-i", "10000", "33-61", "72-14", "23-7", "28-5", "11-47", "9-3", "83-20", "51-55", "91-73" };
+    bench_args_t args = { sizeof(argv) / sizeof(*argv), argv };
+    if (!bench_run(bench, "cli_parse/args", BENCH_KIND_MICRO, bench_cli_parse, &args, 10000))
+        failed++;
+
+    // the config files are parsed with the -c option like the sals executable does
+    char* const configs[3] = { "hardend.sals", "funkyargs.sals", "distributions/custom_a.sals" };
+    for (size_t i = 0; i < 3; i++) {
+        char path[BENCH_NAME_LENGTH];
+        snprintf(path, sizeof(path), "%s/%s", bench->examples, configs[i]);
+        if (access(path, R_OK) != 0) {
+            fprintf(stderr, "%swarning:%s skipping benchmark of config '%s'. unable to read file.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), path);
+            failed++;
+            continue;
+        }
+        char* configargv[3] = { "sals", "-c", path };
+        bench_args_t configargs = { 3, configargv };
+        char name[BENCH_NAME_LENGTH];
+        snprintf(name, sizeof(name), "cli_parse/%s", configs[i]);
+        if (!bench_run(bench, name, BENCH_KIND_MICRO, bench_cli_parse, &configargs, 1000))
+            failed++;
+    }
+    return failed;
+}
+
+size_t bench_suite_game(bench_t* bench) {
+    const size_t sizes[3][2] = { { 100, 100 }, { 1000, 100 }, { 1000, 1000 } };
+    size_t failed = 0;
+    for (size_t i = 0; i < 3; i++) {
+        char* argv[1] = { "sals" };
+        cli_args_t cli_args = cli_parse(1, argv);
+        cli_args.width = sizes[i][0];
+        cli_args.height = sizes[i][1];
+        // a ladder or snake in every block of 10 cells, hence none of them overlap
+        const size_t cellcount = cli_args.width * cli_args.height;
+        bool added = true;
+        for (size_t block = 0; added && block < cellcount / 10; block++) {
+            snakeorladder_t sol = block % 2 ? (snakeorladder_t){ block * 10 + 7, block * 10 + 2 } : (snakeorladder_t){ block * 10 + 2, block * 10 + 7 };
+            added = array_add(&cli_args.snakesandladders, &sol);
+        }
+        char name[BENCH_NAME_LENGTH];
+        snprintf(name, sizeof(name), "game_setup/%lux%lu", sizes[i][0], sizes[i][1]);
+        if (!added || !bench_run(bench, name, BENCH_KIND_MICRO, bench_game_setup, &cli_args, cellcount >= 1000000 ? 1 : 10))
+            failed++;
+        cli_args_free(&cli_args);
+    }
+    // random snakes and ladders of realistic lengths on the largest board, hence the jump tables are accessed irregularly
+    char* argv[1] = { "sals" };
+    cli_args_t cli_args = cli_parse(1, argv);
+    cli_args.width = sizes[2][0];
+    cli_args.height = sizes[2][1];
+    const generator_lengths_t lengths = OPTVAL_SAL_LENGTHS_DEFAULT;
+    char name[BENCH_NAME_LENGTH];
+    snprintf(name, sizeof(name), "game_setup/generated/%lux%lu", cli_args.width, cli_args.height);
+    if (generator_generate(cli_args.width, cli_args.height, OPTVAL_SAL_DENSITY_DEFAULT, &lengths, BENCH_SEED, &cli_args.snakesandladders) != 0
+        || !bench_run(bench, name, BENCH_KIND_MICRO, bench_game_setup, &cli_args, 1))
+        failed++;
+    cli_args_free(&cli_args);
+    return failed;
+}
+
+size_t bench_suite_examples(bench_t* bench) {
+    if (access(bench->sals, X_OK) != 0) {
+        fprintf(stderr, "%swarning:%s skipping end-to-end benchmarks. '%s' is not executable (build it with make sals).\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), bench->sals);
+        return 1;
+    }
+    char pattern[BENCH_NAME_LENGTH];
+    glob_t configs = {};
+    snprintf(pattern, sizeof(pattern), "%s/*.sals", bench->examples);
+    int error = glob(pattern, 0, 0, &configs);
+    snprintf(pattern, sizeof(pattern), "%s/distributions/*.sals", bench->examples);
+    if (error == 0 || error == GLOB_NOMATCH)
+        error = glob(pattern, configs.gl_pathc > 0 ? GLOB_APPEND : 0, 0, &configs);
+    if (error != 0 && error != GLOB_NOMATCH) {
+        fprintf(stderr, "%swarning:%s skipping end-to-end benchmarks. unable to list the configs in '%s'.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), bench->examples);
+        globfree(&configs);
+        return 1;
+    }
+    size_t failed = 0;
+    for (size_t i = 0; i < configs.gl_pathc; i++) {
+        bench_example_t example = { bench->sals, configs.gl_pathv[i] };
+        if (!bench_run(bench, configs.gl_pathv[i], BENCH_KIND_MACRO, bench_example, &example, 1))
+            failed++;
+    }
+    globfree(&configs);
+    return failed;
+}
+
+void bench_print_json(FILE* file, const bench_t* bench) {
+    if (!file || !bench)
+        return;
+    fprintf(file, "{\n  \"version\": \"%d.%d.%d\",\n  \"samples\": %lu,\n  \"warmup\": %lu,\n  \"seed\": %lu,\n  \"unit\": \"ns\",\n  \"benchmarks\": [",
+        VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH, bench->samples, BENCH_WARMUP_SAMPLES, BENCH_SEED);
+    for (size_t i = 0; i < bench->results.size; i++) {
+        const bench_result_t* result = array_getconst(&bench->results, i);
+        fprintf(file, "%s\n    { \"name\": ", i == 0 ? "" : ",");
+        report_print_json_string(file, result->name);
+        fprintf(file,
+            ", \"kind\": \"%s\", \"iterations\": %lu, \"median\": %.3lf, \"mean\": %.3lf, \"variance\": %.3lf, \"stddev\": %.3lf, \"min\": %.3lf, \"max\": %.3lf }",
+            result->kind == BENCH_KIND_MICRO ? "micro" : "macro", result->iterations, result->median, result->mean, result->variance,
+            sqrt(result->variance), result->min, result->max
+        );
+    }
+    fprintf(file, "\n  ]\n}\n");
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "array.h"
+#include "simulator.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BENCH_SAMPLES_DEFAULT 10ul                  // The default number of measured samples of every benchmark
+#define BENCH_WARMUP_SAMPLES 1ul                    // The number of samples run before measuring (e.g. to warm up the caches)
+#define BENCH_SEED 1ul                              // The seed of the random number generator, hence every run rolls the same dices
+#define BENCH_SALS_DEFAULT "./sals"                 // The default executable the end-to-end benchmarks run
+#define BENCH_EXAMPLES_DEFAULT "examples"           // The default directory of the configs the end-to-end benchmarks run
+#define BENCH_OUTPUT_DEFAULT "bench.json"           // The default file the results are written to
+#define BENCH_NAME_LENGTH 128                       // The maximum length of a benchmark name including the terminating null character
+#define BENCH_STATS_GAMES 64ul                      // The number of recorded games the statistics accumulation benchmark adds in turns
+#define BENCH_STATS_WORKERS 4ul                     // The number of workers whose partial statistics the statistics analysis benchmark merges
+
+/**
+ * Enum to identify the kind of a benchmark.
+ */
+typedef enum bench_kind_t {
+    BENCH_KIND_MICRO,                   // A single function of the simulator measured in process
+    BENCH_KIND_MACRO                    // A complete run of the sals executable with a config file
+} bench_kind_t;
+
+/**
+ * Function pointer type of a benchmarked function performing the measured operation the given number of times.
+ * @param context The context of the benchmark (e.g. the die that should be rolled).
+ * @param iterations The number of times the operation should be performed.
+ * @return true if the operations succeeded, false otherwise.
+ */
+typedef bool (*bench_fn_t)(void* context, size_t iterations);
+
+/**
+ * Struct for the summarized samples of a benchmark. All times are nanoseconds per operation.
+ */
+typedef struct bench_result_t {
+    char name[BENCH_NAME_LENGTH];       // The name of the benchmark (e.g. dice/uniform/6)
+    bench_kind_t kind;                  // The kind of the benchmark
+    size_t iterations;                  // The number of operations per sample
+    size_t samples;                     // The number of measured samples
+    double median;                      // The median of the samples
+    double mean;                        // The mean of the samples
+    double variance;                    // The sample variance of the samples
+    double min;                         // The fastest sample
+    double max;                         // The slowest sample
+} bench_result_t;
+
+/**
+ * Struct for a benchmark run.
+ */
+typedef struct bench_t {
+    size_t samples;                     // The number of measured samples of every benchmark
+    const char* sals;                   // The sals executable the end-to-end benchmarks run
+    const char* examples;               // The directory of the configs the end-to-end benchmarks run
+    array_t results;                    // The results of the benchmarks (element type: bench_result_t)
+} bench_t;
+
+/**
+ * Struct for the context of a statistics accumulation benchmark.
+ */
+typedef struct bench_stats_t {
+    const simulator_t* simulator;       // The simulator the accumulated statistics are initialized for
+    const simulation_t* sims;           // The recorded games of the simulator that are added in turns
+    size_t simcount;                    // The number of recorded games
+} bench_stats_t;
+
+/**
+ * Struct for the context of a command line parsing benchmark.
+ */
+typedef struct bench_args_t {
+    int argc;                           // The number of arguments
+    char** argv;                        // The arguments including the program name
+} bench_args_t;
+
+/**
+ * Struct for the context of an end-to-end benchmark.
+ */
+typedef struct bench_example_t {
+    const char* sals;                   // The sals executable
+    const char* config;                 // The config file passed with -c
+} bench_example_t;
+
+// The sink the benchmarked functions write their results to, hence the compiler can't optimize the operations away
+extern volatile size_t bench_sink;
+
+/**
+ * Creates a benchmark run with no results.
+ * @param samples The number of measured samples of every benchmark, at least 1.
+ * @param sals The sals executable the end-to-end benchmarks run.
+ * @param examples The directory of the configs the end-to-end benchmarks run.
+ * @return The created benchmark run.
+ */
+bench_t bench_create(size_t samples, const char* sals, const char* examples);
+
+/**
+ * Frees the given benchmark run freeing it's results.
+ * @param bench The benchmark run that should be freed.
+ */
+void bench_free(bench_t* bench);
+
+/**
+ * Compares two doubles (used to sort the samples).
+ * @param a The address of the first double.
+ * @param b The address of the second double.
+ * @return A negative value if a < b, 0 if a == b, a positive value if a > b.
+ */
+int bench_compare_doubles(const void* a, const void* b);
+
+/**
+ * Summarizes the given samples into the median, mean, sample variance, minimum and maximum.
+ * @param result The result the summary is stored in.
+ * @param samples The samples in nanoseconds per operation (sorted in place).
+ * @param count The number of samples.
+ */
+void bench_summarize(bench_result_t* result, double* samples, size_t count);
+
+/**
+ * Runs the given benchmark BENCH_WARMUP_SAMPLES times unmeasured and bench->samples times measured with the monotonic clock
+ * and adds the summarized samples to the results. The benchmark is printed to stderr as it finishes.
+ * @param bench The benchmark run the result should be added to.
+ * @param name The name of the benchmark.
+ * @param kind The kind of the benchmark.
+ * @param fn The benchmarked function.
+ * @param context The context passed to the benchmarked function.
+ * @param iterations The number of operations per sample.
+ * @return true if every sample succeeded and the result was added, false otherwise.
+ */
+bool bench_run(bench_t* bench, const char* name, bench_kind_t kind, bench_fn_t fn, void* context, size_t iterations);
+
+/**
+ * Rolls the given die the given number of times (see bench_fn_t, context type: die_t).
+ */
+bool bench_dice(void* context, size_t iterations);
+
+/**
+ * Runs the given number of single games of the given simulation (see bench_fn_t, context type: simulation_t).
+ */
+bool bench_simulation_run(void* context, size_t iterations);
+
+/**
+ * Adds the given number of recorded games in turns to new statistics (see bench_fn_t, context type: bench_stats_t).
+ */
+bool bench_stats_add(void* context, size_t iterations);
+
+/**
+ * Analyzes the statistics of the given simulator which already ran it's simulations the given number of times (see bench_fn_t, context type: simulator_t).
+ * Only the partial statistics of the workers are merged, hence the cost depends on the number of workers and not on the number of games.
+ */
+bool bench_stats_analyze(void* context, size_t iterations);
+
+/**
+ * Parses the given command line arguments the given number of times (see bench_fn_t, context type: bench_args_t).
+ */
+bool bench_cli_parse(void* context, size_t iterations);
+
+/**
+ * Sets up the game of the given command line arguments the given number of times (see bench_fn_t, context type: cli_args_t).
+ */
+bool bench_game_setup(void* context, size_t iterations);
+
+/**
+ * Runs the given sals executable with the given config file the given number of times discarding it's output (see bench_fn_t, context type: bench_example_t).
+ */
+bool bench_example(void* context, size_t iterations);
+
+/**
+ * Benchmarks the dice function for every distribution preset with 6, 20 and 100 sides.
+ * @param bench The benchmark run.
+ * @return The number of failed benchmarks.
+ */
+size_t bench_suite_dice(bench_t* bench);
+
+/**
+ * Benchmarks single games of the simulation_run kernel on the board of the examples with 6 and 12 sides.
+ * @param bench The benchmark run.
+ * @return The number of failed benchmarks.
+ */
+size_t bench_suite_simulation(bench_t* bench);
+
+/**
+ * Benchmarks stats_add accumulating 10000 and 100000 games and stats_analyze merging the partial statistics of BENCH_STATS_WORKERS workers.
+ * @param bench The benchmark run.
+ * @return The number of failed benchmarks.
+ */
+size_t bench_suite_stats(bench_t* bench);
+
+/**
+ * Benchmarks parsing the command line arguments and the config files of the examples.
+ * @param bench The benchmark run.
+ * @return The number of failed benchmarks.
+ */
+size_t bench_suite_cli(bench_t* bench);
+
+/**
+ * Benchmarks game_setup on boards of 100x100, 1000x100 and 1000x1000 cells with a snake or ladder every 10 cells
+ * and on a 1000x1000 board with the snakes and ladders of sals generate (default density and lengths, seeded with BENCH_SEED).
+ * @param bench The benchmark run.
+ * @return The number of failed benchmarks.
+ */
+size_t bench_suite_game(bench_t* bench);
+
+/**
+ * Benchmarks running the sals executable with every config in the examples directory and it's distributions subdirectory.
+ * @param bench The benchmark run.
+ * @return The number of failed benchmarks.
+ */
+size_t bench_suite_examples(bench_t* bench);
+
+/**
+ * Prints the results of the given benchmark run as JSON object with the samples, the seed and one object per benchmark
+ * with it's name, kind, iterations and the median, mean, variance, standard deviation, minimum and maximum in nanoseconds per operation.
+ * @param file The file the results should be printed to.
+ * @param bench The benchmark run.
+ */
+void bench_print_json(FILE* file, const bench_t* bench);
@@ -0,0 +1,134 @@
+#include "bench.h"
+#include "scaling.h"
+
+#include "assetmanager.h"
+#include "cvts.h"
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char* argv[]) {
+    assetmanager_init();
+
+    size_t samples = 0;
+    const char* output = 0;
+    const char* sals = BENCH_SALS_DEFAULT;
+    const char* examples = BENCH_EXAMPLES_DEFAULT;
+    bool runscaling = false;
+    size_t workload = SCALING_WORKLOAD_DEFAULT;
+    size_t maxworkers = 0;
+    int opt = -1;
+    while ((opt = getopt(argc, argv, ":hr:o:b:e:sw:j:")) != -1) {
+        switch (opt) {
+            case 'h':
+                printf(
+                    "Usage: %s [-r samples] [-o file] [-b sals] [-e examples]\n"
+                    "       %s -s [-r samples] [-o file] [-w dices] [-j workers] [sals...]\n"
+                    "Runs the micro benchmarks (dice, simulation_run, stats_add, stats_analyze, cli_parse and game_setup) and the end-to-end\n"
+                    "benchmarks (the sals executable with every config of the examples) and writes their medians and variances as JSON.\n"
+                    "With -s runs the scaling benchmark instead, which runs every given sals executable (the default is %s) on 1, 2,\n"
+                    "4 ... workers with boards from 10x10 to 1000x1000 and dies from 6 to 10000 sides and writes the throughput,\n"
+                    "the efficiency relative to one worker, the wall time percentiles and the peak memory of every configuration as CSV.\n"
+                    "  -r samples                The number of measured samples of every benchmark. The default is %lu (%lu with -s).\n"
+                    "  -o file                   The file the results are written to, - for stdout. The default is %s (%s with -s).\n"
+                    "  -b sals                   The sals executable run by the end-to-end benchmarks. The default is %s.\n"
+                    "  -e examples               The directory of the configs run by the end-to-end benchmarks. The default is %s.\n"
+                    "  -s                        Runs the scaling benchmark.\n"
+                    "  -w dices                  The number of dices every run of the scaling benchmark rolls. The default is %lu.\n"
+                    "  -j workers                The maximum number of workers of the scaling benchmark. The default is the number of online processors.\n",
+                    argv[0], argv[0], BENCH_SALS_DEFAULT, BENCH_SAMPLES_DEFAULT, SCALING_SAMPLES_DEFAULT, BENCH_OUTPUT_DEFAULT, SCALING_OUTPUT_DEFAULT,
+                    BENCH_SALS_DEFAULT, BENCH_EXAMPLES_DEFAULT, SCALING_WORKLOAD_DEFAULT
+                );
+                exit(0);
+            case 'r':
+            case 'w':
+            case 'j':
+            {
+                char* end = 0;
+                size_t value = strtoul(optarg, &end, 10);
+                if (*optarg == '\0' || *optarg == '-' || *end != '\0' || value == 0) {
+                    fprintf(stderr, "%serror:%s invalid value '%s' for option -%c. must be a positive integer.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optarg, opt);
+                    exit(1);
+                }
+                *(opt == 'r' ? &samples : opt == 'w' ? &workload : &maxworkers) = value;
+                break;
+            }
+            case 's':
+                runscaling = true;
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 'b':
+                sals = optarg;
+                break;
+            case 'e':
+                examples = optarg;
+                break;
+            case ':':
+                fprintf(stderr, "%serror:%s missing value for option -%c.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optopt);
+                exit(1);
+            default:
+                fprintf(stderr, "%serror:%s unknown option -%c.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optopt);
+                exit(1);
+        }
+    }
+
+    if (runscaling) {
+        scaling_t scaling = scaling_create(samples > 0 ? samples : SCALING_SAMPLES_DEFAULT, workload, maxworkers);
+        assetmanager_add(&scaling, (deallocator_fn_t)scaling_free);
+        if (optind >= argc)
+            array_add(&scaling.sals, &sals);
+        for (int i = optind; i < argc; i++)
+            array_add(&scaling.sals, &argv[i]);
+        fprintf(stderr, "Scaling (median throughput of %lu runs of about %lu dices each, up to %lu workers)\n", scaling.samples, scaling.workload, scaling.maxworkers);
+        size_t failed = scaling_run(&scaling);
+
+        output = output ? output : SCALING_OUTPUT_DEFAULT;
+        FILE* file = strcmp(output, "-") == 0 ? stdout : fopen(output, "w");
+        if (!file) {
+            fprintf(stderr, "%serror:%s unable to open output file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), output);
+            exit(1);
+        }
+        scaling_print_csv(file, &scaling);
+        if (file != stdout && fclose(file) != 0) {
+            fprintf(stderr, "%serror:%s unable to write output file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), output);
+            exit(1);
+        }
+        if (file != stdout)
+            fprintf(stderr, "wrote %lu scaling results into '%s'.\n", scaling.results.size, output);
+        if (failed > 0)
+            fprintf(stderr, "%swarning:%s %lu scaling configurations failed.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), failed);
+        assetmanager_free_all();
+        return failed > 0 ? 1 : 0;
+    }
+
+    output = output ? output : BENCH_OUTPUT_DEFAULT;
+    bench_t bench = bench_create(samples > 0 ? samples : BENCH_SAMPLES_DEFAULT, sals, examples);
+    assetmanager_add(&bench, (deallocator_fn_t)bench_free);
+    fprintf(stderr, "Benchmarks (median and standard deviation of %lu samples per operation)\n", bench.samples);
+    size_t failed = bench_suite_dice(&bench);
+    failed += bench_suite_simulation(&bench);
+    failed += bench_suite_stats(&bench);
+    failed += bench_suite_cli(&bench);
+    failed += bench_suite_game(&bench);
+    failed += bench_suite_examples(&bench);
+
+    FILE* file = strcmp(output, "-") == 0 ? stdout : fopen(output, "w");
+    if (!file) {
+        fprintf(stderr, "%serror:%s unable to open output file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), output);
+        exit(1);
+    }
+    bench_print_json(file, &bench);
+    if (file != stdout && fclose(file) != 0) {
+        fprintf(stderr, "%serror:%s unable to write output file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), output);
+        exit(1);
+    }
+    if (file != stdout)
+        fprintf(stderr, "wrote %lu benchmark results into '%s'.\n", bench.results.size, output);
+    if (failed > 0)
+        fprintf(stderr, "%swarning:%s %lu benchmarks failed or were skipped.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), failed);
+    assetmanager_free_all();
+    return failed > 0 ? 1 : 0;
+}
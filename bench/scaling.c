@@ -0,0 +1,204 @@
+// wait4 is only declared for the default feature set
+#define _DEFAULT_SOURCE
+
+#include "scaling.h"
+
+#include "bench.h"
+#include "cvts.h"
+#include "report.h"
+#include "stopwatch.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+scaling_t scaling_create(size_t samples, size_t workload, size_t maxworkers) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (scaling_t){
+        .samples = samples > 0 ? samples : 1,
+        .workload = workload > 0 ? workload : 1,
+        .maxworkers = maxworkers > 0 ? maxworkers : cpus > 0 ? (size_t)cpus : 1,
+        .sals = array_create(0, sizeof(const char*), 0),
+        .results = array_create(0, sizeof(scaling_result_t), 0)
+    };
+}
+
+void scaling_free(scaling_t* scaling) {
+    if (!scaling)
+        return;
+    array_free(&scaling->sals, 0);
+    array_free(&scaling->results, 0);
+}
+
+size_t scaling_iterations(size_t workload, size_t width, size_t height, size_t sides) {
+    // a game rolls about the number of cells divided by the average side of the die (at least one dice)
+    const double dices = fmax(1.0, (double)width * height / ((sides + 1) / 2.0));
+    const size_t iterations = (size_t)(workload / dices);
+    return iterations > SCALING_ITERATIONS_MIN ? iterations : SCALING_ITERATIONS_MIN;
+}
+
+int scaling_run_config(const scaling_config_t* config, double* seconds, double* gamerate, double* dicerate, size_t* peakrss) {
+    if (!config || !seconds || !gamerate || !dicerate || !peakrss)
+        return 1;
+    char args[6][32];
+    snprintf(args[0], sizeof(args[0]), "%lu", config->width);
+    snprintf(args[1], sizeof(args[1]), "%lu", config->height);
+    snprintf(args[2], sizeof(args[2]), "%lu", config->sides);
+    snprintf(args[3], sizeof(args[3]), "%lu", config->iterations);
+    // the dice limit is never reached, hence every game runs until it is won
+    snprintf(args[4], sizeof(args[4]), "%lu", config->width * config->height * 100);
+    snprintf(args[5], sizeof(args[5]), "%lu", config->workers);
+
+    int fds[2];
+    if (pipe(fds) != 0)
+        return 2;
+    fflush(stdout);
+    fflush(stderr);
+    stopwatch_t stopwatch = stopwatch_start();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return 2;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0)
+            dup2(devnull, STDERR_FILENO);
+        execl(config->sals, config->sals, "-x", args[0], "-y", args[1], "-s", args[2], "-i", args[3], "-l", args[4], "-j", args[5],
+            "-S", "1", "-m", "-f", "csv", (char*)0);
+        _exit(127);
+    }
+    close(fds[1]);
+
+    // read the output while the run is going, it is the timings report containing the rates of the simulate phase
+    *gamerate = 0.0;
+    *dicerate = 0.0;
+    FILE* output = fdopen(fds[0], "r");
+    if (output) {
+        char line[SCALING_READ_BUFFER_SIZE];
+        bool linestart = true;
+        while (fgets(line, sizeof(line), output)) {
+            if (linestart)
+                sscanf(line, "phase,simulate,%*f,,%lf,%lf", gamerate, dicerate);
+            linestart = line[strlen(line) - 1] == '\n';
+        }
+        fclose(output);
+    } else {
+        close(fds[0]);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid)
+        return 2;
+    *seconds = stopwatch_elapsed(&stopwatch);
+    // linux reports the maximum resident set size in kilobytes
+    *peakrss = (size_t)usage.ru_maxrss * 1024;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 3;
+}
+
+bool scaling_run_configs(scaling_t* scaling, const scaling_config_t* config) {
+    if (!scaling || !config)
+        return false;
+    scaling_result_t result = { .config = *config, .efficiency = NAN };
+    double* seconds = malloc(scaling->samples * sizeof(*seconds));
+    double* gamerates = malloc(scaling->samples * sizeof(*gamerates));
+    double* dicerates = malloc(scaling->samples * sizeof(*dicerates));
+    result.failed = !seconds || !gamerates || !dicerates;
+    for (size_t i = 0; !result.failed && i < scaling->samples; i++) {
+        size_t peakrss = 0;
+        result.failed = scaling_run_config(config, &seconds[i], &gamerates[i], &dicerates[i], &peakrss) != 0;
+        if (peakrss > result.peakrss)
+            result.peakrss = peakrss;
+        result.samples += !result.failed;
+    }
+    if (!result.failed) {
+        qsort(seconds, result.samples, sizeof(*seconds), bench_compare_doubles);
+        qsort(gamerates, result.samples, sizeof(*gamerates), bench_compare_doubles);
+        qsort(dicerates, result.samples, sizeof(*dicerates), bench_compare_doubles);
+        result.p50 = seconds[(size_t)ceil(0.5 * result.samples) - 1];
+        result.p95 = seconds[(size_t)ceil(0.95 * result.samples) - 1];
+        result.max = seconds[result.samples - 1];
+        result.gamerate = gamerates[result.samples / 2];
+        result.dicerate = dicerates[result.samples / 2];
+        // compare with the same executable, board and die on one worker
+        for (size_t i = 0; i < scaling->results.size; i++) {
+            const scaling_result_t* single = array_getconst(&scaling->results, i);
+            if (single->config.sals == config->sals && single->config.width == config->width && single->config.height == config->height
+                && single->config.sides == config->sides && single->config.workers == 1 && !single->failed && single->dicerate > 0.0) {
+                result.efficiency = result.dicerate / (config->workers * single->dicerate);
+                break;
+            }
+        }
+    }
+    free(seconds);
+    free(gamerates);
+    free(dicerates);
+    if (result.failed)
+        fprintf(stderr, "%swarning:%s run of '%s' on %lux%lu with %lu sides and %lu workers failed.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT),
+            config->sals, config->width, config->height, config->sides, config->workers);
+    else
+        fprintf(stderr, "  %-20s %5lux%-5lu %6lu sides %4lu workers %14.0lf dices/s  efficiency %6.2lf%%  p95 %9.3lf s  %6.1lf MB\n",
+            config->sals, config->width, config->height, config->sides, config->workers, result.dicerate,
+            isnan(result.efficiency) ? 100.0 : result.efficiency * 100.0, result.p95, result.peakrss / 1e6);
+    array_add(&scaling->results, &result);
+    return !result.failed;
+}
+
+size_t scaling_run(scaling_t* scaling) {
+    if (!scaling)
+        return 0;
+    // the boards with a 6-sided die and the dies on a 100x100 board (the 100x100 board with a 6-sided die is run once)
+    const size_t shapes[SCALING_SHAPES][3] = {
+        { 10, 10, 6 }, { 32, 32, 6 }, { 100, 100, 6 }, { 316, 316, 6 }, { 1000, 1000, 6 },
+        { 100, 100, 100 }, { 100, 100, 1000 }, { 100, 100, 10000 }
+    };
+    size_t failed = 0;
+    for (size_t i = 0; i < scaling->sals.size; i++) {
+        const char* sals = *(const char* const*)array_getconst(&scaling->sals, i);
+        for (size_t j = 0; j < SCALING_SHAPES; j++) {
+            // double the workers up to the maximum, which is run even if it is no power of two
+            for (size_t workers = 1;; workers = workers * 2 < scaling->maxworkers ? workers * 2 : scaling->maxworkers) {
+                const scaling_config_t config = {
+                    .sals = sals,
+                    .width = shapes[j][0],
+                    .height = shapes[j][1],
+                    .sides = shapes[j][2],
+                    .workers = workers,
+                    .iterations = scaling_iterations(scaling->workload, shapes[j][0], shapes[j][1], shapes[j][2])
+                };
+                failed += !scaling_run_configs(scaling, &config);
+                if (workers == scaling->maxworkers)
+                    break;
+            }
+        }
+    }
+    return failed;
+}
+
+void scaling_print_csv(FILE* file, const scaling_t* scaling) {
+    if (!file || !scaling)
+        return;
+    fprintf(file, "sals,width,height,die_sides,workers,iterations,samples,wall_p50_s,wall_p95_s,wall_max_s,games_per_s,dices_per_s,efficiency,peak_rss_bytes,status\n");
+    for (size_t i = 0; i < scaling->results.size; i++) {
+        const scaling_result_t* result = array_getconst(&scaling->results, i);
+        report_print_csv_string(file, result->config.sals);
+        fprintf(file, ",%lu,%lu,%lu,%lu,%lu,%lu,", result->config.width, result->config.height, result->config.sides, result->config.workers,
+            result->config.iterations, result->samples);
+        if (result->failed) {
+            fprintf(file, ",,,,,,%lu,failed\n", result->peakrss);
+            continue;
+        }
+        fprintf(file, "%.6lf,%.6lf,%.6lf,%.3lf,%.3lf,", result->p50, result->p95, result->max, result->gamerate, result->dicerate);
+        if (!isnan(result->efficiency))
+            fprintf(file, "%.4lf", result->efficiency);
+        fprintf(file, ",%lu,ok\n", result->peakrss);
+    }
+}
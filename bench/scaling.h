@@ -0,0 +1,125 @@
+#pragma once
+
+#include "array.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define SCALING_SAMPLES_DEFAULT 3ul                 // The default number of runs of every configuration
+#define SCALING_WORKLOAD_DEFAULT 10000000ul         // The default number of dices every run should roll (the iterations are derived from it)
+#define SCALING_ITERATIONS_MIN 100ul                // The minimum number of simulations of a run
+#define SCALING_OUTPUT_DEFAULT "scaling.csv"        // The default file the results are written to
+#define SCALING_SHAPES 8                            // The number of combinations of board size and die sides
+#define SCALING_READ_BUFFER_SIZE 4096ul             // The number of bytes of the output of a run read at once
+
+/**
+ * Struct for a configuration of the scaling benchmark.
+ */
+typedef struct scaling_config_t {
+    const char* sals;                   // The sals executable that is run
+    size_t width;                       // The width of the board
+    size_t height;                      // The height of the board
+    size_t sides;                       // The number of sides of the uniform die
+    size_t workers;                     // The number of workers passed with -j, --workers
+    size_t iterations;                  // The number of simulations of every run
+} scaling_config_t;
+
+/**
+ * Struct for the measured runs of a configuration of the scaling benchmark.
+ */
+typedef struct scaling_result_t {
+    scaling_config_t config;            // The configuration that was run
+    size_t samples;                     // The number of successful runs
+    double p50;                         // The median wall time of a run in seconds (nearest rank)
+    double p95;                         // The 95th percentile of the wall time of a run in seconds (nearest rank)
+    double max;                         // The slowest run in seconds
+    double gamerate;                    // The median number of games per second of the simulate phase
+    double dicerate;                    // The median number of dices per second of the simulate phase
+    double efficiency;                  // The dices per second relative to the workers times the dices per second of one worker, NAN if unknown
+    size_t peakrss;                     // The highest peak resident set size of a run in bytes
+    bool failed;                        // Indicates if a run failed
+} scaling_result_t;
+
+/**
+ * Struct for a scaling benchmark which runs every configuration of board size, die sides and workers for every sals executable.
+ * The workers double from 1 up to the maximum (which is run even if it is no power of two) for each of the boards 10x10, 32x32,
+ * 100x100, 316x316 and 1000x1000 with a 6-sided die and for each of the dies with 6, 100, 1000 and 10000 sides on a 100x100 board.
+ */
+typedef struct scaling_t {
+    size_t samples;                     // The number of runs of every configuration
+    size_t workload;                    // The number of dices every run should roll
+    size_t maxworkers;                  // The maximum number of workers
+    array_t sals;                       // The sals executables that are compared (element type: const char*)
+    array_t results;                    // The results of every configuration (element type: scaling_result_t)
+} scaling_t;
+
+/**
+ * Creates a scaling benchmark with no executables and no results.
+ * @param samples The number of runs of every configuration, at least 1.
+ * @param workload The number of dices every run should roll, at least 1.
+ * @param maxworkers The maximum number of workers, 0 for the number of online processors.
+ * @return The created scaling benchmark.
+ */
+scaling_t scaling_create(size_t samples, size_t workload, size_t maxworkers);
+
+/**
+ * Frees the given scaling benchmark freeing it's executables and results.
+ * @param scaling The scaling benchmark that should be freed.
+ */
+void scaling_free(scaling_t* scaling);
+
+/**
+ * Determines the number of simulations of a run with the given board and die that roll about the given number of dices,
+ * estimated with the average side of the uniform die (the snakes and ladders are ignored).
+ * @param workload The number of dices that should be rolled.
+ * @param width The width of the board.
+ * @param height The height of the board.
+ * @param sides The number of sides of the uniform die.
+ * @return The number of simulations, at least SCALING_ITERATIONS_MIN.
+ */
+size_t scaling_iterations(size_t workload, size_t width, size_t height, size_t sides);
+
+/**
+ * Runs the sals executable of the given configuration once with it's output read from a pipe and measures the wall time,
+ * the games and dices per second of the simulate phase (parsed from the -m, --timings csv report) and the peak resident set size.
+ * @param config The configuration that should be run.
+ * @param seconds The address the wall time is stored in.
+ * @param gamerate The address the games per second are stored in, 0 if they could not be parsed.
+ * @param dicerate The address the dices per second are stored in, 0 if they could not be parsed.
+ * @param peakrss The address the peak resident set size in bytes is stored in.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran the configuration
+ *
+ * - 1 no configuration or addresses given
+ *
+ * - 2 unable to create pipe or process
+ *
+ * - 3 the run exited with an error
+ */
+int scaling_run_config(const scaling_config_t* config, double* seconds, double* gamerate, double* dicerate, size_t* peakrss);
+
+/**
+ * Runs the given configuration scaling->samples times and adds the summarized runs to the results.
+ * The efficiency is determined relative to the result of the same board and die with 1 worker if it was already run.
+ * @param scaling The scaling benchmark.
+ * @param config The configuration that should be run.
+ * @return true if every run succeeded, false otherwise (the result is added and marked as failed).
+ */
+bool scaling_run_configs(scaling_t* scaling, const scaling_config_t* config);
+
+/**
+ * Runs every configuration of the given scaling benchmark for every executable, printing each result to stderr as it finishes.
+ * @param scaling The scaling benchmark.
+ * @return The number of configurations with failed runs.
+ */
+size_t scaling_run(scaling_t* scaling);
+
+/**
+ * Prints the results of the given scaling benchmark as CSV with the columns sals, width, height, die_sides, workers, iterations,
+ * samples, wall_p50_s, wall_p95_s, wall_max_s, games_per_s, dices_per_s, efficiency, peak_rss_bytes and status.
+ * @param file The file the results should be printed to.
+ * @param scaling The scaling benchmark.
+ */
+void scaling_print_csv(FILE* file, const scaling_t* scaling);
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define ALLOCATIONS_SUBSYSTEM_COUNT 5
+
+/**
+ * Enum to identify the subsystem an allocation is accounted to.
+ */
+typedef enum allocations_subsystem_t {
+    ALLOCATIONS_SUBSYSTEM_OTHER,        // Allocations outside of the other subsystems (e.g. the asset manager)
+    ALLOCATIONS_SUBSYSTEM_CLI,          // Parsing the command line arguments and the config file
+    ALLOCATIONS_SUBSYSTEM_GAME,         // Setting up the game (board, die and snakes and ladders)
+    ALLOCATIONS_SUBSYSTEM_SIMULATOR,    // The simulator, it's workers and their simulations (e.g. the diced sides of a game)
+    ALLOCATIONS_SUBSYSTEM_STATS         // The partial statistics of the workers and the analyzed statistics
+} allocations_subsystem_t;
+
+/**
+ * Struct to store information about a subsystem.
+ */
+typedef struct allocations_subsystem_info_t {
+    char* name;                         // The name of the subsystem
+} allocations_subsystem_info_t;
+
+// Information about each allocations_subsystem_t value
+extern allocations_subsystem_info_t allocations_subsystem_infos[ALLOCATIONS_SUBSYSTEM_COUNT];
+
+/**
+ * Struct for the accounted allocations of a subsystem.
+ * The counters are updated with relaxed atomics, hence the workers can allocate concurrently.
+ */
+typedef struct allocations_counter_t {
+    atomic_size_t allocations;          // The number of allocated memory blocks
+    atomic_size_t reallocations;        // The number of resized memory blocks
+    atomic_size_t frees;                // The number of freed memory blocks
+    atomic_size_t bytes;                // The number of allocated bytes including the bytes a memory block grew by
+    atomic_size_t live;                 // The number of currently allocated bytes
+    atomic_size_t peak;                 // The highest number of allocated bytes at any time
+} allocations_counter_t;
+
+// The accounted allocations of each allocations_subsystem_t value
+extern allocations_counter_t allocations_counters[ALLOCATIONS_SUBSYSTEM_COUNT];
+
+// The accounted allocations of all subsystems, it's peak is the highest number of bytes allocated at the same time by all subsystems
+extern allocations_counter_t allocations_total;
+
+/**
+ * Enables or disables the accounting of allocations, which is disabled by default hence allocating touches no shared counters.
+ * Every thread reads the setting once at it's first allocation, hence it must be set before other threads allocate
+ * and never changed afterwards (memory blocks allocated while disabled are not accounted when they are freed while enabled).
+ * @param enabled Indicates if the allocations should be accounted.
+ */
+void allocations_enable(bool enabled);
+
+/**
+ * Determines whether the allocations of the calling thread are accounted (see allocations_enable).
+ * @return true if the allocations are accounted, false if not.
+ */
+bool allocations_enabled();
+
+/**
+ * Sets the subsystem the allocations of the calling thread are accounted to if the allocated object doesn't track it's own subsystem
+ * (e.g. the arrays created by the calling thread). Every thread starts with ALLOCATIONS_SUBSYSTEM_OTHER.
+ * @param subsystem The subsystem the allocations of the calling thread should be accounted to.
+ * @return The previous subsystem of the calling thread which should be restored afterwards.
+ */
+allocations_subsystem_t allocations_set_subsystem(allocations_subsystem_t subsystem);
+
+/**
+ * Determines the subsystem the allocations of the calling thread are accounted to.
+ * @return The current subsystem of the calling thread.
+ */
+allocations_subsystem_t allocations_subsystem();
+
+/**
+ * Accounts a memory block of the given subsystem whose size changed from the given old size to the given new size.
+ * An old size of 0 accounts an allocation, a new size of 0 a free and otherwise a reallocation. Nothing is accounted unless the accounting
+ * is enabled (see allocations_enable).
+ * @param subsystem The subsystem the memory block belongs to.
+ * @param oldsize The previous size of the memory block, 0 if it was allocated.
+ * @param newsize The new size of the memory block, 0 if it was freed.
+ */
+void allocations_account(allocations_subsystem_t subsystem, size_t oldsize, size_t newsize);
+
+/**
+ * Updates the given counter for a memory block whose size changed from the given old size to the given new size (see allocations_account).
+ * @param counter The counter that should be updated.
+ * @param oldsize The previous size of the memory block, 0 if it was allocated.
+ * @param newsize The new size of the memory block, 0 if it was freed.
+ */
+void allocations_counter_update(allocations_counter_t* counter, size_t oldsize, size_t newsize);
+
+/**
+ * Allocates a memory block of the given size with malloc and accounts it to the given subsystem.
+ * @param subsystem The subsystem the memory block belongs to.
+ * @param size The size of the memory block.
+ * @return The allocated memory block, 0 if it could not be allocated.
+ */
+void* allocations_malloc(allocations_subsystem_t subsystem, size_t size);
+
+/**
+ * Allocates a zero initialized memory block of count elements of the given size with calloc and accounts it to the given subsystem.
+ * @param subsystem The subsystem the memory block belongs to.
+ * @param count The number of elements.
+ * @param size The size of a single element.
+ * @return The allocated memory block, 0 if it could not be allocated.
+ */
+void* allocations_calloc(allocations_subsystem_t subsystem, size_t count, size_t size);
+
+/**
+ * Allocates a memory block of the given size aligned to the given alignment with aligned_alloc and accounts it to the given subsystem.
+ * @param subsystem The subsystem the memory block belongs to.
+ * @param alignment The alignment of the memory block.
+ * @param size The size of the memory block which must be a multiple of the alignment.
+ * @return The allocated memory block, 0 if it could not be allocated.
+ */
+void* allocations_aligned_alloc(allocations_subsystem_t subsystem, size_t alignment, size_t size);
+
+/**
+ * Resizes the given memory block with realloc and accounts the reallocation to the given subsystem.
+ * If no memory block is given a new memory block is allocated and accounted as allocation.
+ * @param subsystem The subsystem the memory block belongs to.
+ * @param data The memory block that should be resized.
+ * @param oldsize The current size of the memory block.
+ * @param newsize The new size of the memory block.
+ * @return The resized memory block, 0 if it could not be resized in which case the given memory block is left untouched.
+ */
+void* allocations_realloc(allocations_subsystem_t subsystem, void* data, size_t oldsize, size_t newsize);
+
+/**
+ * Frees the given memory block and accounts it to the given subsystem.
+ * If no memory block is given no action is performed.
+ * @param subsystem The subsystem the memory block belongs to.
+ * @param data The memory block that should be freed.
+ * @param size The size of the memory block.
+ */
+void allocations_free(allocations_subsystem_t subsystem, void* data, size_t size);
+
+/**
+ * Determines the peak resident set size of the process.
+ * @return The highest number of bytes the process had in physical memory, 0 if it could not be determined.
+ */
+size_t allocations_peak_rss();
+
+/**
+ * Prints the accounted allocations of every subsystem and of all subsystems as table followed by the peak resident set size.
+ * The bytes still live at exit are allocations that were not freed.
+ * @param file The file the allocations should be printed to.
+ */
+void allocations_print(FILE* file);
+
+/**
+ * Prints the accounted allocations to stderr (see allocations_print), hence the statistics and reports on stdout stay untouched.
+ * Meant to be registered with atexit.
+ */
+void allocations_print_exit();
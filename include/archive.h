@@ -0,0 +1,236 @@
+#pragma once
+
+#include "game.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ARCHIVE_MAGIC "SALST\r\n\x1a"                   // The signature at the beginning of every trace archive (the line endings and EOF character detect text mode conversions)
+#define ARCHIVE_MAGIC_SIZE 8ul                          // The number of bytes of the signature
+#define ARCHIVE_VERSION 1u                              // The version of the trace archive layout, incremented whenever the layout or the coding changes
+#define ARCHIVE_BYTE_ORDER 0x01020304u                  // The value stored in the byte order of the writing machine to detect archives written on machines with another byte order
+#define ARCHIVE_ALIGNMENT 8ul                           // The alignment of the code lengths and index sections in bytes
+#define ARCHIVE_CODE_LENGTH_MAX 32u                     // The maximum length of the code of a die side in bits
+#define ARCHIVE_BLOCK_SIMS 256ul                        // The maximum number of simulations of a block, hence of the simulations decoded to fetch one of them
+
+// forward declarations
+typedef struct records_buffer_t records_buffer_t;
+
+/**
+ * Struct for a block of a trace archive containing the traces of consecutive simulations.
+ * Each trace is stored as the number of dices (LEB128 varint) followed by the codes of the diced sides padded to a full byte.
+ */
+typedef struct archive_block_t {
+    uint64_t first;                     // The index of the first simulation of the block
+    uint64_t count;                     // The number of simulations of the block
+    uint64_t offset;                    // The offset of the block in bytes (relative to it's buffer while buffered, to the archive once written)
+    uint64_t size;                      // The size of the block in bytes
+} archive_block_t;
+
+/**
+ * Struct for the header at the beginning of a trace archive.
+ * The header is followed by the sections (each aligned to ARCHIVE_ALIGNMENT bytes and zero padded):
+ *
+ * - the code length of each die side in bits, 0 for sides that can't be diced (uint8_t[sidecount])
+ *
+ * - the blocks in the order they were written
+ *
+ * - the index of the blocks ordered by their first simulation (archive_block_t[blockcount])
+ */
+typedef struct archive_header_t {
+    char magic[ARCHIVE_MAGIC_SIZE];     // The signature of trace archives (ARCHIVE_MAGIC)
+    uint32_t version;                   // The version of the trace archive layout (ARCHIVE_VERSION)
+    uint32_t byteorder;                 // ARCHIVE_BYTE_ORDER stored in the byte order of the writing machine
+    uint64_t fingerprint;               // The fingerprint of the game whose simulations are archived (see archive_fingerprint)
+    uint64_t sidecount;                 // The number of sides of the die
+    uint64_t simcount;                  // The number of archived simulations
+    uint64_t blockcount;                // The number of blocks
+    uint64_t lengthsoffset;             // The offset of the code lengths section in bytes
+    uint64_t blocksoffset;              // The offset of the first block in bytes
+    uint64_t indexoffset;               // The offset of the index section in bytes
+    uint64_t size;                      // The size of the whole archive in bytes
+} archive_header_t;
+
+/**
+ * Struct for a die side with it's probability used to build a Huffman code.
+ */
+typedef struct archive_symbol_t {
+    double prob;                        // The probability of the side
+    size_t side;                        // The 0 based side
+} archive_symbol_t;
+
+/**
+ * Struct for a canonical Huffman code of the sides of a die.
+ * The code is built from the side probabilities, hence likely sides get short codes and sides that can't be diced get none.
+ * The codes of each length are consecutive numbers assigned in the order of the sides, so the code lengths define the whole code.
+ */
+typedef struct archive_codebook_t {
+    array_t lengths;                                    // The code length of each side in bits, 0 if the side has no code (element type: uint8_t)
+    array_t codes;                                      // The code of each side (element type: uint32_t)
+    array_t symbols;                                    // The 0 based sides that have a code ordered by code length and side (element type: size_t)
+    uint32_t counts[ARCHIVE_CODE_LENGTH_MAX + 1];       // The number of codes of each length
+    uint32_t firsts[ARCHIVE_CODE_LENGTH_MAX + 1];       // The first code of each length
+    size_t offsets[ARCHIVE_CODE_LENGTH_MAX + 1];        // The index of the first side of each length in the symbols array
+} archive_codebook_t;
+
+/**
+ * Struct for a trace archive that is read from a read-only memory mapping.
+ */
+typedef struct archive_t {
+    void* mapping;                      // The memory mapped archive, 0 if empty
+    size_t size;                        // The size of the mapping in bytes
+    const archive_header_t* header;     // The header of the archive
+    const archive_block_t* index;       // The index of the blocks ordered by their first simulation
+    archive_codebook_t codebook;        // The code of the die sides rebuilt from the stored code lengths
+} archive_t;
+
+/**
+ * Compares the given symbols by their probability and side (qsort comparator).
+ * @param a The first symbol (archive_symbol_t).
+ * @param b The second symbol (archive_symbol_t).
+ * @return A negative value if a is less probable than b, a positive value if it is more probable, the difference of the sides if they are equally probable.
+ */
+int archive_symbol_compare(const void* a, const void* b);
+
+/**
+ * Creates an empty codebook.
+ * @return The created empty codebook.
+ */
+archive_codebook_t archive_codebook_create_empty();
+
+/**
+ * Creates the canonical Huffman code of the sides of the given die whose code lengths are limited to ARCHIVE_CODE_LENGTH_MAX bits.
+ * @param die The die whose side probabilities the code should be built from.
+ * @return The created codebook, an empty codebook if no die was given, no side can be diced or it could not be allocated.
+ */
+archive_codebook_t archive_codebook_create(const die_t* die);
+
+/**
+ * Creates the canonical Huffman code with the given code lengths.
+ * @param lengths The code length of each side in bits, 0 for sides without code.
+ * @param sidecount The number of sides.
+ * @return The created codebook, an empty codebook if no lengths were given, they don't describe a prefix code or it could not be allocated.
+ */
+archive_codebook_t archive_codebook_create_lengths(const uint8_t* lengths, size_t sidecount);
+
+/**
+ * Frees the given codebook freeing it's arrays and resetting it to an empty codebook.
+ * @param codebook The codebook that should be freed.
+ */
+void archive_codebook_free(archive_codebook_t* codebook);
+
+/**
+ * Calculates the fingerprint of the given game from it's dimensions, ending and snakes and ladders,
+ * i.e. everything besides the die that is needed to replay a trace.
+ * @param game The game whose fingerprint should be calculated.
+ * @return The fingerprint, 0 if no game was given.
+ */
+uint64_t archive_fingerprint(const game_t* game);
+
+/**
+ * Creates the header of a trace archive for the simulations of the given game without any blocks.
+ * @param game The game whose simulations are archived.
+ * @return The created header.
+ */
+archive_header_t archive_header_create(const game_t* game);
+
+/**
+ * Adds the trace of a simulation to the given buffer (the number of dices as varint followed by the codes of the diced sides padded to a full byte).
+ * @param buffer The buffer the trace should be added to.
+ * @param codebook The code of the die sides.
+ * @param dices The diced sides of the simulation (element type: size_t).
+ * @return true if the trace was added, false if not all were given, a side has no code or the buffer could not be enlarged.
+ */
+bool archive_encode(records_buffer_t* buffer, const archive_codebook_t* codebook, const array_t* dices);
+
+/**
+ * Decodes the trace of a simulation beginning at the given offset of the given data.
+ * @param data The data containing the trace.
+ * @param size The size of the data in bytes.
+ * @param offset The address of the offset the trace starts at. It is advanced behind the trace.
+ * @param codebook The code of the die sides.
+ * @param dices The array the diced sides are added to (1 based, element type: size_t). If not given the trace is skipped.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully decoded trace
+ *
+ * - 1 not all of data, offset and codebook given
+ *
+ * - 2 trace corrupted (truncated or invalid code)
+ *
+ * - 3 unable to add a diced side
+ */
+int archive_decode(const unsigned char* data, size_t size, size_t* offset, const archive_codebook_t* codebook, array_t* dices);
+
+/**
+ * Creates an empty archive.
+ * @return The created empty archive.
+ */
+archive_t archive_create_empty();
+
+/**
+ * Loads the trace archive at the given path by mapping it read-only into memory and rebuilding the code of the die sides.
+ * @param filepath The path of the trace archive.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully loaded archive
+ *
+ * - 1 no filepath given
+ *
+ * - 2 unable to open archive
+ *
+ * - 3 not a trace archive
+ *
+ * - 4 archive version or machine (byte order) not supported
+ *
+ * - 5 archive corrupted (inconsistent sections or code lengths)
+ *
+ * - 6 unable to map archive
+ *
+ * @return The loaded archive, an empty archive if it could not be loaded.
+ */
+archive_t archive_load(const char* filepath, int* error);
+
+/**
+ * Loads the trace archive at the given path with the archive_load function and checks that it was recorded on the given game.
+ * If the archive could not be loaded or was recorded on another game (fingerprint or number of die sides differ)
+ * an appropriate error message is output on stderr and the program is terminated with exit code 1.
+ * @param filepath The path of the trace archive.
+ * @param game The game the archive should have been recorded on.
+ * @return The loaded archive.
+ */
+archive_t archive_setup(const char* filepath, const game_t* game);
+
+/**
+ * Frees the given archive unmapping it and freeing it's codebook and resetting it to an empty archive.
+ * @param archive The archive that should be freed.
+ */
+void archive_free(archive_t* archive);
+
+/**
+ * Fetches the trace of the simulation with the given index by finding it's block with a binary search in the index
+ * and decoding the block up to the simulation, hence the time does not depend on the size of the archive.
+ * @param archive The archive the trace should be fetched from.
+ * @param index The index of the simulation.
+ * @param dices The array the diced sides are added to (1 based, element type: size_t).
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully fetched trace
+ *
+ * - 1 not all were given
+ *
+ * - 2 simulation not in archive
+ *
+ * - 3 archive corrupted
+ *
+ * - 4 unable to add a diced side
+ */
+int archive_get(const archive_t* archive, size_t index, array_t* dices);
+
+/**
+ * Replays the given trace on the given game printing every dice with the player's moves and used snakes and ladders.
+ * @param game The game the trace was recorded on.
+ * @param index The index of the simulation the trace belongs to.
+ * @param dices The diced sides of the simulation (1 based, element type: size_t).
+ */
+void archive_replay(const game_t* game, size_t index, const array_t* dices);
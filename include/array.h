@@ -1,5 +1,7 @@
 #pragma once
 
+#include "allocations.h"
+
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -22,6 +24,8 @@ typedef void (*element_fn_t)(void* element);
  * Struct for an array capable of holding elements of arbitrary size in a contiguous memory block.
  * The elementsize should not be changed while the array is not empty unless the next action on the array is a clear or free.
  * If a comparison is required (e.g. in array_find) the comparator function is used, if it is 0 the byte_compare function is used as a fallback.
+ * The memory block is accounted to the subsystem of the thread that created the array (see allocations_set_subsystem),
+ * or of the thread that allocated the memory block if the array was not created with array_create.
  */
 typedef struct array_t {
     void* data;                     // A pointer to the beginning of the data (elements) memory block.
@@ -29,6 +33,7 @@ typedef struct array_t {
     size_t size;                    // The number of elements currently stored in the data memory block.
     size_t elementsize;             // The size of each element the array can store.
     comparator_fn_t comparator;     // The function used for value comparisons.
+    allocations_subsystem_t subsystem;  // The subsystem the memory block is accounted to.
 } array_t;
 
 /**
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#define ATOMICFILE_SUFFIX ".XXXXXX"             // The suffix of the path of the temporary file replaced by mkstemp with a unique name
+
+/**
+ * Struct for a file that is written to a temporary file next to it and replaces it atomically once it is complete,
+ * hence readers never see a partially written file and a failed write leaves the previous file untouched.
+ */
+typedef struct atomicfile_t {
+    const char* filepath;           // The path of the file that is replaced by the temporary file
+    char* temppath;                 // The path of the temporary file next to the file
+    FILE* file;                     // The temporary file the content is written to
+} atomicfile_t;
+
+/**
+ * Creates an empty atomic file.
+ * @return The created empty atomic file.
+ */
+atomicfile_t atomicfile_create_empty();
+
+/**
+ * Opens a new temporary file next to the given file the content is written to.
+ * @param atomicfile The atomic file that should be opened. Left as empty atomic file if it could not be opened.
+ * @param filepath The path of the file that should be replaced. It must not be freed until the atomic file is committed.
+ * @param mode The permissions of the file, 0 to keep the permissions of mkstemp (readable and writable by the owner only).
+ * @return true if the temporary file was opened, false if not all were given or the temporary file could not be created.
+ */
+bool atomicfile_open(atomicfile_t* atomicfile, const char* filepath, mode_t mode);
+
+/**
+ * Flushes the temporary file of the given atomic file to disk, closes it and renames it to the file it replaces.
+ * If the content was not written successfully or any step fails the temporary file is removed instead.
+ * The atomic file is left empty either way.
+ * @param atomicfile The opened atomic file that should be committed.
+ * @param success Indicates if the content was written successfully, otherwise the temporary file is discarded.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully replaced file
+ *
+ * - 1 no opened atomic file given
+ *
+ * - 2 unable to write temporary file (or the content was not written successfully)
+ *
+ * - 3 unable to replace file
+ */
+int atomicfile_commit(atomicfile_t* atomicfile, bool success);
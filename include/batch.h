@@ -0,0 +1,159 @@
+#pragma once
+
+#include "distribution.h"
+#include "game.h"
+#include "report.h"
+#include "simulator.h"
+#include "statistics.h"
+
+#include <stdatomic.h>
+#include <threads.h>
+
+#define BATCH_SUPPORTED_FLAGS (CLIAFLAG_WIDTH | CLIAFLAG_HEIGHT | CLIAFLAG_DIE_SIDES | CLIAFLAG_EXACT_ENDING | CLIAFLAG_DISTRIBUTION \
+    | CLIAFLAG_ITERATIONS | CLIAFLAG_DICE_LIMIT | CLIAFLAG_BAR_LENGTH | CLIAFLAG_TARGET_PRECISION | CLIAFLAG_REPORT_FORMAT) // The options supported in the config files of a batch
+#define BATCH_READ_BUFFER_SIZE 4096ul   // The number of bytes read at once from a config file
+
+// forward declarations
+typedef struct cli_args_t cli_args_t;
+
+/**
+ * Struct for a config file of a batch and the results of simulating the game it describes.
+ */
+typedef struct batch_file_t {
+    char* filepath;                     // The path of the config file
+    char* error;                        // The reason why the config file is invalid, 0 if valid
+    size_t width;                       // The width of the playing field
+    size_t height;                      // The height of the playing field
+    size_t die_sides;                   // The number of sides of the die
+    distr_preset_t distribution;        // The distribution preset of the die (DISTR_PRESET_NONE for custom distribution weights)
+    bool exact_ending;                  // Indicates wether the game must end by exactly landing on the last cell
+    size_t simcount;                    // The (maximum) number of simulations that should be run
+    size_t dicelimit;                   // The maximum allowed number of dices in a simulation before resigning if the game wasn't won yet
+    double targetprecision;             // The half-width of the 95% confidence interval of the average number of dices at which the simulations are stopped (0 if disabled)
+    game_t game;                        // The game described by the config file
+    simulator_t simulator;              // The simulator running the simulations of the game
+    stats_t stats;                      // The statistics of the simulations of the game
+} batch_file_t;
+
+/**
+ * Struct for a batch running the games of many config files in one process.
+ * The config files are parsed with the parser of the library (see libsals_args_parse_str) which reports invalid arguments
+ * instead of terminating the program and uses no global state, hence they are parsed and their games are loaded concurrently
+ * on a few threads and the reason why a file is invalid is stored for it. The games of the valid config files are then
+ * simulated on one shared pool of threads (see simulator_pool_run).
+ */
+typedef struct batch_t {
+    array_t files;                      // The config files in the order they were specified, glob patterns expanded in sorted order (element type: batch_file_t)
+    size_t workers;                     // The number of workers the simulations and validations run on, 0 for one per online processor
+    double elapsed;                     // The number of seconds it took to run the simulations of all valid games
+} batch_t;
+
+/**
+ * Struct for a thread loading the config files of a batch (see batch_validate).
+ */
+typedef struct batch_loader_t {
+    batch_t* batch;                     // The batch whose config files are loaded
+    const cli_args_t* cli_args;         // The cli arguments of the batch
+    atomic_size_t* next;                // The index of the next config file that is not claimed by a thread yet, shared by all threads
+    thrd_t thread;                      // The identifier of the thread
+    bool started;                       // Indicates if the thread was started successfully
+} batch_loader_t;
+
+/**
+ * Frees the given config file of a batch freeing it's filepath, error, game, simulator and statistics.
+ * @param file The config file that should be freed.
+ */
+void batch_file_free(batch_file_t* file);
+
+/**
+ * Adds a config file with the given path to the given batch.
+ * @param batch The batch the config file should be added to.
+ * @param filepath The path of the config file.
+ * @param error The reason why the config file is invalid, 0 if it should still be validated.
+ * @return true if the config file was added, false if not both were given or it could not be added.
+ */
+bool batch_add_file(batch_t* batch, const char* filepath, const char* error);
+
+/**
+ * Reads the content of the file at the given path into memory. Unlike the cli_read_configfile function nothing is printed
+ * and the program is never terminated.
+ * @param filepath The path of the file that should be read.
+ * @param size The address the size of the content in bytes should be stored at.
+ * @return The content of the file, ownership is transferred to the caller. 0 if not both were given or the file could not be read.
+ */
+char* batch_read_file(const char* filepath, size_t* size);
+
+/**
+ * Parses the given config file and loads it's game. The iterations, dice limit and target precision that are set
+ * in the given cli arguments override the values of the config file. If the config file could not be read, it's arguments
+ * are invalid or unsupported (see BATCH_SUPPORTED_FLAGS) or it's game could not be created the file is marked as invalid.
+ * Nothing is printed and no global state is used, hence many config files can be loaded concurrently.
+ * @param file The config file whose game should be loaded.
+ * @param cli_args The cli arguments of the batch.
+ */
+void batch_file_load(batch_file_t* file, const cli_args_t* cli_args);
+
+/**
+ * Loads the config files of the batch of the given loader (see batch_file_load) until every config file is claimed by a thread.
+ * @param loader The loader whose thread runs the function.
+ * @return 0 on success, 1 if no loader was given.
+ */
+int batch_loader_run(batch_loader_t* loader);
+
+/**
+ * Creates an empty batch.
+ * @return The created empty batch.
+ */
+batch_t batch_create_empty();
+
+/**
+ * Creates a batch for the config files of the given cli arguments expanding their glob patterns.
+ * Patterns that don't match any file are added as invalid config files.
+ * If the batch could not be allocated an appropriate error message is output on stderr and the program is terminated with exit code 1.
+ * @param cli_args The cli arguments containing the config files or glob patterns.
+ * @return The created batch.
+ */
+batch_t batch_create(const cli_args_t* cli_args);
+
+/**
+ * Frees the given batch freeing all of it's config files and resetting it to an empty batch.
+ * @param batch The batch that should be freed.
+ */
+void batch_free(batch_t* batch);
+
+/**
+ * Validates all config files of the given batch and loads their games concurrently on one thread per worker of the batch
+ * (see batch_file_load), the calling thread is one of them. Invalid config files are marked as invalid with the reason why.
+ * @param batch The batch whose config files should be validated.
+ * @param cli_args The cli arguments of the batch.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully validated all config files
+ *
+ * - 1 not both were given
+ *
+ * - 2 unable to allocate the loaders
+ */
+int batch_validate(batch_t* batch, const cli_args_t* cli_args);
+
+/**
+ * Simulates the games of all valid config files of the given validated batch on a shared pool of threads
+ * with the simulator_pool_run function and collects their statistics.
+ * @param batch The validated batch that should be run.
+ * @param cli_args The cli arguments of the batch.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran all valid games
+ *
+ * - 1 not both were given
+ *
+ * - 2 unable to run the thread pool
+ */
+int batch_run(batch_t* batch, const cli_args_t* cli_args);
+
+/**
+ * Prints the results of all config files of the given batch as one table keyed by the config file in the given format.
+ * @param batch The batch that should be printed.
+ * @param format The format of the printed table.
+ */
+void batch_print(const batch_t* batch, report_format_t format);
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "game.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define BOARD_MAGIC "SALSB\r\n\x1a"                 // The signature at the beginning of every board file (the line endings and EOF character detect text mode conversions)
+#define BOARD_MAGIC_SIZE 8ul                        // The number of bytes of the signature
+#define BOARD_VERSION 1u                            // The version of the board file layout, incremented whenever the layout or one of the stored structs changes
+#define BOARD_BYTE_ORDER 0x01020304u                // The value stored in the byte order of the compiling machine to detect boards compiled on machines with another byte order
+#define BOARD_ALIGNMENT 8ul                         // The alignment of every section of a board file in bytes
+#define BOARD_FLAG_EXACT_ENDING 1u                  // The flag indicating that the game must end by exactly landing on the last cell
+#define BOARD_CHECKSUM_SEED 0xcbf29ce484222325ull   // The initial value of a checksum (FNV-1a 64 bit offset basis)
+#define BOARD_CHECKSUM_PRIME 0x100000001b3ull       // The multiplier of a checksum (FNV-1a 64 bit prime)
+
+/**
+ * Struct for the header at the beginning of a board file.
+ * A board file stores a validated game in the in-memory layout of the game's die and tables, hence a loaded board is used in place
+ * from a read-only memory mapping without parsing, validation or copying. The header is followed by the sections
+ * (each aligned to BOARD_ALIGNMENT bytes and zero padded):
+ *
+ * - the side probabilities of the die (double[sidecount])
+ *
+ * - the alias table of the die (die_alias_t[sidecount])
+ *
+ * - the snakes and ladders in the order they were specified using 0 based cell indices (edge_t[edgecount])
+ *
+ * - the destinations of the snakes and ladders ordered by their starting cell (size_t[edgecount])
+ *
+ * - the jump table mapping each cell to the index of the snake or ladder starting in it (optional_size_t[width * height])
+ */
+typedef struct board_header_t {
+    char magic[BOARD_MAGIC_SIZE];       // The signature of board files (BOARD_MAGIC)
+    uint32_t version;                   // The version of the board file layout (BOARD_VERSION)
+    uint32_t byteorder;                 // BOARD_BYTE_ORDER stored in the byte order of the compiling machine
+    uint32_t wordsize;                  // The size of size_t on the compiling machine in bytes
+    uint32_t flags;                     // The bitwise ORed board flags (e.g. BOARD_FLAG_EXACT_ENDING)
+    uint64_t width;                     // The width of the playing field
+    uint64_t height;                    // The height of the playing field
+    uint64_t sidecount;                 // The number of sides of the die
+    uint64_t edgecount;                 // The number of snakes and ladders
+    uint64_t sidesoffset;               // The offset of the side probabilities section in bytes
+    uint64_t aliasoffset;               // The offset of the alias table section in bytes
+    uint64_t edgesoffset;               // The offset of the edge list section in bytes
+    uint64_t soldstsoffset;             // The offset of the snake and ladder destinations section in bytes
+    uint64_t solidxsoffset;             // The offset of the jump table section in bytes
+    uint64_t size;                      // The size of the whole board file in bytes
+    uint64_t checksum;                  // The checksum of all sections (everything after the header)
+    uint64_t headerchecksum;            // The checksum of the header up to this field
+} board_header_t;
+
+/**
+ * Struct for writing the sections of a board file while calculating their checksum.
+ */
+typedef struct board_writer_t {
+    FILE* file;                         // The file that is written
+    uint64_t size;                      // The number of bytes written so far
+    uint64_t checksum;                  // The checksum of the bytes written after the header so far
+    unsigned char pending[8];           // The bytes of an incomplete 64 bit word that are added to the checksum once the word is complete
+    size_t pendingsize;                 // The number of pending bytes
+    bool failed;                        // Indicates if a write failed
+} board_writer_t;
+
+/**
+ * Calculates the checksum of the given data continuing the given checksum.
+ * The data is hashed in 64 bit words with the FNV-1a algorithm (trailing bytes are hashed individually)
+ * which is fast enough to verify large boards at memory bandwidth.
+ * @param checksum The checksum that should be continued, BOARD_CHECKSUM_SEED for a new checksum.
+ * @param data The data that should be hashed.
+ * @param size The size of the data in bytes. It should be a multiple of 8 unless it is the last data of the checksum.
+ * @return The continued checksum.
+ */
+uint64_t board_checksum(uint64_t checksum, const void* data, size_t size);
+
+/**
+ * Calculates the size of a section with the given number of elements including the padding to the next section.
+ * @param count The number of elements of the section.
+ * @param elementsize The size of each element in bytes.
+ * @return The size of the section in bytes, UINT64_MAX if it overflows.
+ */
+uint64_t board_section_size(uint64_t count, uint64_t elementsize);
+
+/**
+ * Creates the header of a board file for the given game calculating the offsets of the sections and the size of the file.
+ * The checksums are not calculated.
+ * @param game The game whose board file header should be created.
+ * @return The created header, a header with size 0 if no game was given, it's tables are inconsistent with it's dimensions or the board file would be too large.
+ */
+board_header_t board_header_create(const game_t* game);
+
+/**
+ * Writes the given data to the board file of the given writer and adds it to the checksum.
+ * The checksum is calculated in 64 bit words regardless of how the data is split into writes.
+ * If a previous write failed no action is performed.
+ * @param writer The writer of the board file.
+ * @param data The data that should be written.
+ * @param size The size of the data in bytes.
+ * @return true if the data was written, false if not both were given or the data could not be written.
+ */
+bool board_write(board_writer_t* writer, const void* data, size_t size);
+
+/**
+ * Writes zero bytes to the board file of the given writer until the written size is aligned to BOARD_ALIGNMENT bytes.
+ * @param writer The writer of the board file.
+ * @return true if the padding was written, false otherwise.
+ */
+bool board_write_padding(board_writer_t* writer);
+
+/**
+ * Compiles the given validated game into a board file at the given path.
+ * The board is written to a temporary file in the same directory which then replaces the file at the given path,
+ * hence processes that mapped a previous version of the file keep using it undisturbed.
+ * @param game The game that should be compiled. It must have been validated (e.g. set up with the game_setup function).
+ * @param filepath The path of the board file.
+ * @return The error code.
+ *
+ * - 0 successfully compiled board
+ *
+ * - 1 not both were given
+ *
+ * - 2 board too large
+ *
+ * - 3 unable to create temporary file
+ *
+ * - 4 unable to write board file
+ *
+ * - 5 unable to replace board file
+ */
+int board_compile(const game_t* game, const char* filepath);
+
+/**
+ * Loads the game stored in the board file at the given path by mapping the file read-only into memory.
+ * The die and tables of the loaded game reference the mapping instead of being copied, hence the startup does not depend
+ * on the size of the board and processes loading the same board share it's pages. Only the header checksum and the offsets
+ * and sizes of the sections are verified, the sections are neither read nor validated again (use the board_verify function
+ * to verify their checksum). A board file whose header is consistent is trusted to be compiled from a valid game.
+ * The game is unmapped when it is freed with the game_free function.
+ * @param filepath The path of the board file.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully loaded board
+ *
+ * - 1 no filepath given
+ *
+ * - 2 unable to open board file
+ *
+ * - 3 not a board file
+ *
+ * - 4 board file version or machine (byte order, word size) not supported
+ *
+ * - 5 board file corrupted (header checksum mismatch or inconsistent sections)
+ *
+ * - 6 unable to map board file
+ *
+ * @return The loaded game, an empty game if the board could not be loaded.
+ */
+game_t board_load(const char* filepath, int* error);
+
+/**
+ * Verifies the checksum of all sections of the given game loaded with the board_load function.
+ * This reads the whole mapping, hence the time depends on the size of the board and every page is faulted in.
+ * @param game The loaded game that should be verified.
+ * @return true if the checksum of the sections matches the checksum stored in the header, false if not or the game was not loaded from a board file.
+ */
+bool board_verify(const game_t* game);
+
+/**
+ * Loads the game stored in the board file at the given path with the board_load function.
+ * If the board could not be loaded or verified an appropriate error message is output on stderr and the program is terminated with exit code 1.
+ * The game is not registered in the asset manager.
+ * @param filepath The path of the board file.
+ * @param verify Indicates if the checksum of the sections should be verified with the board_verify function.
+ * @return The loaded game.
+ */
+game_t board_setup(const char* filepath, bool verify);
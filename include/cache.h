@@ -0,0 +1,103 @@
+#pragma once
+
+#include "game.h"
+#include "statistics.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CACHE_ENTRY_EXTENSION ".partial"                // The extension of the entries of a result cache (partial statistics files)
+#define CACHE_LOCK_FILENAME ".lock"                     // The name of the file in the cache directory that is locked while an entry is updated
+
+/**
+ * Struct for the entry of a game in a result cache.
+ * A result cache is a directory containing the statistics of previously simulated games. Each entry is a partial statistics file
+ * (see partial.h) named after the canonical hash of the game (see game_hash) which stores the number of simulations, the histogram
+ * and the Welford accumulators, hence the statistics of new simulations of the same game can be merged into it.
+ */
+typedef struct cache_t {
+    char* filepath;                 // The path of the entry of the game, 0 if the cache is disabled
+    char* lockpath;                 // The path of the lock file of the cache directory
+    uint64_t key;                   // The canonical hash of the game and dice limit the entry is named after
+    size_t dicelimit;               // The maximum allowed number of dices in a simulation
+    size_t solcount;                // The number of snakes and ladders of the game
+} cache_t;
+
+/**
+ * Creates an empty (disabled) cache entry.
+ * @return The created empty cache entry.
+ */
+cache_t cache_create_empty();
+
+/**
+ * Creates the entry of the given game simulated with the given dice limit in the result cache at the given directory.
+ * The directory is created if it doesn't exist yet.
+ * @param dirpath The path of the cache directory.
+ * @param game The game whose entry should be created.
+ * @param dicelimit The maximum allowed number of dices in a simulation.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully created cache entry
+ *
+ * - 1 not both dirpath and game given
+ *
+ * - 2 unable to create cache directory
+ *
+ * - 3 unable to allocate paths or hash game
+ *
+ * @return The created cache entry, an empty cache entry if it could not be created.
+ */
+cache_t cache_create(const char* dirpath, const game_t* game, size_t dicelimit, int* error);
+
+/**
+ * Frees the given cache entry resetting it to an empty cache entry. The entry on disk is kept.
+ * @param cache The cache entry that should be freed.
+ */
+void cache_free(cache_t* cache);
+
+/**
+ * Loads the statistics stored in the given cache entry into the given empty statistics and finalizes them.
+ * @param cache The cache entry that should be loaded.
+ * @param stats The empty statistics the cached statistics are stored in.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully loaded cached statistics
+ *
+ * - 1 not all given or cache disabled
+ *
+ * - 2 no cached statistics
+ *
+ * - 3 entry corrupted or of another game
+ */
+int cache_load(const cache_t* cache, stats_t* stats);
+
+/**
+ * Checks wether the given cached statistics already contain the requested number of simulations or reach the requested target precision.
+ * @param stats The finalized cached statistics.
+ * @param simcount The requested number of simulations.
+ * @param targetprecision The targeted CI95 of the average number of dices, 0 if disabled.
+ * @return true if no further simulations are needed, false otherwise.
+ */
+bool cache_satisfies(const stats_t* stats, size_t simcount, double targetprecision);
+
+/**
+ * Merges the statistics currently stored in the given cache entry into the given statistics of new simulations of the game,
+ * finalizes them and stores them as the new entry. The cache directory is locked while the entry is updated,
+ * hence concurrent processes simulating the same game don't lose each other's simulations.
+ * The indices of the new simulations are counted after the cached ones.
+ * @param cache The cache entry that should be updated.
+ * @param stats The collected statistics of the new simulations which are replaced by the merged statistics.
+ * @param cachedsims The address the number of simulations merged from the cache should be stored in. If not given it is not stored.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully updated cache entry
+ *
+ * - 1 not all given or cache disabled
+ *
+ * - 2 unable to lock cache directory
+ *
+ * - 3 unable to merge cached statistics
+ *
+ * - 4 unable to write cache entry
+ */
+int cache_store(const cache_t* cache, stats_t* stats, size_t* cachedsims);
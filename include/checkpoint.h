@@ -0,0 +1,165 @@
+#pragma once
+
+#include "simulator.h"
+#include "statistics.h"
+#include "tsrand48.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CHECKPOINT_MAGIC "SALSC\r\n\x1a"                // The signature at the beginning of every checkpoint file (the line endings and EOF character detect text mode conversions)
+#define CHECKPOINT_MAGIC_SIZE 8ul                       // The number of bytes of the signature
+#define CHECKPOINT_VERSION 2u                           // The version of the checkpoint file layout, incremented whenever the layout or one of the stored structs changes
+#define CHECKPOINT_BYTE_ORDER 0x01020304u               // The value stored in the byte order of the writing machine to detect checkpoints written on machines with another byte order
+#define CHECKPOINT_FLAG_SEEDED 1u                       // The flag indicating that the simulations were run with a fixed seed
+
+/**
+ * Struct for the header at the beginning of a checkpoint file.
+ * A checkpoint stores the partial statistics of every worker of a simulator at a moment all workers were paused between two batches,
+ * hence every simulation is either contained in exactly one worker's statistics or was not run yet.
+ * The header is followed by one section per worker:
+ *
+ * - the state of the worker (checkpoint_worker_t)
+ *
+ * - the counts of the histogram of the number of dices (size_t[bucketcount])
+ *
+ * - the shortest dice sequence that lead to a win (size_t[shortestcount of the worker])
+ *
+ * - the summary statistics about the usage of each snake or ladder ordered by their starting cell (valstats_t[solcount])
+ */
+typedef struct checkpoint_header_t {
+    char magic[CHECKPOINT_MAGIC_SIZE];  // The signature of checkpoint files (CHECKPOINT_MAGIC)
+    uint32_t version;                   // The version of the checkpoint file layout (CHECKPOINT_VERSION)
+    uint32_t byteorder;                 // CHECKPOINT_BYTE_ORDER stored in the byte order of the writing machine
+    uint32_t wordsize;                  // The size of size_t on the writing machine in bytes
+    uint32_t flags;                     // The bitwise ORed checkpoint flags (e.g. CHECKPOINT_FLAG_SEEDED)
+    uint64_t fingerprint;               // The fingerprint of the simulated game including it's die (see checkpoint_fingerprint)
+    uint64_t seed;                      // The fixed seed of the simulations, 0 if not seeded
+    uint64_t shard;                     // The 0 based index of the shard of the simulations
+    uint64_t shardcount;                // The number of shards the simulations are split into
+    uint64_t simcount;                  // The maximum number of simulations
+    uint64_t dicelimit;                 // The maximum allowed number of dices in a simulation
+    uint64_t workercount;               // The number of workers
+    uint64_t solcount;                  // The number of snakes and ladders
+    uint64_t bucketcount;               // The number of buckets of the histograms of the number of dices
+    double elapsed;                     // The number of seconds the simulations ran until the checkpoint was taken
+    valstats_t progress;                // The summary statistics about the number of dices published for the target precision
+    uint64_t size;                      // The size of the whole checkpoint file in bytes
+    uint64_t checksum;                  // The checksum of all worker sections (everything after the header)
+    uint64_t headerchecksum;            // The checksum of the header up to this field
+} checkpoint_header_t;
+
+/**
+ * Struct for the state of a worker stored in a checkpoint file.
+ */
+typedef struct checkpoint_worker_t {
+    uint64_t next;                      // The index of the next simulation of the worker (seeded simulations only)
+    uint64_t sims;                      // The number of simulations run by the worker
+    uint64_t wins;                      // The number of won games
+    uint64_t losses;                    // The number of lost games
+    uint64_t histtotal;                 // The number of values recorded in the histogram of the number of dices
+    uint64_t shortestcount;             // The length of the shortest dice sequence that lead to a win, 0 if none
+    uint64_t shortestindex;             // The index of the simulation of the shortest dice sequence
+    tsseed48_t seed;                    // The position in the worker's stream of random numbers (unseeded simulations only)
+    uint16_t hasseed;                   // 1 if the seed is set, 0 otherwise
+    valstats_t dices;                   // The summary statistics about the dices
+    valstats_t salsuses;                // The summary statistics about the number of used snakes and ladders
+    valstats_t snakesuses;              // The summary statistics about the number of used snakes
+    valstats_t laddersuses;             // The summary statistics about the number of used ladders
+} checkpoint_worker_t;
+
+/**
+ * Struct for the checkpoints of a simulation run.
+ */
+typedef struct checkpoint_t {
+    const char* filepath;               // The path of the checkpoint file, 0 if checkpoints are disabled
+    double interval;                    // The number of seconds between two checkpoints
+    bool resume;                        // Indicates if the simulations should continue from the checkpoint file
+    double last;                        // The number of seconds the simulations ran when the last checkpoint was taken
+    size_t count;                       // The number of checkpoints written
+} checkpoint_t;
+
+/**
+ * Creates an empty (disabled) checkpoint.
+ * @return The created empty checkpoint.
+ */
+checkpoint_t checkpoint_create_empty();
+
+/**
+ * Creates the checkpoints of a simulation run which are written to the given file.
+ * @param filepath The path of the checkpoint file.
+ * @param interval The number of seconds between two checkpoints.
+ * @param resume Indicates if the simulations should continue from the checkpoint file.
+ * @return The created checkpoint.
+ */
+checkpoint_t checkpoint_create(const char* filepath, double interval, bool resume);
+
+/**
+ * Calculates the fingerprint of the given game from it's dimensions, ending, snakes and ladders and die.
+ * @param game The game whose fingerprint should be calculated.
+ * @return The fingerprint, 0 if no game was given.
+ */
+uint64_t checkpoint_fingerprint(const game_t* game);
+
+/**
+ * Writes the partial statistics of all workers of the given simulator to the checkpoint file.
+ * The workers must be paused or finished. The checkpoint is written to a temporary file in the same directory
+ * which then replaces the checkpoint file, hence the checkpoint file is always complete even if the process is killed while writing.
+ * @param checkpoint The checkpoint whose file should be written.
+ * @param simulator The simulator whose state should be stored.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully wrote checkpoint
+ *
+ * - 1 not both given or checkpoints disabled
+ *
+ * - 2 unable to create temporary file
+ *
+ * - 3 unable to write checkpoint file
+ *
+ * - 4 unable to replace checkpoint file
+ */
+int checkpoint_write(checkpoint_t* checkpoint, const simulator_t* simulator);
+
+/**
+ * Writes the checkpoint file with the checkpoint_write function and remembers the time it was taken.
+ * If the checkpoint could not be written a warning is output on stderr, the simulations continue regardless.
+ * @param checkpoint The checkpoint whose file should be written.
+ * @param simulator The simulator whose state should be stored. The workers must be paused or finished.
+ * @param elapsed The number of seconds the simulations ran.
+ */
+void checkpoint_take(checkpoint_t* checkpoint, simulator_t* simulator, double elapsed);
+
+/**
+ * Restores the state of the given simulator from the checkpoint file. The simulator must have been created
+ * with the same game, number of simulations, dice limit, seed and shard as the simulator the checkpoint was taken of
+ * and it's workers must not have been run. The number of workers is adjusted to the checkpoint.
+ * @param checkpoint The checkpoint whose file should be read.
+ * @param simulator The simulator whose state should be restored.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully restored simulator
+ *
+ * - 1 not both given or checkpoints disabled
+ *
+ * - 2 unable to open checkpoint file
+ *
+ * - 3 not a checkpoint file
+ *
+ * - 4 checkpoint version or machine (byte order, word size) not supported
+ *
+ * - 5 checkpoint corrupted (inconsistent size or checksum mismatch)
+ *
+ * - 6 checkpoint taken of another game, number of simulations, dice limit, seed or shard
+ *
+ * - 7 unable to restore workers
+ */
+int checkpoint_load(checkpoint_t* checkpoint, simulator_t* simulator);
+
+/**
+ * Restores the state of the given simulator from the checkpoint file with the checkpoint_load function.
+ * If the simulator could not be restored an appropriate error message is output on stderr and the program is terminated with exit code 1.
+ * @param checkpoint The checkpoint whose file should be read.
+ * @param simulator The simulator whose state should be restored.
+ */
+void checkpoint_resume(checkpoint_t* checkpoint, simulator_t* simulator);
@@ -2,8 +2,13 @@
 
 #include "distribution.h"
 #include "game.h"
+#include "generator.h"
+#include "records.h"
+#include "report.h"
 #include "snakeorladder.h"
+#include "sweep.h"
 
+#include <float.h>
 #include <getopt.h>
 #include <limits.h>
 #include <stdbool.h>
@@ -32,6 +37,32 @@
 #define OPTVAL_BAR_LENGTH_DEFAULT 50ul                                      // The default length of the bars that visualize the probability of each side of the used die
 #define OPTVAL_BAR_LENGTH_MIN 1ul                                           // The minimum length of the bars that visualize the probability of each side of the used die
 #define OPTVAL_BAR_LENGTH_MAX ULONG_MAX                                     // The maximum length of the bars that visualize the probability of each side of the used die
+#define OPTVAL_TARGET_PRECISION_DEFAULT 0.0                                 // The default target precision (0 runs the fixed number of iterations)
+#define OPTVAL_TARGET_PRECISION_MIN DBL_MIN                                 // The minimum half-width of the 95% confidence interval of the average number of dices
+#define OPTVAL_TARGET_PRECISION_MAX DBL_MAX                                 // The maximum half-width of the 95% confidence interval of the average number of dices
+#define OPTVAL_TIME_LIMIT_DEFAULT 0.0                                       // The default time limit in seconds (0 disables the time limit)
+#define OPTVAL_TIME_LIMIT_MIN DBL_MIN                                       // The minimum time limit in seconds
+#define OPTVAL_TIME_LIMIT_MAX 1e9                                           // The maximum time limit in seconds (about 31 years)
+#define OPTVAL_REPORT_FORMAT_DEFAULT REPORT_FORMAT_CSV                      // The default format of machine-readable reports
+#define OPTVAL_RECORDS_FORMAT_DEFAULT RECORDS_FORMAT_BINARY                 // The default format of the per-simulation records file
+#define OPTVAL_CHECKPOINT_INTERVAL_DEFAULT 60.0                             // The default number of seconds between two checkpoints
+#define OPTVAL_CHECKPOINT_INTERVAL_MIN 1e-3                                 // The minimum number of seconds between two checkpoints
+#define OPTVAL_CHECKPOINT_INTERVAL_MAX 1e9                                  // The maximum number of seconds between two checkpoints (about 31 years)
+#define OPTVAL_SEED_MIN 0ul                                                 // The minimum seed of the simulations
+#define OPTVAL_SEED_MAX ULONG_MAX                                           // The maximum seed of the simulations
+#define OPTVAL_SHARD_COUNT_MAX 1000000ul                                    // The maximum number of shards the simulations can be split into
+#define OPTVAL_WORKERS_DEFAULT 0ul                                          // The default number of workers (0 runs one worker per online processor)
+#define OPTVAL_WORKERS_MIN 1ul                                              // The minimum number of workers
+#define OPTVAL_WORKERS_MAX 4096ul                                           // The maximum number of workers
+#define OPTVAL_SAL_DENSITY_DEFAULT 0.05                                     // The default number of generated snakes and ladders per cell
+#define OPTVAL_SAL_DENSITY_MIN DBL_MIN                                      // The minimum number of generated snakes and ladders per cell
+#define OPTVAL_SAL_DENSITY_MAX GENERATOR_DENSITY_MAX                        // The maximum number of generated snakes and ladders per cell
+#define OPTVAL_SAL_LENGTHS_DEFAULT (generator_lengths_t){ GENERATOR_LENGTHS_GEOMETRIC, 0 } // The default distribution of the lengths of generated snakes and ladders
+
+#define CLI_SUBCOMMAND_MERGE "merge"                                        // The first argument that merges partial statistics files instead of simulating
+#define CLI_SUBCOMMAND_GENERATE "generate"                                  // The first argument that generates random snakes and ladders instead of simulating
+
+#define CLI_CONFIGFILE_READ_BUFFER_SIZE 4096ul                              // The number of bytes read at once from config files that can't be memory mapped
 
 /**
  * Flags for every cli argument setting.
@@ -49,12 +80,41 @@ typedef enum cli_args_flag_t {
     CLIAFLAG_DICE_LIMIT       = 1 << 8,
     CLIAFLAG_BAR_LENGTH       = 1 << 9,
     CLIAFLAG_SNAKESANDLADDERS = 1 << 10,
+    CLIAFLAG_TARGET_PRECISION = 1 << 11,
+    CLIAFLAG_TIME_LIMIT       = 1 << 12,
+    CLIAFLAG_SWEEP            = 1 << 13,
+    CLIAFLAG_REPORT_FORMAT    = 1 << 14,
+    CLIAFLAG_BATCH            = 1 << 15,
+    CLIAFLAG_COMPILE_BOARD    = 1 << 16,
+    CLIAFLAG_BOARD            = 1 << 17,
+    CLIAFLAG_EMIT_RECORDS     = 1 << 18,
+    CLIAFLAG_RECORDS_FORMAT   = 1 << 19,
+    CLIAFLAG_RECORDS_TRACE    = 1 << 20,
+    CLIAFLAG_REPLAY           = 1 << 21,
+    CLIAFLAG_CHECKPOINT       = 1 << 22,
+    CLIAFLAG_CHECKPOINT_INTERVAL = 1 << 23,
+    CLIAFLAG_RESUME           = 1 << 24,
+    CLIAFLAG_SEED             = 1 << 25,
+    CLIAFLAG_SHARD            = 1 << 26,
+    CLIAFLAG_PARTIAL_OUT      = 1 << 27,
+    CLIAFLAG_MERGE            = 1 << 28,
+    CLIAFLAG_SERVE            = 1 << 29,
+    CLIAFLAG_CACHE            = 1 << 30,
+    CLIAFLAG_TIMINGS          = 1ul << 31,
+    CLIAFLAG_PERF_COUNTERS    = 1ul << 32,
+    CLIAFLAG_ALLOCATIONS      = 1ul << 33,
+    CLIAFLAG_WORKERS          = 1ul << 34,
+    CLIAFLAG_GENERATE         = 1ul << 35,
+    CLIAFLAG_SAL_DENSITY      = 1ul << 36,
+    CLIAFLAG_SAL_LENGTHS      = 1ul << 37,
+    CLIAFLAG_BENCH_DIE        = 1ul << 38,
+    CLIAFLAG_VERIFY_BOARD     = 1ul << 39,
 } cli_args_flag_t;
 
 /**
  * Type used to store multiple cli_args_flag_ts (bitwise ORed)
  */
-typedef uint16_t cli_args_flags_t; 
+typedef uint64_t cli_args_flags_t; 
 
 /**
  * Command line interface arguments.
@@ -63,6 +123,7 @@ typedef uint16_t cli_args_flags_t;
 typedef struct cli_args_t {
     cli_args_flags_t setargsflags;          // Flags that indicate which values where set by the user (bitwise ORed cli_args_flag_ts)
     char* configfile;                       // The filepath of the configuration file
+    size_t configs;                         // The number of parsed configurations (the arguments themselves and every config file they read)
     size_t width;                           // The width of the playing field
     size_t height;                          // The height of the playing field
     size_t die_sides;                       // The number of sides the used die has
@@ -71,7 +132,39 @@ typedef struct cli_args_t {
     size_t iterations;                      // The number of times the game should be simulated
     size_t dicelimit;                       // The number of times a simulation is allowed to dice before resigning if the game wasn't won yet
     size_t barlength;                       // The length of the bars that visualize the probability of each side of the used die
+    double targetprecision;                 // The half-width of the 95% confidence interval of the average number of dices at which the simulations stop (0 if disabled)
+    double timelimit;                       // The number of seconds after which the simulations stop (0 if disabled)
+    report_format_t reportformat;           // The format of machine-readable reports (e.g. the result table of a sweep)
     array_t snakesandladders;               // The snakes and ladders specified in the cli arguments and/or in the config file (element type: snakeorladder_t)
+    array_t sweepparams;                    // The swept game parameters, empty if no sweep should be run (element type: sweep_param_t)
+    array_t batchfiles;                     // The config file paths or glob patterns of a batch referencing the argv strings, empty if no batch should be run (element type: char*)
+    char* compileboard;                     // The filepath the validated game should be compiled to instead of simulating it (referencing the argv string), 0 if disabled
+    char* board;                            // The filepath of the compiled board the game should be loaded from (referencing the argv string), 0 if disabled
+    bool verifyboard;                       // Indicates if the checksum of all sections of the loaded board should be verified
+    char* records;                          // The filepath the result of every simulation should be written to (referencing the argv string), 0 if disabled
+    records_format_t recordsformat;         // The format of the records file
+    bool recordstrace;                      // Indicates if the diced sides of every simulation should be written to the records file
+    char* replay;                           // The filepath of the trace archive a simulation should be replayed from instead of simulating (referencing the argv string), 0 if disabled
+    size_t replayindex;                     // The index of the simulation that should be replayed
+    char* checkpoint;                       // The filepath the partial results should be checkpointed to periodically (referencing the argv string), 0 if disabled
+    double checkpointinterval;              // The number of seconds between two checkpoints
+    bool resume;                            // Indicates if the simulations should continue from the checkpoint file
+    bool seeded;                            // Indicates if the simulations should be rolled with streams derived from the seed
+    uint64_t seed;                          // The seed the streams of the simulations are derived from (if seeded)
+    size_t shard;                           // The 0 based index of the shard of the simulations that should be run
+    size_t shardcount;                      // The number of shards the simulations are split into, 1 if not sharded
+    char* partialout;                       // The filepath the partial statistics of the shard should be written to (referencing the argv string), 0 if disabled
+    array_t mergefiles;                     // The partial statistics files that should be merged referencing the argv strings, empty if not merging (element type: char*)
+    char* serve;                            // The endpoint requests should be served on instead of simulating (referencing the argv string), 0 if disabled
+    char* cache;                            // The directory of the result cache the statistics are loaded from and merged into (referencing the argv string), 0 if disabled
+    bool timings;                           // Indicates if the phases of the run and the workers should be timed and printed
+    bool perfcounters;                      // Indicates if the hardware events of the simulations should be counted and printed
+    bool allocations;                       // Indicates if the accounted allocations and the peak resident set size should be printed at exit
+    size_t workers;                         // The number of workers the simulations run on, 0 for one worker per online processor
+    double saldensity;                      // The number of snakes and ladders per cell the generate subcommand generates
+    generator_lengths_t sallengths;         // The distribution of the lengths of the snakes and ladders the generate subcommand generates
+    char* generatefile;                     // The filepath the generated config should be written to (referencing the argv string), 0 for stdout
+    bool benchdie;                          // Indicates if the samplers and random number backends of the die should be benchmarked instead of simulating
 } cli_args_t;
 
 /**
@@ -80,6 +173,10 @@ typedef struct cli_args_t {
 typedef struct cli_configfile_args_t {
     int argc;               // The number of elements in argv
     char** argv;            // The array containing the config file contents split into arguments.
+    char* content;          // The config file content the arguments were tokenized in place in (element 0 of argv is the filepath instead)
+    size_t contentsize;     // The size of the content in bytes
+    bool mapped;            // Indicates if the content is a private memory mapping of the file (otherwise it was read into allocated memory)
+    char* tail;             // The copy of the last argument if it ends at the end of the content where it's null-terminator doesn't fit, 0 otherwise
 } cli_configfile_args_t;
 
 /**
@@ -140,7 +237,7 @@ void cli_args_free(cli_args_t* cli_args);
  * It's parameter initoptind is set to 1 and isconfigfile is set to false.
  * @param argc The argument count.
  * @param argv The argument values that should be parsed.
- * @return The parsed arguments.
+ * @return The parsed arguments which must be freed with the cli_args_free function.
  */
 cli_args_t cli_parse(int argc, char* argv[]);
 
@@ -151,7 +248,7 @@ cli_args_t cli_parse(int argc, char* argv[]);
  * @param intioptind The index of the first argument in the argv array that should be parsed.
  * The default is 1 which skips the first argument (because this is commonly the program path).
  * @param isconfigfile Indicates whether these arguments came from a config file. If so the -c, --config-file option is disabled.
- * @return The parsed arguments.
+ * @return The parsed arguments which must be freed with the cli_args_free function.
  */
 cli_args_t cli_parse_args(int argc, char* argv[], int initoptind, bool isconfigfile);
 
@@ -181,16 +278,24 @@ void cli_help();
 
 /**
  * Reads the file at the given filepath and stores it's content in cli_configfile_args_t format.
+ * Regular files are memory mapped privately (copy-on-write) and the arguments are tokenized in place, hence no memory is allocated per argument
+ * and the time to read the file scales linearly with it's size. Files that can't be mapped (e.g. pipes) are read into memory instead.
  * If no filepath was given no action is performed.
  * If the file could not be read an appropriate error message is output on stderr and the program terminates with exit code 1.
- * @param filepath The path of the file that should be read.
- * @return The read configfile arguments. 
+ * @param filepath The path of the file that should be read. It must outlive the returned arguments because it is referenced as element 0 of argv.
+ * @return The read configfile arguments which must be freed with the cli_configfile_args_free function.
  */
 cli_configfile_args_t cli_read_configfile(const char* filepath);
 
 /**
- * Reads the next argument from the file. The reading process starts at the current position in the file.
- * The file content is split similarly to how a linux command prompt like bash splits input.
+ * Frees the given configfile arguments unmapping or freeing their content and freeing their argv array.
+ * @param config_args The configfile arguments that should be freed.
+ */
+void cli_configfile_args_free(cli_configfile_args_t* config_args);
+
+/**
+ * Reads the next argument from the given config file content beginning at the given offset.
+ * The content is split similarly to how a linux command prompt like bash splits input.
  * First, all whitespace characters (checked with the iswhitespace function) are skipped.
  * The value is read until another whitespace character is found.
  * If the value is quoted meaning it contains a quotation mark character " or ' the quoted section ends at the
@@ -199,24 +304,26 @@ cli_configfile_args_t cli_read_configfile(const char* filepath);
  * The beginning and ending quotation marks of quoted sections of a value are not included in the value.
  * Outside quoted sections characters can be escaped with the escape character (backslash \).
  * This allows for values that contain whitespace characters and/or quotation marks as part of the value.
- * @param file The file to read the argument from.
- * @param argsstr (optional) The string the read argument is appended to. The array must have elementsize == 1 or 0 (defaults to 1).
- * If not given a new string is allocated and ownership is transferred to the user.
- * @param pos (optional) The file position. If it is given it is used to error messaging when an error occurs.
+ * The quotation marks and escape characters are removed in place by moving the following characters of the value forward,
+ * the value is not null-terminated. The character after the value (content[offset - 1] or beyond) is not part of any value anymore,
+ * hence the caller can null-terminate the value there unless the value ends at the end of the content.
+ * @param content The writable config file content to read the argument from.
+ * @param size The size of the content in bytes.
+ * @param offset The address of the offset the reading starts at. It is advanced behind the read argument.
+ * @param length The address the length of the read argument should be stored at.
+ * @param pos (optional) The file position. If it is given it is advanced and used to error messaging when an error occurs,
+ * otherwise nothing is printed and the error is only reported by the error code.
  * @param error (optional) The address the error code should be stored at. If not given the error code is not stored.
- * 
+ *
  * - 0 successfully read argument.
- * 
- * - 1 unable to add character to the argument
- * 
- * - 2 argument ended in escape mode
- * 
- * - 3 argument ended with unclosed quoted section
- * @return The read argument value, 0 if no file was given or it does not contain a value at/after the
- * current file position or if the value ended in escape mode or with an unclosed quoted section.
- * If argsstr is not given the ownership of the newly allocated string is transferred to the user. 
+ *
+ * - 1 argument ended in escape mode
+ *
+ * - 2 argument ended with unclosed quoted section
+ * @return The start of the read argument value inside the content, 0 if no content, offset or length was given or the content does not contain
+ * a value at/after the offset or if the value ended in escape mode or with an unclosed quoted section.
  */
-char* cli_read_configfile_arg(FILE* file, array_t* argsstr, filepos_t* pos, int* error);
+char* cli_read_configfile_arg(char* content, size_t size, size_t* offset, size_t* length, filepos_t* pos, int* error);
 
 /**
  * Parses the value of the just previously read option opt to a uint64 requiring it to lie in the interval [valmin, valmax] (inclusive).
@@ -228,6 +335,16 @@ char* cli_read_configfile_arg(FILE* file, array_t* argsstr, filepos_t* pos, int*
  */
 uint64_t cli_parse_opt_uint64(char opt, uint64_t valmin, uint64_t valmax);
 
+/**
+ * Parses the value of the just previously read option opt to a double requiring it to lie in the interval [valmin, valmax] (inclusive).
+ * The parsed string is read from the global variable optarg
+ * @param opt The just previously read option.
+ * @param valmin The minimum allowed value.
+ * @param valmax The maximum allowed value.
+ * @return The parsed value.
+ */
+double cli_parse_opt_double(char opt, double valmin, double valmax);
+
 /**
  * Reads and parses the snakes and ladders in the given argv array of size argc beginning at index 0.
  * All parsed snakes and ladders are added to the args->snakesandladders array.
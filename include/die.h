@@ -2,11 +2,22 @@
 
 #include "distribution.h"
 
+/**
+ * Struct for a column of a die's alias table.
+ */
+typedef struct die_alias_t {
+    double prob;            // The probability of dicing the column's own side instead of it's alias once the column was picked
+    size_t alias;           // The 0 based index of the side that is diced otherwise
+} die_alias_t;
+
 /**
  * Struct for a die.
+ * Besides the probability of each side the die stores an alias table (Vose's alias method)
+ * with one column per side which allows dicing in constant time regardless of the number of sides.
  */
 typedef struct die_t {
     array_t sides;          // probabilities for all sides of the die (element type: double)
+    array_t alias;          // alias table with one column per side of the die (element type: die_alias_t)
 } die_t;
 
 /**
@@ -16,14 +27,14 @@ typedef struct die_t {
 die_t die_create_empty();
 
 /**
- * Creates a die with the given distribution.
+ * Creates a die with the given distribution calculating the probability of each side and building the alias table.
  * @param distr The distribution that should be used.
- * @return The created die.
+ * @return The created die, an empty die if the distribution's weight sum is 0 or the die could not be allocated.
  */
 die_t die_create(const distribution_t* distr);
 
 /**
- * Frees the given die freeing it's array of side probabilities.
+ * Frees the given die freeing it's arrays of side probabilities and alias table columns.
  * @param die The die that should be freed.
  */
 void die_free(die_t* die);
@@ -37,6 +48,7 @@ bool die_isempty(const die_t* die);
 
 /**
  * Dices the given die thread-safely generating a random die side with the distribution according to the die's side probabilities.
+ * A column of the alias table is picked uniformly and the fraction of the same random number decides between it's side and it's alias.
  * Possible side values lie in the interval [1, die->sides.size] (1 based indexing meaning the first side of the die has index 1, not 0).
  * @param die The die that should be diced.
  * @return The diced side.
@@ -44,11 +56,13 @@ bool die_isempty(const die_t* die);
 size_t dice(const die_t* die);
 
 /**
- * Uses the given die the given number of times and prints a summary of the diced sides.
- * @param die The die that should be used to dice.
- * @param iterations The number of times the die should be diced.
+ * Picks the side of the given die the given uniformly distributed random number stands for using the alias table (see dice).
+ * Separated from the random number generator, hence other generators can be benchmarked with the same sampler (see diebench_t).
+ * @param die The die that should be diced.
+ * @param random The random number in the interval [0.0, 1.0).
+ * @return The diced side in the interval [1, die->sides.size].
  */
-void simulate_dices(const die_t* die, size_t iterations);
+size_t die_sample(const die_t* die, double random);
 
 /**
  * Prints the given die.
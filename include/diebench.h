@@ -0,0 +1,208 @@
+#pragma once
+
+#include "die.h"
+#include "report.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <threads.h>
+
+#define DIEBENCH_SAMPLER_COUNT 2
+#define DIEBENCH_BACKEND_COUNT 2
+#define DIEBENCH_ROLLS_DEFAULT 10000000ul       // The default number of rolls per measurement if -i, --iterations is not set
+#define DIEBENCH_SEED 1ul                       // The default seed of the rolls, hence every run tests the same rolls
+#define DIEBENCH_ALPHA 0.001                    // The significance level below which a test rejects the sampler
+#define DIEBENCH_TABLE_ERROR_MAX 1e-12          // The maximum deviation of the probabilities implied by a sampler's table from the die's probabilities
+
+// forward declarations
+typedef struct diebench_t diebench_t;
+
+/**
+ * Function pointer type of a sampler picking the side of the die of the given benchmark a uniformly distributed random number stands for.
+ * @param bench The benchmark whose die should be diced.
+ * @param random The random number in the interval [0.0, 1.0).
+ * @return The diced side in the interval [1, sides].
+ */
+typedef size_t (*diebench_sampler_fn_t)(const diebench_t* bench, double random);
+
+/**
+ * Function pointer type of a random number generator backend of the calling thread.
+ * @return A uniformly distributed random number in the interval [0.0, 1.0).
+ */
+typedef double (*diebench_backend_fn_t)();
+
+/**
+ * Struct to store information about a sampler.
+ */
+typedef struct diebench_sampler_info_t {
+    char* name;                         // The name of the sampler
+    diebench_sampler_fn_t sample;       // The function picking the side
+} diebench_sampler_info_t;
+
+/**
+ * Struct to store information about a random number generator backend.
+ */
+typedef struct diebench_backend_info_t {
+    char* name;                         // The name of the backend
+    size_t bits;                        // The number of random bits of the generated numbers
+    diebench_backend_fn_t uniform;      // The function generating the random numbers
+} diebench_backend_info_t;
+
+// Information about each sampler, the first one is the sampler of dice
+extern diebench_sampler_info_t diebench_sampler_infos[DIEBENCH_SAMPLER_COUNT];
+
+// Information about each random number generator backend, the first one is the backend of dice
+extern diebench_backend_info_t diebench_backend_infos[DIEBENCH_BACKEND_COUNT];
+
+/**
+ * Struct for the measured throughput and the tests of a combination of sampler and backend.
+ */
+typedef struct diebench_result_t {
+    size_t sampler;                     // The index of the sampler in diebench_sampler_infos
+    size_t backend;                     // The index of the backend in diebench_backend_infos
+    double single;                      // The rolls per second on one thread
+    double multi;                       // The rolls per second of all threads together
+    double tableerror;                  // The largest deviation of the probabilities implied by the sampler's table from the die's probabilities
+    double chisquare;                   // The chi-square statistic of the counted sides against the die's probabilities
+    size_t df;                          // The degrees of freedom of the chi-square test (the sides with a probability > 0 minus 1)
+    double chisquarep;                  // The p-value of the chi-square goodness-of-fit test
+    double serial;                      // The lag-1 serial correlation of consecutive rolls
+    double serialp;                     // The p-value of the serial correlation test (two-sided, normal approximation)
+    bool passed;                        // Indicates if the table is exact and neither test rejected at DIEBENCH_ALPHA
+} diebench_result_t;
+
+/**
+ * Struct for a benchmark of the samplers and random number generator backends of a die.
+ */
+typedef struct diebench_t {
+    const die_t* die;                   // The benchmarked die
+    array_t cdf;                        // The cumulative probabilities of the sides used by the cdf sampler (element type: double)
+    size_t rolls;                       // The number of rolls per measurement and test
+    size_t threads;                     // The number of threads of the multi-threaded measurement
+    uint64_t seed;                      // The seed the random number streams of the threads are derived from
+    diebench_result_t results[DIEBENCH_SAMPLER_COUNT * DIEBENCH_BACKEND_COUNT]; // The results of each combination of sampler and backend
+} diebench_t;
+
+/**
+ * Struct for a thread of a multi-threaded measurement.
+ */
+typedef struct diebench_thread_t {
+    const diebench_t* bench;            // The benchmark
+    diebench_sampler_fn_t sample;       // The measured sampler
+    diebench_backend_fn_t uniform;      // The measured backend
+    size_t rolls;                       // The number of rolls of the thread
+    uint64_t stream;                    // The index of the random number stream of the thread
+    size_t sink;                        // The sum of the diced sides, hence the compiler can't optimize the rolls away
+    thrd_t thread;                      // The identifier of the thread
+    bool started;                       // Indicates if the thread was started successfully
+} diebench_thread_t;
+
+/**
+ * Creates a benchmark of the given die building the cumulative probabilities of the cdf sampler.
+ * @param die The die that should be benchmarked. It must outlive the benchmark.
+ * @param rolls The number of rolls per measurement and test, at least 1.
+ * @param threads The number of threads of the multi-threaded measurement, at least 1.
+ * @param seed The seed the random number streams are derived from.
+ * @return The created benchmark, a benchmark without cumulative probabilities if they could not be allocated.
+ */
+diebench_t diebench_create(const die_t* die, size_t rolls, size_t threads, uint64_t seed);
+
+/**
+ * Frees the given benchmark freeing it's cumulative probabilities.
+ * @param bench The benchmark that should be freed.
+ */
+void diebench_free(diebench_t* bench);
+
+/**
+ * Samples the die with it's alias table in constant time (see die_sample), the sampler of dice.
+ */
+size_t diebench_sample_alias(const diebench_t* bench, double random);
+
+/**
+ * Samples the die with a binary search for the first cumulative probability greater than the random number in O(log sides) time.
+ */
+size_t diebench_sample_cdf(const diebench_t* bench, double random);
+
+/**
+ * Generates a random number with all 48 bits of erand48 (see tserand48), the backend of dice.
+ */
+double diebench_uniform_erand48();
+
+/**
+ * Generates a random number from the upper 31 bits of nrand48 (see tsnrand48) scaled by 2^-31.
+ */
+double diebench_uniform_nrand48();
+
+/**
+ * Determines the largest deviation of the probabilities implied by the table of the given sampler from the probabilities of the die.
+ * The implied probabilities are derived from the alias table or the cumulative probabilities analytically, hence they are exact.
+ * @param bench The benchmark.
+ * @param sampler The index of the sampler in diebench_sampler_infos.
+ * @return The largest absolute deviation, INFINITY if the sampler is unknown or the table could not be checked.
+ */
+double diebench_table_error(const diebench_t* bench, size_t sampler);
+
+/**
+ * Rolls the die of the given thread it's number of times with it's random number stream.
+ * @param thread The thread that should roll.
+ * @return 0 on success, 1 if no thread was given.
+ */
+int diebench_thread_run(diebench_thread_t* thread);
+
+/**
+ * Measures the throughput of the given sampler and backend rolling bench->rolls times split evenly on the given number of threads.
+ * A single thread rolls on the calling thread.
+ * @param bench The benchmark.
+ * @param sampler The index of the sampler in diebench_sampler_infos.
+ * @param backend The index of the backend in diebench_backend_infos.
+ * @param threads The number of threads.
+ * @return The rolls per second, 0 if the threads could not be created.
+ */
+double diebench_measure(const diebench_t* bench, size_t sampler, size_t backend, size_t threads);
+
+/**
+ * Computes the p-value of the given chi-square statistic (the regularized upper incomplete gamma function Q(df / 2, chisquare / 2)).
+ * @param chisquare The chi-square statistic.
+ * @param df The degrees of freedom.
+ * @return The probability of a statistic at least as large under the null hypothesis, 1 if there are no degrees of freedom.
+ */
+double diebench_chisquare_p(double chisquare, size_t df);
+
+/**
+ * Rolls the given sampler and backend bench->rolls times on the calling thread and tests the counted sides with a chi-square goodness-of-fit test
+ * against the die's probabilities and the consecutive rolls with a lag-1 serial correlation test against the die's mean and variance.
+ * @param bench The benchmark.
+ * @param result The result the tests are stored in (it's sampler and backend must be set).
+ * @return true if the tests ran, false if no benchmark or result was given or the counts could not be allocated.
+ */
+bool diebench_test(const diebench_t* bench, diebench_result_t* result);
+
+/**
+ * Measures and tests every combination of sampler and backend.
+ * @param bench The benchmark.
+ * @return true if every combination was measured and tested, false otherwise.
+ */
+bool diebench_run(diebench_t* bench);
+
+/**
+ * Counts the combinations of sampler and backend of the given benchmark that failed the table check or a test.
+ * @param bench The benchmark.
+ * @return The number of failed combinations, 0 if no benchmark was given.
+ */
+size_t diebench_failed(const diebench_t* bench);
+
+/**
+ * Prints the results of the given benchmark as table.
+ * @param bench The benchmark.
+ */
+void diebench_print(const diebench_t* bench);
+
+/**
+ * Prints the results of the given benchmark as machine-readable report with one row per combination of sampler and backend.
+ * @param file The file the report should be printed to (e.g. stdout).
+ * @param bench The benchmark.
+ * @param format The format of the report.
+ */
+void diebench_print_report(FILE* file, const diebench_t* bench, report_format_t format);
@@ -80,6 +80,7 @@ void distr_free(distribution_t* distr);
  * <W1>,<W2>,<W3>,<W4>,...,<Wn>
  * 
  * Each weight must be a positive integer value. They must be separated by commas ','.
+ * The weights are parsed in place without allocating memory except for the array of weights.
  * @param str The string that should be converted.
  * @param error The address the error code should be stored in. If not given the error code is not stored.
  * 
@@ -87,7 +88,7 @@ void distr_free(distribution_t* distr);
  * 
  * - 1 no string given.
  * 
- * - 2 unable to duplicate string.
+ * - 2 unused (the string is not duplicated anymore).
  * 
  * - 3 weight value out of range (overflow/underflow).
  * 
@@ -95,6 +96,8 @@ void distr_free(distribution_t* distr);
  * 
  * - 5 remaining characters after number in weight string.
  * 
+ * - 7 unable to add weight.
+ * 
  * @return The distribution represented by the string, an empty distribution if the string could not be converted.
  */
 distribution_t strtodistr(const char* str, int* error);
@@ -2,21 +2,179 @@
 
 #include "die.h"
 #include "graph.h"
+#include "snakeorladder.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <threads.h>
 
 #define GAME_WIDTH_MIN 2lu
 #define GAME_HEIGHT_MIN 2lu
+#define GAME_CHECK_PARALLEL_MIN_SALS 65536ul    // The minimum number of snakes and ladders per thread that are validated on multiple threads
 
 // forward declarations
 typedef struct cli_args_t cli_args_t;
 
+/**
+ * Struct for an optional size_t. Can optionally have value of type size_t.
+ */
+typedef struct optional_size_t {
+    bool present;                   // Indicates if this optional has a value
+    size_t value;                   // The stored value
+} optional_size_t;
+
+/**
+ * Struct for a snakes and ladders game.
+ * The snakes and ladders are stored as edge list and as jump tables that map each cell to the snake or ladder starting in it in constant time.
+ * The die and the tables are either allocated or reference a read-only memory mapped board file (see board_load).
+ */
 typedef struct game_t {
     size_t width;           // The width of the playing field
     size_t height;          // The height of the playing field
     die_t die;              // The die to use while playing
     bool exact_ending;      // Indicates wether the game must end by exactly landing on the last cell
-    adjmat_t adjmat;        // The graph representing and connecting the cells of the playing field
+    array_t edges;          // The snakes and ladders in the order they were specified using 0 based cell indices (element type: edge_t)
+    array_t soldsts;        // The 0 based destination cells of the snakes and ladders ordered by their starting cell (element type: size_t)
+    array_t solidxs;        // Maps each 0 based cell index to the index of the snake or ladder starting in it in the soldsts array (element type: optional_size_t)
+    void* mapping;          // The memory mapped board file the die and the tables reference, 0 if they are allocated
+    size_t mappingsize;     // The size of the memory mapped board file in bytes
 } game_t;
 
+/**
+ * Struct for the occupancy of the cells of a playing field by snakes and ladders used to detect overlapping snakes and ladders
+ * in constant time per cell. Each occupied cell is mapped to the smallest index of the snakes and ladders starting or ending in it.
+ * If the playing field has at most a few cells per snake or ladder the cells are used as slot index directly,
+ * otherwise they are hashed into a table with a few slots per snake or ladder (open addressing with linear probing),
+ * hence the memory usage never depends on the number of cells of a sparse playing field.
+ * The slots are claimed atomically, thus multiple threads can occupy cells concurrently.
+ */
+typedef struct game_occupancy_t {
+    size_t capacity;                // The number of slots (a power of two if the cells are hashed)
+    bool hashed;                    // Indicates if the cells are hashed instead of being used as slot index
+    _Atomic size_t* cells;          // The 1 based cell each slot belongs to, 0 if the slot is empty (only allocated if the cells are hashed)
+    _Atomic size_t* owners;         // The smallest index of the snakes and ladders occupying each slot's cell, SIZE_MAX if none
+} game_occupancy_t;
+
+/**
+ * Struct for a thread validating a range of snakes and ladders (see game_check_sals).
+ */
+typedef struct game_check_thread_t {
+    const array_t* sals;            // The validated snakes and ladders (element type: snakeorladder_t)
+    game_occupancy_t* occupancy;    // The occupancy of the cells shared by all threads
+    size_t cellcount;               // The number of cells of the playing field
+    size_t first;                   // The index of the first snake or ladder validated by the thread
+    size_t last;                    // The index after the last snake or ladder validated by the thread
+    bool occupy;                    // Indicates if the thread should occupy the cells (first pass) or detect overlaps (second pass)
+    int error;                      // The error code of the first invalid snake or ladder of the range (see game_check_sals), 0 if none
+    size_t invalididx;              // The index of the first invalid snake or ladder of the range
+    size_t otheridx;                // The index of the snake or ladder the first invalid one overlaps with (error code 7)
+    thrd_t thread;                  // The identifier of the thread
+    bool started;                   // Indicates if the thread was started successfully
+} game_check_thread_t;
+
+/**
+ * Creates an empty cell occupancy for the given number of snakes and ladders on a playing field with the given number of cells.
+ * @param cellcount The number of cells of the playing field.
+ * @param salcount The number of snakes and ladders.
+ * @return The created occupancy, an occupancy with capacity 0 if it could not be allocated.
+ */
+game_occupancy_t game_occupancy_create(size_t cellcount, size_t salcount);
+
+/**
+ * Frees the given cell occupancy freeing it's slots and resetting it to an occupancy with capacity 0.
+ * @param occupancy The occupancy that should be freed.
+ */
+void game_occupancy_free(game_occupancy_t* occupancy);
+
+/**
+ * Determines the slot of the given cell, claiming an empty slot for it if requested. This function is thread-safe.
+ * @param occupancy The cell occupancy.
+ * @param cell The 1 based index of the cell. It must lie on the playing field the occupancy was created for.
+ * @param claim Indicates if an empty slot should be claimed if the cell has no slot yet.
+ * @return The owner of the cell's slot, 0 if the cell has no slot (and none was claimed or the table is full).
+ */
+_Atomic size_t* game_occupancy_slot(game_occupancy_t* occupancy, size_t cell, bool claim);
+
+/**
+ * Occupies the given cell by the snake or ladder with the given index keeping the smallest index of all snakes and ladders occupying it.
+ * This function is thread-safe.
+ * @param occupancy The cell occupancy.
+ * @param cell The 1 based index of the cell. It must lie on the playing field the occupancy was created for.
+ * @param index The index of the snake or ladder occupying the cell.
+ * @return true if the cell was occupied, false if no occupancy was given or it is full.
+ */
+bool game_occupancy_occupy(game_occupancy_t* occupancy, size_t cell, size_t index);
+
+/**
+ * Checks whether the given snake or ladder (1 based cell indices) lies on a playing field with the given number of cells
+ * without regard to other snakes and ladders.
+ * @param cellcount The number of cells of the playing field.
+ * @param sol The snake or ladder that should be checked.
+ * @return The error code as described by the game_check_sals function (0 or 2 to 6).
+ */
+int game_check_sol(size_t cellcount, const snakeorladder_t* sol);
+
+/**
+ * Runs a pass of the validation of the given thread's range of snakes and ladders.
+ * In the first pass the cells of the valid snakes and ladders are occupied and the first snake or ladder that doesn't lie on the
+ * playing field is determined. In the second pass the first snake or ladder that overlaps with one of a smaller index is determined.
+ * @param thread The thread whose range should be validated.
+ * @return 0 on success, 1 if no thread was given, 2 if the occupancy is full.
+ */
+int game_check_thread_run(game_check_thread_t* thread);
+
+/**
+ * Checks whether the given snakes and ladders (1 based cell indices) are valid on a playing field with the given number of cells.
+ * Overlaps are detected with a cell occupancy (see game_occupancy_t) in O(snakes and ladders) time.
+ * Very large numbers of snakes and ladders are validated on one thread per online processor.
+ * The reported snake or ladder is always the first invalid one in the given order as if they were validated one after another.
+ * @param cellcount The number of cells of the playing field.
+ * @param sals The snakes and ladders that should be checked (element type: snakeorladder_t).
+ * @param invalididx The address the index of the first invalid snake or ladder should be stored at. If not given it is not stored.
+ * @param otheridx The address the index of the snake or ladder the invalid one overlaps with should be stored at (error code 7). If not given it is not stored.
+ * @return The error code.
+ *
+ * - 0 all snakes and ladders are valid
+ *
+ * - 1 no snakes and ladders given
+ *
+ * - 2 a snake or ladder starts in a non-existant cell
+ *
+ * - 3 a snake or ladder ends in a non-existant cell
+ *
+ * - 4 a snake or ladder starts and ends in the same cell
+ *
+ * - 5 a snake or ladder starts in the last cell
+ *
+ * - 6 a snake or ladder ends in the last cell
+ *
+ * - 7 a snake or ladder overlaps with another snake or ladder
+ *
+ * - 8 unable to allocate the cell occupancy
+ */
+int game_check_sals(size_t cellcount, const array_t* sals, size_t* invalididx, size_t* otheridx);
+
+/**
+ * Builds the edge list and the jump tables of the given game from the given already validated snakes and ladders (see game_check_sals)
+ * in O(cells + snakes and ladders) time. The width and height of the game must be set.
+ * @param game The game whose edge list and jump tables should be built. Previously built tables are freed.
+ * @param sals The snakes and ladders of the playing field using 1 based cell indices (element type: snakeorladder_t).
+ * @return true if the tables were built, false if not both were given, the game references a board file or the tables could not be allocated.
+ */
+bool game_build_jumps(game_t* game, const array_t* sals);
+
+/**
+ * Creates a snakes and ladders game from the given already validated parameters (see game_check_sals).
+ * Unlike the game_setup function the program is not terminated on failure.
+ * @param width The width of the playing field.
+ * @param height The height of the playing field.
+ * @param distribution The built distribution of the die.
+ * @param exact_ending Indicates wether the game must end by exactly landing on the last cell.
+ * @param sals The snakes and ladders of the playing field using 1 based cell indices (element type: snakeorladder_t).
+ * @return The created game, an empty game if it could not be created.
+ */
+game_t game_create(size_t width, size_t height, const distribution_t* distribution, bool exact_ending, const array_t* sals);
+
 /**
  * Sets up a snakes and ladders game derived from the given cli arguments.
  * If the cli_args describe an invalid game an appropriate error message
@@ -27,7 +185,26 @@ typedef struct game_t {
 game_t game_setup(cli_args_t* cli_args);
 
 /**
- * Frees the given game freeing it's die and adjacency matrix and resetting it's width and height to 0.
+ * Compares the given snakes or ladders by their starting and ending cell (qsort comparator).
+ * @param a The first snake or ladder (edge_t).
+ * @param b The second snake or ladder (edge_t).
+ * @return A negative value if a starts (or ends if both start in the same cell) before b, a positive value if after, 0 if they are equal.
+ */
+int game_edge_compare(const void* a, const void* b);
+
+/**
+ * Computes the canonical hash of the given game simulated with the given dice limit.
+ * The hash covers the dimensions, the snakes and ladders ordered by their starting cell, the normalized probabilities of the die sides,
+ * the exact ending requirement and the dice limit, hence games that only differ in the order of their snakes and ladders or
+ * in proportional die weights (e.g. 1,1,2 and 2,2,4) have the same hash regardless of wether they were set up or loaded from a board file.
+ * @param game The game that should be hashed.
+ * @param dicelimit The maximum allowed number of dices in a simulation.
+ * @return The hash of the game, 0 if no game was given or the snakes and ladders could not be sorted.
+ */
+uint64_t game_hash(const game_t* game, size_t dicelimit);
+
+/**
+ * Frees the given game freeing it's die, edge list and jump tables (or unmapping the board file they reference) and resetting it to an empty game.
  * @param game The game that should be freed.
  */
 void game_free(game_t* game);
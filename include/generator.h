@@ -0,0 +1,157 @@
+#pragma once
+
+#include "array.h"
+#include "game.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define GENERATOR_LENGTHS_COUNT 2
+#define GENERATOR_DENSITY_MAX 0.4               // The maximum number of snakes and ladders per cell, hence at least a fifth of the cells stays free
+#define GENERATOR_SALS_PER_LINE 10ul            // The number of snakes and ladders written per line of a generated config file
+
+// forward declarations
+typedef struct cli_args_t cli_args_t;
+
+/**
+ * Enum to identify the distribution of the lengths of generated snakes and ladders.
+ */
+typedef enum generator_lengths_kind_t {
+    GENERATOR_LENGTHS_GEOMETRIC,        // Short jumps are most likely, the lengths follow a geometric distribution with the given mean
+    GENERATOR_LENGTHS_UNIFORM           // Every length from 1 up to the given maximum is equally likely
+} generator_lengths_kind_t;
+
+/**
+ * Struct to store information about a length distribution.
+ */
+typedef struct generator_lengths_info_t {
+    char* name;                         // The name of the length distribution
+} generator_lengths_info_t;
+
+// Information about each generator_lengths_kind_t value
+extern generator_lengths_info_t generator_lengths_infos[GENERATOR_LENGTHS_COUNT];
+
+/**
+ * Struct for the distribution of the lengths (number of cells between the starting and ending cell) of generated snakes and ladders.
+ */
+typedef struct generator_lengths_t {
+    generator_lengths_kind_t kind;      // The distribution of the lengths
+    size_t value;                       // The mean (geometric) or maximum (uniform) length, 0 for the width of the playing field
+} generator_lengths_t;
+
+/**
+ * Struct for the list of free cells of a playing field that snakes and ladders are placed on.
+ * The cells 1 to the cell before the last one start in the list at the position of their own index. A removed cell is swapped
+ * with the last free cell and the list is shortened (swap-remove), hence a random free cell is drawn in constant time and
+ * a cell is free if it's position lies within the list. Only the positions and cells that differ from the identity are stored
+ * in two game_occupancy_ts, hence the memory usage depends on the number of removed cells instead of the number of cells.
+ */
+typedef struct generator_free_cells_t {
+    size_t size;                        // The number of cells that can be free (all but the last one)
+    size_t count;                       // The number of free cells
+    game_occupancy_t cells;             // Maps the 1 based positions of the list to the cell at them if it isn't the identity
+    game_occupancy_t positions;         // Maps the cells to their 1 based position in the list if it isn't the identity
+} generator_free_cells_t;
+
+/**
+ * Creates the list of free cells of a playing field with the given number of cells (all but the last one are free).
+ * @param cellcount The number of cells of the playing field.
+ * @param removecount The maximum number of cells that are removed from the list.
+ * @return The created list, a list with 0 free cells if it could not be allocated.
+ */
+generator_free_cells_t generator_free_cells_create(size_t cellcount, size_t removecount);
+
+/**
+ * Frees the given list of free cells.
+ * @param freecells The list that should be freed.
+ */
+void generator_free_cells_free(generator_free_cells_t* freecells);
+
+/**
+ * Looks up the given key in the given map of a list of free cells.
+ * @param map The map of positions to cells or cells to positions.
+ * @param key The 1 based position or cell.
+ * @return The value stored for the key, the key itself if none is stored.
+ */
+size_t generator_free_cells_lookup(game_occupancy_t* map, size_t key);
+
+/**
+ * Checks whether the given cell is freecells.
+ * @param freecells The list of free cells.
+ * @param cell The 1 based index of the cell.
+ * @return true if the cell is in the list, false if it was removed or it is the last cell or beyond.
+ */
+bool generator_free_cells_contains(generator_free_cells_t* freecells, size_t cell);
+
+/**
+ * Removes the given free cell from the given list by swapping it with the last free cell.
+ * @param freecells The list of free cells.
+ * @param cell The 1 based index of the free cell.
+ * @return true if the cell was removed, false if the maps are full.
+ */
+bool generator_free_cells_remove(generator_free_cells_t* freecells, size_t cell);
+
+/**
+ * Parses the given string to a length distribution. Format: name[:value] where name is geometric or uniform and value is
+ * the positive mean or maximum length, e.g. geometric:100. If the value is omitted the width of the playing field is used.
+ * @param str The string that should be parsed.
+ * @param error The address where the error code should be stored if it is given.
+ *
+ * - 0 successfully parsed string
+ *
+ * - 1 no string given
+ *
+ * - 2 unknown length distribution
+ *
+ * - 3 invalid length (not a positive integer)
+ * @return The parsed length distribution, the geometric distribution with the default mean if the string could not be parsed.
+ */
+generator_lengths_t strtogenlengths(const char* str, int* error);
+
+/**
+ * Draws the length of a snake or ladder from the given length distribution with the random number generator of the calling thread.
+ * @param lengths The length distribution with a value that is not 0.
+ * @return The drawn length, at least 1.
+ */
+size_t generator_draw_length(const generator_lengths_t* lengths);
+
+/**
+ * Generates random snakes and ladders that are valid on a playing field of the given size (see game_check_sals): they don't overlap,
+ * and neither start nor end in the last cell. Half of them are ladders and half of them snakes on average.
+ * Each one draws a random starting cell from the list of free cells (see generator_free_cells_t) and a length from the given distribution.
+ * If the ending cell lies outside the playing field the other direction is taken (or the cell closest to the edge if neither fits)
+ * and if it is occupied the nearest free cell around it is taken instead, hence every placement succeeds as long as a free cell is left.
+ * At most GENERATOR_DENSITY_MAX snakes and ladders per cell occupy at most 80% of the cells, hence the nearest free cell is found after
+ * a few cells on average and generating takes O(snakes and ladders) time and memory regardless of the number of cells.
+ * The same seed always generates the same snakes and ladders.
+ * @param width The width of the playing field.
+ * @param height The height of the playing field.
+ * @param density The number of snakes and ladders per cell, at most GENERATOR_DENSITY_MAX.
+ * @param lengths The distribution of the lengths of the snakes and ladders.
+ * @param seed The seed the random number generator is seeded with.
+ * @param sals The array the generated snakes and ladders are added to using 1 based cell indices (element type: snakeorladder_t).
+ * @return The error code.
+ *
+ * - 0 successfully generated the snakes and ladders
+ *
+ * - 1 no length distribution or snakes and ladders given
+ *
+ * - 2 the density is not in (0, GENERATOR_DENSITY_MAX] or the playing field is too large
+ *
+ * - 3 unable to allocate the cell occupancy or snakes and ladders
+ *
+ * - 4 the playing field has too few cells for the snakes and ladders
+ */
+int generator_generate(size_t width, size_t height, double density, const generator_lengths_t* lengths, uint64_t seed, array_t* sals);
+
+/**
+ * Writes a config file with the game options of the given cli arguments (-x, -y, -s, -e, -d and the -i and -l options if set)
+ * followed by the given snakes and ladders, hence it can be run with -c or compiled with -o.
+ * @param file The file the config should be written to.
+ * @param cli_args The cli arguments whose game options should be written.
+ * @param sals The snakes and ladders that should be written (element type: snakeorladder_t).
+ * @return true if the config was written, false if not all were given or writing failed.
+ */
+bool generator_write_config(FILE* file, const cli_args_t* cli_args, const array_t* sals);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "array.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HISTOGRAM_EXACT_BITS 8                                          // Values below 2^HISTOGRAM_EXACT_BITS are counted in their own bucket
+#define HISTOGRAM_EXACT_COUNT (1ul << HISTOGRAM_EXACT_BITS)             // The number of buckets that count exactly one value
+#define HISTOGRAM_SUBBUCKET_COUNT (HISTOGRAM_EXACT_COUNT / 2)           // The number of buckets each power of two above the exact range is split into
+
+/**
+ * Struct for a log-linear histogram (HDR style) of unsigned integer values.
+ * Values below HISTOGRAM_EXACT_COUNT are counted exactly. Every power of two range above that
+ * is split into HISTOGRAM_SUBBUCKET_COUNT equally wide buckets, which bounds the relative error
+ * of a bucket to 1 / HISTOGRAM_SUBBUCKET_COUNT.
+ * The number of buckets only depends on the largest trackable value, not on the number of recorded values.
+ * Two histograms with the same largest trackable value can be merged by adding up their bucket counts.
+ */
+typedef struct histogram_t {
+    size_t maxvalue;                // The largest value that can be recorded in the histogram
+    size_t total;                   // The number of recorded values
+    array_t counts;                 // The number of recorded values in each bucket (element type: size_t)
+} histogram_t;
+
+/**
+ * Creates an empty histogram without buckets.
+ * @return The created empty histogram.
+ */
+histogram_t histogram_create_empty();
+
+/**
+ * Creates a histogram with enough buckets to record every value in the interval [0, maxvalue].
+ * If the buckets could not be allocated an empty histogram is returned.
+ * @param maxvalue The largest value that should be recordable in the histogram.
+ * @return The created histogram, an empty histogram if the buckets could not be allocated.
+ */
+histogram_t histogram_create(size_t maxvalue);
+
+/**
+ * Frees the given histogram freeing it's array of bucket counts and resetting it to an empty histogram.
+ * @param histogram The histogram that should be freed.
+ */
+void histogram_free(histogram_t* histogram);
+
+/**
+ * Determines the index of the bucket the given value is recorded in.
+ * @param value The value whose bucket should be determined.
+ * @return The index of the bucket.
+ */
+size_t histogram_bucket_index(size_t value);
+
+/**
+ * Determines the smallest value that is recorded in the bucket with the given index.
+ * @param index The index of the bucket.
+ * @return The smallest value of the bucket.
+ */
+size_t histogram_bucket_low(size_t index);
+
+/**
+ * Determines the largest value that is recorded in the bucket with the given index.
+ * @param index The index of the bucket.
+ * @return The largest value of the bucket.
+ */
+size_t histogram_bucket_high(size_t index);
+
+/**
+ * Records the given value in the histogram.
+ * @param histogram The histogram the value should be recorded in.
+ * @param value The value that should be recorded.
+ * @return true if the value was recorded, false if no histogram was given or the value is greater than histogram->maxvalue.
+ */
+bool histogram_add(histogram_t* histogram, size_t value);
+
+/**
+ * Merges the source histogram into the destination histogram by adding up their bucket counts.
+ * @param dst The histogram the counts of the source histogram are added to.
+ * @param src The histogram that should be merged into the destination histogram.
+ * @return true if the histograms were merged, false if not both histograms were given or they have a different maxvalue.
+ */
+bool histogram_merge(histogram_t* dst, const histogram_t* src);
+
+/**
+ * Determines the value below or at which the given fraction q of all recorded values lie.
+ * The largest value of the bucket the quantile lies in is returned, hence the result is exact in the exactly counted range.
+ * @param histogram The histogram the quantile should be determined of.
+ * @param q The fraction of recorded values in the interval [0, 1].
+ * @return The quantile value, 0 if no histogram was given or it is empty.
+ */
+size_t histogram_quantile(const histogram_t* histogram, double q);
+
+/**
+ * Prints the distribution of the recorded values as rows of bars.
+ * The rows cover the values from the smallest recorded value up to the 99.9th percentile in equally wide ranges,
+ * all recorded values above are summarized in a last tail row.
+ * @param histogram The histogram that should be printed.
+ * @param rows The maximum number of rows the distribution should be printed with (excluding the tail row).
+ * @param barlength The length of the longest printed bar.
+ */
+void histogram_print(const histogram_t* histogram, size_t rows, size_t barlength);
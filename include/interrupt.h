@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+
+#define INTERRUPT_EXIT_CODE_BASE 128        // The exit code of a process terminated by a signal is this value plus the signal number (e.g. 130 for SIGINT)
+
+/**
+ * Installs handlers for SIGINT and SIGTERM. The first signal is only recorded, hence running simulations can be stopped
+ * at the next game boundary and the statistics of the finished games can still be printed (see interrupt_requested).
+ * A second signal terminates the process immediately with the exit code INTERRUPT_EXIT_CODE_BASE plus the signal number
+ * after restoring the cursor and text format of the terminal (e.g. the cursor hidden by a loading screen).
+ * @return true if both handlers were installed, false otherwise.
+ */
+bool interrupt_install();
+
+/**
+ * The handler of SIGINT and SIGTERM. Only async-signal-safe functions are called.
+ * @param signum The number of the received signal.
+ */
+void interrupt_handle(int signum);
+
+/**
+ * Determines if a SIGINT or SIGTERM was received since the handlers were installed.
+ * @return true if a signal was received, false otherwise.
+ */
+bool interrupt_requested();
+
+/**
+ * Determines the number of the first received SIGINT or SIGTERM.
+ * @return The signal number, 0 if no signal was received.
+ */
+int interrupt_signal();
@@ -0,0 +1,307 @@
+#pragma once
+
+#include "board.h"
+#include "cli.h"
+#include "distribution.h"
+#include "game.h"
+#include "simulator.h"
+#include "statistics.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <threads.h>
+
+#define LIBSALS_SOL_LENGTH_MAX 64ul     // The maximum length of a snake or ladder in a spec (two 20 digit numbers and the '-' fit easily)
+#define LIBSALS_OPT_COUNT 37ul          // The number of options of the command line interface known to the argument parser
+#define LIBSALS_ERROR_SIZE 256ul        // The size of the buffer the reason why arguments are invalid is stored in
+
+/**
+ * The function of a task submitted to the thread pool of an executor. The return value is ignored.
+ */
+typedef int (*libsals_task_fn_t)(void* argument);
+
+/**
+ * Struct for an executor that runs the workers of a simulation on a thread pool of the caller instead of on new threads.
+ * Every submitted task must eventually be run exactly once, the tasks may run on any threads and in any order.
+ */
+typedef struct libsals_executor_t {
+    bool (*submit)(void* context, libsals_task_fn_t task, void* argument);  // Submits the task to the thread pool, returns false if it couldn't be submitted (the task is run on the calling thread instead)
+    void* context;                                                          // The context passed to submit (e.g. the caller's thread pool)
+} libsals_executor_t;
+
+/**
+ * Struct for the in-memory description of a game in the syntax of the command line arguments.
+ */
+typedef struct libsals_spec_t {
+    size_t width;                   // The width of the playing field
+    size_t height;                  // The height of the playing field
+    size_t diesides;                // The number of sides of the die
+    const char* distribution;       // The distribution of the die as preset name or weight sequence (see strtodistr), 0 for uniform
+    bool exactending;               // Indicates wether the game must end by exactly landing on the last cell
+    const char* sals;               // The snakes and ladders as whitespace separated a-b pairs of 1 based cells (e.g. "1-16 13-45"), 0 for none
+} libsals_spec_t;
+
+/**
+ * Struct for the settings of the simulations of a game.
+ */
+typedef struct libsals_options_t {
+    size_t simcount;                        // The maximum number of simulations
+    size_t workers;                         // The number of workers the simulations run on (0 for one worker per online processor)
+    size_t dicelimit;                       // The maximum allowed number of dices in a simulation before resigning if the game wasn't won yet
+    double targetprecision;                 // The half-width of the 95% confidence interval of the average number of dices at which the simulations stop (0 if disabled)
+    double timelimit;                       // The number of seconds after which the simulations stop (0 if disabled)
+    bool seeded;                            // Indicates if the simulations should be rolled with streams derived from the seed
+    uint64_t seed;                          // The seed the streams of the simulations are derived from (if seeded)
+    const libsals_executor_t* executor;     // The executor the workers are run on, 0 to run them on new threads
+    const atomic_bool* cancel;              // The flag that stops the simulations at the next game boundary once it is set, 0 if they can't be cancelled
+} libsals_options_t;
+
+/**
+ * Struct for a worker of a simulation run as task (see libsals_executor_t).
+ */
+typedef struct libsals_task_t {
+    worker_t* worker;               // The worker run by the task (0 once a task that was not started finished on the calling thread)
+    atomic_size_t* pending;         // The number of tasks of the simulation that did not finish yet
+    int res;                        // The error code of the worker (see worker_run)
+    thrd_t thread;                  // The identifier of the thread the task is run on if the simulation has no executor
+    bool started;                   // Indicates if the task was handed to a thread or the executor
+    bool stepped;                   // Indicates if a task that was not started ran a batch on the calling thread (see libsals_task_step)
+} libsals_task_t;
+
+/**
+ * Struct for an option of the command line interface known to the argument parser (see libsals_args_parse).
+ */
+typedef struct libsals_opt_info_t {
+    char name;                      // The short name of the option
+    const char* longname;           // The long name of the option
+    bool hasvalue;                  // Indicates if the option takes a value
+    cli_args_flag_t flag;           // The flag of the option in the set argument flags
+} libsals_opt_info_t;
+
+extern libsals_opt_info_t libsals_opt_infos[LIBSALS_OPT_COUNT];
+
+/**
+ * Struct for a game and it's simulation settings parsed from arguments in the syntax of the command line or a config file.
+ * Unlike the cli_parse function the arguments are parsed without getopt, nothing is printed and the program is never terminated,
+ * hence arguments can be parsed on many threads concurrently and invalid arguments are reported to the caller.
+ */
+typedef struct libsals_args_t {
+    libsals_spec_t spec;                // The game described by the arguments (the distribution references the arguments)
+    libsals_options_t options;          // The simulation settings described by the arguments (simulations, dice limit, target precision and seed)
+    const char* board;                  // The path of the compiled board the game is loaded from referencing the arguments, 0 to create it from the spec
+    distr_preset_t preset;              // The preset of the distribution of the die, DISTR_PRESET_NONE for custom weights
+    cli_args_flags_t setargsflags;      // The flags of the options that were given (see cli_args_flag_t)
+    char* content;                      // The arguments split in place if they were parsed from a string (see libsals_args_parse_str), 0 otherwise
+    array_t argv;                       // The arguments split from the content (element type: char*)
+    char* sals;                         // The snakes and ladders of the spec joined by spaces, 0 if none were given
+    char error[LIBSALS_ERROR_SIZE];     // The reason why the arguments are invalid or their game could not be created, empty if none
+} libsals_args_t;
+
+/**
+ * Creates a spec of the default game of the command line interface (10x10 playing field, uniform 6-sided die, no snakes and ladders).
+ * @return The created spec.
+ */
+libsals_spec_t libsals_spec_create();
+
+/**
+ * Creates the default simulation settings of the command line interface (1000 simulations on one worker per online processor,
+ * dice limit 10000, run on new threads).
+ * @return The created settings.
+ */
+libsals_options_t libsals_options_create();
+
+/**
+ * Parses the snakes and ladders of the given spec string into the given array.
+ * @param str The whitespace separated a-b pairs of 1 based cells.
+ * @param sals The array the snakes and ladders are added to (element type: snakeorladder_t).
+ * @param invalididx The address the index of the first snake or ladder that could not be parsed should be stored at. If not given it is not stored.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully parsed snakes and ladders
+ *
+ * - 1 not all given
+ *
+ * - 2 a snake or ladder is not an a-b pair of positive integers
+ *
+ * - 3 unable to add snake or ladder
+ */
+int libsals_parse_sals(const char* str, array_t* sals, size_t* invalididx);
+
+/**
+ * Creates the game described by the given spec. Unlike the game_setup function nothing is printed and the program is never terminated,
+ * hence many games can be created and simulated concurrently in one process. The created game is freed with the game_free function.
+ * Compiled boards are loaded the same way with the board_load function.
+ * @param spec The spec of the game.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully created game
+ *
+ * - 1 no spec given
+ *
+ * - 2 invalid dimensions (less than GAME_WIDTH_MIN x GAME_HEIGHT_MIN)
+ *
+ * - 3 invalid distribution (unknown preset, invalid or too many weights, odd die sides for twodice, no die sides or weight sum 0)
+ *
+ * - 4 a snake or ladder could not be parsed
+ *
+ * - 5 a snake or ladder is invalid on the playing field (see game_check_sals)
+ *
+ * - 6 unable to allocate game
+ *
+ * @param invalididx The address the index of the invalid snake or ladder should be stored at (error codes 4 and 5). If not given it is not stored.
+ * @return The created game, an empty game if it could not be created.
+ */
+game_t libsals_game_create(const libsals_spec_t* spec, int* error, size_t* invalididx);
+
+/**
+ * Creates empty parsed arguments describing the default game and simulation settings of the command line interface.
+ * @return The created empty arguments.
+ */
+libsals_args_t libsals_args_create_empty();
+
+/**
+ * Frees the given parsed arguments freeing their split content and joined snakes and ladders and resetting them to empty arguments.
+ * @param args The arguments that should be freed.
+ */
+void libsals_args_free(libsals_args_t* args);
+
+/**
+ * Stores the formatted reason why the given arguments are invalid in their error buffer (truncated to LIBSALS_ERROR_SIZE).
+ * @param args The arguments the reason should be stored in.
+ * @param error The error code that is returned.
+ * @param format The format of the reason (see printf).
+ * @return The given error code.
+ */
+int libsals_args_fail(libsals_args_t* args, int error, const char* format, ...);
+
+/**
+ * Parses the given value of an option into the given unsigned integer and checks that it is within the given range.
+ * @param args The arguments the reason why the value is invalid is stored in.
+ * @param opt The option the value belongs to.
+ * @param str The value of the option.
+ * @param valmin The minimum value.
+ * @param valmax The maximum value.
+ * @param value The address the parsed value should be stored at.
+ * @return true if the value was parsed, false if it is invalid.
+ */
+bool libsals_args_parse_uint64(libsals_args_t* args, const libsals_opt_info_t* opt, const char* str, uint64_t valmin, uint64_t valmax, uint64_t* value);
+
+/**
+ * Parses the given value of an option into the given floating point number and checks that it is within the given range.
+ * @param args The arguments the reason why the value is invalid is stored in.
+ * @param opt The option the value belongs to.
+ * @param str The value of the option.
+ * @param valmin The minimum value.
+ * @param valmax The maximum value.
+ * @param value The address the parsed value should be stored at.
+ * @return true if the value was parsed, false if it is invalid.
+ */
+bool libsals_args_parse_double(libsals_args_t* args, const libsals_opt_info_t* opt, const char* str, double valmin, double valmax, double* value);
+
+/**
+ * Applies the given option and it's value to the given arguments.
+ * @param args The arguments the option is applied to.
+ * @param opt The option.
+ * @param value The value of the option, 0 if it takes no value.
+ * @param supported The flags of the options that are supported (see cli_args_flag_t).
+ * @param context The description of where the arguments come from used in the reason why an option is not supported (e.g. "in the requests of a daemon").
+ * @return true if the option was applied, false if it is not supported or it's value is invalid.
+ */
+bool libsals_args_parse_opt(libsals_args_t* args, const libsals_opt_info_t* opt, const char* value, cli_args_flags_t supported, const char* context);
+
+/**
+ * Parses the given arguments like the command line arguments into the given empty arguments. Options can be given in short or long form,
+ * long options can be abbreviated and their values can be attached with '='. Every argument that is not an option (or follows "--")
+ * is a snake or ladder. Options whose flag is not supported are rejected without evaluating their value, hence e.g. a config file
+ * that is not supported is never read. Unlike the cli_parse function nothing is printed, the program is never terminated
+ * and no global state is used. The spec and board reference the given arguments, hence they must not be freed while the
+ * parsed arguments are used.
+ * @param args The empty arguments the parsed game and simulation settings are stored in, the reason why they are invalid is stored in it's error buffer.
+ * @param argc The number of arguments (without program name).
+ * @param argv The arguments (without program name).
+ * @param supported The flags of the options that are supported (see cli_args_flag_t).
+ * @param context The description of where the arguments come from used in the reason why an option is not supported (e.g. "in the requests of a daemon").
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully parsed arguments
+ *
+ * - 1 not all given
+ *
+ * - 2 invalid arguments
+ *
+ * - 3 unable to allocate arguments
+ */
+int libsals_args_parse(libsals_args_t* args, int argc, char* const argv[], cli_args_flags_t supported, const char* context);
+
+/**
+ * Splits the given string into arguments like a config file (see cli_read_configfile_arg) and parses them with the libsals_args_parse function.
+ * The string is copied, hence it may be freed while the parsed arguments are used.
+ * @param args The empty arguments the parsed game and simulation settings are stored in, the reason why they are invalid is stored in it's error buffer.
+ * @param str The arguments in the syntax of the command line or a config file.
+ * @param size The size of the string in bytes.
+ * @param supported The flags of the options that are supported (see cli_args_flag_t).
+ * @param context The description of where the arguments come from used in the reason why an option is not supported (e.g. "in the requests of a daemon").
+ * @return The error code (see libsals_args_parse).
+ */
+int libsals_args_parse_str(libsals_args_t* args, const char* str, size_t size, cli_args_flags_t supported, const char* context);
+
+/**
+ * Creates the game described by the given parsed arguments with the libsals_game_create function or loads their compiled board
+ * with the board_load function. The reason why the game could not be created is stored in the arguments' error buffer.
+ * @param args The parsed arguments.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully created game
+ *
+ * - 1 no arguments given
+ *
+ * - 2 invalid game or board
+ *
+ * - 3 unable to allocate game
+ *
+ * @return The created game, an empty game if it could not be created.
+ */
+game_t libsals_args_game_create(libsals_args_t* args, int* error);
+
+/**
+ * Runs the worker of the given task and counts the task as finished. The task must not be accessed by it's thread afterwards.
+ * @param task The task that should be run.
+ * @return The error code of the worker (see worker_run).
+ */
+int libsals_task_run(libsals_task_t* task);
+
+/**
+ * Runs the next batch of simulations of the given task that could not be started on the calling thread.
+ * The random number generator of the calling thread is seeded for the worker before it's first batch
+ * and the task is counted as finished once the worker claimed all of it's simulations, was stopped or failed.
+ * @param task The task whose next batch should be run.
+ * @return true if the task has to be stepped again, false if it finished or was started on a thread or the executor.
+ */
+bool libsals_task_step(libsals_task_t* task);
+
+/**
+ * Simulates the given game with the given settings and collects the statistics of the simulations.
+ * The workers are run on new threads or on the executor of the settings while the calling thread checks the stopping criteria.
+ * Workers that could not be started are run batch by batch on the calling thread in between the checks (see libsals_task_step).
+ * Nothing is printed, no signal handlers or other global state are used and the program is never terminated, hence many games
+ * can be simulated concurrently in one process. The die of every worker is rolled with the thread local random number generator
+ * of the thread running it, which is reseeded.
+ * @param game The game that should be simulated. It must not be freed while it is simulated.
+ * @param options The settings of the simulations.
+ * @param stats The empty statistics the statistics of the simulations are stored in, marked as interrupted if the simulations were cancelled.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully simulated game
+ *
+ * - 1 not all given or no simulations requested
+ *
+ * - 2 unable to create simulator
+ *
+ * - 3 unable to allocate tasks
+ *
+ * - 4 a worker failed
+ *
+ * - 5 unable to collect statistics
+ */
+int libsals_simulate(const game_t* game, const libsals_options_t* options, stats_t* stats);
@@ -1,28 +1,53 @@
 #pragma once
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <threads.h>
 
+#define LOADINGSCREEN_FRAME_INTERVAL_NS 50000000l   // The interval in nanoseconds in which the loading screen renders the next frame
+#define LOADINGSCREEN_RATE_WINDOW_FRAMES 20         // The number of frames the rates are averaged over (the last second)
+
+/**
+ * Struct for the progress of the work a loading screen is shown for.
+ */
+typedef struct loadingscreen_progress_t {
+    size_t games;                   // The number of finished games
+    size_t dices;                   // The number of dices of the finished games
+    size_t total;                   // The number of games that should be finished, 0 if unknown
+    double timelimit;               // The number of seconds after which the work is stopped, 0 if none
+} loadingscreen_progress_t;
+
+/**
+ * The function reading the current progress of the given source (e.g. the finished games of a simulator) into the given progress.
+ * It is called by the rendering thread while the work is running, hence it must only read values that are safe to read concurrently.
+ */
+typedef void (*loadingscreen_progress_fn_t)(const void* source, loadingscreen_progress_t* progress);
+
 /**
  * Struct to store information for a loading screen.
+ * The loading screen is only rendered if stdout is a terminal. The rendering thread reads the progress without locking
+ * and polls the stop flag between two frames, hence the work is never blocked by the loading screen.
  */
 typedef struct loadingscreen_t {
-    bool valid;                     // Indicates if the loading screen was successfully created
-    bool running;                   // Indicates if the loading screen is currently running
-    mtx_t mtx;                      // The timed mutex used for the condition in a loading screen
-    cnd_t cnd;                      // The condition that should be signalled to stop the loading screen
-    thrd_t thrd;                    // The thread that is run to render the loading screen
-    const char* msg;                // The text that should be output next to the loading symbol
+    bool valid;                             // Indicates if the loading screen was successfully created
+    bool running;                           // Indicates if the loading screen is currently running
+    atomic_bool stop;                       // Indicates that the rendering thread should stop
+    thrd_t thrd;                            // The thread that is run to render the loading screen
+    const char* msg;                        // The text that should be output next to the loading symbol
+    loadingscreen_progress_fn_t progress;   // The function reading the progress of the work, 0 if no progress is shown
+    const void* source;                     // The source the progress is read from
 } loadingscreen_t;
 
 /**
- * Creates a new loading screen with the given message initializing it's mutex and condition and setting valid to true on success.
- * If an error occurs an appropriate warning is output on stderr and
- * an empty loading screen with the member valid set to false is returned.
+ * Creates a new loading screen with the given message and progress.
  * @param msg The message that should be printed next to the loading symbol. If no message is given no message is printed.
- * @return The created loading screen with valid set to true, an empty loading screen with valid set to false.
+ * @param progress The function reading the progress of the work which is printed after the message (percentage, games and dices per second,
+ *                 running average of the dices and estimated remaining time). If not given no progress is printed.
+ * @param source The source the progress is read from.
+ * @return The created loading screen with valid set to true.
  */
-loadingscreen_t loadingscreen_create(const char* msg);
+loadingscreen_t loadingscreen_create(const char* msg, loadingscreen_progress_fn_t progress, const void* source);
 
 /**
  * Destroys the given loading screen if it's member valid is true.
@@ -32,9 +57,9 @@ loadingscreen_t loadingscreen_create(const char* msg);
 void loadingscreen_destroy(loadingscreen_t* loadscreen);
 
 /**
- * Starts rendering the given loading screen on a separate thread if it is valid and not already running.
+ * Starts rendering the given loading screen on a separate thread if it is valid, not already running and stdout is a terminal.
  * Rendering stops when the loadingscreen_stop function is called for the same loading screen.
- * If no loading screen was given, it is invalid or already running no action is performed and false is returned.
+ * If no loading screen was given, it is invalid or already running or stdout is not a terminal no thread is started and false is returned.
  * @param loadscreen The loading screen that should be started.
  * @return true if the loading screen was successfully started, false otherwise.
  */
@@ -42,7 +67,7 @@ bool loadingscreen_start(loadingscreen_t* loadscreen);
 
 /**
  * Stops rendering the given loading screen by stopping the rendering thread if it is valid and currently running.
- * The calling thread blocks until the loading screen rendering thread stopped.
+ * The calling thread blocks until the loading screen rendering thread stopped (at most one frame interval).
  * If no loading screen was given, it is invalid or currently not running no action is performed and false is returned.
  * @param loadscreen The loading screen that should be stopped.
  * @return true if the loading screen was successfully stopped, false otherwise.
@@ -50,8 +75,27 @@ bool loadingscreen_start(loadingscreen_t* loadscreen);
 bool loadingscreen_stop(loadingscreen_t* loadscreen);
 
 /**
- * Renders the given loading screen until it's condition is signalled if it is valid and not already running.
- * @param loadscreen The condition that must be signalled to stop rendering of the loading screen
- * @return Always 0.
+ * Formats the given number with at most four significant digits and a k, M, G or T suffix (e.g. 1.235M).
+ * @param buffer The buffer the formatted number is written to.
+ * @param size The size of the buffer.
+ * @param value The number that should be formatted.
+ */
+void loadingscreen_format_count(char* buffer, size_t size, double value);
+
+/**
+ * Prints the given progress after the loading symbol and message: the percentage and the estimated remaining time
+ * (if the total number of games or the time limit is known), the number of finished games, the games and dices per second
+ * and the running average of the dices per game.
+ * @param progress The current progress.
+ * @param elapsed The number of seconds since the loading screen was started.
+ * @param gamerate The number of games finished per second.
+ * @param dicerate The number of dices per second.
+ */
+void loadingscreen_print_progress(const loadingscreen_progress_t* progress, double elapsed, double gamerate, double dicerate);
+
+/**
+ * Renders the given loading screen until it's stop flag is set if it is valid and running.
+ * @param loadscreen The loading screen that should be rendered.
+ * @return 0 after rendering stopped, 1 if no loading screen was given or it is invalid or not running.
  */
 int loadingscreen_run(loadingscreen_t* loadscreen);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -22,7 +23,7 @@
 int strtodouble(const char* str, double* value);
 
 /**
- * Parses the given string to a uint64_t.
+ * Parses the given null-terminated string to a uint64_t with the strntouint64 function.
  * @param str The string that should be parsed.
  * @param value The address the parsed uint64_t should be stored at.
  * If the parse failed the value remains unchanged. If no address was given the parsed uint64_t is not stored.
@@ -39,3 +40,24 @@ int strtodouble(const char* str, double* value);
  * - 4 remaining characters after number in string
  */
 int strtouint64(const char* str, uint64_t* value);
+
+/**
+ * Parses the first length characters of the given string to a decimal uint64_t without allocating memory or requiring a null-terminator.
+ * Like the strtoul function leading whitespaces and a plus sign are skipped, but a minus sign is rejected instead of negating the value.
+ * @param str The string that should be parsed.
+ * @param length The number of characters of the string that should be parsed.
+ * @param value The address the parsed uint64_t should be stored at.
+ * If the parse failed the value remains unchanged. If no address was given the parsed uint64_t is not stored.
+ * @return The error code.
+ *
+ * - 0 parsed successfully
+ *
+ * - 1 no string given
+ *
+ * - 2 value out of range (overflow)
+ *
+ * - 3 invalid characters (not a number)
+ *
+ * - 4 remaining characters after number in string
+ */
+int strntouint64(const char* str, size_t length, uint64_t* value);
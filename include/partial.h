@@ -0,0 +1,130 @@
+#pragma once
+
+#include "array.h"
+#include "simulator.h"
+#include "statistics.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PARTIAL_MAGIC "SALSM\r\n\x1a"                   // The signature at the beginning of every partial statistics file (the line endings and EOF character detect text mode conversions)
+#define PARTIAL_MAGIC_SIZE 8ul                          // The number of bytes of the signature
+#define PARTIAL_VERSION 1u                              // The version of the partial statistics file layout, incremented whenever the layout or one of the stored structs changes
+#define PARTIAL_BYTE_ORDER 0x01020304u                  // The value stored in the byte order of the writing machine to detect files written on machines with another byte order
+#define PARTIAL_FLAG_INTERRUPTED 1u                     // The flag indicating that the simulations of the shard were interrupted
+
+/**
+ * Struct for the header at the beginning of a partial statistics file.
+ * A partial statistics file stores the statistics of one shard of a seeded run (see simulator_shard) including the
+ * histogram and the Welford accumulators, hence the statistics of all shards can be merged into the statistics of the whole run.
+ * The header is followed by:
+ *
+ * - the counts of the histogram of the number of dices (size_t[bucketcount])
+ *
+ * - the shortest dice sequence that lead to a win (size_t[shortestcount])
+ *
+ * - the statistics about each snake or ladder ordered by their starting cell (solstats_t[solcount])
+ */
+typedef struct partial_header_t {
+    char magic[PARTIAL_MAGIC_SIZE];     // The signature of partial statistics files (PARTIAL_MAGIC)
+    uint32_t version;                   // The version of the partial statistics file layout (PARTIAL_VERSION)
+    uint32_t byteorder;                 // PARTIAL_BYTE_ORDER stored in the byte order of the writing machine
+    uint32_t wordsize;                  // The size of size_t on the writing machine in bytes
+    uint32_t flags;                     // The bitwise ORed partial flags (e.g. PARTIAL_FLAG_INTERRUPTED)
+    uint64_t fingerprint;               // The fingerprint of the simulated game including it's die (see checkpoint_fingerprint)
+    uint64_t seed;                      // The seed of the simulations
+    uint64_t simcount;                  // The number of simulations of the whole run
+    uint64_t dicelimit;                 // The maximum allowed number of dices in a simulation
+    uint64_t shard;                     // The 0 based index of the shard
+    uint64_t shardcount;                // The number of shards of the whole run
+    uint64_t solcount;                  // The number of snakes and ladders
+    uint64_t bucketcount;               // The number of buckets of the histogram of the number of dices
+    uint64_t sims;                      // The number of simulations run by the shard
+    uint64_t wins;                      // The number of won games
+    uint64_t losses;                    // The number of lost games
+    uint64_t histtotal;                 // The number of values recorded in the histogram of the number of dices
+    uint64_t shortestcount;             // The length of the shortest dice sequence that lead to a win, 0 if none
+    uint64_t shortestindex;             // The index of the simulation of the shortest dice sequence
+    double elapsed;                     // The number of seconds it took to run the simulations of the shard
+    valstats_t dices;                   // The summary statistics about the dices
+    valstats_t salsuses;                // The summary statistics about the number of used snakes and ladders
+    valstats_t snakesuses;              // The summary statistics about the number of used snakes
+    valstats_t laddersuses;             // The summary statistics about the number of used ladders
+    uint64_t size;                      // The size of the whole file in bytes
+    uint64_t checksum;                  // The checksum of everything after the header
+    uint64_t headerchecksum;            // The checksum of the header up to this field
+} partial_header_t;
+
+/**
+ * Writes the given statistics of the shard run by the given seeded simulator to a partial statistics file.
+ * The file is written to a temporary file in the same directory which then replaces the partial statistics file.
+ * @param filepath The path of the partial statistics file.
+ * @param stats The collected statistics of the simulator (see stats_collect).
+ * @param simulator The seeded simulator that ran the simulations of the shard.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully wrote partial statistics
+ *
+ * - 1 not all given or simulator not seeded
+ *
+ * - 2 unable to create temporary file
+ *
+ * - 3 unable to write partial statistics file
+ *
+ * - 4 unable to replace partial statistics file
+ */
+int partial_write(const char* filepath, const stats_t* stats, const simulator_t* simulator);
+
+/**
+ * Writes the given statistics of the run described by the given header to a partial statistics file.
+ * Only the fingerprint, seed, simcount, dicelimit, shard and shardcount of the given header are stored, the remaining fields are derived from the statistics.
+ * The file is written to a temporary file in the same directory which then replaces the partial statistics file.
+ * @param filepath The path of the partial statistics file.
+ * @param stats The collected statistics of the run.
+ * @param run The header describing the run the statistics belong to.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully wrote partial statistics
+ *
+ * - 1 not all given
+ *
+ * - 2 unable to create temporary file
+ *
+ * - 3 unable to write partial statistics file
+ *
+ * - 4 unable to replace partial statistics file
+ */
+int partial_write_run(const char* filepath, const stats_t* stats, const partial_header_t* run);
+
+/**
+ * Loads the partial statistics file at the given path into the given empty statistics.
+ * @param filepath The path of the partial statistics file.
+ * @param header The address the header of the file is stored in.
+ * @param stats The empty statistics the partial statistics are stored in.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully loaded partial statistics
+ *
+ * - 1 not all given
+ *
+ * - 2 unable to open file
+ *
+ * - 3 not a partial statistics file
+ *
+ * - 4 version or machine (byte order, word size) not supported
+ *
+ * - 5 file corrupted (inconsistent size or checksum mismatch)
+ *
+ * - 6 unable to allocate statistics
+ */
+int partial_load(const char* filepath, partial_header_t* header, stats_t* stats);
+
+/**
+ * Merges the partial statistics files of all shards of a seeded run into the statistics of the whole run.
+ * The shards are merged in the order of their index regardless of the order of the files, hence the counts, sums, histogram and
+ * shortest dice sequence are identical to a single-process run with the same seed. If a file could not be loaded, belongs
+ * to another run or a shard is missing or given twice an appropriate error message is output on stderr and the program is terminated with exit code 1.
+ * @param filepaths The paths of the partial statistics files (element type: char*).
+ * @return The finalized statistics of the whole run, marked as interrupted if any shard was interrupted.
+ */
+stats_t partial_merge(const array_t* filepaths);
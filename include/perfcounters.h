@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PERFCOUNTERS_EVENT_COUNT 6
+
+/**
+ * Enum to identify a hardware event counted by the performance monitoring unit of the processor.
+ */
+typedef enum perfcounters_event_t {
+    PERFCOUNTERS_EVENT_CYCLES,          // The number of processor cycles
+    PERFCOUNTERS_EVENT_INSTRUCTIONS,    // The number of retired instructions
+    PERFCOUNTERS_EVENT_BRANCHES,        // The number of retired branch instructions
+    PERFCOUNTERS_EVENT_BRANCH_MISSES,   // The number of mispredicted branch instructions
+    PERFCOUNTERS_EVENT_L1D_MISSES,      // The number of level 1 data cache read misses
+    PERFCOUNTERS_EVENT_LLC_MISSES       // The number of last level cache read misses
+} perfcounters_event_t;
+
+/**
+ * Struct to store information about a hardware event.
+ */
+typedef struct perfcounters_event_info_t {
+    char* name;                         // The name of the event
+    uint32_t type;                      // The perf_event_attr type of the event
+    uint64_t config;                    // The perf_event_attr config of the event
+} perfcounters_event_info_t;
+
+// Information about each perfcounters_event_t value
+extern perfcounters_event_info_t perfcounters_event_infos[PERFCOUNTERS_EVENT_COUNT];
+
+/**
+ * Struct for the hardware events counted while simulating games, e.g. on a worker thread.
+ * Every event is opened separately with perf_event_open (user space only, hence a perf_event_paranoid of 2 suffices),
+ * events the processor or kernel don't support are skipped. If the kernel multiplexes the events the counts are scaled
+ * by the ratio of the time the event was enabled to the time it was counted.
+ */
+typedef struct perfcounters_t {
+    int fds[PERFCOUNTERS_EVENT_COUNT];          // The file descriptors of the opened events, -1 if not opened
+    bool counted[PERFCOUNTERS_EVENT_COUNT];     // Indicates which events were counted
+    uint64_t values[PERFCOUNTERS_EVENT_COUNT];  // The number of counted events
+    size_t games;                               // The number of games finished while the events were counted
+    size_t dices;                               // The number of dices of the games finished while the events were counted
+} perfcounters_t;
+
+/**
+ * Creates empty performance counters with no opened or counted events.
+ * @return The created performance counters.
+ */
+perfcounters_t perfcounters_create_empty();
+
+/**
+ * Opens and enables the hardware events of the given performance counters for the calling thread.
+ * @param counters The performance counters whose events should be opened.
+ * @param inherit Indicates if the threads created by the calling thread afterwards should be counted as well (once they finished).
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully opened at least one event
+ *
+ * - 1 no performance counters given
+ *
+ * - 2 performance counters are not supported on this platform
+ *
+ * - 3 the kernel denied access to the performance counters (see /proc/sys/kernel/perf_event_paranoid)
+ *
+ * - 4 the processor or kernel supports none of the events (e.g. in a virtual machine without performance monitoring unit)
+ *
+ * - 5 unable to open the events for another reason (e.g. too many open files)
+ */
+int perfcounters_open(perfcounters_t* counters, bool inherit);
+
+/**
+ * Reads the opened events of the given performance counters, adds their counts to the counted values and closes them.
+ * If no performance counters were given no action is performed.
+ * @param counters The performance counters whose events should be read and closed.
+ */
+void perfcounters_stop(perfcounters_t* counters);
+
+/**
+ * Adds the counted events, games and dices of the given source to the given destination.
+ * @param dst The performance counters the counts should be added to.
+ * @param src The performance counters whose counts should be added.
+ */
+void perfcounters_merge(perfcounters_t* dst, const perfcounters_t* src);
+
+/**
+ * Determines the ratio of the counts of the given events (e.g. instructions per cycle).
+ * @param counters The performance counters.
+ * @param numerator The event whose count is divided.
+ * @param denominator The event whose count divides.
+ * @return The ratio, NAN if not both events were counted or the denominator is 0.
+ */
+double perfcounters_ratio(const perfcounters_t* counters, perfcounters_event_t numerator, perfcounters_event_t denominator);
+
+/**
+ * Determines the description of the given error code of the perfcounters_open function.
+ * @param error The error code.
+ * @return The description of the error code.
+ */
+const char* perfcounters_strerror(int error);
+
+/**
+ * Prints the given performance counters as table of every event normalized per game and per dice,
+ * followed by the instructions per cycle and the share of mispredicted branches.
+ * @param counters The performance counters that should be printed.
+ */
+void perfcounters_print(const perfcounters_t* counters);
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "archive.h"
+#include "game.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <threads.h>
+
+#define RECORDS_FORMAT_COUNT 3
+#define RECORDS_MAGIC "SALSR\r\n\x1a"                   // The signature at the beginning of every binary records file (the line endings and EOF character detect text mode conversions)
+#define RECORDS_MAGIC_SIZE 8ul                          // The number of bytes of the signature
+#define RECORDS_VERSION 1u                              // The version of the binary records layout, incremented whenever the layout changes
+#define RECORDS_BYTE_ORDER 0x01020304u                  // The value stored in the byte order of the writing machine to detect files written on machines with another byte order
+#define RECORDS_FLAG_TRACE 1u                           // The flag indicating that every record is followed by the sides diced during it's simulation
+#define RECORDS_FILE_BUFFER_SIZE (1ul << 20)            // The size of the stdio buffer of the records file in bytes
+#define RECORDS_BUFFER_SIZE (64ul << 10)                // The number of bytes of records after which a producer hands it's buffer off to the writer
+#define RECORDS_PRODUCER_BUFFERS 8ul                    // The maximum number of buffers of a producer that are filled or queued for writing at once
+#define RECORDS_WRITER_INTERVAL_NS 1000000l             // The interval in nanoseconds in which the writer checks the queue while it is empty
+#define RECORDS_PRODUCER_INTERVAL_NS 100000l            // The interval in nanoseconds in which a producer checks for written buffers while all of it's buffers are queued
+
+// forward declarations
+typedef struct simulation_t simulation_t;
+typedef struct records_producer_t records_producer_t;
+
+/**
+ * Enum to identify the format of a records file.
+ */
+typedef enum records_format_t {
+    RECORDS_FORMAT_BINARY,              // Fixed-width records of unsigned 64 bit integers in native byte order after a header
+    RECORDS_FORMAT_CSV,                 // Comma separated values with a header row, one row per record
+    RECORDS_FORMAT_ARCHIVE              // Compressed traces with random access by simulation index (see archive_header_t)
+} records_format_t;
+
+/**
+ * Struct to store information about a records format.
+ */
+typedef struct records_format_info_t {
+    char* name;                         // The name of the records format
+} records_format_info_t;
+
+// Information about each records_format_t value
+extern records_format_info_t records_format_infos[RECORDS_FORMAT_COUNT];
+
+/**
+ * Struct for the header at the beginning of a binary records file.
+ * The header is followed by the snakes and ladders ordered by their starting cell (uint64_t[edgecount][2], 1 based start and end cells)
+ * and the records. Each record consists of recordsize bytes of unsigned 64 bit integers:
+ *
+ * - the index of the simulation
+ *
+ * - the number of dices
+ *
+ * - 1 if the simulation was aborted because the dice limit was reached, 0 otherwise
+ *
+ * - the number of times each snake or ladder was used (uint64_t[edgecount] in the order of the snakes and ladders section)
+ *
+ * If RECORDS_FLAG_TRACE is set each record is followed by the diced sides (uint64_t[number of dices]).
+ * The records are ordered by the time their simulations finished, not by the index of the simulations.
+ */
+typedef struct records_header_t {
+    char magic[RECORDS_MAGIC_SIZE];     // The signature of binary records files (RECORDS_MAGIC)
+    uint32_t version;                   // The version of the binary records layout (RECORDS_VERSION)
+    uint32_t byteorder;                 // RECORDS_BYTE_ORDER stored in the byte order of the writing machine
+    uint32_t flags;                     // The bitwise ORed records flags (e.g. RECORDS_FLAG_TRACE)
+    uint32_t reserved;                  // Always 0
+    uint64_t edgecount;                 // The number of snakes and ladders
+    uint64_t recordsize;                // The size of each record without it's trace in bytes
+} records_header_t;
+
+/**
+ * Struct for a buffer of formatted records that is handed off from a producer to the writer as a whole.
+ */
+typedef struct records_buffer_t {
+    struct records_buffer_t* next;      // The next buffer in the queue or free list the buffer is in
+    records_producer_t* producer;       // The producer the buffer is returned to after it was written
+    unsigned char* data;                // The formatted records
+    size_t size;                        // The number of bytes of formatted records
+    size_t capacity;                    // The number of bytes that can be stored in the allocated data
+    size_t count;                       // The number of records in the buffer
+    array_t blocks;                     // The archive blocks in the buffer, offsets relative to the buffer (archive format only, element type: archive_block_t)
+} records_buffer_t;
+
+/**
+ * Struct for a records file that per-simulation results are written to by a separate writer thread.
+ * The producers (one per worker) format the records of their simulations into buffers and push each full buffer
+ * onto a lock-free stack. The writer repeatedly takes the whole stack at once, writes the buffers in the order they were pushed
+ * and returns them to the free lists of their producers, hence the simulations never wait for the file unless all buffers
+ * of a producer are queued (the writer can't keep up).
+ */
+typedef struct records_t {
+    FILE* file;                                 // The records file, 0 if the records are disabled
+    records_format_t format;                    // The format of the records file
+    bool trace;                                 // Indicates if the diced sides are written with every record
+    const game_t* game;                         // The game whose simulations are recorded
+    _Atomic(records_buffer_t*) queue;           // The buffers pushed by the producers that were not taken by the writer yet (newest first)
+    atomic_bool done;                           // Indicates that no more buffers will be pushed
+    atomic_bool failed;                         // Indicates that writing to the records file failed (the following buffers are discarded)
+    size_t count;                               // The number of records written by the writer
+    uint64_t offset;                            // The number of bytes written to the records file (archive format only)
+    array_t index;                              // The written archive blocks (archive format only, element type: archive_block_t)
+    archive_codebook_t codebook;                // The code of the die sides (archive format only)
+    thrd_t thread;                              // The identifier of the writer thread
+    bool started;                               // Indicates if the writer thread was started successfully
+} records_t;
+
+/**
+ * Struct for a producer that formats the records of one worker.
+ */
+typedef struct records_producer_t {
+    records_t* records;                         // The records the producer writes to, 0 if the records are disabled
+    _Atomic(records_buffer_t*) free;            // The buffers returned by the writer that were not taken by the producer yet
+    records_buffer_t* spare;                    // The buffers taken from the free list that are not in use
+    records_buffer_t* current;                  // The buffer the records are currently added to, 0 if none
+    size_t buffercount;                         // The number of buffers allocated by the producer
+} records_producer_t;
+
+/**
+ * Converts the string into the corresponding records format.
+ * It must be one of the following names: binary, csv, archive
+ * @param str The string that should be converted.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully parsed records format.
+ *
+ * - 1 no string given.
+ *
+ * - 2 unknown records format.
+ *
+ * @return The records format represented by the string, RECORDS_FORMAT_BINARY if the string could not be converted.
+ */
+records_format_t strtorecordsformat(const char* str, int* error);
+
+/**
+ * Creates a new empty buffer for the given producer.
+ * @param producer The producer the buffer belongs to.
+ * @return The created buffer, ownership is transferred to the caller. 0 if it could not be allocated.
+ */
+records_buffer_t* records_buffer_create(records_producer_t* producer);
+
+/**
+ * Frees the given buffer and it's data.
+ * @param buffer The buffer that should be freed.
+ */
+void records_buffer_free(records_buffer_t* buffer);
+
+/**
+ * Ensures that the given number of bytes can be added to the given buffer without reallocating it's data.
+ * @param buffer The buffer whose capacity should be ensured.
+ * @param size The number of bytes that should fit behind the buffer's data.
+ * @return true if the bytes fit, false if not enough memory could be allocated or no buffer was given.
+ */
+bool records_buffer_reserve(records_buffer_t* buffer, size_t size);
+
+/**
+ * Adds the given bytes to the given buffer.
+ * @param buffer The buffer the bytes should be added to.
+ * @param data The bytes that should be added.
+ * @param size The number of bytes.
+ * @return true if the bytes were added, false otherwise.
+ */
+bool records_buffer_add(records_buffer_t* buffer, const void* data, size_t size);
+
+/**
+ * Adds the given value to the given buffer as unsigned 64 bit integer (binary format) or as decimal number (CSV format).
+ * @param buffer The buffer the value should be added to.
+ * @param format The format of the buffer.
+ * @param value The value that should be added.
+ * @return true if the value was added, false otherwise.
+ */
+bool records_buffer_add_value(records_buffer_t* buffer, records_format_t format, uint64_t value);
+
+/**
+ * Creates empty (disabled) records.
+ * @return The created empty records.
+ */
+records_t records_create_empty();
+
+/**
+ * Creates the records file at the given path for the simulations of the given game and writes it's header
+ * (the header and the snakes and ladders section in binary format, the header row in CSV format,
+ * the preliminary header and the code lengths in archive format).
+ * @param filepath The path of the records file. An existing file is truncated.
+ * @param format The format of the records file.
+ * @param trace Indicates if the diced sides should be written with every record. Archives always contain the diced sides.
+ * @param game The game whose simulations are recorded.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully created records file
+ *
+ * - 1 not both filepath and game given
+ *
+ * - 2 unable to open records file
+ *
+ * - 3 unable to write header
+ *
+ * @return The created records, empty records if the records file could not be created.
+ */
+records_t records_create(const char* filepath, records_format_t format, bool trace, const game_t* game, int* error);
+
+/**
+ * Frees the given records closing the records file and resetting them to empty records.
+ * The writer thread must have been stopped with the records_stop function.
+ * @param records The records that should be freed.
+ */
+void records_free(records_t* records);
+
+/**
+ * Starts the writer thread of the given records.
+ * @param records The records whose writer should be started.
+ * @return true if the writer was started, false if no records file was given or the thread could not be started.
+ */
+bool records_start(records_t* records);
+
+/**
+ * Writes the remaining queued buffers, stops the writer thread of the given records and flushes the records file.
+ * In archive format the block index is appended and the header is rewritten with the final counts and offsets.
+ * Must be called after all producers finished.
+ * @param records The records whose writer should be stopped.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully wrote all records
+ *
+ * - 1 no records given
+ *
+ * - 2 unable to write records file
+ */
+int records_stop(records_t* records);
+
+/**
+ * Runs the writer of the given records until they are done and the queue is empty.
+ * Whenever the queue is not empty all queued buffers are taken at once, written in the order they were pushed and returned to their producers.
+ * @param records The records whose writer should be run.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran the writer
+ *
+ * - 1 no records given
+ */
+int records_writer_run(records_t* records);
+
+/**
+ * Creates an empty (disabled) producer.
+ * @return The created empty producer.
+ */
+records_producer_t records_producer_create_empty();
+
+/**
+ * Frees the given producer freeing all of it's buffers and resetting it to an empty producer.
+ * None of the producer's buffers may be queued (i.e. the writer was stopped).
+ * @param producer The producer that should be freed.
+ */
+void records_producer_free(records_producer_t* producer);
+
+/**
+ * Takes a buffer for the given producer: a buffer returned by the writer if there is one, otherwise a newly allocated buffer
+ * if the producer has less than RECORDS_PRODUCER_BUFFERS buffers. If all buffers are queued the producer waits until the writer returns one.
+ * @param producer The producer that needs a buffer.
+ * @return The empty buffer, 0 if no producer was given or the buffer could not be allocated.
+ */
+records_buffer_t* records_producer_acquire(records_producer_t* producer);
+
+/**
+ * Adds the record of the given finished simulation to the current buffer of the given producer.
+ * In archive format the trace is added to the buffer's last block if the simulation directly follows it's simulations, otherwise to a new block.
+ * If the producer has no current buffer one is taken with the records_producer_acquire function.
+ * If the producer is disabled no action is performed.
+ * @param producer The producer the record should be added to.
+ * @param simulation The finished simulation.
+ * @param index The index of the simulation.
+ * @return true if the record was added or the producer is disabled, false if the record could not be added.
+ */
+bool records_producer_add(records_producer_t* producer, const simulation_t* simulation, size_t index);
+
+/**
+ * Hands the current buffer of the given producer off to the writer by pushing it onto the queue of the producer's records
+ * if it contains at least RECORDS_BUFFER_SIZE bytes or the flush is forced.
+ * If the producer is disabled or the current buffer is empty no action is performed.
+ * @param producer The producer whose current buffer should be handed off.
+ * @param force Indicates if the buffer should be handed off regardless of it's size (e.g. because the producer finished).
+ */
+void records_producer_flush(records_producer_t* producer, bool force);
+
+/**
+ * Adds the trace of the given finished simulation to the current buffer of the given producer in archive format.
+ * The producer must have a current buffer.
+ * @param producer The producer the trace should be added to.
+ * @param simulation The finished simulation.
+ * @param index The index of the simulation.
+ * @return true if the trace was added, false if it could not be added.
+ */
+bool records_producer_add_trace(records_producer_t* producer, const simulation_t* simulation, size_t index);
+
+/**
+ * Compares the given archive blocks by their first simulation (qsort comparator).
+ * @param a The first block (archive_block_t).
+ * @param b The second block (archive_block_t).
+ * @return A negative value if a starts before b, a positive value if it starts after b, 0 otherwise.
+ */
+int records_block_compare(const void* a, const void* b);
+
+/**
+ * Finishes the archive of the given records after all blocks were written by appending the padded block index
+ * ordered by the first simulations and rewriting the header with the final counts and offsets.
+ * @param records The records in archive format that should be finished.
+ * @return true if the archive was finished, false if writing failed or the records file is not seekable.
+ */
+bool records_finish_archive(records_t* records);
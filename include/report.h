@@ -0,0 +1,74 @@
+#pragma once
+
+#include "statistics.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define REPORT_FORMAT_COUNT 2
+
+/**
+ * Enum to identify the format of a machine-readable report.
+ */
+typedef enum report_format_t {
+    REPORT_FORMAT_CSV,                  // Comma separated values with a header row, one row per result
+    REPORT_FORMAT_JSON                  // A JSON array with one object per result
+} report_format_t;
+
+/**
+ * Struct to store information about a report format.
+ */
+typedef struct report_format_info_t {
+    char* name;                         // The name of the report format
+} report_format_info_t;
+
+// Information about each report_format_t value
+extern report_format_info_t report_format_infos[REPORT_FORMAT_COUNT];
+
+/**
+ * Converts the string into the corresponding report format.
+ * It must be one of the following names: csv, json
+ * @param str The string that should be converted.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully parsed report format.
+ *
+ * - 1 no string given.
+ *
+ * - 2 unknown report format.
+ *
+ * @return The report format represented by the string, REPORT_FORMAT_CSV if the string could not be converted.
+ */
+report_format_t strtoreportformat(const char* str, int* error);
+
+/**
+ * Prints the given string to the given file as quoted JSON string escaping quotes, backslashes and control characters.
+ * If no string was given null is printed.
+ * @param file The file the string should be printed to (e.g. stdout).
+ * @param str The string that should be printed.
+ */
+void report_print_json_string(FILE* file, const char* str);
+
+/**
+ * Prints the given string to the given file as CSV field quoting it if it contains commas, quotes or line breaks.
+ * If no string was given an empty field is printed.
+ * @param file The file the string should be printed to (e.g. stdout).
+ * @param str The string that should be printed.
+ */
+void report_print_csv_string(FILE* file, const char* str);
+
+/**
+ * Prints the names of the statistics columns to the given file as CSV header fields, each preceded by a comma.
+ * @param file The file the header fields should be printed to (e.g. stdout).
+ */
+void report_print_stats_header(FILE* file);
+
+/**
+ * Prints the summary of the given statistics to the given file in the given format.
+ * For CSV each value is printed as field preceded by a comma, for JSON as members preceded by a comma.
+ * If no statistics were given the fields are left empty (CSV) or set to null (JSON).
+ * @param file The file the statistics should be printed to (e.g. stdout).
+ * @param stats The statistics that should be printed.
+ * @param format The format the statistics should be printed in.
+ */
+void report_print_stats(FILE* file, const stats_t* stats, report_format_t format);
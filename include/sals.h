@@ -1,7 +1,24 @@
 #pragma once
 
+#include "allocations.h"
+#include "archive.h"
 #include "assetmanager.h"
+#include "atomicfile.h"
+#include "batch.h"
+#include "board.h"
+#include "cache.h"
+#include "checkpoint.h"
 #include "cli.h"
+#include "diebench.h"
 #include "game.h"
+#include "generator.h"
+#include "interrupt.h"
+#include "partial.h"
+#include "perfcounters.h"
+#include "records.h"
+#include "serve.h"
 #include "simulator.h"
 #include "statistics.h"
+#include "sweep.h"
+#include "timings.h"
+#include "tsrand48.h"
@@ -0,0 +1,333 @@
+#pragma once
+
+#include "array.h"
+#include "cli.h"
+#include "game.h"
+#include "simulator.h"
+#include "statistics.h"
+#include "stopwatch.h"
+#include "tsrand48.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <threads.h>
+
+#define SERVE_STDIO_ENDPOINT "-"                // The endpoint that serves the requests on stdin and stdout instead of a unix domain socket
+#define SERVE_SUPPORTED_FLAGS (CLIAFLAG_WIDTH | CLIAFLAG_HEIGHT | CLIAFLAG_DIE_SIDES | CLIAFLAG_EXACT_ENDING | CLIAFLAG_DISTRIBUTION | CLIAFLAG_ITERATIONS \
+    | CLIAFLAG_DICE_LIMIT | CLIAFLAG_BAR_LENGTH | CLIAFLAG_TARGET_PRECISION | CLIAFLAG_REPORT_FORMAT | CLIAFLAG_SEED | CLIAFLAG_BOARD) // The options supported in requests
+#define SERVE_READ_BUFFER_SIZE 4096ul           // The number of bytes read at once from a client
+#define SERVE_REQUEST_SIZE_MAX (16ul << 20)     // The maximum number of bytes of a request line (e.g. the content of a large config file)
+#define SERVE_CACHE_CAPACITY 256ul              // The number of loaded boards after which the least recently used idle board is evicted
+#define SERVE_BACKLOG 64                        // The maximum number of pending connections on the unix domain socket
+#define SERVE_IDLE_INTERVAL_MS 100              // The interval in milliseconds in which an idle daemon checks whether a signal was received
+#define SERVE_JSON_WHITESPACE " \t\r\n"           // The characters that are whitespace in JSON
+#define SERVE_JSON_DEPTH_MAX 64ul               // The maximum nesting depth of the ignored members of a request
+
+/**
+ * Struct for a request that was parsed from a line of JSON.
+ */
+typedef struct serve_request_t {
+    char* id;                           // The JSON text of the id member which is echoed in the response, 0 if the request has no id
+    char* args;                         // The arguments of the request in the syntax of the command line or a config file
+} serve_request_t;
+
+/**
+ * Struct for the game and simulation settings described by the arguments of requests.
+ * The arguments are parsed and validated in the daemon without terminating it (see libsals_args_parse) and the game is loaded once,
+ * hence later requests with the same arguments reuse the loaded jump tables and die.
+ */
+typedef struct serve_board_t {
+    char* args;                         // The arguments the board was loaded from (the key of the cache)
+    char* error;                        // The reason why the arguments are invalid, 0 if valid
+    game_t game;                        // The game described by the arguments
+    size_t simcount;                    // The (maximum) number of simulations that should be run
+    size_t dicelimit;                   // The maximum allowed number of dices in a simulation before resigning if the game wasn't won yet
+    double targetprecision;             // The half-width of the 95% confidence interval of the average number of dices at which the simulations are stopped (0 if disabled)
+    bool seeded;                        // Indicates if the simulations should be rolled with streams derived from the seed
+    uint64_t seed;                      // The seed the streams of the simulations are derived from (if seeded)
+    size_t jobs;                        // The number of running jobs simulating the game, the board is not evicted while it is used
+    uint64_t lastused;                  // The number of the last request that used the board, the least recently used board is evicted first
+} serve_board_t;
+
+/**
+ * Struct for a client of a daemon sending requests and receiving one response line per request.
+ */
+typedef struct serve_client_t {
+    int fd;                             // The file descriptor the requests are read from
+    FILE* out;                          // The stream the responses are written to
+    bool owned;                         // Indicates if the file descriptor and stream are closed when the client is freed (false for stdin and stdout)
+    array_t input;                      // The received bytes of the request that was not terminated by a line break yet (element type: char)
+    bool ended;                         // Indicates that the client sends no more requests (end of input or the daemon stops)
+    bool broken;                        // Indicates that the responses can't be written anymore, hence the running jobs of the client are stopped
+    size_t jobs;                        // The number of running jobs of the client's requests
+} serve_client_t;
+
+/**
+ * Struct for the simulations of a request which are run by the thread pool of a daemon.
+ */
+typedef struct serve_job_t {
+    uint64_t number;                    // The number of the request, increasing in the order of arrival
+    serve_client_t* client;             // The client the response is written to
+    serve_board_t* board;               // The board whose game is simulated
+    char* id;                           // The JSON text of the request's id, 0 if the request has no id
+    bool cached;                        // Indicates if the board was loaded by an earlier request
+    stopwatch_t stopwatch;              // The stopwatch started when the request was received
+    simulator_t simulator;              // The simulator whose workers are run by the threads of the pool
+    array_t finished;                   // Indicates for each worker whether it finished, guarded by the daemon's mutex (element type: bool)
+    size_t finishedcount;               // The number of finished workers, guarded by the daemon's mutex
+    bool failed;                        // Indicates that a worker failed, guarded by the daemon's mutex
+} serve_job_t;
+
+// forward declarations
+typedef struct serve_t serve_t;
+
+/**
+ * Struct for a thread of the pool of a daemon.
+ */
+typedef struct serve_thread_t {
+    serve_t* server;                    // The daemon the thread belongs to
+    size_t index;                       // The index of the worker the thread runs in each job
+    uint64_t last;                      // The number of the job the thread ran it's last batch of (it's position in the round robin)
+    thrd_t thread;                      // The identifier of the thread
+    bool started;                       // Indicates if the thread was started successfully
+} serve_thread_t;
+
+/**
+ * Struct for a long-running daemon answering requests on a unix domain socket or on stdin and stdout.
+ * Every request line is a JSON object whose args member contains the arguments of a game in the syntax of the command line
+ * or a config file. The response line contains the id of the request and the statistics of the simulations.
+ * The calling thread reads the requests and writes the responses, the simulations of all running requests are run
+ * by one pool of threads that is started once: each thread runs one batch of SIMULATOR_BATCH_SIZE simulations at a time
+ * and takes the running jobs in turns (round robin), hence a small request is answered quickly even while large ones are running.
+ */
+typedef struct serve_t {
+    const char* endpoint;               // The path of the unix domain socket, SERVE_STDIO_ENDPOINT for stdin and stdout
+    pid_t pid;                          // The process identifier of the process that created the daemon
+    int listenfd;                       // The file descriptor of the listening unix domain socket, -1 when serving stdin and stdout
+    int wakefds[2];                     // The pipe a thread of the pool writes to when it finished the last worker of a job
+    array_t clients;                    // The connected clients (element type: serve_client_t*)
+    array_t boards;                     // The cached boards (element type: serve_board_t*)
+    array_t jobs;                       // The running jobs in the order of arrival, modified by the calling thread with the mutex locked (element type: serve_job_t*)
+    uint64_t seed;                      // The base the streams of random numbers of the workers of unseeded jobs are derived from
+    uint64_t requests;                  // The number of received requests
+    bool stopping;                      // Indicates that the threads of the pool should exit, guarded by the mutex
+    bool hassync;                       // Indicates if the mutex and condition were initialized
+    mtx_t mtx;                          // The mutex guarding the jobs and the progress of their workers
+    cnd_t cnd;                          // The condition signalled when a job was added or the threads should exit
+    serve_thread_t* threads;            // The threads of the pool
+    size_t threadcount;                 // The number of threads of the pool
+} serve_t;
+
+/**
+ * Frees the given request freeing it's id and arguments.
+ * @param request The request that should be freed.
+ */
+void serve_request_free(serve_request_t* request);
+
+/**
+ * Parses the 4 hexadecimal digits of a JSON unicode escape sequence.
+ * @param str The digits behind "\\u".
+ * @param codepoint The address the parsed code point is stored at.
+ * @return true if 4 hexadecimal digits were parsed, false if not all were given or a digit is invalid.
+ */
+bool serve_parse_json_hex(const char* str, uint32_t* codepoint);
+
+/**
+ * Parses the JSON string at the given position, decoding it's escape sequences into UTF-8.
+ * @param str The position of the string's opening quotation mark.
+ * @param value (optional) The array the decoded characters are added to (element type: char). If not given the string is only skipped.
+ * @return The position behind the string's closing quotation mark, 0 if the string is invalid or a character could not be added.
+ */
+const char* serve_parse_json_string(const char* str, array_t* value);
+
+/**
+ * Skips the JSON value (string, number, object, array, true, false or null) at the given position.
+ * @param str The position of the value.
+ * @param depth The nesting depth of the value, values nested deeper than SERVE_JSON_DEPTH_MAX are invalid.
+ * @return The position behind the value, 0 if the value is invalid.
+ */
+const char* serve_skip_json_value(const char* str, size_t depth);
+
+/**
+ * Parses the given line as JSON object with a string member args and an optional member id (a string, number, true, false or null).
+ * Other members are ignored. The id is parsed even if the arguments are invalid and kept on error, hence the request must always be freed.
+ * @param line The null-terminated line that should be parsed.
+ * @param request The address the parsed request is stored at.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully parsed request
+ *
+ * - 1 not all given
+ *
+ * - 2 line is not a JSON object
+ *
+ * - 3 member args missing or not a string, or member id not a string, number, true, false or null
+ *
+ * - 4 unable to allocate request
+ */
+int serve_parse_request(const char* line, serve_request_t* request);
+
+/**
+ * Frees the given board freeing it's arguments, error and game.
+ * @param board The board that should be freed.
+ */
+void serve_board_free(serve_board_t* board);
+
+/**
+ * Loads the board described by the given request arguments. The arguments are parsed with the libsals_args_parse_str function
+ * and the game is created with the libsals_args_game_create function, hence invalid arguments never terminate the daemon.
+ * Only the options describing the game, the iterations, dice limit, target precision, seed and a compiled board are supported,
+ * in particular config files are rejected without being read.
+ * @param args The arguments of a request.
+ * @return The loaded board (marked as invalid if the arguments are invalid), ownership is transferred to the caller. 0 if it could not be allocated.
+ */
+serve_board_t* serve_board_load(const char* args);
+
+/**
+ * Gets the cached board of the given request arguments or loads it (see serve_board_load), evicting the least recently used idle board
+ * if SERVE_CACHE_CAPACITY boards are cached already.
+ * @param server The daemon whose cache should be used.
+ * @param args The arguments of a request.
+ * @param cached The address that is set to true if the board was cached and false if it was loaded.
+ * @return The board, 0 if not all were given or it could not be loaded.
+ */
+serve_board_t* serve_board_get(serve_t* server, const char* args, bool* cached);
+
+/**
+ * Creates a client of a daemon.
+ * @param fd The file descriptor the requests are read from.
+ * @param out The stream the responses are written to.
+ * @param owned Indicates if the file descriptor and stream should be closed when the client is freed.
+ * @return The created client, ownership is transferred to the caller. 0 if it could not be allocated.
+ */
+serve_client_t* serve_client_create(int fd, FILE* out, bool owned);
+
+/**
+ * Frees the given client closing it's file descriptor and stream if it owns them.
+ * @param client The client that should be freed.
+ */
+void serve_client_free(serve_client_t* client);
+
+/**
+ * Frees the given job whose workers finished freeing it's id and simulator.
+ * @param job The job that should be freed.
+ */
+void serve_job_free(serve_job_t* job);
+
+/**
+ * Writes one response line to the given client. If it could not be written the client is marked as broken.
+ * @param client The client the response should be written to.
+ * @param id The JSON text of the request's id, 0 for null.
+ * @param status The status of the request: ok, invalid, interrupted or failed.
+ * @param error The reason why the request failed, 0 if it didn't.
+ * @param cached Indicates if the board of the request was cached.
+ * @param elapsed The number of seconds since the request was received.
+ * @param stats The statistics of the request's simulations, 0 if none.
+ */
+void serve_respond(serve_client_t* client, const char* id, const char* status, const char* error, bool cached, double elapsed, const stats_t* stats);
+
+/**
+ * Creates an empty daemon.
+ * @return The created empty daemon.
+ */
+serve_t serve_create_empty();
+
+/**
+ * Creates a daemon serving the given endpoint. The threads of it's pool are started by the serve_run function.
+ * If the endpoint is SERVE_STDIO_ENDPOINT the requests are read from stdin and the responses written to stdout,
+ * otherwise a unix domain socket is created at the path of the endpoint (replacing a stale socket no daemon listens on).
+ * @param endpoint The path of the unix domain socket or SERVE_STDIO_ENDPOINT.
+ * @param workers The number of threads of the pool, 0 for one thread per online processor.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully created daemon
+ *
+ * - 1 no endpoint given
+ *
+ * - 2 unable to create unix domain socket (e.g. path too long or not writable)
+ *
+ * - 3 another daemon listens on the unix domain socket
+ *
+ * - 4 unable to create the pipe, mutex or condition
+ *
+ * - 5 unable to allocate the thread pool
+ *
+ * @return The created daemon, an empty daemon if it could not be created.
+ */
+serve_t serve_create(const char* endpoint, size_t workers, int* error);
+
+/**
+ * Frees the given daemon stopping the threads of it's pool, closing it's clients and removing it's unix domain socket.
+ * @param server The daemon that should be freed.
+ */
+void serve_free(serve_t* server);
+
+/**
+ * Starts the threads of the pool of the given daemon. Must be called after the daemon was moved to it's final address,
+ * because the threads reference it by address.
+ * @param server The daemon whose threads should be started.
+ * @return true if all threads were started, false if no daemon was given or a thread could not be started.
+ */
+bool serve_start(serve_t* server);
+
+/**
+ * Selects the next job the given thread should run a batch of: the first job after the one the thread ran it's last batch of
+ * whose worker of the thread did not finish, starting over with the oldest job if there is none. The daemon's mutex must be locked.
+ * @param server The daemon whose jobs should be searched.
+ * @param thread The thread of the pool.
+ * @return The next job, 0 if the thread has no work in any job or not all were given.
+ */
+serve_job_t* serve_next_job(serve_t* server, const serve_thread_t* thread);
+
+/**
+ * Runs one batch of the given thread's worker at a time in the running jobs of it's daemon in turns (see serve_next_job)
+ * until the daemon stops. Waits while no job has work for the thread.
+ * @param thread The thread of the pool that should be run.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran until the daemon stopped
+ *
+ * - 1 no thread given
+ */
+int serve_thread_run(serve_thread_t* thread);
+
+/**
+ * Handles the given request line of the given client: parses it, gets the board of it's arguments and starts the job of it's simulations.
+ * Requests that can't be started are answered immediately.
+ * @param server The daemon that received the request.
+ * @param client The client that sent the request.
+ * @param line The null-terminated request line.
+ */
+void serve_handle_request(serve_t* server, serve_client_t* client, const char* line);
+
+/**
+ * Answers the jobs of the given daemon whose workers finished and frees them.
+ * @param server The daemon whose finished jobs should be answered.
+ */
+void serve_collect(serve_t* server);
+
+/**
+ * Reads the available input of the given client and handles every complete request line.
+ * @param server The daemon the client belongs to.
+ * @param client The client whose input should be read.
+ */
+void serve_read_client(serve_t* server, serve_client_t* client);
+
+/**
+ * Starts the thread pool of the given daemon and serves requests until the end of stdin (stdio endpoint) or until a SIGINT or SIGTERM is received.
+ * The daemon must not be moved while it is running.
+ * At a signal the running jobs are stopped at the next game boundary and answered with their partial statistics.
+ * @param server The daemon that should serve requests.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully served requests
+ *
+ * - 1 no daemon given
+ *
+ * - 2 unable to wait for requests
+ *
+ * - 3 unable to start the thread pool
+ */
+int serve_run(serve_t* server);
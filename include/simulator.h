@@ -1,41 +1,138 @@
 #pragma once
 
 #include "game.h"
+#include "loadingscreen.h"
+#include "perfcounters.h"
+#include "records.h"
 #include "snakeorladder.h"
+#include "statistics.h"
+#include "tsrand48.h"
 
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <threads.h>
 
+#define SIMULATOR_BATCH_SIZE 64ul                   // The number of simulations a worker claims at once
+#define SIMULATOR_PRECISION_MIN_SIMS 1000ul         // The minimum number of simulations before the target precision is checked
+#define SIMULATOR_COORDINATOR_INTERVAL_NS 10000000l // The interval in nanoseconds in which the coordinator checks the stopping criteria
+#define SIMULATOR_STOP_CHECK_DICES 1024ul           // The number of dices after which a running simulation checks whether the simulator was stopped (power of two)
+#define SIMULATOR_PAUSE_INTERVAL_NS 100000l         // The interval in nanoseconds in which paused workers check whether they may continue
+#define SIMULATOR_CACHE_LINE_SIZE 64ul              // The size of a cache line in bytes the progress counters of the workers are padded to
+
+// forward declarations
+typedef struct checkpoint_t checkpoint_t;
+
 /**
- * Struct for an optional size_t. Can optionally have value of type size_t.
+ * Struct for the progress counters of a worker which are read by the loading screen while the worker is running.
+ * Every worker only increments it's own counters and they are padded to a cache line, hence the increments are uncontended
+ * and the workers don't invalidate each other's cache lines.
  */
-typedef struct optional_size_t {
-    bool present;                   // Indicates if this optional has a value
-    size_t value;                   // The stored value
-} optional_size_t;
+typedef struct simulator_counter_t {
+    alignas(SIMULATOR_CACHE_LINE_SIZE) atomic_size_t games; // The number of games finished by the worker
+    atomic_size_t dices;                                    // The number of dices of the games finished by the worker
+} simulator_counter_t;
 
 /**
  * Struct used for managing simulations for a specific game.
+ * The simulations are run by a fixed number of workers which repeatedly claim batches of simulations
+ * until the requested number of simulations was claimed or the simulator was stopped. Each worker only keeps the state of the simulation
+ * it is currently running, thus the memory usage does not depend on the number of simulations.
+ * If a target precision is set the workers publish the summary statistics about the number of dices of each finished batch
+ * and the worker publishing the batch that reaches the target precision stops the simulator.
+ * If a time limit is set the coordinator stops the simulator as soon as the time limit passed.
+ * If a SIGINT or SIGTERM is received the coordinator stops the simulator as well and marks it as interrupted (see interrupt_install).
+ * If the simulator is seeded every simulation rolls the die with a stream derived from the seed and it's index and worker i runs
+ * the batches i, i + workercount, i + 2 * workercount, ... hence the partial statistics of every worker and the merged statistics are reproducible.
+ * A seeded simulator can be restricted to one of many shards: shard k of n only runs the batches k, k + n, k + 2 * n, ...
+ * which are distributed to it's workers the same way, hence the shards can be run by separate processes and their statistics merged.
+ * The coordinator can pause the workers between two batches (e.g. to take a checkpoint of their partial statistics).
  */
 typedef struct simulator_t {
     const game_t* game;             // The game simulations should be run on
     size_t dicelimit;               // The maximum allowed number of dices in a simulation before resigning if the game wasn't won yet.
-    array_t soldsts;                // The destinations of the snakes and ladders of the game (element type: size_t)
-    array_t solidxs;                // Maps each cell index to the index of it's corresponding snake or ladder in soldsts array (element type: optional_size_t)
-    array_t sims;                   // The array of simulations (element simulation_t)
+    size_t simcount;                // The maximum number of simulations that should be run
+    double targetprecision;         // The half-width of the 95% confidence interval of the average number of dices at which the simulator is stopped (0 if disabled)
+    double timelimit;               // The number of seconds after which the simulator is stopped (0 if disabled)
+    double elapsed;                 // The number of seconds it took to run the simulations
+    double setupelapsed;            // The number of seconds it took to create the simulator and prepare it's workers
+    _Atomic size_t nextsim;         // The index of the next simulation that was not claimed by a worker yet
+    atomic_bool stop;               // Indicates that the workers should stop claiming simulations
+    bool interrupted;               // Indicates that the simulator was stopped because of a SIGINT or SIGTERM, hence not all simulations were run
+    atomic_bool pause;              // Indicates that the workers should wait before claiming simulations until the flag is cleared
+    atomic_size_t pausedworkers;    // The number of workers that are waiting because of the pause flag
+    bool seeded;                    // Indicates if the simulations are rolled with streams derived from the seed
+    uint64_t seed;                  // The seed the streams of the simulations are derived from (if seeded)
+    size_t shard;                   // The 0 based index of the shard of the simulations run by the simulator (if seeded)
+    size_t shardcount;              // The number of shards the simulations are split into, 1 if not sharded
+    atomic_size_t activeworkers;    // The number of workers that did not finish yet
+    bool hasprogressmtx;            // Indicates if the progress mutex was initialized
+    mtx_t progressmtx;              // The mutex guarding the published progress
+    valstats_t progress;            // The summary statistics about the number of dices of all batches published by the workers
+    simulator_counter_t* counters;  // The progress counters of the workers while they are running (one per worker), 0 if they could not be allocated
+    array_t workers;                // The array of workers running the simulations (element type: worker_t)
+    records_t* records;             // The records the result of every simulation is written to, 0 if disabled
+    bool perfcounters;              // Indicates if the hardware events of the workers are counted
+    perfcounters_t perf;            // The hardware events of all threads of the simulations (counted around them by the coordinator, if perfcounters)
 } simulator_t;
 
 /**
  * Struct for a simulation of a snakes and ladders game.
  */
 typedef struct simulation_t {
-    simulator_t* simulator;         // The simulator the simulation belongs to
-    thrd_t thread;                  // The identifier of the thread the simulation is run on.
+    const simulator_t* simulator;   // The simulator the simulation belongs to
+    size_t index;                   // The index of the simulation within the simulations of the simulator
     bool aborted;                   // Indicates if the simulation was aborted because the SIMULATION_DICE_LIMIT was reached but the game is still running (potentially ran into an infinite loop)
     size_t playerpos;               // The player's position
     array_t soluses;                // The number of times each snake or ladder was used during the simulation (element type: size_t)
     array_t dices;                  // The sequence of diced sides during the simulation (element type: size_t)
 } simulation_t;
 
+/**
+ * Struct for a worker that runs simulations on a separate thread and collects their statistics thread-locally.
+ */
+typedef struct worker_t {
+    simulator_t* simulator;         // The simulator the worker belongs to
+    thrd_t thread;                  // The identifier of the thread the worker is run on
+    bool started;                   // Indicates if the worker's thread was started successfully
+    simulation_t sim;               // The simulation that is reused for every simulation run by the worker
+    stats_t stats;                  // The partial statistics of all simulations run by the worker
+    simulator_counter_t* counter;   // The progress counters the worker increments for every finished game, 0 if disabled
+    double elapsed;                 // The number of seconds the worker ran (summed over resumed runs of the process)
+    perfcounters_t perf;            // The hardware events of the worker's thread while it ran (if the simulator counts them)
+    size_t next;                    // The index of the next simulation the worker runs if the simulator is seeded
+    bool hasseed;                   // Indicates if the worker continues the stream of random numbers stored in seed instead of seeding a new one
+    tsseed48_t seed;                // The position in the worker's stream of random numbers when it was paused or finished
+    records_producer_t records;     // The producer formatting the records of the worker's simulations (disabled if the simulator has no records)
+} worker_t;
+
+/**
+ * Struct for the settings of the simulations run by the simulate function (see simulate_options_create for the defaults).
+ */
+typedef struct simulate_options_t {
+    size_t simcount;                // The (maximum) number of simulations that should be run
+    size_t workers;                 // The number of workers the simulations should be run on, 0 for one worker per online processor
+    size_t dicelimit;               // The maximum allowed number of dices in a simulation before resigning if the game wasn't won yet
+    double targetprecision;         // The half-width of the 95% confidence interval of the average number of dices at which the simulations are stopped (0 if disabled)
+    double timelimit;               // The number of seconds after which the simulations are stopped (0 if disabled)
+    records_t* records;             // The records the result of every simulation should be written to, 0 to disable
+    checkpoint_t* checkpoint;       // The checkpoints of the simulations, 0 to disable
+    const uint64_t* seed;           // The address of the seed the simulations should be rolled with, 0 to seed every worker randomly
+    size_t shard;                   // The 0 based index of the shard of the simulations that should be run (seeded simulations only, see simulator_shard)
+    size_t shardcount;              // The number of shards the simulations are split into, 1 to run all simulations
+    const valstats_t* progress;     // The summary statistics about the number of dices of previous simulations counted towards the target precision (e.g. loaded from a result cache), 0 if none
+    bool perfcounters;              // Indicates if hardware events should be counted for all threads of the simulations and per worker
+} simulate_options_t;
+
+/**
+ * Struct for a thread of a simulator pool which runs the workers of many simulators on one shared set of threads.
+ */
+typedef struct simulator_pool_thread_t {
+    const array_t* simulators;      // The simulators whose workers are run by the pool (element type: simulator_t*)
+    size_t index;                   // The index of the worker the thread runs in each simulator
+    thrd_t thread;                  // The identifier of the thread
+    bool started;                   // Indicates if the thread was started successfully
+} simulator_pool_thread_t;
+
 /**
  * Creates an empty simulation.
  * @return The created empty simulation.
@@ -49,7 +146,7 @@ simulation_t simulation_create_empty();
  * @param simulator The simulator the created simulation belongs to.
  * @return The created simulation.
  */
-simulation_t simulation_create(simulator_t* simulator);
+simulation_t simulation_create(const simulator_t* simulator);
 
 /**
  * Frees the given simulation freeing it's soluses array and resetting to an empty simulation.
@@ -57,6 +154,97 @@ simulation_t simulation_create(simulator_t* simulator);
  */
 void simulation_free(simulation_t* simulation);
 
+/**
+ * Resets the given simulation to the state before it was run, keeping the allocated memory of it's arrays.
+ * If no simulation was given no action is performed.
+ * @param simulation The simulation that should be reset.
+ */
+void simulation_reset(simulation_t* simulation);
+
+/**
+ * Creates an empty worker.
+ * @return The created empty worker.
+ */
+worker_t worker_create_empty();
+
+/**
+ * Creates a new worker for the given simulator with it's own simulation and partial statistics.
+ * If no simulator was given or the worker could not be created an empty worker is returned.
+ * @param simulator The simulator the created worker belongs to.
+ * @return The created worker.
+ */
+worker_t worker_create(simulator_t* simulator);
+
+/**
+ * Frees the given worker freeing it's simulation, statistics and record buffers and resetting it to an empty worker.
+ * @param worker The worker that should be freed.
+ */
+void worker_free(worker_t* worker);
+
+/**
+ * Claims the next batch of simulations for the given worker: the next SIMULATOR_BATCH_SIZE simulations that were not claimed by any worker
+ * or, if the simulator is seeded, the rest of the worker's own next batch. If the simulator is paused the worker waits with the worker_pause function first.
+ * @param worker The worker that should claim simulations.
+ * @param first The address the index of the first claimed simulation is stored at.
+ * @param last The address the index behind the last claimed simulation is stored at.
+ * @return true if simulations were claimed, false if all simulations were claimed, the simulator was stopped or not all were given.
+ */
+bool worker_claim(worker_t* worker, size_t* first, size_t* last);
+
+/**
+ * Waits until the pause flag of the worker's simulator is cleared, storing the position in the worker's stream of random numbers
+ * and counting the worker as paused while waiting.
+ * @param worker The worker that should wait.
+ */
+void worker_pause(worker_t* worker);
+
+/**
+ * Runs the claimed batch of simulations [first, last) on the worker's simulator with the thread local random number generator.
+ * The stop flag is checked before every simulation, a simulation that is interrupted by the stop flag is discarded.
+ * The simulations are analyzed into the worker's partial statistics and, if the simulator has records, added to the worker's producer.
+ * If the simulator has a target precision the summary statistics about the number of dices of the batch are published to the simulator
+ * and the simulator is stopped if they reach the target precision (see simulator_precision_reached).
+ * Every finished game is counted in the worker's progress counters.
+ * @param worker The worker that should run the batch.
+ * @param first The index of the first simulation of the batch (see worker_claim).
+ * @param last The index behind the last simulation of the batch.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran batch
+ *
+ * - 1 no worker given
+ *
+ * - 2 unable to add a simulation to the worker's statistics
+ *
+ * - 3 unable to add the record of a simulation
+ */
+int worker_run_batch(worker_t* worker, size_t first, size_t last);
+
+/**
+ * Finishes the given worker after it claimed it's last batch: hands it's remaining records off to the writer,
+ * stores the position in it's stream of random numbers and counts it as no longer active in it's simulator.
+ * @param worker The worker that finished.
+ */
+void worker_finish(worker_t* worker);
+
+/**
+ * Runs simulations on the worker's simulator until all simulations of the simulator were claimed or the simulator was stopped.
+ * The simulations are claimed in batches with the worker_claim function and run with the worker_run_batch function.
+ * The time the worker ran is added to it's elapsed time and, if the simulator counts hardware events, the events of the calling thread to it's performance counters.
+ * If the simulator has records the record of every simulation is added to the worker's producer which hands them off to the writer in buffers of RECORDS_BUFFER_SIZE bytes.
+ * @param worker The worker that should be run.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran simulations
+ *
+ * - 1 no worker given
+ *
+ * - 2 unable to add a simulation to the worker's statistics
+ *
+ * - 3 unable to add the record of a simulation
+ */
+int worker_run(worker_t* worker);
+
 /**
  * Creates an empty simulator.
  * @return The created empty simulator.
@@ -64,38 +252,176 @@ void simulation_free(simulation_t* simulation);
 simulator_t simulator_create_empty();
 
 /**
- * Creates a new simulator for the given game with the given simulation count.
- * @param game The game that should be simulated by simulations managed by the created simulator.
- * @param simcount The number of simulations that should be run on the specified game.
+ * Initializes the given simulator for the given game with the given simulation count.
+ * The number of workers is the given number of workers (see simulator_worker_count) but not more than the number of simulations.
+ * The workers and their simulations reference the given simulator by address, hence if it is moved afterwards
+ * the simulator_prepare function must be called at it's final address before the workers are run.
+ * @param simulator The simulator that should be initialized. Left as empty simulator if it could not be initialized.
+ * @param game The game that should be simulated by simulations managed by the simulator.
+ * @param simcount The (maximum) number of simulations that should be run on the specified game.
+ * @param workers The number of workers the simulations should be run on, 0 for one worker per online processor.
  * @param dicelimit The maximum allowed number of dices in a simulation before resigning if the game wasn't won yet.
- * @return The created simulator, an empty simulator if no game was given or simcount is 0.
+ * @param targetprecision The half-width of the 95% confidence interval of the average number of dices at which the simulations are stopped, 0 to disable.
+ * @param timelimit The number of seconds after which the simulations are stopped, 0 to disable.
+ * @return true if the simulator was initialized, false if no simulator or game was given, simcount is 0 or the workers could not be created.
+ */
+bool simulator_init(simulator_t* simulator, const game_t* game, size_t simcount, size_t workers, size_t dicelimit, double targetprecision, double timelimit);
+
+/**
+ * Seeds the given simulator, hence every simulation rolls the die with a stream derived from the given seed and it's index
+ * and the workers run fixed batches (see simulator_t). Must be called before the workers are run.
+ * @param simulator The simulator that should be seeded.
+ * @param seed The seed the streams of the simulations are derived from.
  */
-simulator_t simulator_create(const game_t* game, size_t simcount, size_t dicelimit);
+void simulator_seed(simulator_t* simulator, uint64_t seed);
 
 /**
- * Frees the given simulator freeing it's soldsts, solidxs and sims arrays and resetting to an empty simulator.
+ * Restricts the given seeded simulator to one shard of it's simulations: shard k of n runs the batches k, k + n, k + 2 * n, ...
+ * of the simulations (see simulator_t). Must be called after the simulator was seeded and before the workers are run.
+ * If no simulator was given, it is not seeded or the shard is not less than the number of shards no action is performed.
+ * @param simulator The simulator that should be restricted.
+ * @param shard The 0 based index of the shard.
+ * @param shardcount The number of shards.
+ */
+void simulator_shard(simulator_t* simulator, size_t shard, size_t shardcount);
+
+/**
+ * Frees the given simulator freeing it's workers array and resetting to an empty simulator.
  * @param simulator The simulator that should be reset.
  */
 void simulator_free(simulator_t* simulator);
 
 /**
- * Simulates the given game the specified number of times.
- * The simulations are run simultaneously on separate threads.
- * @param game The game that should be simulated.
+ * Determines the number of workers that should be used to run the given number of simulations.
+ * @param workers The requested number of workers, 0 for one worker per online processor.
  * @param simcount The number of simulations that should be run.
- * @return The simulator that ran the simulations.
+ * @return The requested number of workers if set, otherwise the number of online processors, but at least 1 and at most simcount.
+ */
+size_t simulator_worker_count(size_t workers, size_t simcount);
+
+/**
+ * Prepares the given simulator for running it's workers. Must be called at the simulator's final address
+ * before any worker is run, because the workers and their simulations reference the simulator by address.
+ * Initializes the progress mutex (ignoring the target precision if that fails), the number of active workers, the record producers of the workers
+ * and their progress counters (starting at the games already in their partial statistics, e.g. restored from a checkpoint).
+ * @param simulator The simulator that should be prepared.
+ */
+void simulator_prepare(simulator_t* simulator);
+
+/**
+ * Releases the resources needed while the workers of the given simulator were running (i.e. the progress mutex and counters).
+ * Must be called after all workers finished.
+ * @param simulator The simulator whose workers finished.
+ */
+void simulator_finish(simulator_t* simulator);
+
+/**
+ * Pauses the workers of the given simulator and waits until every worker that did not finish yet is paused between two batches,
+ * hence the partial statistics of the workers can be read consistently until the simulator is continued.
+ * @param simulator The simulator whose workers should be paused.
+ */
+void simulator_pause(simulator_t* simulator);
+
+/**
+ * Continues the workers of the given simulator after they were paused with the simulator_pause function.
+ * @param simulator The simulator whose workers should continue.
+ */
+void simulator_continue(simulator_t* simulator);
+
+/**
+ * Checks whether the given summary statistics meet the stopping criterion of a target precision: they contain at least
+ * SIMULATOR_PRECISION_MIN_SIMS simulations and the half-width of the 95% confidence interval of their average number of dices
+ * is at most the target precision.
+ * @param progress The summary statistics about the number of dices published so far.
+ * @param targetprecision The target precision, 0 if disabled.
+ * @return true if the criterion is met, false if not, the target precision is disabled or no statistics were given.
+ */
+bool simulator_precision_reached(const valstats_t* progress, double targetprecision);
+
+/**
+ * Checks whether the stopping criterion of the given simulator is met and stops it if so (see simulator_precision_reached).
+ * The workers check the criterion whenever they publish a batch as well, hence this only catches progress that was published otherwise.
+ * @param simulator The simulator whose stopping criterion should be checked.
+ * @return true if the simulator was stopped, false if the criterion is not met, the simulator has no target precision or none was given.
  */
-simulator_t simulate(const game_t* game, size_t simcount, size_t dicelimit);
+bool simulator_check_precision(simulator_t* simulator);
+
+/**
+ * Reads the progress of the given simulator for a loading screen (see loadingscreen_progress_fn_t) by summing the progress counters
+ * of it's workers without synchronizing with them. The total is the number of simulations of the simulator's shard, 0 if unbounded.
+ * If the simulator has no progress counters only the total and time limit are read.
+ * @param simulator The simulator whose progress should be read.
+ * @param progress The progress the simulator's progress is stored in.
+ */
+void simulator_read_progress(const simulator_t* simulator, loadingscreen_progress_t* progress);
+
+/**
+ * Runs worker thread->index of every simulator of the thread's pool one after another.
+ * @param thread The thread of the simulator pool that should be run.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran all workers
+ *
+ * - 1 no thread given
+ *
+ * - 2 a worker failed
+ */
+int simulator_pool_thread_run(simulator_pool_thread_t* thread);
+
+/**
+ * Runs the simulations of all given simulators on one shared pool of threads: thread i runs worker i of each simulator one after another,
+ * hence threads that finish a simulator early help out with the next simulator instead of waiting for the others.
+ * The simulators are prepared before and finished after running them. The calling thread coordinates the workers by checking
+ * the target precisions and whether a SIGINT or SIGTERM was received, which stops and marks all unfinished simulators as interrupted.
+ * Time limits are not applied.
+ * @param simulators The simulators that should be run, none of them may be moved while running (element type: simulator_t*).
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran all simulators
+ *
+ * - 1 no simulators given
+ *
+ * - 2 unable to allocate the thread pool
+ */
+int simulator_pool_run(const array_t* simulators);
+
+/**
+ * Creates the default settings of the simulate function: no simulations, dice limit and stopping criteria,
+ * no records or checkpoints, unseeded and unsharded without performance counters.
+ * @return The created settings.
+ */
+simulate_options_t simulate_options_create();
+
+/**
+ * Simulates the given game the specified number of times or until the given target precision is reached or the time limit passed.
+ * The simulations are run simultaneously by a pool of workers on separate threads
+ * while the calling thread coordinates the workers by checking the stopping criteria.
+ * If a SIGINT or SIGTERM is received the workers are stopped at the next game boundary and the simulator is marked as interrupted,
+ * hence the statistics of the finished games can be analyzed as partial statistics.
+ * If records are given the result of every simulation is handed off to their writer, whose thread must have been started (see records_start).
+ * If checkpoints are given the workers are paused every checkpoint interval to write their partial statistics to the checkpoint file
+ * and once more after they finished. If the checkpoint should be resumed the simulator is restored from the checkpoint file first
+ * and the time limit includes the time the simulations ran before.
+ * If hardware events should be counted but can't be a warning is printed and the simulations run without counting them.
+ * @param simulator The simulator the simulations are run by (see simulator_init), empty if it could not be initialized. Must be freed by the caller.
+ * @param game The game that should be simulated.
+ * @param options The settings of the simulations (see simulate_options_t).
+ */
+void simulate(simulator_t* simulator, const game_t* game, const simulate_options_t* options);
 
 /**
  * Runs the given simulation. The simulation holds a reference to the simulator the
  * simulation belongs to which contains information about the game that should be simulated.
+ * The simulation is reset before it is run, the die is rolled with the thread local random number generator.
+ * Every SIMULATOR_STOP_CHECK_DICES dices the simulation checks whether the simulator was stopped and if so interrupts the game.
  * @param simulation The simulation that should be run.
  * @return The error code, 0 on success.
- * 
+ *
  * - 0 successfully ran simulation
- * 
+ *
  * - 1 no simulation given
+ *
+ * - 2 the simulation was interrupted because the simulator was stopped
  */
 int simulation_run(simulation_t* simulation);
 
@@ -107,6 +433,14 @@ int simulation_run(simulation_t* simulation);
  */
 void simulator_print(const simulator_t* simulator, uint32_t indent, bool indentfirst);
 
+/**
+ * Prints the hardware events counted around the simulations of the given simulator normalized per game and dice
+ * and the instructions per dice, instructions per cycle and miss rates of every worker.
+ * If no simulator was given or it did not count hardware events nothing is printed.
+ * @param simulator The simulator whose hardware events should be printed.
+ */
+void simulator_print_perfcounters(const simulator_t* simulator);
+
 /**
  * Prints the given simulation with the given indent.
  * if indentfirst is false the first line is not indented.
@@ -26,7 +26,7 @@ bool isladder(snakeorladder_t* sol);
 
 /**
  * Parses the given string to a snakeorladder_t. The string must consist of two positive integer values > 0 separated by a hyphen '-'.
- * Format a-b where a and b are positive integer values > 0.
+ * Format a-b where a and b are positive integer values > 0. The string is parsed in place without allocating memory.
  * @param str The string that should be parsed.
  * @param error The address where the error code should be stored if it is given
  * 
@@ -34,7 +34,7 @@ bool isladder(snakeorladder_t* sol);
  * 
  * -  1 no string given
  * 
- * -  2 unable to duplicate the given string
+ * -  2 unused (the string is not duplicated anymore)
  * 
  * -  3 string does not contain the split character '-'
  * 
@@ -1,18 +1,36 @@
 #pragma once
 
-#include "simulator.h"
+#include "histogram.h"
+#include "snakeorladder.h"
 
 #include <stddef.h>
 
+#define STATS_HISTOGRAM_ROWS 20ul           // The maximum number of rows used to print the distribution of the number of dices
+#define STATS_HISTOGRAM_BAR_LENGTH 50ul     // The length of the longest bar used to print the distribution of the number of dices
+#define STATS_CI95_Z 1.959963984540054      // The z-score of the two-sided 95% confidence interval of the standard normal distribution
+#define STATS_REQUIRED_PRECISION 0.01       // The CI95 relative to the average number of dices that is used to report the number of needed simulations
+
+// forward declarations
+typedef struct simulator_t simulator_t;
+typedef struct simulation_t simulation_t;
+
 /**
  * The summary statistics about a set of unsigned integer values
- * containing the sum, minimum, maximum and average.
+ * containing the sum, minimum, maximum, average, variance and the 95% confidence interval of the average.
+ * The variance is tracked with Welford's online algorithm and merged with Chan's parallel algorithm
+ * which are both numerically stable, hence partial summary statistics can be collected independently and merged.
  */
 typedef struct valstats_t {
+    size_t count;                   // The number of statistically analyzed values
     size_t sum;                     // The sum of the statistically analyzed values
     size_t min;                     // The smallest out of the statistically analyzed values
     size_t max;                     // The largest out of the statistically analyzed values
+    double mean;                    // The running mean of the statistically analyzed values (Welford accumulator)
+    double m2;                      // The running sum of squared differences from the mean (Welford accumulator)
     double avg;                     // The average out of the statistically analyzed values
+    double var;                     // The sample variance of the statistically analyzed values
+    double stddev;                  // The sample standard deviation of the statistically analyzed values
+    double ci95;                    // The half-width of the 95% confidence interval of the average (avg +- ci95)
 } valstats_t;
 
 /**
@@ -25,16 +43,24 @@ typedef struct solstats_t {
 
 /**
  * Struct to store the statistics collected by many game simulations.
+ * The statistics can be collected in multiple partial statistics (e.g. one per thread) which are merged afterwards.
  */
 typedef struct stats_t {
     size_t sims;                    // The number of run simulations
+    double targetprecision;         // The targeted CI95 of the average number of dices at which the simulations were stopped (0 if disabled)
+    double timelimit;               // The number of seconds after which the simulations were stopped (0 if disabled)
+    bool interrupted;               // Indicates that the simulations were interrupted by a signal, hence the statistics are partial
+    double elapsed;                 // The number of seconds it took to run the simulations
+    double throughput;              // The number of simulations run per second (sims / elapsed)
     size_t wins;                    // The number of won games
     size_t losses;                  // The number of lost games (forfeited due to reaching the dice limit without winning)
     double winrate;                 // The relative number of wins (wins / sims)
     double lossrate;                // The relative number of losses (losses / sims)
     size_t dicelimit;               // The maximum allowed number of dices in a simulation before resigning if the game wasn't won yet.
     valstats_t dices;               // The summary statistics about the dices in all simulations
+    histogram_t diceshist;          // The distribution of the number of dices in all simulations
     array_t shortestdices;          // The shortest dice sequence to lead to a win out of all simulations (element type: size_t)
+    size_t shortestindex;           // The index of the simulation of the shortest dice sequence (the lowest index out of equally short sequences)
     valstats_t salsuses;            // The summary statistics about the number of used snakes and ladders in all simulations.
     valstats_t snakesuses;          // The summary statistics about the number of used snakes in all simulations.
     valstats_t laddersuses;         // The summary statistics about the number of used ladders in all simulations.
@@ -43,6 +69,37 @@ typedef struct stats_t {
     array_t sals;                   // Array of summary statistics about each individual snake or ladder in all simulations (element type: solstats_t)
 } stats_t;
 
+/**
+ * Creates empty summary statistics with no analyzed values.
+ * @return The created summary statistics.
+ */
+valstats_t valstats_create();
+
+/**
+ * Adds the given value to the summary statistics updating it's count, sum, minimum, maximum and Welford accumulators.
+ * The average, variance and confidence interval are updated when the statistics are finalized with the valstats_finalize function.
+ * If no summary statistics were given no action is performed.
+ * @param valstats The summary statistics the value should be added to.
+ * @param value The value that should be added.
+ */
+void valstats_add(valstats_t* valstats, size_t value);
+
+/**
+ * Merges the source summary statistics into the destination summary statistics.
+ * The Welford accumulators are combined with Chan's parallel algorithm.
+ * If not both summary statistics were given no action is performed.
+ * @param dst The summary statistics the source summary statistics should be merged into.
+ * @param src The summary statistics that should be merged into the destination summary statistics.
+ */
+void valstats_merge(valstats_t* dst, const valstats_t* src);
+
+/**
+ * Calculates the derived values (average, variance, standard deviation and confidence interval) of the given summary statistics.
+ * If no summary statistics were given no action is performed.
+ * @param valstats The summary statistics that should be finalized.
+ */
+void valstats_finalize(valstats_t* valstats);
+
 /**
  * Creates empty statistics ready to be used for simulations analysis.
  * @return The created statistics.
@@ -50,13 +107,66 @@ typedef struct stats_t {
 stats_t stats_create();
 
 /**
- * Frees the given statistics freeing it's shortestdices and snakes and ladders arrays.
+ * Frees the given statistics freeing it's histogram, shortestdices and snakes and ladders arrays.
  * @param stats The stats that should be freed.
  */
 void stats_free(stats_t* stats);
 
+/**
+ * Prepares the given empty statistics for analyzing simulations of the given simulator by setting it's dice limit, target precision and time limit
+ * and creating the histogram of the number of dices and the statistics about each snake or ladder of the simulator's game.
+ * @param stats The statistics that should be prepared.
+ * @param simulator The simulator whose simulations should be analyzed with the statistics.
+ * @return true if the statistics were prepared successfully, false otherwise.
+ */
+bool stats_init(stats_t* stats, const simulator_t* simulator);
+
+/**
+ * Adds the results of the given finished simulation to the statistics.
+ * The derived values (averages and rates) are updated when the statistics are finalized with the stats_finalize function.
+ * @param stats The statistics the simulation should be added to. It must have been prepared with the stats_init function.
+ * @param simulation The finished simulation that should be added.
+ * @return true if the simulation was added, false if not both were given or the simulation could not be added.
+ */
+bool stats_add(stats_t* stats, const simulation_t* simulation);
+
+/**
+ * Merges the source statistics into the destination statistics.
+ * Both statistics must have been prepared for the same simulator.
+ * @param dst The statistics the source statistics should be merged into.
+ * @param src The statistics that should be merged into the destination statistics.
+ * @return true if the statistics were merged, false if not both were given or they could not be merged.
+ */
+bool stats_merge(stats_t* dst, const stats_t* src);
+
+/**
+ * Calculates the derived values (averages, rates and throughput) of the given statistics.
+ * If no statistics were given no action is performed.
+ * @param stats The statistics that should be finalized.
+ */
+void stats_finalize(stats_t* stats);
+
+/**
+ * Collects the statistics of all the simulations run by the given simulator into the given empty statistics.
+ * The statistics are prepared for the simulator, the partial statistics collected by the simulator's workers are merged
+ * and the result is finalized, the elapsed time is taken from the simulator.
+ * @param stats The empty statistics the results should be collected in.
+ * @param simulator The simulator who's simulations should be statistically analyzed.
+ * @return true if the statistics were collected, false if not both were given or the statistics could not be prepared or merged.
+ */
+bool stats_collect(stats_t* stats, const simulator_t* simulator);
+
+/**
+ * Determines the number of bytes the given statistics occupy including their histogram, shortest dice sequence and snakes and ladders arrays.
+ * @param stats The statistics whose size should be determined.
+ * @return The number of bytes of the statistics, 0 if no statistics were given.
+ */
+size_t stats_size(const stats_t* stats);
+
 /**
  * Statistically analyzes of all the simulations run by the given simulator and returns the results.
+ * The statistics are collected with the stats_collect function. If they could not be collected
+ * an appropriate error message is output on stderr and the program is terminated with exit code 1.
  * @param simulator The simulator who's simulations should be statistically analyzed.
  * @return The results of the statistical analysis.
  */
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <time.h>
+
+/**
+ * Struct for a stopwatch measuring the elapsed time since it was started using the monotonic clock.
+ */
+typedef struct stopwatch_t {
+    struct timespec start;          // The point in time the stopwatch was started at
+} stopwatch_t;
+
+/**
+ * Creates a stopwatch that is started at the current point in time.
+ * @return The started stopwatch.
+ */
+stopwatch_t stopwatch_start();
+
+/**
+ * Determines the number of seconds that passed since the given stopwatch was started.
+ * @param stopwatch The stopwatch whose elapsed time should be determined.
+ * @return The elapsed seconds, 0 if no stopwatch was given.
+ */
+double stopwatch_elapsed(const stopwatch_t* stopwatch);
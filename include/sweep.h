@@ -0,0 +1,208 @@
+#pragma once
+
+#include "distribution.h"
+#include "game.h"
+#include "report.h"
+#include "simulator.h"
+#include "statistics.h"
+
+#define SWEEP_PARAM_COUNT 5
+
+// forward declarations
+typedef struct cli_args_t cli_args_t;
+
+/**
+ * Enum to identify a game parameter that can be swept.
+ */
+typedef enum sweep_param_kind_t {
+    SWEEP_PARAM_WIDTH,                  // The width of the playing field (values: unsigned integers)
+    SWEEP_PARAM_HEIGHT,                 // The height of the playing field (values: unsigned integers)
+    SWEEP_PARAM_DIE_SIDES,              // The number of sides of the die (values: unsigned integers)
+    SWEEP_PARAM_DISTRIBUTION,           // The distribution preset of the die (values: distr_preset_t)
+    SWEEP_PARAM_EXACT_ENDING            // The activation of the exact ending (values: 0 = off, 1 = on)
+} sweep_param_kind_t;
+
+/**
+ * Struct to store information about a sweepable game parameter.
+ */
+typedef struct sweep_param_info_t {
+    char* name;                         // The name of the parameter (same as the name of the corresponding long option)
+} sweep_param_info_t;
+
+// Information about each sweep_param_kind_t value
+extern sweep_param_info_t sweep_param_infos[SWEEP_PARAM_COUNT];
+
+/**
+ * Struct for a swept game parameter and the values it should take.
+ */
+typedef struct sweep_param_t {
+    sweep_param_kind_t kind;            // The swept parameter
+    array_t values;                     // The values the parameter should take in the order they were specified (element type: size_t)
+} sweep_param_t;
+
+/**
+ * Struct for a cached playing field shared by all variants with the same dimensions.
+ */
+typedef struct sweep_board_t {
+    size_t width;                       // The width of the playing field
+    size_t height;                      // The height of the playing field
+    const char* error;                  // The reason why the snakes and ladders don't fit on the playing field, 0 if valid
+    game_t game;                        // The game holding the edge list and jump tables of the playing field (without a die)
+} sweep_board_t;
+
+/**
+ * Struct for a cached die shared by all variants with the same die sides and distribution.
+ */
+typedef struct sweep_die_t {
+    size_t die_sides;                   // The number of sides of the die
+    distr_preset_t preset;              // The distribution preset of the die (DISTR_PRESET_NONE for the custom distribution weights)
+    const char* error;                  // The reason why the distribution could not be built, 0 if valid
+    die_t die;                          // The die built from the distribution
+} sweep_die_t;
+
+/**
+ * Struct for a single combination of the swept game parameters.
+ */
+typedef struct sweep_variant_t {
+    size_t width;                       // The width of the playing field
+    size_t height;                      // The height of the playing field
+    size_t die_sides;                   // The number of sides of the die
+    distr_preset_t distribution;        // The distribution preset of the die (DISTR_PRESET_NONE for the custom distribution weights)
+    bool exact_ending;                  // Indicates wether the game must end by exactly landing on the last cell
+    const char* error;                  // The reason why the variant is invalid, 0 if valid
+    game_t game;                        // The game of the variant referencing the cached board and die (not owned by the variant)
+    simulator_t simulator;              // The simulator running the simulations of the variant
+    stats_t stats;                      // The statistics of the simulations of the variant
+} sweep_variant_t;
+
+/**
+ * Struct for a parameter sweep running the simulations of many game variants in one process.
+ * Playing fields and dies are built once and shared by all variants using them.
+ * The simulations of all variants are run by one shared pool of threads (see simulator_pool_run).
+ */
+typedef struct sweep_t {
+    array_t boards;                     // The cached playing fields (element type: sweep_board_t)
+    array_t dies;                       // The cached dies (element type: sweep_die_t)
+    array_t variants;                   // The variants in the order of the swept parameters, the last one varying fastest (element type: sweep_variant_t)
+    double elapsed;                     // The number of seconds it took to run the simulations of all variants
+} sweep_t;
+
+/**
+ * Frees the given swept parameter freeing it's array of values.
+ * @param param The swept parameter that should be freed.
+ */
+void sweep_param_free(sweep_param_t* param);
+
+/**
+ * Converts the string into the corresponding swept parameter.
+ * The string must have the format <name>=<values> where name is one of
+ * width, height, die-sides, distribution, exact-ending
+ * and values is a comma separated list of values. For width, height and die-sides each value is either
+ * an unsigned integer or an inclusive range of unsigned integers <a>..<b>, for distribution each value
+ * is the name of a distribution preset and for exact-ending each value is either on or off.
+ * e.g. die-sides=4..8,12 distribution=uniform,twodice exact-ending=on,off
+ * @param str The string that should be converted.
+ * @param error The address the error code should be stored in. If not given the error code is not stored.
+ *
+ * - 0 successfully parsed swept parameter.
+ *
+ * - 1 no string given.
+ *
+ * - 2 unable to duplicate string.
+ *
+ * - 3 missing '=' between name and values.
+ *
+ * - 4 unknown parameter name.
+ *
+ * - 5 invalid value.
+ *
+ * - 6 invalid range (start > end).
+ *
+ * - 7 unable to add value.
+ *
+ * @return The swept parameter represented by the string, a parameter without values if the string could not be converted.
+ */
+sweep_param_t strtosweepparam(const char* str, int* error);
+
+/**
+ * Frees the given cached playing field freeing it's edge list and jump tables.
+ * @param board The cached playing field that should be freed.
+ */
+void sweep_board_free(sweep_board_t* board);
+
+/**
+ * Frees the given cached die freeing it's array of side probabilities.
+ * @param die The cached die that should be freed.
+ */
+void sweep_die_free(sweep_die_t* die);
+
+/**
+ * Frees the given variant freeing it's simulator and statistics. The cached playing field and die referenced by it's game are not freed.
+ * @param variant The variant that should be freed.
+ */
+void sweep_variant_free(sweep_variant_t* variant);
+
+/**
+ * Determines the cached playing field with the given dimensions, building and caching it if it wasn't cached yet.
+ * @param sweep The sweep whose cache should be used.
+ * @param width The width of the playing field.
+ * @param height The height of the playing field.
+ * @param sals The snakes and ladders of the playing field using 1 based cell indices (element type: snakeorladder_t).
+ * @return The cached playing field which is valid until the next playing field is cached, 0 if it could not be cached.
+ */
+sweep_board_t* sweep_get_board(sweep_t* sweep, size_t width, size_t height, const array_t* sals);
+
+/**
+ * Determines the cached die with the given die sides and distribution preset, building and caching it if it wasn't cached yet.
+ * @param sweep The sweep whose cache should be used.
+ * @param die_sides The number of sides of the die.
+ * @param preset The distribution preset of the die.
+ * @param weights The custom distribution weights used if the preset is DISTR_PRESET_NONE (element type: size_t).
+ * @return The cached die which is valid until the next die is cached, 0 if it could not be cached.
+ */
+sweep_die_t* sweep_get_die(sweep_t* sweep, size_t die_sides, distr_preset_t preset, const array_t* weights);
+
+/**
+ * Creates an empty sweep.
+ * @return The created empty sweep.
+ */
+sweep_t sweep_create_empty();
+
+/**
+ * Creates a sweep for every combination of the parameters swept in the given cli arguments.
+ * The parameters that are not swept take the value of the cli arguments. Every variant gets it's own simulator
+ * for the given number of simulations. Variants whose snakes and ladders don't fit on the playing field or whose distribution
+ * can't be built for the die sides are marked as invalid instead of terminating the program.
+ * If the sweep could not be allocated an appropriate error message is output on stderr and the program is terminated with exit code 1.
+ * @param cli_args The cli arguments containing the swept parameters and the values of the other parameters.
+ * @param simcount The (maximum) number of simulations that should be run for each variant.
+ * @return The created sweep.
+ */
+sweep_t sweep_create(const cli_args_t* cli_args, size_t simcount);
+
+/**
+ * Frees the given sweep freeing it's variants and cached playing fields and dies and resetting it to an empty sweep.
+ * @param sweep The sweep that should be freed.
+ */
+void sweep_free(sweep_t* sweep);
+
+/**
+ * Runs the simulations of all valid variants of the given sweep on a shared pool of threads with the simulator_pool_run function
+ * and collects their statistics.
+ * @param sweep The sweep that should be run.
+ * @return The error code, 0 on success.
+ *
+ * - 0 successfully ran all variants
+ *
+ * - 1 no sweep given
+ *
+ * - 2 unable to run the thread pool
+ */
+int sweep_run(sweep_t* sweep);
+
+/**
+ * Prints the results of all variants of the given sweep as one table keyed by the swept parameters in the given format.
+ * @param sweep The sweep that should be printed.
+ * @param format The format of the printed table.
+ */
+void sweep_print(const sweep_t* sweep, report_format_t format);
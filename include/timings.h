@@ -0,0 +1,120 @@
+#pragma once
+
+#include "array.h"
+#include "report.h"
+#include "simulator.h"
+#include "stopwatch.h"
+
+#include <stdio.h>
+
+#define TIMINGS_PHASE_COUNT 6
+
+/**
+ * Enum to identify a phase of a run whose duration is measured.
+ */
+typedef enum timings_phase_t {
+    TIMINGS_PHASE_CLI_PARSE,            // Parsing the command line arguments and the config file
+    TIMINGS_PHASE_GAME_SETUP,           // Setting up the game or loading it from a compiled board
+    TIMINGS_PHASE_SIMULATOR_CREATE,     // Creating the simulator, it's workers and their partial statistics
+    TIMINGS_PHASE_SIMULATE,             // Running the simulations on the workers
+    TIMINGS_PHASE_STATS_ANALYZE,        // Merging the partial statistics of the workers
+    TIMINGS_PHASE_STATS_PRINT           // Printing the statistics
+} timings_phase_t;
+
+/**
+ * Struct to store information about a phase.
+ */
+typedef struct timings_phase_info_t {
+    char* name;                         // The name of the phase
+} timings_phase_info_t;
+
+// Information about each timings_phase_t value
+extern timings_phase_info_t timings_phase_infos[TIMINGS_PHASE_COUNT];
+
+/**
+ * Struct for the measured time of a worker.
+ */
+typedef struct timings_worker_t {
+    double elapsed;                     // The number of seconds the worker ran
+    size_t games;                       // The number of games finished by the worker
+    size_t dices;                       // The number of dices of the games finished by the worker
+} timings_worker_t;
+
+/**
+ * Struct for the durations of the phases of a run and of it's workers measured with the monotonic clock,
+ * and the amounts of work the rates of the phases are derived from.
+ */
+typedef struct timings_t {
+    double phases[TIMINGS_PHASE_COUNT]; // The number of seconds spent in each phase
+    size_t configs;                     // The number of parsed configurations (the command line arguments and every config file they read)
+    size_t games;                       // The number of simulated games
+    size_t dices;                       // The number of dices of the simulated games
+    size_t aggregatedbytes;             // The number of bytes of partial statistics merged when analyzing the statistics
+    array_t workers;                    // The measured times of the workers (element type: timings_worker_t)
+} timings_t;
+
+/**
+ * Creates empty timings with no measured phases or workers.
+ * @return The created timings.
+ */
+timings_t timings_create();
+
+/**
+ * Frees the given timings freeing their workers array and resetting them to empty timings.
+ * @param timings The timings that should be freed.
+ */
+void timings_free(timings_t* timings);
+
+/**
+ * Adds the seconds that passed since the given stopwatch was started to the given phase.
+ * If no timings or stopwatch were given no action is performed.
+ * @param timings The timings the phase belongs to.
+ * @param phase The phase that was measured.
+ * @param stopwatch The stopwatch started at the beginning of the phase.
+ */
+void timings_add(timings_t* timings, timings_phase_t phase, const stopwatch_t* stopwatch);
+
+/**
+ * Collects the time it took to create the given simulator, the time every worker ran, the number of games and dices
+ * and the size of the partial statistics of the workers. Must be called before the partial statistics are analyzed.
+ * @param timings The timings the simulator's times should be added to.
+ * @param simulator The simulator that ran the simulations.
+ * @return true if the times were collected, false if not all were given or the workers could not be added.
+ */
+bool timings_collect(timings_t* timings, const simulator_t* simulator);
+
+/**
+ * Determines the number of seconds of all phases.
+ * @param timings The timings whose total should be determined.
+ * @return The number of seconds of all phases, 0 if no timings were given.
+ */
+double timings_total(const timings_t* timings);
+
+/**
+ * Prints the given timings as tables: one row per phase with it's share of the total time and the rates derived from it
+ * (configs parsed per second, games and dices per second, megabytes of partial statistics aggregated per second)
+ * and one row per worker with it's games and dices per second and the share of the simulation it was busy.
+ * @param timings The timings that should be printed.
+ */
+void timings_print(const timings_t* timings);
+
+/**
+ * Prints one phase or worker of timings to the given file in the given format (see timings_print_report).
+ * @param file The file the row should be printed to.
+ * @param kind The kind of the row which is either phase or worker.
+ * @param name The name of the phase or the index of the worker.
+ * @param seconds The number of seconds of the phase or worker.
+ * @param rates The configs, games, dices and megabytes per second, NAN if they don't apply.
+ * @param format The format the row should be printed in.
+ * @param first Indicates wether the row is the first row, hence no separator is printed before it (JSON).
+ */
+void timings_print_report_row(FILE* file, const char* kind, const char* name, double seconds, const double rates[4], report_format_t format, bool first);
+
+/**
+ * Prints the given timings to the given file in the given format, one row (CSV) or object (JSON) per phase and per worker
+ * with the columns kind, name, seconds, configs_per_s, games_per_s, dices_per_s and mb_per_s. Rates that don't apply are left empty (CSV) or null (JSON).
+ * @param file The file the timings should be printed to (e.g. stdout).
+ * @param timings The timings that should be printed.
+ * @param format The format the timings should be printed in.
+ */
+void timings_print_report(FILE* file, const timings_t* timings, report_format_t format);
@@ -27,6 +27,21 @@ tsseed48_t tsseed48(const tsseed48_t* newseed);
  */
 tsseed48_t tsnewseed48();
 
+/**
+ * Retrieves the thread local internal seed of the random number generator, i.e. the position in it's stream of random numbers.
+ * @return A copy of the current seed.
+ */
+tsseed48_t tsgetseed48();
+
+/**
+ * Derives the seed of the given stream from the given base seed by mixing both with the SplitMix64 finalizer,
+ * hence neighbouring streams get unrelated seeds and every stream is reproducible from the base seed alone.
+ * @param base The base seed.
+ * @param stream The index of the stream (e.g. the index of a simulation).
+ * @return The derived seed.
+ */
+tsseed48_t tsderiveseed48(uint64_t base, uint64_t stream);
+
 /**
  * Thread-safely generates a pseudo-random nonnegative double-precision floating-point value uniformly distributed over the interval [0.0, 1.0).
  * @return The pseudo-randomly generated double-precision floating-point value.
@@ -0,0 +1,155 @@
+#include "allocations.h"
+
+#include "cvts.h"
+
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <threads.h>
+
+allocations_subsystem_info_t allocations_subsystem_infos[ALLOCATIONS_SUBSYSTEM_COUNT] = {
+    { "other"     },
+    { "cli"       },
+    { "game"      },
+    { "simulator" },
+    { "stats"     }
+};
+
+allocations_counter_t allocations_counters[ALLOCATIONS_SUBSYSTEM_COUNT] = {};
+
+allocations_counter_t allocations_total = {};
+
+// the subsystem the allocations of the calling thread are accounted to
+static thread_local allocations_subsystem_t current = ALLOCATIONS_SUBSYSTEM_OTHER;
+
+// indicates if allocations are accounted at all (see allocations_enable)
+static atomic_bool accounting = false;
+
+// the accounting of the calling thread read once from the shared flag: -1 if not read yet, 0 if disabled, 1 if enabled
+static thread_local signed char threadaccounting = -1;
+
+void allocations_enable(bool enabled) {
+    atomic_store(&accounting, enabled);
+    threadaccounting = enabled;
+}
+
+bool allocations_enabled() {
+    if (threadaccounting < 0)
+        threadaccounting = atomic_load_explicit(&accounting, memory_order_relaxed);
+    return threadaccounting;
+}
+
+allocations_subsystem_t allocations_set_subsystem(allocations_subsystem_t subsystem) {
+    allocations_subsystem_t previous = current;
+    current = subsystem;
+    return previous;
+}
+
+allocations_subsystem_t allocations_subsystem() {
+    return current;
+}
+
+void allocations_account(allocations_subsystem_t subsystem, size_t oldsize, size_t newsize) {
+    // the shared counters are only touched if the allocations are printed
+    if (oldsize == newsize || !allocations_enabled())
+        return;
+    allocations_counter_update(&allocations_counters[subsystem], oldsize, newsize);
+    allocations_counter_update(&allocations_total, oldsize, newsize);
+}
+
+void allocations_counter_update(allocations_counter_t* counter, size_t oldsize, size_t newsize) {
+    if (!counter)
+        return;
+    if (oldsize == 0)
+        atomic_fetch_add_explicit(&counter->allocations, 1, memory_order_relaxed);
+    else if (newsize == 0)
+        atomic_fetch_add_explicit(&counter->frees, 1, memory_order_relaxed);
+    else
+        atomic_fetch_add_explicit(&counter->reallocations, 1, memory_order_relaxed);
+    if (newsize < oldsize) {
+        atomic_fetch_sub_explicit(&counter->live, oldsize - newsize, memory_order_relaxed);
+        return;
+    }
+    atomic_fetch_add_explicit(&counter->bytes, newsize - oldsize, memory_order_relaxed);
+    size_t live = atomic_fetch_add_explicit(&counter->live, newsize - oldsize, memory_order_relaxed) + newsize - oldsize;
+    // raise the peak unless another thread already raised it higher
+    size_t peak = atomic_load_explicit(&counter->peak, memory_order_relaxed);
+    while (peak < live && !atomic_compare_exchange_weak_explicit(&counter->peak, &peak, live, memory_order_relaxed, memory_order_relaxed));
+}
+
+void* allocations_malloc(allocations_subsystem_t subsystem, size_t size) {
+    void* data = malloc(size);
+    if (data)
+        allocations_account(subsystem, 0, size);
+    return data;
+}
+
+void* allocations_calloc(allocations_subsystem_t subsystem, size_t count, size_t size) {
+    void* data = calloc(count, size);
+    if (data)
+        allocations_account(subsystem, 0, count * size);
+    return data;
+}
+
+void* allocations_aligned_alloc(allocations_subsystem_t subsystem, size_t alignment, size_t size) {
+    void* data = aligned_alloc(alignment, size);
+    if (data)
+        allocations_account(subsystem, 0, size);
+    return data;
+}
+
+void* allocations_realloc(allocations_subsystem_t subsystem, void* data, size_t oldsize, size_t newsize) {
+    if (!data)
+        return allocations_malloc(subsystem, newsize);
+    void* newdata = realloc(data, newsize);
+    if (newdata)
+        allocations_account(subsystem, oldsize, newsize);
+    return newdata;
+}
+
+void allocations_free(allocations_subsystem_t subsystem, void* data, size_t size) {
+    if (!data)
+        return;
+    free(data);
+    allocations_account(subsystem, size, 0);
+}
+
+size_t allocations_peak_rss() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    // linux reports the maximum resident set size in kilobytes
+    return (size_t)usage.ru_maxrss * 1024;
+}
+
+void allocations_print(FILE* file) {
+    if (!file)
+        return;
+    fprintf(file,
+        "Allocations\n"
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%-9s  %10s  %10s  %10s  %14s  %14s  %12s%s \x1b(0x\x1b(B\n",
+        FMT(FMTVAL_BOLD), "SUBSYSTEM", "ALLOCS", "REALLOCS", "FREES", "BYTES", "PEAK", "LIVE", FMT(FMTVAL_NO_BOLD)
+    );
+    for (size_t i = 0; i < ALLOCATIONS_SUBSYSTEM_COUNT; i++) {
+        const allocations_counter_t* counter = &allocations_counters[i];
+        fprintf(file,
+            "  \x1b(0x\x1b(B %-9s  %10lu  %10lu  %10lu  %14lu  %14lu  %12lu \x1b(0x\x1b(B\n",
+            allocations_subsystem_infos[i].name, atomic_load(&counter->allocations), atomic_load(&counter->reallocations), atomic_load(&counter->frees),
+            atomic_load(&counter->bytes), atomic_load(&counter->peak), atomic_load(&counter->live)
+        );
+    }
+    fprintf(file,
+        "  \x1b(0x\x1b(B %s%-9s  %10lu  %10lu  %10lu  %14lu  %14lu  %12lu%s \x1b(0x\x1b(B\n"
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "  %sBytes of arrays and simulator objects, PEAK is the most bytes allocated at the same time and LIVE the bytes not freed before exit.%s\n"
+        "  Peak resident set size: %lu bytes.\n"
+        "\n",
+        FMT(FMTVAL_BOLD), "TOTAL", atomic_load(&allocations_total.allocations), atomic_load(&allocations_total.reallocations), atomic_load(&allocations_total.frees),
+        atomic_load(&allocations_total.bytes), atomic_load(&allocations_total.peak), atomic_load(&allocations_total.live), FMT(FMTVAL_NO_BOLD),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), allocations_peak_rss()
+    );
+}
+
+void allocations_print_exit() {
+    allocations_print(stderr);
+}
@@ -0,0 +1,478 @@
+#include "archive.h"
+
+#include "board.h"
+#include "cvts.h"
+#include "records.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int archive_symbol_compare(const void* a, const void* b) {
+    const archive_symbol_t* syma = a;
+    const archive_symbol_t* symb = b;
+    if (syma->prob != symb->prob)
+        return syma->prob < symb->prob ? -1 : 1;
+    return syma->side < symb->side ? -1 : syma->side > symb->side;
+}
+
+archive_codebook_t archive_codebook_create_empty() {
+    return (archive_codebook_t){
+        .lengths = array_create(0, sizeof(uint8_t), 0),
+        .codes = array_create(0, sizeof(uint32_t), 0),
+        .symbols = array_create(0, sizeof(size_t), 0)
+    };
+}
+
+archive_codebook_t archive_codebook_create(const die_t* die) {
+    if (!die || die_isempty(die))
+        return archive_codebook_create_empty();
+
+    // collect the sides that can be diced ordered from the least to the most probable
+    const size_t sidecount = die->sides.size;
+    archive_symbol_t* symbols = malloc(sidecount * sizeof(*symbols));
+    uint8_t* lengths = calloc(sidecount, sizeof(*lengths));
+    if (!symbols || !lengths) {
+        free(symbols);
+        free(lengths);
+        return archive_codebook_create_empty();
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < sidecount; i++) {
+        double prob = *(const double*)array_getconst(&die->sides, i);
+        if (prob > 0.0)
+            symbols[count++] = (archive_symbol_t){ prob, i };
+    }
+    if (count == 0 || count > (1ull << ARCHIVE_CODE_LENGTH_MAX)) {
+        free(symbols);
+        free(lengths);
+        return archive_codebook_create_empty();
+    }
+    qsort(symbols, count, sizeof(*symbols), archive_symbol_compare);
+
+    if (count == 1) {
+        lengths[symbols[0].side] = 1;
+    } else {
+        // build the Huffman tree with two queues (the sorted leaves and the internal nodes which are created in ascending order of their weight)
+        const size_t nodecount = 2 * count - 1;
+        double* weights = malloc(nodecount * sizeof(*weights));
+        size_t* parents = malloc(nodecount * sizeof(*parents));
+        size_t* lengthcounts = calloc(count, sizeof(*lengthcounts));
+        if (!weights || !parents || !lengthcounts) {
+            free(weights);
+            free(parents);
+            free(lengthcounts);
+            free(symbols);
+            free(lengths);
+            return archive_codebook_create_empty();
+        }
+        for (size_t i = 0; i < count; i++)
+            weights[i] = symbols[i].prob;
+        size_t leaf = 0;
+        size_t internal = count;
+        for (size_t node = count; node < nodecount; node++) {
+            size_t children[2];
+            for (size_t i = 0; i < 2; i++)
+                children[i] = leaf < count && (internal >= node || weights[leaf] <= weights[internal]) ? leaf++ : internal++;
+            weights[node] = weights[children[0]] + weights[children[1]];
+            parents[children[0]] = node;
+            parents[children[1]] = node;
+        }
+
+        // the depth of each node is one more than the depth of it's parent which was created after it
+        // (the depths are stored in the parents array in place, the root has depth 0)
+        size_t maxlength = 0;
+        parents[nodecount - 1] = 0;
+        for (size_t node = nodecount - 1; node-- > 0;) {
+            parents[node] = parents[parents[node]] + 1;
+            if (node < count) {
+                lengthcounts[parents[node]]++;
+                if (maxlength < parents[node])
+                    maxlength = parents[node];
+            }
+        }
+
+        // limit the code lengths by moving pairs of the longest codes up the tree (see JPEG standard, annex K.2)
+        for (size_t length = maxlength; length > ARCHIVE_CODE_LENGTH_MAX; length--) {
+            while (lengthcounts[length] > 0) {
+                size_t shorter = length - 2;
+                while (lengthcounts[shorter] == 0)
+                    shorter--;
+                lengthcounts[length] -= 2;
+                lengthcounts[length - 1]++;
+                lengthcounts[shorter + 1] += 2;
+                lengthcounts[shorter]--;
+            }
+        }
+
+        // assign the shortest codes to the most probable sides
+        size_t next = count;
+        for (size_t length = 1; length <= ARCHIVE_CODE_LENGTH_MAX && length <= maxlength; length++)
+            for (size_t i = 0; i < lengthcounts[length]; i++)
+                lengths[symbols[--next].side] = length;
+
+        free(weights);
+        free(parents);
+        free(lengthcounts);
+    }
+
+    archive_codebook_t codebook = archive_codebook_create_lengths(lengths, sidecount);
+    free(symbols);
+    free(lengths);
+    return codebook;
+}
+
+archive_codebook_t archive_codebook_create_lengths(const uint8_t* lengths, size_t sidecount) {
+    if (!lengths || sidecount == 0)
+        return archive_codebook_create_empty();
+
+    archive_codebook_t codebook = archive_codebook_create_empty();
+    for (size_t i = 0; i < sidecount; i++) {
+        if (lengths[i] > ARCHIVE_CODE_LENGTH_MAX)
+            return codebook;
+        codebook.counts[lengths[i]]++;
+    }
+    codebook.counts[0] = 0;
+
+    // the code lengths must not be over-subscribed (Kraft inequality), an incomplete code only wastes code space
+    uint64_t kraft = 0;
+    size_t symbolcount = 0;
+    for (size_t length = 1; length <= ARCHIVE_CODE_LENGTH_MAX; length++) {
+        kraft += (uint64_t)codebook.counts[length] << (ARCHIVE_CODE_LENGTH_MAX - length);
+        symbolcount += codebook.counts[length];
+    }
+    if (symbolcount == 0 || kraft > (1ull << ARCHIVE_CODE_LENGTH_MAX))
+        return codebook;
+
+    // calculate the first code and the first symbol of each length (canonical Huffman code)
+    uint64_t code = 0;
+    size_t offset = 0;
+    for (size_t length = 1; length <= ARCHIVE_CODE_LENGTH_MAX; length++) {
+        code = (code + codebook.counts[length - 1]) << 1;
+        codebook.firsts[length] = code;
+        codebook.offsets[length] = offset;
+        offset += codebook.counts[length];
+    }
+
+    if (!array_reserve(&codebook.lengths, sidecount) || !array_reserve(&codebook.codes, sidecount) || !array_reserve(&codebook.symbols, symbolcount)) {
+        archive_codebook_free(&codebook);
+        return codebook;
+    }
+    memcpy(codebook.lengths.data, lengths, sidecount);
+    codebook.lengths.size = sidecount;
+    codebook.codes.size = sidecount;
+    codebook.symbols.size = symbolcount;
+    size_t positions[ARCHIVE_CODE_LENGTH_MAX + 1];
+    memcpy(positions, codebook.offsets, sizeof(positions));
+    uint32_t* codes = codebook.codes.data;
+    size_t* symbols = codebook.symbols.data;
+    for (size_t i = 0; i < sidecount; i++) {
+        codes[i] = 0;
+        if (lengths[i] == 0)
+            continue;
+        codes[i] = codebook.firsts[lengths[i]] + (positions[lengths[i]] - codebook.offsets[lengths[i]]);
+        symbols[positions[lengths[i]]++] = i;
+    }
+    return codebook;
+}
+
+void archive_codebook_free(archive_codebook_t* codebook) {
+    if (!codebook)
+        return;
+    array_free(&codebook->lengths, 0);
+    array_free(&codebook->codes, 0);
+    array_free(&codebook->symbols, 0);
+    *codebook = archive_codebook_create_empty();
+}
+
+uint64_t archive_fingerprint(const game_t* game) {
+    if (!game)
+        return 0;
+    const uint64_t values[4] = { game->width, game->height, game->exact_ending, game->edges.size };
+    uint64_t fingerprint = board_checksum(BOARD_CHECKSUM_SEED, values, sizeof(values));
+    return board_checksum(fingerprint, game->edges.data, game->edges.size * sizeof(edge_t));
+}
+
+archive_header_t archive_header_create(const game_t* game) {
+    archive_header_t header = {
+        .version = ARCHIVE_VERSION,
+        .byteorder = ARCHIVE_BYTE_ORDER,
+        .fingerprint = archive_fingerprint(game),
+        .sidecount = game ? game->die.sides.size : 0,
+        .lengthsoffset = sizeof(archive_header_t)
+    };
+    memcpy(header.magic, ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE);
+    header.blocksoffset = header.lengthsoffset + (header.sidecount + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+    return header;
+}
+
+bool archive_encode(records_buffer_t* buffer, const archive_codebook_t* codebook, const array_t* dices) {
+    if (!buffer || !codebook || !dices || dices->size > (SIZE_MAX - 16) / ARCHIVE_CODE_LENGTH_MAX)
+        return false;
+    // reserve the worst case size so the trace is written without further checks (10 bytes for the varint)
+    if (!records_buffer_reserve(buffer, 11 + dices->size * ARCHIVE_CODE_LENGTH_MAX / 8))
+        return false;
+
+    unsigned char* out = buffer->data + buffer->size;
+    uint64_t value = dices->size;
+    do {
+        *out++ = (value & 0x7f) | (value > 0x7f ? 0x80 : 0);
+        value >>= 7;
+    } while (value != 0);
+
+    // append the codes most significant bit first
+    const uint8_t* lengths = codebook->lengths.data;
+    const uint32_t* codes = codebook->codes.data;
+    const size_t* sides = dices->data;
+    uint64_t bits = 0;
+    unsigned bitcount = 0;
+    for (size_t i = 0; i < dices->size; i++) {
+        size_t side = sides[i];
+        if (side == 0 || side > codebook->lengths.size || lengths[side - 1] == 0)
+            return false;
+        bits = (bits << lengths[side - 1]) | codes[side - 1];
+        bitcount += lengths[side - 1];
+        while (bitcount >= 8) {
+            bitcount -= 8;
+            *out++ = bits >> bitcount;
+        }
+        bits &= (1ull << bitcount) - 1;
+    }
+    if (bitcount != 0)
+        *out++ = bits << (8 - bitcount);
+
+    buffer->size = out - buffer->data;
+    return true;
+}
+
+int archive_decode(const unsigned char* data, size_t size, size_t* offset, const archive_codebook_t* codebook, array_t* dices) {
+    if (!data || !offset || !codebook)
+        return 1;
+
+    // read the number of dices
+    size_t pos = *offset;
+    uint64_t count = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        if (pos >= size || shift > 63)
+            return 2;
+        count |= (uint64_t)(data[pos] & 0x7f) << shift;
+        if (!(data[pos++] & 0x80))
+            break;
+    }
+    // every code has at least one bit
+    if (count > (size - pos) * 8)
+        return 2;
+    if (dices && !array_reserve(dices, dices->size + count))
+        return 3;
+
+    // decode the codes bit by bit, the codes of each length are consecutive numbers
+    const size_t* symbols = codebook->symbols.data;
+    size_t bitpos = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t code = 0;
+        size_t length = 1;
+        for (;; length++) {
+            if (length > ARCHIVE_CODE_LENGTH_MAX || pos + bitpos / 8 >= size)
+                return 2;
+            code = (code << 1) | ((data[pos + bitpos / 8] >> (7 - bitpos % 8)) & 1);
+            bitpos++;
+            if (code >= codebook->firsts[length] && code - codebook->firsts[length] < codebook->counts[length])
+                break;
+        }
+        if (dices) {
+            size_t side = symbols[codebook->offsets[length] + (code - codebook->firsts[length])] + 1;
+            array_add(dices, &side);
+        }
+    }
+    *offset = pos + (bitpos + 7) / 8;
+    return 0;
+}
+
+archive_t archive_create_empty() {
+    return (archive_t){ .codebook = archive_codebook_create_empty() };
+}
+
+archive_t archive_load(const char* filepath, int* error) {
+    if (!filepath) {
+        if (error)
+            *error = 1;
+        return archive_create_empty();
+    }
+    int fd = open(filepath, O_RDONLY);
+    struct stat filestat;
+    if (fd < 0 || fstat(fd, &filestat) != 0) {
+        if (fd >= 0)
+            close(fd);
+        if (error)
+            *error = 2;
+        return archive_create_empty();
+    }
+    if (!S_ISREG(filestat.st_mode) || (uint64_t)filestat.st_size < sizeof(archive_header_t)) {
+        close(fd);
+        if (error)
+            *error = 3;
+        return archive_create_empty();
+    }
+    size_t size = filestat.st_size;
+    void* mapping = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        if (error)
+            *error = 6;
+        return archive_create_empty();
+    }
+
+    // verify header and sections
+    archive_t archive = archive_create_empty();
+    archive.mapping = mapping;
+    archive.size = size;
+    archive.header = mapping;
+    const archive_header_t* header = archive.header;
+    int err = 0;
+    if (memcmp(header->magic, ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE) != 0)
+        err = 3;
+    else if (header->version != ARCHIVE_VERSION || header->byteorder != ARCHIVE_BYTE_ORDER)
+        err = 4;
+    else if (header->size != size || header->lengthsoffset != sizeof(archive_header_t) || header->sidecount > size
+        || header->blocksoffset != header->lengthsoffset + (header->sidecount + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT
+        || header->indexoffset < header->blocksoffset || header->indexoffset % ARCHIVE_ALIGNMENT != 0 || header->indexoffset > size
+        || header->blockcount != (size - header->indexoffset) / sizeof(archive_block_t) || (size - header->indexoffset) % sizeof(archive_block_t) != 0)
+        err = 5;
+    if (!err) {
+        archive.index = (const archive_block_t*)((const unsigned char*)mapping + header->indexoffset);
+        uint64_t simcount = 0;
+        for (size_t i = 0; !err && i < header->blockcount; i++) {
+            const archive_block_t* block = &archive.index[i];
+            if (block->offset < header->blocksoffset || block->offset > header->indexoffset || block->size > header->indexoffset - block->offset
+                || block->count == 0 || (i != 0 && block->first < archive.index[i - 1].first + archive.index[i - 1].count))
+                err = 5;
+            simcount += block->count;
+        }
+        if (!err && simcount != header->simcount)
+            err = 5;
+    }
+    if (!err) {
+        archive.codebook = archive_codebook_create_lengths((const uint8_t*)mapping + header->lengthsoffset, header->sidecount);
+        if (archive.codebook.symbols.size == 0)
+            err = 5;
+    }
+
+    if (err) {
+        archive_free(&archive);
+        if (error)
+            *error = err;
+        return archive;
+    }
+    if (error)
+        *error = 0;
+    return archive;
+}
+
+archive_t archive_setup(const char* filepath, const game_t* game) {
+    int error = 0;
+    archive_t archive = archive_load(filepath, &error);
+    switch (error) {
+        case 0:
+            break;
+        case 2:
+            fprintf(stderr, "%serror:%s unable to open trace archive '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 3:
+            fprintf(stderr, "%serror:%s '%s' is not a trace archive.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 4:
+            fprintf(stderr, "%serror:%s trace archive '%s' was written by an incompatible version or machine.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 5:
+            fprintf(stderr, "%serror:%s trace archive '%s' is corrupted.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        default:
+            fprintf(stderr, "%serror:%s unable to load trace archive '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+    }
+    if (!game || archive.header->fingerprint != archive_fingerprint(game) || archive.header->sidecount != game->die.sides.size) {
+        fprintf(stderr, "%serror:%s trace archive '%s' was recorded on another game. specify the same playing field, snakes and ladders and die sides.\n",
+            FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+        archive_free(&archive);
+        exit(1);
+    }
+    return archive;
+}
+
+void archive_free(archive_t* archive) {
+    if (!archive)
+        return;
+    if (archive->mapping)
+        munmap(archive->mapping, archive->size);
+    archive_codebook_free(&archive->codebook);
+    *archive = archive_create_empty();
+}
+
+int archive_get(const archive_t* archive, size_t index, array_t* dices) {
+    if (!archive || !archive->header || !dices)
+        return 1;
+
+    // find the last block starting at or before the simulation
+    size_t low = 0;
+    size_t high = archive->header->blockcount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (archive->index[mid].first <= index)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == 0 || index - archive->index[low - 1].first >= archive->index[low - 1].count)
+        return 2;
+    const archive_block_t* block = &archive->index[low - 1];
+
+    // skip the traces of the block's previous simulations
+    const unsigned char* data = (const unsigned char*)archive->mapping + block->offset;
+    size_t offset = 0;
+    for (size_t i = block->first; i < index; i++)
+        if (archive_decode(data, block->size, &offset, &archive->codebook, 0) != 0)
+            return 3;
+    switch (archive_decode(data, block->size, &offset, &archive->codebook, dices)) {
+        case 0:
+            return 0;
+        case 3:
+            return 4;
+        default:
+            return 3;
+    }
+}
+
+void archive_replay(const game_t* game, size_t index, const array_t* dices) {
+    if (!game || !dices)
+        return;
+    const size_t lastcell = game->width * game->height;
+    size_t playerpos = 0;
+    printf("simulation %lu (%lu dices)\n", index, dices->size);
+    for (size_t i = 0; i < dices->size; i++) {
+        size_t side = *(const size_t*)array_getconst(dices, i);
+        printf("  [%lu] diced %lu: %lu", i + 1, side, playerpos);
+        // move the player exactly like the simulation does
+        if (playerpos + side == lastcell || (!game->exact_ending && playerpos + side > lastcell)) {
+            playerpos = lastcell;
+            printf(" -> %lu (end)\n", playerpos);
+            continue;
+        } else if (playerpos + side > lastcell) {
+            printf(" (overshoots the last cell)\n");
+            continue;
+        }
+        playerpos += side;
+        printf(" -> %lu", playerpos);
+        const optional_size_t* solidx = array_getconst(&game->solidxs, playerpos - 1);
+        if (solidx->present) {
+            size_t dst = *(const size_t*)array_getconst(&game->soldsts, solidx->value) + 1;
+            printf(" -> %lu (%s %lu-%lu)", dst, dst > playerpos ? "ladder" : "snake", playerpos, dst);
+            playerpos = dst;
+        }
+        printf("\n");
+    }
+    printf("%s\n", playerpos == lastcell ? "won" : "not won (dice limit reached)");
+}
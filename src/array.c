@@ -1,6 +1,5 @@
 #include "array.h"
 
-#include <stdlib.h>
 #include <string.h>
 
 int byte_compare(size_t valuesize, const void* a, const void* b) {
@@ -19,19 +18,20 @@ int array_value_compare(array_t* array, const void* a, const void* b) {
 }
 
 array_t array_create(size_t initcapacity, size_t elementsize, comparator_fn_t comparator) {
+    const allocations_subsystem_t subsystem = allocations_subsystem();
     if (elementsize == 0)
-        return (array_t){ .comparator = comparator };
-    void* data = initcapacity != 0 ? malloc(initcapacity * elementsize) : 0;
+        return (array_t){ .comparator = comparator, .subsystem = subsystem };
+    void* data = initcapacity != 0 ? allocations_malloc(subsystem, initcapacity * elementsize) : 0;
     return data
-        ? (array_t){ .data = data, .capacity = initcapacity, .size = 0, .elementsize = elementsize, .comparator = comparator }
-        : (array_t){ .elementsize = elementsize, .comparator = comparator };
+        ? (array_t){ .data = data, .capacity = initcapacity, .size = 0, .elementsize = elementsize, .comparator = comparator, .subsystem = subsystem }
+        : (array_t){ .elementsize = elementsize, .comparator = comparator, .subsystem = subsystem };
 }
 
 void array_free_full(array_t* array) {
     if (!array)
         return;
     if (array->data)
-        free(array->data);
+        allocations_free(array->subsystem, array->data, array->capacity * array->elementsize);
     *array = (array_t){};
 }
 
@@ -42,7 +42,7 @@ void array_free(array_t* array, element_fn_t destructor) {
         if (destructor)
             for (size_t i = 0; i < array->size; i++)
                 destructor(array_get(array, i));
-        free(array->data);
+        allocations_free(array->subsystem, array->data, array->capacity * array->elementsize);
     }
     array->data = 0;
     array->capacity = 0;
@@ -64,7 +64,10 @@ bool array_reserve(array_t* array, size_t newcapacity) {
         return false;
     if (array->capacity >= newcapacity)
         return true;
-    void* newdata = array->data ? realloc(array->data, newcapacity * array->elementsize) : malloc(newcapacity * array->elementsize);
+    // arrays not created with array_create are accounted to the subsystem of the thread allocating their first memory block
+    if (!array->data && array->subsystem == ALLOCATIONS_SUBSYSTEM_OTHER)
+        array->subsystem = allocations_subsystem();
+    void* newdata = allocations_realloc(array->subsystem, array->data, array->capacity * array->elementsize, newcapacity * array->elementsize);
     if (!newdata)
         return false;
     array->data = newdata;
@@ -6,7 +6,7 @@
 #include <stdlib.h>
 
 assetmanager_t assetmanager = {
-    .assets = (array_t){ 0, 0, 0, sizeof(asset_t), 0 }
+    .assets = (array_t){ 0, 0, 0, sizeof(asset_t), 0, ALLOCATIONS_SUBSYSTEM_OTHER }
 };
 
 int assetmanager_init() {
@@ -0,0 +1,75 @@
+#include "atomicfile.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+atomicfile_t atomicfile_create_empty() {
+    return (atomicfile_t){
+        .filepath = 0,
+        .temppath = 0,
+        .file = 0
+    };
+}
+
+bool atomicfile_open(atomicfile_t* atomicfile, const char* filepath, mode_t mode) {
+    if (!atomicfile)
+        return false;
+    *atomicfile = atomicfile_create_empty();
+    if (!filepath)
+        return false;
+
+    // create temporary file next to the file, hence it is renamed within the same file system
+    const char suffix[] = ATOMICFILE_SUFFIX;
+    size_t pathlength = strlen(filepath);
+    char* temppath = malloc(pathlength + sizeof(suffix));
+    if (!temppath)
+        return false;
+    memcpy(temppath, filepath, pathlength);
+    memcpy(temppath + pathlength, suffix, sizeof(suffix));
+    int fd = mkstemp(temppath);
+    FILE* file = fd >= 0 ? fdopen(fd, "wb") : 0;
+    if (!file) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(temppath);
+        }
+        free(temppath);
+        return false;
+    }
+    if (mode != 0)
+        fchmod(fd, mode);
+
+    atomicfile->filepath = filepath;
+    atomicfile->temppath = temppath;
+    atomicfile->file = file;
+    return true;
+}
+
+int atomicfile_commit(atomicfile_t* atomicfile, bool success) {
+    if (!atomicfile || !atomicfile->file)
+        return 1;
+    FILE* file = atomicfile->file;
+    char* temppath = atomicfile->temppath;
+    const char* filepath = atomicfile->filepath;
+    *atomicfile = atomicfile_create_empty();
+
+    // flush the content to disk before renaming, hence a crash never leaves a renamed but incomplete file
+    success = fflush(file) == 0 && fsync(fileno(file)) == 0 && success;
+    success = fclose(file) == 0 && success;
+    if (!success) {
+        unlink(temppath);
+        free(temppath);
+        return 2;
+    }
+
+    // replace file atomically
+    if (rename(temppath, filepath) != 0) {
+        unlink(temppath);
+        free(temppath);
+        return 3;
+    }
+    free(temppath);
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "batch.h"
+
+#include "cli.h"
+#include "cvts.h"
+#include "libsals.h"
+#include "stopwatch.h"
+#include "str.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void batch_file_free(batch_file_t* file) {
+    if (!file)
+        return;
+    free(file->filepath);
+    free(file->error);
+    simulator_free(&file->simulator);
+    stats_free(&file->stats);
+    game_free(&file->game);
+    *file = (batch_file_t){};
+}
+
+bool batch_add_file(batch_t* batch, const char* filepath, const char* error) {
+    if (!batch || !filepath)
+        return false;
+    batch_file_t file = {
+        .filepath = strduplicate(filepath),
+        .error = error ? strduplicate(error) : 0,
+        .distribution = DISTR_PRESET_NONE,
+        .simulator = simulator_create_empty(),
+        .stats = stats_create()
+    };
+    if (!file.filepath || (error && !file.error) || !array_add(&batch->files, &file)) {
+        batch_file_free(&file);
+        return false;
+    }
+    return true;
+}
+
+char* batch_read_file(const char* filepath, size_t* size) {
+    if (!filepath || !size)
+        return 0;
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    array_t content = array_create(0, sizeof(char), 0);
+    char buffer[BATCH_READ_BUFFER_SIZE];
+    ssize_t count;
+    while ((count = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 || !array_reserve(&content, content.size + count)) {
+            array_free(&content, 0);
+            close(fd);
+            return 0;
+        }
+        memcpy((char*)content.data + content.size, buffer, count);
+        content.size += count;
+    }
+    close(fd);
+    // an empty config file has no content, but is read successfully
+    if (!content.data && !array_reserve(&content, 1))
+        return 0;
+    *size = content.size;
+    return content.data;
+}
+
+void batch_file_load(batch_file_t* file, const cli_args_t* cli_args) {
+    if (!file || !cli_args || file->error)
+        return;
+    size_t size = 0;
+    char* content = batch_read_file(file->filepath, &size);
+    if (!content) {
+        file->error = strduplicate("unable to read config file");
+        return;
+    }
+
+    // parse the config file once in this process, nested config files and options that don't describe a game are rejected
+    libsals_args_t file_args = libsals_args_create_empty();
+    int error = libsals_args_parse_str(&file_args, content, size, BATCH_SUPPORTED_FLAGS, "in the config files of a batch");
+    free(content);
+    if (!error)
+        file->game = libsals_args_game_create(&file_args, &error);
+    if (error) {
+        file->error = strduplicate(file_args.error[0] ? file_args.error : "config file does not describe a game");
+        libsals_args_free(&file_args);
+        return;
+    }
+
+    // the simulation settings of the batch override the ones of the config file
+    if (cli_args->setargsflags & CLIAFLAG_ITERATIONS) {
+        file_args.setargsflags |= CLIAFLAG_ITERATIONS;
+        file_args.options.simcount = cli_args->iterations;
+    }
+    if (cli_args->setargsflags & CLIAFLAG_DICE_LIMIT)
+        file_args.options.dicelimit = cli_args->dicelimit;
+    if (cli_args->setargsflags & CLIAFLAG_TARGET_PRECISION)
+        file_args.options.targetprecision = cli_args->targetprecision;
+
+    file->width = file_args.spec.width;
+    file->height = file_args.spec.height;
+    file->die_sides = file_args.spec.diesides;
+    file->distribution = file_args.preset;
+    file->exact_ending = file_args.spec.exactending;
+    file->dicelimit = file_args.options.dicelimit;
+    file->targetprecision = file_args.options.targetprecision;
+    file->simcount = file_args.options.simcount;
+    if (file->targetprecision > 0.0 && !(file_args.setargsflags & CLIAFLAG_ITERATIONS))
+        file->simcount = OPTVAL_ITERATIONS_MAX;
+    libsals_args_free(&file_args);
+}
+
+int batch_loader_run(batch_loader_t* loader) {
+    if (!loader)
+        return 1;
+    size_t index;
+    while ((index = atomic_fetch_add(loader->next, 1)) < loader->batch->files.size)
+        batch_file_load(array_get(&loader->batch->files, index), loader->cli_args);
+    return 0;
+}
+
+batch_t batch_create_empty() {
+    return (batch_t){
+        .files = array_create(0, sizeof(batch_file_t), 0),
+        .workers = 0,
+        .elapsed = 0.0
+    };
+}
+
+batch_t batch_create(const cli_args_t* cli_args) {
+    batch_t batch = batch_create_empty();
+    if (!cli_args)
+        return batch;
+    batch.workers = cli_args->workers;
+    for (size_t i = 0; i < cli_args->batchfiles.size; i++) {
+        const char* pattern = *(char* const*)array_getconst(&cli_args->batchfiles, i);
+        glob_t matches = {};
+        int res = glob(pattern, 0, 0, &matches);
+        bool added = true;
+        if (res == 0) {
+            for (size_t j = 0; added && j < matches.gl_pathc; j++)
+                added = batch_add_file(&batch, matches.gl_pathv[j], 0);
+        } else {
+            added = batch_add_file(&batch, pattern, res == GLOB_NOMATCH ? "no matching config file" : "unable to expand glob pattern");
+        }
+        globfree(&matches);
+        if (!added) {
+            fprintf(stderr, "%serror:%s unable to add config files of '%s' to the batch.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pattern);
+            exit(1);
+        }
+    }
+    return batch;
+}
+
+void batch_free(batch_t* batch) {
+    if (!batch)
+        return;
+    array_free(&batch->files, (element_fn_t)batch_file_free);
+    *batch = batch_create_empty();
+}
+
+int batch_validate(batch_t* batch, const cli_args_t* cli_args) {
+    if (!batch || !cli_args)
+        return 1;
+    size_t threadcount = simulator_worker_count(batch->workers, batch->files.size);
+    if (threadcount == 0)
+        threadcount = 1;
+    batch_loader_t* loaders = calloc(threadcount, sizeof(*loaders));
+    if (!loaders)
+        return 2;
+
+    // the threads claim the config files one at a time, hence a large config file doesn't hold up the others
+    atomic_size_t next = 0;
+    for (size_t i = 0; i < threadcount; i++) {
+        loaders[i] = (batch_loader_t){ .batch = batch, .cli_args = cli_args, .next = &next };
+        loaders[i].started = i != 0 && thrd_create(&loaders[i].thread, (thrd_start_t)batch_loader_run, &loaders[i]) == thrd_success;
+    }
+    // the calling thread loads config files as well, it also takes over the ones of threads that couldn't be started
+    batch_loader_run(&loaders[0]);
+    for (size_t i = 0; i < threadcount; i++)
+        if (loaders[i].started)
+            thrd_join(loaders[i].thread, 0);
+    free(loaders);
+    return 0;
+}
+
+int batch_run(batch_t* batch, const cli_args_t* cli_args) {
+    if (!batch || !cli_args)
+        return 1;
+
+    // create the simulators now that the files (and therefore their games) don't move anymore
+    array_t simulators = array_create(batch->files.size, sizeof(simulator_t*), 0);
+    for (size_t i = 0; i < batch->files.size; i++) {
+        batch_file_t* file = array_get(&batch->files, i);
+        if (file->error)
+            continue;
+        if (!simulator_init(&file->simulator, &file->game, file->simcount, cli_args->workers, file->dicelimit, file->targetprecision, 0.0)) {
+            file->error = strduplicate("unable to create simulator");
+            continue;
+        }
+        simulator_t* simulator = &file->simulator;
+        if (!array_add(&simulators, &simulator)) {
+            array_free(&simulators, 0);
+            return 2;
+        }
+    }
+
+    // run the simulators of all valid games on one shared thread pool
+    stopwatch_t stopwatch = stopwatch_start();
+    int error = simulator_pool_run(&simulators);
+    batch->elapsed = stopwatch_elapsed(&stopwatch);
+    array_free(&simulators, 0);
+    if (error)
+        return 2;
+
+    // collect the statistics of every valid game
+    for (size_t i = 0; i < batch->files.size; i++) {
+        batch_file_t* file = array_get(&batch->files, i);
+        if (!file->error && !stats_collect(&file->stats, &file->simulator))
+            file->error = strduplicate("unable to collect statistics");
+    }
+
+    return 0;
+}
+
+void batch_print(const batch_t* batch, report_format_t format) {
+    if (!batch)
+        return;
+    if (format == REPORT_FORMAT_JSON) {
+        printf("[\n");
+        for (size_t i = 0; i < batch->files.size; i++) {
+            const batch_file_t* file = array_getconst(&batch->files, i);
+            printf("  { \"file\": ");
+            report_print_json_string(stdout, file->filepath);
+            printf(", \"status\": \"%s\", \"error\": ", file->error ? "invalid" : file->stats.interrupted ? "interrupted" : "ok");
+            report_print_json_string(stdout, file->error);
+            if (file->error)
+                printf(", \"width\": null, \"height\": null, \"die_sides\": null, \"distribution\": null, \"exact_ending\": null");
+            else
+                printf(
+                    ", \"width\": %lu, \"height\": %lu, \"die_sides\": %lu, \"distribution\": \"%s\", \"exact_ending\": %s",
+                    file->width, file->height, file->die_sides, file->distribution != DISTR_PRESET_NONE ? distr_preset_infos[file->distribution].name : "custom",
+                    file->exact_ending ? "true" : "false"
+                );
+            report_print_stats(stdout, file->error ? 0 : &file->stats, format);
+            printf(" }%s\n", i != batch->files.size - 1 ? "," : "");
+        }
+        printf("]\n");
+        return;
+    }
+    printf("file,status,error,width,height,die_sides,distribution,exact_ending");
+    report_print_stats_header(stdout);
+    printf("\n");
+    for (size_t i = 0; i < batch->files.size; i++) {
+        const batch_file_t* file = array_getconst(&batch->files, i);
+        report_print_csv_string(stdout, file->filepath);
+        printf(",%s,", file->error ? "invalid" : file->stats.interrupted ? "interrupted" : "ok");
+        report_print_csv_string(stdout, file->error);
+        if (file->error)
+            printf(",,,,,");
+        else
+            printf(
+                ",%lu,%lu,%lu,%s,%s",
+                file->width, file->height, file->die_sides, file->distribution != DISTR_PRESET_NONE ? distr_preset_infos[file->distribution].name : "custom",
+                file->exact_ending ? "on" : "off"
+            );
+        report_print_stats(stdout, file->error ? 0 : &file->stats, format);
+        printf("\n");
+    }
+}
@@ -0,0 +1,298 @@
+#include "board.h"
+
+#include "atomicfile.h"
+#include "cvts.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+uint64_t board_checksum(uint64_t checksum, const void* data, size_t size) {
+    if (!data)
+        return checksum;
+    const unsigned char* bytes = data;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        checksum = (checksum ^ word) * BOARD_CHECKSUM_PRIME;
+    }
+    for (; i < size; i++)
+        checksum = (checksum ^ bytes[i]) * BOARD_CHECKSUM_PRIME;
+    return checksum;
+}
+
+uint64_t board_section_size(uint64_t count, uint64_t elementsize) {
+    if (elementsize != 0 && count > (UINT64_MAX - BOARD_ALIGNMENT) / elementsize)
+        return UINT64_MAX;
+    uint64_t size = count * elementsize;
+    return (size + BOARD_ALIGNMENT - 1) / BOARD_ALIGNMENT * BOARD_ALIGNMENT;
+}
+
+board_header_t board_header_create(const game_t* game) {
+    board_header_t header = {};
+    if (!game)
+        return header;
+    memcpy(header.magic, BOARD_MAGIC, BOARD_MAGIC_SIZE);
+    header.version = BOARD_VERSION;
+    header.byteorder = BOARD_BYTE_ORDER;
+    header.wordsize = sizeof(size_t);
+    header.flags = game->exact_ending ? BOARD_FLAG_EXACT_ENDING : 0;
+    header.width = game->width;
+    header.height = game->height;
+    header.sidecount = game->die.sides.size;
+    header.edgecount = game->edges.size;
+
+    // the tables of the game must be consistent with it's dimensions
+    size_t cellcount = game->width * game->height;
+    if (game->height == 0 || cellcount / game->height != game->width || game->solidxs.size != cellcount
+        || game->die.alias.size != game->die.sides.size || game->soldsts.size != game->edges.size)
+        return (board_header_t){};
+
+    // lay out the sections one after another
+    uint64_t sizes[] = {
+        board_section_size(header.sidecount, sizeof(double)),
+        board_section_size(header.sidecount, sizeof(die_alias_t)),
+        board_section_size(header.edgecount, sizeof(edge_t)),
+        board_section_size(header.edgecount, sizeof(size_t)),
+        board_section_size(cellcount, sizeof(optional_size_t))
+    };
+    uint64_t* offsets[] = { &header.sidesoffset, &header.aliasoffset, &header.edgesoffset, &header.soldstsoffset, &header.solidxsoffset };
+    uint64_t offset = board_section_size(1, sizeof(board_header_t));
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        if (sizes[i] == UINT64_MAX || offset > UINT64_MAX - sizes[i])
+            return (board_header_t){};
+        *offsets[i] = offset;
+        offset += sizes[i];
+    }
+    header.size = offset;
+    return header;
+}
+
+bool board_write(board_writer_t* writer, const void* data, size_t size) {
+    if (!writer || (!data && size != 0) || writer->failed)
+        return false;
+    if (size != 0 && fwrite(data, 1, size, writer->file) != size) {
+        writer->failed = true;
+        return false;
+    }
+    writer->size += size;
+    // hash complete words directly and keep the bytes of an incomplete word until it is completed by the next write
+    const unsigned char* bytes = data;
+    while (size != 0) {
+        if (writer->pendingsize == 0 && size >= sizeof(writer->pending)) {
+            size_t wordbytes = size / sizeof(writer->pending) * sizeof(writer->pending);
+            writer->checksum = board_checksum(writer->checksum, bytes, wordbytes);
+            bytes += wordbytes;
+            size -= wordbytes;
+            continue;
+        }
+        size_t count = sizeof(writer->pending) - writer->pendingsize < size ? sizeof(writer->pending) - writer->pendingsize : size;
+        memcpy(writer->pending + writer->pendingsize, bytes, count);
+        writer->pendingsize += count;
+        bytes += count;
+        size -= count;
+        if (writer->pendingsize == sizeof(writer->pending)) {
+            writer->checksum = board_checksum(writer->checksum, writer->pending, sizeof(writer->pending));
+            writer->pendingsize = 0;
+        }
+    }
+    return true;
+}
+
+bool board_write_padding(board_writer_t* writer) {
+    if (!writer)
+        return false;
+    static const char zeros[BOARD_ALIGNMENT] = {};
+    size_t remainder = writer->size % BOARD_ALIGNMENT;
+    return board_write(writer, zeros, remainder != 0 ? BOARD_ALIGNMENT - remainder : 0);
+}
+
+int board_compile(const game_t* game, const char* filepath) {
+    if (!game || !filepath)
+        return 1;
+    board_header_t header = board_header_create(game);
+    if (header.size == 0)
+        return 2;
+
+    // create temporary file next to the board file (readable by everyone as the board is meant to be shared)
+    atomicfile_t atomicfile;
+    if (!atomicfile_open(&atomicfile, filepath, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH))
+        return 3;
+    FILE* file = atomicfile.file;
+
+    // reserve the header which is written once the checksum of the sections is known
+    board_writer_t writer = { .file = file, .size = 0, .checksum = BOARD_CHECKSUM_SEED, .pendingsize = 0, .failed = false };
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1 && fseek(file, header.sidesoffset, SEEK_SET) == 0;
+    writer.size = header.sidesoffset;
+
+    // write die sections (struct members are copied into zeroed structs to write deterministic padding bytes)
+    success = success && board_write(&writer, game->die.sides.data, game->die.sides.size * sizeof(double)) && board_write_padding(&writer);
+    for (size_t i = 0; success && i < game->die.alias.size; i++) {
+        const die_alias_t* column = array_getconst(&game->die.alias, i);
+        die_alias_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.prob = column->prob;
+        entry.alias = column->alias;
+        success = board_write(&writer, &entry, sizeof(entry));
+    }
+    success = success && board_write_padding(&writer);
+
+    // write snakes and ladders sections
+    for (size_t i = 0; success && i < game->edges.size; i++) {
+        const edge_t* edge = array_getconst(&game->edges, i);
+        edge_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.from = edge->from;
+        entry.to = edge->to;
+        success = board_write(&writer, &entry, sizeof(entry));
+    }
+    success = success && board_write_padding(&writer);
+    success = success && board_write(&writer, game->soldsts.data, game->soldsts.size * sizeof(size_t)) && board_write_padding(&writer);
+    for (size_t i = 0; success && i < game->solidxs.size; i++) {
+        const optional_size_t* solidx = array_getconst(&game->solidxs, i);
+        optional_size_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.present = solidx->present;
+        entry.value = solidx->present ? solidx->value : 0;
+        success = board_write(&writer, &entry, sizeof(entry));
+    }
+    success = success && board_write_padding(&writer) && writer.size == header.size;
+
+    // write header with checksums
+    header.checksum = writer.checksum;
+    header.headerchecksum = board_checksum(BOARD_CHECKSUM_SEED, &header, offsetof(board_header_t, headerchecksum));
+    success = success && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // replace board file atomically
+    int error = atomicfile_commit(&atomicfile, success);
+    return error ? error + 2 : 0;
+}
+
+game_t board_load(const char* filepath, int* error) {
+    if (!filepath) {
+        if (error)
+            *error = 1;
+        return (game_t){};
+    }
+    int fd = open(filepath, O_RDONLY);
+    struct stat filestat;
+    if (fd < 0 || fstat(fd, &filestat) != 0) {
+        if (fd >= 0)
+            close(fd);
+        if (error)
+            *error = 2;
+        return (game_t){};
+    }
+    if (!S_ISREG(filestat.st_mode) || (uint64_t)filestat.st_size < sizeof(board_header_t)) {
+        close(fd);
+        if (error)
+            *error = 3;
+        return (game_t){};
+    }
+
+    // map the board file read-only and shared so processes loading the same board share it's pages
+    size_t size = filestat.st_size;
+    void* mapping = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        if (error)
+            *error = 6;
+        return (game_t){};
+    }
+
+    // verify header
+    const board_header_t* header = mapping;
+    int err = 0;
+    if (memcmp(header->magic, BOARD_MAGIC, BOARD_MAGIC_SIZE) != 0)
+        err = 3;
+    else if (header->version != BOARD_VERSION || header->byteorder != BOARD_BYTE_ORDER || header->wordsize != sizeof(size_t))
+        err = 4;
+    else if (header->headerchecksum != board_checksum(BOARD_CHECKSUM_SEED, header, offsetof(board_header_t, headerchecksum)))
+        err = 5;
+
+    // verify that the sections are laid out as the compiler lays them out and cover the whole file
+    if (!err) {
+        game_t game = {
+            .width = header->width,
+            .height = header->height,
+            .exact_ending = header->flags & BOARD_FLAG_EXACT_ENDING,
+            .die = { .sides = { .size = header->sidecount }, .alias = { .size = header->sidecount } },
+            .edges = { .size = header->edgecount },
+            .soldsts = { .size = header->edgecount },
+            .solidxs = { .size = header->width * header->height }
+        };
+        board_header_t expected = board_header_create(&game);
+        if (expected.size != size || expected.size != header->size || expected.sidesoffset != header->sidesoffset
+            || expected.aliasoffset != header->aliasoffset || expected.edgesoffset != header->edgesoffset
+            || expected.soldstsoffset != header->soldstsoffset || expected.solidxsoffset != header->solidxsoffset)
+            err = 5;
+    }
+
+    if (err) {
+        munmap(mapping, size);
+        if (error)
+            *error = err;
+        return (game_t){};
+    }
+
+    // reference the sections of the mapping as arrays
+    const char* data = mapping;
+    size_t cellcount = header->width * header->height;
+    game_t game = {
+        .width = header->width,
+        .height = header->height,
+        .exact_ending = header->flags & BOARD_FLAG_EXACT_ENDING,
+        .die = {
+            .sides = { (void*)(data + header->sidesoffset), header->sidecount, header->sidecount, sizeof(double), 0 },
+            .alias = { (void*)(data + header->aliasoffset), header->sidecount, header->sidecount, sizeof(die_alias_t), 0 }
+        },
+        .edges = { (void*)(data + header->edgesoffset), header->edgecount, header->edgecount, sizeof(edge_t), 0 },
+        .soldsts = { (void*)(data + header->soldstsoffset), header->edgecount, header->edgecount, sizeof(size_t), 0 },
+        .solidxs = { (void*)(data + header->solidxsoffset), cellcount, cellcount, sizeof(optional_size_t), 0 },
+        .mapping = mapping,
+        .mappingsize = size
+    };
+    if (error)
+        *error = 0;
+    return game;
+}
+
+bool board_verify(const game_t* game) {
+    if (!game || !game->mapping || game->mappingsize < sizeof(board_header_t))
+        return false;
+    const board_header_t* header = game->mapping;
+    return header->checksum == board_checksum(BOARD_CHECKSUM_SEED, (const char*)game->mapping + header->sidesoffset, game->mappingsize - header->sidesoffset);
+}
+
+game_t board_setup(const char* filepath, bool verify) {
+    int error = 0;
+    game_t game = board_load(filepath, &error);
+    if (!error && verify && !board_verify(&game)) {
+        game_free(&game);
+        error = 5;
+    }
+    switch (error) {
+        case 0:
+            return game;
+        case 2:
+            fprintf(stderr, "%serror:%s unable to open board file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 3:
+            fprintf(stderr, "%serror:%s '%s' is not a board file.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 4:
+            fprintf(stderr, "%serror:%s board file '%s' was compiled by an incompatible version or machine. compile it again.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 5:
+            fprintf(stderr, "%serror:%s board file '%s' is corrupted.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        default:
+            fprintf(stderr, "%serror:%s unable to load board file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+    }
+}
@@ -0,0 +1,135 @@
+#include "cache.h"
+
+#include "partial.h"
+#include "simulator.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+cache_t cache_create_empty() {
+    return (cache_t){};
+}
+
+cache_t cache_create(const char* dirpath, const game_t* game, size_t dicelimit, int* error) {
+    int tmp;
+    if (!error)
+        error = &tmp;
+    *error = 0;
+    cache_t cache = cache_create_empty();
+    if (!dirpath || !game) {
+        *error = 1;
+        return cache;
+    }
+
+    // create the cache directory unless it exists
+    if (mkdir(dirpath, 0777) != 0 && errno != EEXIST) {
+        *error = 2;
+        return cache;
+    }
+    struct stat dirstat;
+    if (stat(dirpath, &dirstat) != 0 || !S_ISDIR(dirstat.st_mode)) {
+        *error = 2;
+        return cache;
+    }
+
+    // name the entry after the canonical hash of the game
+    cache.key = game_hash(game, dicelimit);
+    cache.dicelimit = dicelimit;
+    cache.solcount = game->edges.size;
+    size_t pathlength = strlen(dirpath);
+    size_t filepathsize = pathlength + 18 + sizeof(CACHE_ENTRY_EXTENSION);
+    size_t lockpathsize = pathlength + 1 + sizeof(CACHE_LOCK_FILENAME);
+    cache.filepath = malloc(filepathsize);
+    cache.lockpath = malloc(lockpathsize);
+    if (cache.key == 0 || !cache.filepath || !cache.lockpath) {
+        cache_free(&cache);
+        *error = 3;
+        return cache;
+    }
+    snprintf(cache.filepath, filepathsize, "%s/%016" PRIx64 "%s", dirpath, cache.key, CACHE_ENTRY_EXTENSION);
+    snprintf(cache.lockpath, lockpathsize, "%s/%s", dirpath, CACHE_LOCK_FILENAME);
+    return cache;
+}
+
+void cache_free(cache_t* cache) {
+    if (!cache)
+        return;
+    free(cache->filepath);
+    free(cache->lockpath);
+    *cache = cache_create_empty();
+}
+
+int cache_load(const cache_t* cache, stats_t* stats) {
+    if (!cache || !cache->filepath || !stats)
+        return 1;
+    if (access(cache->filepath, F_OK) != 0)
+        return 2;
+
+    // the entry must belong to the game, hash collisions are detected by the dice limit and number of snakes and ladders
+    partial_header_t header;
+    if (partial_load(cache->filepath, &header, stats) != 0 || header.fingerprint != cache->key || header.dicelimit != cache->dicelimit
+        || header.solcount != cache->solcount || header.shardcount != 1) {
+        stats_free(stats);
+        return 3;
+    }
+    stats_finalize(stats);
+    return 0;
+}
+
+bool cache_satisfies(const stats_t* stats, size_t simcount, double targetprecision) {
+    if (!stats)
+        return false;
+    if (stats->sims >= simcount)
+        return true;
+    return targetprecision > 0.0 && stats->sims >= SIMULATOR_PRECISION_MIN_SIMS && stats->dices.ci95 <= targetprecision;
+}
+
+int cache_store(const cache_t* cache, stats_t* stats, size_t* cachedsims) {
+    if (!cache || !cache->filepath || !stats)
+        return 1;
+
+    // lock the cache directory, hence the entry can't be replaced between loading and writing it
+    int lockfd = open(cache->lockpath, O_RDWR | O_CREAT, 0666);
+    if (lockfd < 0)
+        return 2;
+    if (lockf(lockfd, F_LOCK, 0) != 0) {
+        close(lockfd);
+        return 2;
+    }
+
+    // reload the entry which might have been updated by another process since the simulations started, a corrupted entry is replaced
+    stats_t cached = stats_create();
+    int error = 0;
+    if (cache_load(cache, &cached) == 0) {
+        stats->shortestindex += cached.sims;
+        stats->elapsed += cached.elapsed;
+        if (!stats_merge(stats, &cached))
+            error = 3;
+    }
+    size_t sims = cached.sims;
+    stats_free(&cached);
+
+    if (!error) {
+        stats_finalize(stats);
+        const partial_header_t run = {
+            .fingerprint = cache->key,
+            .simcount = stats->sims,
+            .dicelimit = cache->dicelimit,
+            .shard = 0,
+            .shardcount = 1,
+        };
+        if (partial_write_run(cache->filepath, stats, &run) != 0)
+            error = 4;
+    }
+    lockf(lockfd, F_ULOCK, 0);
+    close(lockfd);
+    if (!error && cachedsims)
+        *cachedsims = sims;
+    return error;
+}
@@ -0,0 +1,277 @@
+#include "checkpoint.h"
+
+#include "archive.h"
+#include "atomicfile.h"
+#include "board.h"
+#include "cvts.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+checkpoint_t checkpoint_create_empty() {
+    return (checkpoint_t){
+        .filepath = 0,
+        .interval = 0.0,
+        .resume = false,
+        .last = 0.0,
+        .count = 0
+    };
+}
+
+checkpoint_t checkpoint_create(const char* filepath, double interval, bool resume) {
+    checkpoint_t checkpoint = checkpoint_create_empty();
+    checkpoint.filepath = filepath;
+    checkpoint.interval = interval;
+    checkpoint.resume = resume;
+    return checkpoint;
+}
+
+uint64_t checkpoint_fingerprint(const game_t* game) {
+    if (!game)
+        return 0;
+    return board_checksum(archive_fingerprint(game), game->die.sides.data, game->die.sides.size * sizeof(double));
+}
+
+int checkpoint_write(checkpoint_t* checkpoint, const simulator_t* simulator) {
+    if (!checkpoint || !checkpoint->filepath || !simulator || !simulator->game)
+        return 1;
+
+    // create temporary file next to the checkpoint file
+    atomicfile_t atomicfile;
+    if (!atomicfile_open(&atomicfile, checkpoint->filepath, 0))
+        return 2;
+    FILE* file = atomicfile.file;
+
+    // reserve the header which is written once the checksum of the worker sections is known
+    checkpoint_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_SIZE);
+    header.version = CHECKPOINT_VERSION;
+    header.byteorder = CHECKPOINT_BYTE_ORDER;
+    header.wordsize = sizeof(size_t);
+    header.flags = simulator->seeded ? CHECKPOINT_FLAG_SEEDED : 0;
+    header.fingerprint = checkpoint_fingerprint(simulator->game);
+    header.seed = simulator->seeded ? simulator->seed : 0;
+    header.shard = simulator->shard;
+    header.shardcount = simulator->shardcount;
+    header.simcount = simulator->simcount;
+    header.dicelimit = simulator->dicelimit;
+    header.workercount = simulator->workers.size;
+    header.elapsed = simulator->elapsed;
+    header.progress = simulator->progress;
+    if (simulator->workers.size != 0) {
+        const worker_t* worker = array_getconst(&simulator->workers, 0);
+        header.solcount = worker->stats.sals.size;
+        header.bucketcount = worker->stats.diceshist.counts.size;
+    }
+    board_writer_t writer = { .file = file, .size = 0, .checksum = BOARD_CHECKSUM_SEED, .pendingsize = 0, .failed = false };
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    writer.size = sizeof(header);
+
+    // write worker sections (struct members are copied into zeroed structs to write deterministic padding bytes)
+    for (size_t i = 0; success && i < simulator->workers.size; i++) {
+        const worker_t* worker = array_getconst(&simulator->workers, i);
+        const stats_t* stats = &worker->stats;
+        if (stats->sals.size != header.solcount || stats->diceshist.counts.size != header.bucketcount) {
+            success = false;
+            break;
+        }
+        checkpoint_worker_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.next = worker->next;
+        entry.sims = stats->sims;
+        entry.wins = stats->wins;
+        entry.losses = stats->losses;
+        entry.histtotal = stats->diceshist.total;
+        entry.shortestcount = stats->shortestdices.size;
+        entry.shortestindex = stats->shortestindex;
+        entry.seed = worker->seed;
+        entry.hasseed = worker->hasseed;
+        entry.dices = stats->dices;
+        entry.salsuses = stats->salsuses;
+        entry.snakesuses = stats->snakesuses;
+        entry.laddersuses = stats->laddersuses;
+        success = board_write(&writer, &entry, sizeof(entry))
+            && board_write(&writer, stats->diceshist.counts.data, stats->diceshist.counts.size * sizeof(size_t))
+            && board_write(&writer, stats->shortestdices.data, stats->shortestdices.size * sizeof(size_t));
+        for (size_t j = 0; success && j < stats->sals.size; j++)
+            success = board_write(&writer, &((const solstats_t*)array_getconst(&stats->sals, j))->uses, sizeof(valstats_t));
+    }
+
+    // write header with checksums
+    header.size = writer.size;
+    header.checksum = writer.checksum;
+    header.headerchecksum = board_checksum(BOARD_CHECKSUM_SEED, &header, offsetof(checkpoint_header_t, headerchecksum));
+    success = success && !writer.failed && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // replace checkpoint file atomically
+    int error = atomicfile_commit(&atomicfile, success);
+    return error ? error + 1 : 0;
+}
+
+void checkpoint_take(checkpoint_t* checkpoint, simulator_t* simulator, double elapsed) {
+    if (!checkpoint || !simulator)
+        return;
+    simulator->elapsed = elapsed;
+    checkpoint->last = elapsed;
+    int error = checkpoint_write(checkpoint, simulator);
+    if (error) {
+        fprintf(stderr, "%swarning:%s unable to write checkpoint '%s'. %s.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), checkpoint->filepath,
+            error == 2 ? "unable to create temporary file" : error == 4 ? "unable to replace file" : "unable to write file");
+        return;
+    }
+    checkpoint->count++;
+}
+
+int checkpoint_load(checkpoint_t* checkpoint, simulator_t* simulator) {
+    if (!checkpoint || !checkpoint->filepath || !simulator || !simulator->game)
+        return 1;
+
+    // map the checkpoint file read-only
+    int fd = open(checkpoint->filepath, O_RDONLY);
+    struct stat filestat;
+    if (fd < 0 || fstat(fd, &filestat) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return 2;
+    }
+    if (!S_ISREG(filestat.st_mode) || (uint64_t)filestat.st_size < sizeof(checkpoint_header_t)) {
+        close(fd);
+        return 3;
+    }
+    size_t size = filestat.st_size;
+    void* mapping = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return 2;
+
+    // verify header
+    checkpoint_header_t header;
+    memcpy(&header, mapping, sizeof(header));
+    const unsigned char* data = (const unsigned char*)mapping + sizeof(header);
+    int error = 0;
+    if (memcmp(header.magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_SIZE) != 0)
+        error = 3;
+    else if (header.version != CHECKPOINT_VERSION || header.byteorder != CHECKPOINT_BYTE_ORDER || header.wordsize != sizeof(size_t))
+        error = 4;
+    else if (header.headerchecksum != board_checksum(BOARD_CHECKSUM_SEED, &header, offsetof(checkpoint_header_t, headerchecksum))
+        || header.size != size || header.checksum != board_checksum(BOARD_CHECKSUM_SEED, data, size - sizeof(header)) || header.workercount == 0)
+        error = 5;
+    else if (header.fingerprint != checkpoint_fingerprint(simulator->game) || header.simcount != simulator->simcount || header.dicelimit != simulator->dicelimit
+        || (header.flags & CHECKPOINT_FLAG_SEEDED) != (simulator->seeded ? CHECKPOINT_FLAG_SEEDED : 0) || header.seed != (simulator->seeded ? simulator->seed : 0)
+        || header.shard != simulator->shard || header.shardcount != simulator->shardcount)
+        error = 6;
+
+    // adjust the number of workers, seeded simulations are only reproducible with the same workers
+    while (!error && simulator->workers.size > header.workercount) {
+        worker_free(array_get(&simulator->workers, simulator->workers.size - 1));
+        simulator->workers.size--;
+    }
+    while (!error && simulator->workers.size < header.workercount) {
+        worker_t worker = worker_create(simulator);
+        if (!worker.simulator || !array_add(&simulator->workers, &worker)) {
+            worker_free(&worker);
+            error = 7;
+        }
+    }
+
+    // restore worker sections
+    size_t offset = 0;
+    const size_t datasize = size - sizeof(header);
+    size_t nextsim = 0;
+    for (size_t i = 0; !error && i < simulator->workers.size; i++) {
+        worker_t* worker = array_get(&simulator->workers, i);
+        stats_t* stats = &worker->stats;
+        if (stats->sals.size != header.solcount || stats->diceshist.counts.size != header.bucketcount) {
+            error = 6;
+            break;
+        }
+        checkpoint_worker_t entry;
+        if (datasize - offset < sizeof(entry)) {
+            error = 5;
+            break;
+        }
+        memcpy(&entry, data + offset, sizeof(entry));
+        offset += sizeof(entry);
+        if (entry.shortestcount > header.dicelimit || (datasize - offset) / sizeof(size_t) < header.bucketcount + entry.shortestcount
+            || (datasize - offset - (header.bucketcount + entry.shortestcount) * sizeof(size_t)) / sizeof(valstats_t) < header.solcount) {
+            error = 5;
+            break;
+        }
+        worker->next = entry.next;
+        worker->seed = entry.seed;
+        worker->hasseed = entry.hasseed != 0;
+        stats->sims = entry.sims;
+        stats->wins = entry.wins;
+        stats->losses = entry.losses;
+        stats->dices = entry.dices;
+        stats->salsuses = entry.salsuses;
+        stats->snakesuses = entry.snakesuses;
+        stats->laddersuses = entry.laddersuses;
+        stats->diceshist.total = entry.histtotal;
+        memcpy(stats->diceshist.counts.data, data + offset, header.bucketcount * sizeof(size_t));
+        offset += header.bucketcount * sizeof(size_t);
+        array_clear(&stats->shortestdices);
+        if (!array_reserve(&stats->shortestdices, entry.shortestcount)) {
+            error = 7;
+            break;
+        }
+        memcpy(stats->shortestdices.data, data + offset, entry.shortestcount * sizeof(size_t));
+        stats->shortestdices.size = entry.shortestcount;
+        stats->shortestindex = entry.shortestindex;
+        offset += entry.shortestcount * sizeof(size_t);
+        for (size_t j = 0; j < header.solcount; j++) {
+            memcpy(&((solstats_t*)array_get(&stats->sals, j))->uses, data + offset, sizeof(valstats_t));
+            offset += sizeof(valstats_t);
+        }
+        nextsim += entry.sims;
+    }
+    if (!error && offset != datasize)
+        error = 5;
+    munmap(mapping, size);
+    if (error)
+        return error;
+
+    // unseeded simulations are claimed in any order, hence they continue after the number of finished simulations
+    atomic_store(&simulator->nextsim, nextsim);
+    simulator->progress = header.progress;
+    simulator->elapsed = header.elapsed;
+    checkpoint->last = header.elapsed;
+    return 0;
+}
+
+void checkpoint_resume(checkpoint_t* checkpoint, simulator_t* simulator) {
+    int error = checkpoint_load(checkpoint, simulator);
+    const char* filepath = checkpoint ? checkpoint->filepath : 0;
+    switch (error) {
+        case 0:
+            break;
+        case 2:
+            fprintf(stderr, "%serror:%s unable to open checkpoint '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 3:
+            fprintf(stderr, "%serror:%s '%s' is not a checkpoint.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 4:
+            fprintf(stderr, "%serror:%s checkpoint '%s' was written by an incompatible version or machine.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 5:
+            fprintf(stderr, "%serror:%s checkpoint '%s' is corrupted.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 6:
+            fprintf(stderr, "%serror:%s checkpoint '%s' was taken of another run. specify the same game, -i, --iterations, -l, --dice-limit, -S, --seed and -n, --shard.\n",
+                FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        case 7:
+            fprintf(stderr, "%serror:%s unable to restore the workers from checkpoint '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        default:
+            fprintf(stderr, "%serror:%s unable to resume from checkpoint '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+    }
+}
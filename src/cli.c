@@ -1,12 +1,17 @@
 #include "cli.h"
 
-#include "assetmanager.h"
 #include "cvts.h"
+#include "diebench.h"
 #include "macros.h"
 #include "numbers.h"
 #include "str.h"
 
+#include <fcntl.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 getopt_state_t getopt_state() {
     return (getopt_state_t){ optind, optarg, optopt };
@@ -43,6 +48,9 @@ void cli_args_free(cli_args_t *cli_args) {
         return;
     distr_free(&cli_args->distribution);
     array_free(&cli_args->snakesandladders, 0);
+    array_free(&cli_args->sweepparams, (element_fn_t)sweep_param_free);
+    array_free(&cli_args->batchfiles, 0);
+    array_free(&cli_args->mergefiles, 0);
     *cli_args = (cli_args_t){};
 }
 
@@ -54,6 +62,7 @@ cli_args_t cli_parse_args(int argc, char* argv[], int initoptind, bool isconfigf
     cli_args_t args = {
         .setargsflags = CLIAFLAG_NONE,
         .configfile = OPTVAL_CONFIGFILE_DEFAULT,
+        .configs = 1,
         .width = OPTVAL_WIDTH_DEFAULT,
         .height = OPTVAL_HEIGHT_DEFAULT,
         .die_sides = OPTVAL_DIE_SIDES_DEFAULT,
@@ -62,40 +71,136 @@ cli_args_t cli_parse_args(int argc, char* argv[], int initoptind, bool isconfigf
         .iterations = OPTVAL_ITERATIONS_DEFAULT,
         .dicelimit = OPTVAL_DICE_LIMIT_DEFAULT,
         .barlength = OPTVAL_BAR_LENGTH_DEFAULT,
-        .snakesandladders = array_create(0, sizeof(snakeorladder_t), 0)
+        .targetprecision = OPTVAL_TARGET_PRECISION_DEFAULT,
+        .timelimit = OPTVAL_TIME_LIMIT_DEFAULT,
+        .reportformat = OPTVAL_REPORT_FORMAT_DEFAULT,
+        .snakesandladders = array_create(0, sizeof(snakeorladder_t), 0),
+        .sweepparams = array_create(0, sizeof(sweep_param_t), 0),
+        .batchfiles = array_create(0, sizeof(char*), 0),
+        .compileboard = 0,
+        .board = 0,
+        .verifyboard = false,
+        .records = 0,
+        .recordsformat = OPTVAL_RECORDS_FORMAT_DEFAULT,
+        .recordstrace = false,
+        .replay = 0,
+        .replayindex = 0,
+        .checkpoint = 0,
+        .checkpointinterval = OPTVAL_CHECKPOINT_INTERVAL_DEFAULT,
+        .resume = false,
+        .seeded = false,
+        .seed = 0,
+        .shard = 0,
+        .shardcount = 1,
+        .partialout = 0,
+        .mergefiles = array_create(0, sizeof(char*), 0),
+        .serve = 0,
+        .cache = 0,
+        .timings = false,
+        .perfcounters = false,
+        .allocations = false,
+        .workers = OPTVAL_WORKERS_DEFAULT,
+        .saldensity = OPTVAL_SAL_DENSITY_DEFAULT,
+        .sallengths = OPTVAL_SAL_LENGTHS_DEFAULT,
+        .generatefile = 0,
+        .benchdie = false
     };
-    assetmanager_add(&args, (deallocator_fn_t)cli_args_free);
+
+    // the merge subcommand takes partial statistics files instead of snakes and ladders
+    if (!isconfigfile && initoptind < argc && strcmp(argv[initoptind], CLI_SUBCOMMAND_MERGE) == 0) {
+        args.setargsflags |= CLIAFLAG_MERGE;
+        initoptind++;
+    }
+    // the generate subcommand takes the file the generated config is written to instead of snakes and ladders
+    if (!isconfigfile && initoptind < argc && strcmp(argv[initoptind], CLI_SUBCOMMAND_GENERATE) == 0) {
+        args.setargsflags |= CLIAFLAG_GENERATE;
+        initoptind++;
+    }
 
     // define options
     const char* optstring;
-    struct option longopts[11];
+    struct option longopts[38];
     if (isconfigfile) {
-        // disable option -c --config-file if args came from a config file
-        optstring = ":hx:y:s:ed:l:i:b:";
-        longopts[ 0] = (struct option){ "help"        , 0, 0, 'h' };
-        longopts[ 1] = (struct option){ "width"       , 1, 0, 'x' };
-        longopts[ 2] = (struct option){ "height"      , 1, 0, 'y' };
-        longopts[ 3] = (struct option){ "die-sides"   , 1, 0, 's' };
-        longopts[ 4] = (struct option){ "exact-ending", 0, 0, 'e' };
-        longopts[ 5] = (struct option){ "distribution", 1, 0, 'd' };
-        longopts[ 6] = (struct option){ "iterations"  , 1, 0, 'i' };
-        longopts[ 7] = (struct option){ "dice-limit"  , 1, 0, 'l' };
-        longopts[ 8] = (struct option){ "bar-length"  , 1, 0, 'b' };
-        longopts[ 9] = (struct option){ 0             , 0, 0, 0   };
-        longopts[10] = (struct option){ 0             , 0, 0, 0   };
+        // disable the options -c, -B, -o, -g, -r, -R, -T, -P, -k, -K, -u, -S, -n, -O, -D and -C if args came from a config file
+        optstring = ":hx:y:s:ed:l:i:b:p:t:w:f:";
+        longopts[ 0] = (struct option){ "help"            , 0, 0, 'h' };
+        longopts[ 1] = (struct option){ "width"           , 1, 0, 'x' };
+        longopts[ 2] = (struct option){ "height"          , 1, 0, 'y' };
+        longopts[ 3] = (struct option){ "die-sides"       , 1, 0, 's' };
+        longopts[ 4] = (struct option){ "exact-ending"    , 0, 0, 'e' };
+        longopts[ 5] = (struct option){ "distribution"    , 1, 0, 'd' };
+        longopts[ 6] = (struct option){ "iterations"      , 1, 0, 'i' };
+        longopts[ 7] = (struct option){ "dice-limit"      , 1, 0, 'l' };
+        longopts[ 8] = (struct option){ "bar-length"      , 1, 0, 'b' };
+        longopts[ 9] = (struct option){ "target-precision", 1, 0, 'p' };
+        longopts[10] = (struct option){ "time-limit"      , 1, 0, 't' };
+        longopts[11] = (struct option){ "sweep"           , 1, 0, 'w' };
+        longopts[12] = (struct option){ "format"          , 1, 0, 'f' };
+        longopts[13] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[14] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[15] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[16] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[17] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[18] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[19] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[20] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[21] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[22] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[23] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[24] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[25] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[26] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[27] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[28] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[29] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[30] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[31] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[32] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[33] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[34] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[35] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[36] = (struct option){ 0                 , 0, 0, 0   };
+        longopts[37] = (struct option){ 0                 , 0, 0, 0   };
     } else {
-        optstring = ":hc:x:y:s:ed:l:i:b:";
-        longopts[ 0] = (struct option){ "help"        , 0, 0, 'h' };
-        longopts[ 1] = (struct option){ "config-file" , 1, 0, 'c' };
-        longopts[ 2] = (struct option){ "width"       , 1, 0, 'x' };
-        longopts[ 3] = (struct option){ "height"      , 1, 0, 'y' };
-        longopts[ 4] = (struct option){ "die-sides"   , 1, 0, 's' };
-        longopts[ 5] = (struct option){ "exact-ending", 0, 0, 'e' };
-        longopts[ 6] = (struct option){ "distribution", 1, 0, 'd' };
-        longopts[ 7] = (struct option){ "iterations"  , 1, 0, 'i' };
-        longopts[ 8] = (struct option){ "dice-limit"  , 1, 0, 'l' };
-        longopts[ 9] = (struct option){ "bar-length"   , 1, 0, 'b' };
-        longopts[10] = (struct option){ 0             , 0, 0, 0   };
+        optstring = ":hc:x:y:s:ed:l:i:b:p:t:w:f:Bo:g:r:R:TP:k:K:uS:n:O:D:C:mHAj:G:L:QV";
+        longopts[ 0] = (struct option){ "help"            , 0, 0, 'h' };
+        longopts[ 1] = (struct option){ "config-file"     , 1, 0, 'c' };
+        longopts[ 2] = (struct option){ "width"           , 1, 0, 'x' };
+        longopts[ 3] = (struct option){ "height"          , 1, 0, 'y' };
+        longopts[ 4] = (struct option){ "die-sides"       , 1, 0, 's' };
+        longopts[ 5] = (struct option){ "exact-ending"    , 0, 0, 'e' };
+        longopts[ 6] = (struct option){ "distribution"    , 1, 0, 'd' };
+        longopts[ 7] = (struct option){ "iterations"      , 1, 0, 'i' };
+        longopts[ 8] = (struct option){ "dice-limit"      , 1, 0, 'l' };
+        longopts[ 9] = (struct option){ "bar-length"      , 1, 0, 'b' };
+        longopts[10] = (struct option){ "target-precision", 1, 0, 'p' };
+        longopts[11] = (struct option){ "time-limit"      , 1, 0, 't' };
+        longopts[12] = (struct option){ "sweep"           , 1, 0, 'w' };
+        longopts[13] = (struct option){ "format"          , 1, 0, 'f' };
+        longopts[14] = (struct option){ "batch"           , 0, 0, 'B' };
+        longopts[15] = (struct option){ "compile-board"   , 1, 0, 'o' };
+        longopts[16] = (struct option){ "board"           , 1, 0, 'g' };
+        longopts[17] = (struct option){ "emit-records"    , 1, 0, 'r' };
+        longopts[18] = (struct option){ "records-format"  , 1, 0, 'R' };
+        longopts[19] = (struct option){ "records-trace"   , 0, 0, 'T' };
+        longopts[20] = (struct option){ "replay"          , 1, 0, 'P' };
+        longopts[21] = (struct option){ "checkpoint"      , 1, 0, 'k' };
+        longopts[22] = (struct option){ "checkpoint-interval", 1, 0, 'K' };
+        longopts[23] = (struct option){ "resume"          , 0, 0, 'u' };
+        longopts[24] = (struct option){ "seed"            , 1, 0, 'S' };
+        longopts[25] = (struct option){ "shard"           , 1, 0, 'n' };
+        longopts[26] = (struct option){ "partial-out"     , 1, 0, 'O' };
+        longopts[27] = (struct option){ "serve"           , 1, 0, 'D' };
+        longopts[28] = (struct option){ "cache"           , 1, 0, 'C' };
+        longopts[29] = (struct option){ "timings"         , 0, 0, 'm' };
+        longopts[30] = (struct option){ "perf-counters"   , 0, 0, 'H' };
+        longopts[31] = (struct option){ "allocations"     , 0, 0, 'A' };
+        longopts[32] = (struct option){ "workers"         , 1, 0, 'j' };
+        longopts[33] = (struct option){ "sal-density"     , 1, 0, 'G' };
+        longopts[34] = (struct option){ "sal-lengths"     , 1, 0, 'L' };
+        longopts[35] = (struct option){ "bench-die"       , 0, 0, 'Q' };
+        longopts[36] = (struct option){ "verify-board"    , 0, 0, 'V' };
+        longopts[37] = (struct option){ 0                 , 0, 0, 0   };
     }
     // parse options
     cli_parse_opts(&args, argc, argv, initoptind, optstring, longopts);
@@ -138,10 +243,217 @@ cli_args_t cli_parse_args(int argc, char* argv[], int initoptind, bool isconfigf
             fprintf(stderr, "%serror:%s invalid distribution. weight sum is 0.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
             exit(1);
         }
+        // the variants of a sweep share one thread pool, hence a time limit per simulator can't be applied
+        if (args.sweepparams.size != 0 && (args.setargsflags & CLIAFLAG_TIME_LIMIT)) {
+            fprintf(stderr, "%serror:%s option -t, --time-limit can't be combined with -w, --sweep.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        // the games of a batch are defined by the config files, hence a sweep and a time limit can't be applied either
+        if (args.setargsflags & CLIAFLAG_BATCH) {
+            if (args.sweepparams.size != 0) {
+                fprintf(stderr, "%serror:%s option -B, --batch can't be combined with -w, --sweep.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            if (args.setargsflags & CLIAFLAG_TIME_LIMIT) {
+                fprintf(stderr, "%serror:%s option -t, --time-limit can't be combined with -B, --batch.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            if (optind == argc) {
+                fprintf(stderr, "%serror:%s option -B, --batch requires at least one config file.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+        }
+        // compiling or loading a board describes exactly one game
+        if (args.setargsflags & (CLIAFLAG_COMPILE_BOARD | CLIAFLAG_BOARD)) {
+            const char* option = args.setargsflags & CLIAFLAG_BOARD ? "-g, --board" : "-o, --compile-board";
+            if (args.sweepparams.size != 0) {
+                fprintf(stderr, "%serror:%s option %s can't be combined with -w, --sweep.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), option);
+                exit(1);
+            }
+            if (args.setargsflags & CLIAFLAG_BATCH) {
+                fprintf(stderr, "%serror:%s option %s can't be combined with -B, --batch.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), option);
+                exit(1);
+            }
+            if ((args.setargsflags & CLIAFLAG_BOARD) && (args.setargsflags & CLIAFLAG_COMPILE_BOARD)) {
+                fprintf(stderr, "%serror:%s option -g, --board can't be combined with -o, --compile-board.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+        }
+        if ((args.setargsflags & CLIAFLAG_VERIFY_BOARD) && !(args.setargsflags & CLIAFLAG_BOARD)) {
+            fprintf(stderr, "%serror:%s option -V, --verify-board requires -g, --board.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        // the records describe the simulations of exactly one game
+        if (args.setargsflags & CLIAFLAG_EMIT_RECORDS) {
+            if (args.sweepparams.size != 0) {
+                fprintf(stderr, "%serror:%s option -r, --emit-records can't be combined with -w, --sweep.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            if (args.setargsflags & CLIAFLAG_BATCH) {
+                fprintf(stderr, "%serror:%s option -r, --emit-records can't be combined with -B, --batch.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            if (args.setargsflags & CLIAFLAG_COMPILE_BOARD) {
+                fprintf(stderr, "%serror:%s option -r, --emit-records can't be combined with -o, --compile-board.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+        } else if (args.setargsflags & (CLIAFLAG_RECORDS_FORMAT | CLIAFLAG_RECORDS_TRACE)) {
+            fprintf(stderr, "%serror:%s options -R, --records-format and -T, --records-trace require -r, --emit-records.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        // a checkpoint stores the partial results of exactly one game, records would miss the simulations before resuming
+        if (args.setargsflags & CLIAFLAG_CHECKPOINT) {
+            const cli_args_flags_t checkpointconflicts[5] = { CLIAFLAG_EMIT_RECORDS, CLIAFLAG_SWEEP, CLIAFLAG_BATCH, CLIAFLAG_COMPILE_BOARD, CLIAFLAG_REPLAY };
+            const char* const checkpointoptions[5] = { "-r, --emit-records", "-w, --sweep", "-B, --batch", "-o, --compile-board", "-P, --replay" };
+            for (size_t i = 0; i < 5; i++) {
+                if (args.setargsflags & checkpointconflicts[i]) {
+                    fprintf(stderr, "%serror:%s option -k, --checkpoint can't be combined with %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), checkpointoptions[i]);
+                    exit(1);
+                }
+            }
+        } else if (args.setargsflags & (CLIAFLAG_CHECKPOINT_INTERVAL | CLIAFLAG_RESUME)) {
+            fprintf(stderr, "%serror:%s options -K, --checkpoint-interval and -u, --resume require -k, --checkpoint.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        // the games of a batch are simulated with the settings of their config files
+        if ((args.setargsflags & CLIAFLAG_SEED) && (args.setargsflags & CLIAFLAG_BATCH)) {
+            fprintf(stderr, "%serror:%s option -S, --seed can't be combined with -B, --batch.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        // a replay only reads an archive of exactly one game instead of simulating
+        if (args.setargsflags & CLIAFLAG_REPLAY) {
+            const cli_args_flags_t replayconflicts[4] = { CLIAFLAG_EMIT_RECORDS, CLIAFLAG_SWEEP, CLIAFLAG_BATCH, CLIAFLAG_COMPILE_BOARD };
+            const char* const replayoptions[4] = { "-r, --emit-records", "-w, --sweep", "-B, --batch", "-o, --compile-board" };
+            for (size_t i = 0; i < 4; i++) {
+                if (args.setargsflags & replayconflicts[i]) {
+                    fprintf(stderr, "%serror:%s option -P, --replay can't be combined with %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), replayoptions[i]);
+                    exit(1);
+                }
+            }
+        }
+        // a shard runs a fixed slice of a seeded run, hence the simulations can't depend on the precision or time
+        if (args.setargsflags & CLIAFLAG_PARTIAL_OUT) {
+            if (!(args.setargsflags & CLIAFLAG_SEED)) {
+                fprintf(stderr, "%serror:%s option -O, --partial-out requires -S, --seed.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            const cli_args_flags_t partialconflicts[6] = { CLIAFLAG_TARGET_PRECISION, CLIAFLAG_TIME_LIMIT, CLIAFLAG_SWEEP, CLIAFLAG_BATCH, CLIAFLAG_COMPILE_BOARD, CLIAFLAG_REPLAY };
+            const char* const partialoptions[6] = { "-p, --target-precision", "-t, --time-limit", "-w, --sweep", "-B, --batch", "-o, --compile-board", "-P, --replay" };
+            for (size_t i = 0; i < 6; i++) {
+                if (args.setargsflags & partialconflicts[i]) {
+                    fprintf(stderr, "%serror:%s option -O, --partial-out can't be combined with %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), partialoptions[i]);
+                    exit(1);
+                }
+            }
+        } else if (args.setargsflags & CLIAFLAG_SHARD) {
+            fprintf(stderr, "%serror:%s option -n, --shard requires -O, --partial-out.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        // the merge subcommand only reads the partial statistics files
+        if (args.setargsflags & CLIAFLAG_MERGE) {
+            if (args.setargsflags & ~(CLIAFLAG_MERGE | CLIAFLAG_HELP)) {
+                fprintf(stderr, "%serror:%s subcommand merge takes no options.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            if (optind == argc) {
+                fprintf(stderr, "%serror:%s subcommand merge requires at least one partial statistics file.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+        }
+        // the generate subcommand only writes the game options and the generated snakes and ladders
+        if (args.setargsflags & CLIAFLAG_GENERATE) {
+            const cli_args_flags_t generateflags = CLIAFLAG_HELP | CLIAFLAG_GENERATE | CLIAFLAG_WIDTH | CLIAFLAG_HEIGHT | CLIAFLAG_DIE_SIDES | CLIAFLAG_EXACT_ENDING
+                | CLIAFLAG_DISTRIBUTION | CLIAFLAG_ITERATIONS | CLIAFLAG_DICE_LIMIT | CLIAFLAG_SEED | CLIAFLAG_COMPILE_BOARD | CLIAFLAG_SAL_DENSITY | CLIAFLAG_SAL_LENGTHS;
+            if (args.setargsflags & ~generateflags) {
+                fprintf(stderr, "%serror:%s subcommand generate only takes the options -x, -y, -s, -e, -d, -i, -l, -S, -o, -G and -L.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            if (argc - optind > 1) {
+                fprintf(stderr, "%serror:%s subcommand generate takes at most one config file.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+        } else if (args.setargsflags & (CLIAFLAG_SAL_DENSITY | CLIAFLAG_SAL_LENGTHS)) {
+            fprintf(stderr, "%serror:%s options -G, --sal-density and -L, --sal-lengths require the subcommand generate.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        // the die benchmark only rolls the die of -s and -d
+        if (args.setargsflags & CLIAFLAG_BENCH_DIE) {
+            const cli_args_flags_t benchdieflags = CLIAFLAG_HELP | CLIAFLAG_BENCH_DIE | CLIAFLAG_DIE_SIDES | CLIAFLAG_DISTRIBUTION | CLIAFLAG_ITERATIONS | CLIAFLAG_SEED
+                | CLIAFLAG_WORKERS | CLIAFLAG_REPORT_FORMAT;
+            if (args.setargsflags & ~benchdieflags) {
+                fprintf(stderr, "%serror:%s option -Q, --bench-die can only be combined with the options -s, -d, -i, -S, -j and -f.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            if (optind != argc) {
+                fprintf(stderr, "%serror:%s option -Q, --bench-die takes no snakes and ladders.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+        }
+        // a cache entry accumulates unseeded simulations of exactly one game
+        if (args.setargsflags & CLIAFLAG_CACHE) {
+            const cli_args_flags_t cacheconflicts[9] = { CLIAFLAG_SEED, CLIAFLAG_CHECKPOINT, CLIAFLAG_EMIT_RECORDS, CLIAFLAG_PARTIAL_OUT, CLIAFLAG_SWEEP, CLIAFLAG_BATCH, CLIAFLAG_COMPILE_BOARD, CLIAFLAG_REPLAY, CLIAFLAG_SERVE };
+            const char* const cacheoptions[9] = { "-S, --seed", "-k, --checkpoint", "-r, --emit-records", "-O, --partial-out", "-w, --sweep", "-B, --batch", "-o, --compile-board", "-P, --replay", "-D, --serve" };
+            for (size_t i = 0; i < 9; i++) {
+                if (args.setargsflags & cacheconflicts[i]) {
+                    fprintf(stderr, "%serror:%s option -C, --cache can't be combined with %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cacheoptions[i]);
+                    exit(1);
+                }
+            }
+        }
+        // the timings and hardware events measure the phases of exactly one simulated game
+        if (args.setargsflags & (CLIAFLAG_TIMINGS | CLIAFLAG_PERF_COUNTERS)) {
+            const char* option = args.setargsflags & CLIAFLAG_TIMINGS ? "-m, --timings" : "-H, --perf-counters";
+            const cli_args_flags_t timingsconflicts[4] = { CLIAFLAG_SWEEP, CLIAFLAG_BATCH, CLIAFLAG_COMPILE_BOARD, CLIAFLAG_REPLAY };
+            const char* const timingsoptions[4] = { "-w, --sweep", "-B, --batch", "-o, --compile-board", "-P, --replay" };
+            for (size_t i = 0; i < 4; i++) {
+                if (args.setargsflags & timingsconflicts[i]) {
+                    fprintf(stderr, "%serror:%s option %s can't be combined with %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), option, timingsoptions[i]);
+                    exit(1);
+                }
+            }
+        }
+        // the games and simulation settings of a daemon are given by it's requests
+        if (args.setargsflags & CLIAFLAG_SERVE) {
+            if (args.setargsflags & ~(CLIAFLAG_SERVE | CLIAFLAG_HELP)) {
+                fprintf(stderr, "%serror:%s option -D, --serve can't be combined with other options.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+            if (optind != argc) {
+                fprintf(stderr, "%serror:%s option -D, --serve takes no snakes and ladders, they are given by the requests.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
+            }
+        }
     }
 
-    // read snakes and ladders given as arguments
-    cli_read_sals(&args, argc - optind, argv + optind);
+    if (args.setargsflags & CLIAFLAG_BATCH) {
+        // read config files or glob patterns of the batch given as arguments
+        for (int i = optind; i < argc; i++) {
+            if (!array_add(&args.batchfiles, &argv[i])) {
+                fprintf(stderr, "%serror:%s unable to add config file '%s' to the batch.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), argv[i]);
+                exit(1);
+            }
+        }
+    } else if (args.setargsflags & CLIAFLAG_MERGE) {
+        // read partial statistics files given as arguments
+        for (int i = optind; i < argc; i++) {
+            if (!array_add(&args.mergefiles, &argv[i])) {
+                fprintf(stderr, "%serror:%s unable to add partial statistics file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), argv[i]);
+                exit(1);
+            }
+        }
+    } else if (args.setargsflags & CLIAFLAG_GENERATE) {
+        // the generated config is written to the file given as argument or to stdout
+        args.generatefile = optind < argc ? argv[optind] : 0;
+    } else {
+        // read snakes and ladders given as arguments
+        cli_read_sals(&args, argc - optind, argv + optind);
+    }
+    // the game of a compiled board is fixed, hence the options describing the game can't be applied
+    const cli_args_flags_t gameflags = CLIAFLAG_WIDTH | CLIAFLAG_HEIGHT | CLIAFLAG_DIE_SIDES | CLIAFLAG_EXACT_ENDING | CLIAFLAG_DISTRIBUTION | CLIAFLAG_SNAKESANDLADDERS;
+    if (!isconfigfile && (args.setargsflags & CLIAFLAG_BOARD) && (args.setargsflags & gameflags)) {
+        fprintf(stderr, "%serror:%s option -g, --board can't be combined with the options -x, -y, -s, -e, -d or snakes and ladders.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+        exit(1);
+    }
     if (optind != argc)
         optind = argc;
 
@@ -191,6 +503,8 @@ cli_args_t* cli_parse_opts(cli_args_t* cli_args, int argc, char* argv[], int ini
                 #endif
 
                 // transfer config file cli arguments into cli arguments (only argument settings that where set in config file)
+                cli_args->setargsflags |= config_cli_args.setargsflags;
+                cli_args->configs += config_cli_args.configs;
                 if (config_cli_args.setargsflags & CLIAFLAG_WIDTH)
                     cli_args->width = config_cli_args.width;
                 if (config_cli_args.setargsflags & CLIAFLAG_HEIGHT)
@@ -210,6 +524,17 @@ cli_args_t* cli_parse_opts(cli_args_t* cli_args, int argc, char* argv[], int ini
                     cli_args->dicelimit = config_cli_args.dicelimit;
                 if (config_cli_args.setargsflags & CLIAFLAG_BAR_LENGTH)
                     cli_args->barlength = config_cli_args.barlength;
+                if (config_cli_args.setargsflags & CLIAFLAG_TARGET_PRECISION)
+                    cli_args->targetprecision = config_cli_args.targetprecision;
+                if (config_cli_args.setargsflags & CLIAFLAG_TIME_LIMIT)
+                    cli_args->timelimit = config_cli_args.timelimit;
+                if (config_cli_args.setargsflags & CLIAFLAG_SWEEP) {
+                    array_free(&cli_args->sweepparams, (element_fn_t)sweep_param_free);
+                    cli_args->sweepparams = config_cli_args.sweepparams;
+                    config_cli_args.sweepparams = array_create(0, sizeof(sweep_param_t), 0);
+                }
+                if (config_cli_args.setargsflags & CLIAFLAG_REPORT_FORMAT)
+                    cli_args->reportformat = config_cli_args.reportformat;
                 if (config_cli_args.setargsflags & CLIAFLAG_SNAKESANDLADDERS) {
                     if (cli_args->snakesandladders.size == 0) {
                         cli_args->snakesandladders = config_cli_args.snakesandladders;
@@ -221,11 +546,8 @@ cli_args_t* cli_parse_opts(cli_args_t* cli_args, int argc, char* argv[], int ini
                 }
 
                 // free resources
-                assetmanager_free(&config_cli_args);
-                if (config_args.argc != 0) {
-                    free(config_args.argv[0]);
-                    free(config_args.argv);
-                }
+                cli_args_free(&config_cli_args);
+                cli_configfile_args_free(&config_args);
                 
                 // restore previous getopt state
                 getopt_state_set(&getoptstate);
@@ -306,6 +628,242 @@ cli_args_t* cli_parse_opts(cli_args_t* cli_args, int argc, char* argv[], int ini
                 cli_args->barlength = cli_parse_opt_uint64(opt, OPTVAL_BAR_LENGTH_MIN, OPTVAL_BAR_LENGTH_MAX);
                 break;
             }
+            case 'p':
+            {
+                cli_args->setargsflags |= CLIAFLAG_TARGET_PRECISION;
+                cli_args->targetprecision = cli_parse_opt_double(opt, OPTVAL_TARGET_PRECISION_MIN, OPTVAL_TARGET_PRECISION_MAX);
+                break;
+            }
+            case 't':
+            {
+                cli_args->setargsflags |= CLIAFLAG_TIME_LIMIT;
+                cli_args->timelimit = cli_parse_opt_double(opt, OPTVAL_TIME_LIMIT_MIN, OPTVAL_TIME_LIMIT_MAX);
+                break;
+            }
+            case 'w':
+            {
+                cli_args->setargsflags |= CLIAFLAG_SWEEP;
+                int error = 0;
+                sweep_param_t param = strtosweepparam(optarg, &error);
+                if (error) {
+                    fprintf(stderr, "%serror:%s invalid sweep '%s'. ", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optarg);
+                    switch (error) {
+                        case 1:
+                            fprintf(stderr, "no string given.\n");
+                            exit(1);
+                        case 2:
+                            fprintf(stderr, "unable to duplicate string.\n");
+                            exit(1);
+                        case 3:
+                            fprintf(stderr, "missing '=' between parameter name and values.\n");
+                            exit(1);
+                        case 4:
+                            fprintf(stderr, "unknown parameter. must be one of width, height, die-sides, distribution, exact-ending.\n");
+                            exit(1);
+                        case 5:
+                            fprintf(stderr, "invalid value.\n");
+                            exit(1);
+                        case 6:
+                            fprintf(stderr, "range start is greater than range end.\n");
+                            exit(1);
+                        case 7:
+                            fprintf(stderr, "unable to add value.\n");
+                            exit(1);
+                        default:
+                            fprintf(stderr, "unknown error.\n");
+                            exit(1);
+                    }
+                }
+                for (size_t i = 0; i < cli_args->sweepparams.size; i++) {
+                    if (((sweep_param_t*)array_get(&cli_args->sweepparams, i))->kind == param.kind) {
+                        fprintf(stderr, "%serror:%s parameter '%s' is swept more than once.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sweep_param_infos[param.kind].name);
+                        exit(1);
+                    }
+                }
+                if (!array_add(&cli_args->sweepparams, &param)) {
+                    fprintf(stderr, "%serror:%s unable to add sweep '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case 'f':
+            {
+                cli_args->setargsflags |= CLIAFLAG_REPORT_FORMAT;
+                int error = 0;
+                cli_args->reportformat = strtoreportformat(optarg, &error);
+                if (error) {
+                    fprintf(stderr, "%serror:%s invalid format '%s'. must be one of csv, json.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case 'B':
+            {
+                cli_args->setargsflags |= CLIAFLAG_BATCH;
+                break;
+            }
+            case 'o':
+            {
+                cli_args->setargsflags |= CLIAFLAG_COMPILE_BOARD;
+                cli_args->compileboard = optarg;
+                break;
+            }
+            case 'g':
+            {
+                cli_args->setargsflags |= CLIAFLAG_BOARD;
+                cli_args->board = optarg;
+                break;
+            }
+            case 'V':
+            {
+                cli_args->setargsflags |= CLIAFLAG_VERIFY_BOARD;
+                cli_args->verifyboard = true;
+                break;
+            }
+            case 'r':
+            {
+                cli_args->setargsflags |= CLIAFLAG_EMIT_RECORDS;
+                cli_args->records = optarg;
+                break;
+            }
+            case 'R':
+            {
+                cli_args->setargsflags |= CLIAFLAG_RECORDS_FORMAT;
+                int error = 0;
+                cli_args->recordsformat = strtorecordsformat(optarg, &error);
+                if (error) {
+                    fprintf(stderr, "%serror:%s invalid records format '%s'. must be one of binary, csv, archive.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case 'T':
+            {
+                cli_args->setargsflags |= CLIAFLAG_RECORDS_TRACE;
+                cli_args->recordstrace = true;
+                break;
+            }
+            case 'P':
+            {
+                cli_args->setargsflags |= CLIAFLAG_REPLAY;
+                // split the value at the first '@' into the simulation index and the archive path
+                const char* at = strchr(optarg, '@');
+                uint64_t index = 0;
+                if (!at || at[1] == '\0' || strntouint64(optarg, at - optarg, &index) != 0) {
+                    fprintf(stderr, "%serror:%s invalid replay '%s'. must be <index>@<archive-file>.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optarg);
+                    exit(1);
+                }
+                cli_args->replayindex = index;
+                cli_args->replay = (char*)at + 1;
+                break;
+            }
+            case 'k':
+            {
+                cli_args->setargsflags |= CLIAFLAG_CHECKPOINT;
+                cli_args->checkpoint = optarg;
+                break;
+            }
+            case 'K':
+            {
+                cli_args->setargsflags |= CLIAFLAG_CHECKPOINT_INTERVAL;
+                cli_args->checkpointinterval = cli_parse_opt_double(opt, OPTVAL_CHECKPOINT_INTERVAL_MIN, OPTVAL_CHECKPOINT_INTERVAL_MAX);
+                break;
+            }
+            case 'u':
+            {
+                cli_args->setargsflags |= CLIAFLAG_RESUME;
+                cli_args->resume = true;
+                break;
+            }
+            case 'S':
+            {
+                cli_args->setargsflags |= CLIAFLAG_SEED;
+                cli_args->seeded = true;
+                cli_args->seed = cli_parse_opt_uint64(opt, OPTVAL_SEED_MIN, OPTVAL_SEED_MAX);
+                break;
+            }
+            case 'n':
+            {
+                cli_args->setargsflags |= CLIAFLAG_SHARD;
+                // split the value at the first '/' into the shard index and the number of shards
+                const char* slash = strchr(optarg, '/');
+                uint64_t shard = 0;
+                uint64_t shardcount = 0;
+                if (!slash || strntouint64(optarg, slash - optarg, &shard) != 0 || strntouint64(slash + 1, strlen(slash + 1), &shardcount) != 0
+                    || shardcount == 0 || shardcount > OPTVAL_SHARD_COUNT_MAX || shard >= shardcount) {
+                    fprintf(stderr, "%serror:%s invalid shard '%s'. must be <k>/<n> with 0 <= k < n <= %lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optarg, OPTVAL_SHARD_COUNT_MAX);
+                    exit(1);
+                }
+                cli_args->shard = shard;
+                cli_args->shardcount = shardcount;
+                break;
+            }
+            case 'O':
+            {
+                cli_args->setargsflags |= CLIAFLAG_PARTIAL_OUT;
+                cli_args->partialout = optarg;
+                break;
+            }
+            case 'D':
+            {
+                cli_args->setargsflags |= CLIAFLAG_SERVE;
+                cli_args->serve = optarg;
+                break;
+            }
+            case 'C':
+            {
+                cli_args->setargsflags |= CLIAFLAG_CACHE;
+                cli_args->cache = optarg;
+                break;
+            }
+            case 'm':
+            {
+                cli_args->setargsflags |= CLIAFLAG_TIMINGS;
+                cli_args->timings = true;
+                break;
+            }
+            case 'H':
+            {
+                cli_args->setargsflags |= CLIAFLAG_PERF_COUNTERS;
+                cli_args->perfcounters = true;
+                break;
+            }
+            case 'A':
+            {
+                cli_args->setargsflags |= CLIAFLAG_ALLOCATIONS;
+                cli_args->allocations = true;
+                break;
+            }
+            case 'j':
+            {
+                cli_args->setargsflags |= CLIAFLAG_WORKERS;
+                cli_args->workers = cli_parse_opt_uint64(opt, OPTVAL_WORKERS_MIN, OPTVAL_WORKERS_MAX);
+                break;
+            }
+            case 'G':
+            {
+                cli_args->setargsflags |= CLIAFLAG_SAL_DENSITY;
+                cli_args->saldensity = cli_parse_opt_double(opt, OPTVAL_SAL_DENSITY_MIN, OPTVAL_SAL_DENSITY_MAX);
+                break;
+            }
+            case 'L':
+            {
+                cli_args->setargsflags |= CLIAFLAG_SAL_LENGTHS;
+                int error = 0;
+                cli_args->sallengths = strtogenlengths(optarg, &error);
+                if (error) {
+                    fprintf(stderr, "%serror:%s invalid length distribution '%s'. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optarg,
+                        error == 2 ? "must be geometric or uniform" : "the length must be a positive integer");
+                    exit(1);
+                }
+                break;
+            }
+            case 'Q':
+            {
+                cli_args->setargsflags |= CLIAFLAG_BENCH_DIE;
+                cli_args->benchdie = true;
+                break;
+            }
             case ':':
             {
                 fprintf(stderr, "%serror:%s missing value for option '%c'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), optopt);
@@ -331,6 +889,7 @@ void cli_args_print(const cli_args_t* cli_args) {
         "cli_args = {\n"
         "  setargsflags     = 0b%u%u%u%u%u%u%u%u,\n"
         "  configfile       = %s%s%s,\n"
+        "  configs          = %lu,\n"
         "  width            = %lu,\n"
         "  height           = %lu,\n"
         "  die_sides        = %lu,\n"
@@ -347,6 +906,7 @@ void cli_args_print(const cli_args_t* cli_args) {
         (bool)(cli_args->setargsflags & CLIAFLAG_CONFIGFILE),
         (bool)(cli_args->setargsflags & CLIAFLAG_HELP),
         cli_args->configfile ? "\"" : "", cli_args->configfile, cli_args->configfile ? "\"" : "",
+        cli_args->configs,
         cli_args->width,
         cli_args->height,
         cli_args->die_sides,
@@ -366,10 +926,70 @@ void cli_args_print(const cli_args_t* cli_args) {
         "  iterations       = %lu,\n"
         "  dicelimit        = %lu,\n"
         "  barlength        = %lu,\n"
+        "  targetprecision  = %lf,\n"
+        "  timelimit        = %lf,\n"
+        "  sweepparams      = [%lu],\n"
+        "  batchfiles       = [%lu],\n"
+        "  compileboard     = %s%s%s,\n"
+        "  board            = %s%s%s,\n"
+        "  verifyboard      = %s,\n"
+        "  records          = %s%s%s,\n"
+        "  recordsformat    = %s,\n"
+        "  recordstrace     = %s,\n"
+        "  replay           = %s%s%s,\n"
+        "  replayindex      = %lu,\n"
+        "  checkpoint       = %s%s%s,\n"
+        "  checkpointinterval = %lf,\n"
+        "  resume           = %s,\n"
+        "  seed             = %lu%s,\n"
+        "  shard            = %lu/%lu,\n"
+        "  partialout       = %s%s%s,\n"
+        "  mergefiles       = [%lu],\n"
+        "  serve            = %s%s%s,\n"
+        "  cache            = %s%s%s,\n"
+        "  timings          = %s,\n"
+        "  perfcounters     = %s,\n"
+        "  allocations      = %s,\n"
+        "  workers          = %lu,\n"
+        "  saldensity       = %lf,\n"
+        "  sallengths       = %s:%lu,\n"
+        "  generatefile     = %s%s%s,\n"
+        "  benchdie         = %s,\n"
+        "  reportformat     = %s,\n"
         "  snakesandladders = [%lu] {",
         cli_args->iterations,
         cli_args->dicelimit,
         cli_args->barlength,
+        cli_args->targetprecision,
+        cli_args->timelimit,
+        cli_args->sweepparams.size,
+        cli_args->batchfiles.size,
+        cli_args->compileboard ? "\"" : "", cli_args->compileboard, cli_args->compileboard ? "\"" : "",
+        cli_args->board ? "\"" : "", cli_args->board, cli_args->board ? "\"" : "",
+        cli_args->verifyboard ? "true" : "false",
+        cli_args->records ? "\"" : "", cli_args->records, cli_args->records ? "\"" : "",
+        records_format_infos[cli_args->recordsformat].name,
+        cli_args->recordstrace ? "true" : "false",
+        cli_args->replay ? "\"" : "", cli_args->replay, cli_args->replay ? "\"" : "",
+        cli_args->replayindex,
+        cli_args->checkpoint ? "\"" : "", cli_args->checkpoint, cli_args->checkpoint ? "\"" : "",
+        cli_args->checkpointinterval,
+        cli_args->resume ? "true" : "false",
+        cli_args->seed, cli_args->seeded ? "" : " (random)",
+        cli_args->shard, cli_args->shardcount,
+        cli_args->partialout ? "\"" : "", cli_args->partialout, cli_args->partialout ? "\"" : "",
+        cli_args->mergefiles.size,
+        cli_args->serve ? "\"" : "", cli_args->serve, cli_args->serve ? "\"" : "",
+        cli_args->cache ? "\"" : "", cli_args->cache, cli_args->cache ? "\"" : "",
+        cli_args->timings ? "true" : "false",
+        cli_args->perfcounters ? "true" : "false",
+        cli_args->allocations ? "true" : "false",
+        cli_args->workers,
+        cli_args->saldensity,
+        generator_lengths_infos[cli_args->sallengths.kind].name, cli_args->sallengths.value,
+        cli_args->generatefile ? "\"" : "", cli_args->generatefile, cli_args->generatefile ? "\"" : "",
+        cli_args->benchdie ? "true" : "false",
+        report_format_infos[cli_args->reportformat].name,
         cli_args->snakesandladders.size
     );
     if (cli_args->snakesandladders.size != 0) {
@@ -387,6 +1007,11 @@ void cli_help() {
     printf(
         "sals " VERSION "\n"
         "Usage: sals [options] <snake-or-ladder>...\n"
+        "       sals [options] -B <config-file>...\n"
+        "       sals [options] -g <board-file>\n"
+        "       sals merge <partial-file>...\n"
+        "       sals generate [options] [<config-file>]\n"
+        "       sals -D <endpoint>\n"
         "\n"
         "  <snake-or-ladder>         A string containing two positive integers separated by a '-' character. Format: %sa%s-%sb%s.\n"
         "                             %sa%s is the index of the starting cell and %sb%s is the index of the ending cell.\n"
@@ -447,6 +1072,93 @@ void cli_help() {
         "                             which must be an integer value >= %lu. The default is %lu.\n"
         "  -b, --bar-length %sval%s      The length of the bars that visualize the probability of each side of the used die\n"
         "                             which must be an integer value >= %lu. The default is %lu.\n"
+        "  -p, --target-precision %sval%s\n"
+        "                            Runs simulations until the half-width of the 95%% confidence interval of the average number of dices\n"
+        "                             is at most %sval%s which must be a positive decimal number (e.g. 0.01). Workers run the simulations in batches\n"
+        "                             and the remaining simulations are cancelled as soon as the target precision is reached.\n"
+        "                             The option -i, --iterations then limits the maximum number of simulations which is unlimited if not set.\n"
+        "  -t, --time-limit %sval%s      Runs simulations until %sval%s seconds passed which must be a positive decimal number (e.g. 2.5).\n"
+        "                             The workers are stopped at the next simulation and the statistics report the number of run simulations\n"
+        "                             and the throughput. The option -i, --iterations then limits the maximum number of simulations\n"
+        "                             which is unlimited if not set.\n"
+        "  -w, --sweep %sname%s=%svalues%s   Runs the simulations of every combination of the swept parameters in one process instead of a single game\n"
+        "                             and prints one result table keyed by the parameters. Can be specified once per parameter.\n"
+        "                             %sname%s is one of width, height, die-sides, distribution, exact-ending and %svalues%s is a comma\n"
+        "                             separated list of integers or inclusive ranges %sa%s..%sb%s (width, height, die-sides), distribution presets\n"
+        "                             (distribution) or on/off (exact-ending). Parameters that are not swept keep their value.\n"
+        "                             e.g. -w die-sides=4..20 -w exact-ending=on,off\n"
+        "  -f, --format %sval%s          The format of the result table printed by -w, --sweep, -B, --batch or -m, --timings which is either\n"
+        "                             csv or json. The default is csv.\n"
+        "  -B, --batch               Runs the games of many configuration files instead of a single game and prints one result table\n"
+        "                             keyed by the file. The non-option arguments are config file paths or quoted glob patterns\n"
+        "                             (e.g. 'examples/*.sals') instead of snakes and ladders. The files are parsed and validated concurrently,\n"
+        "                             invalid files are reported in the table without aborting the batch and the valid games are\n"
+        "                             simulated on one shared thread pool. The options -i, --iterations, -l, --dice-limit and\n"
+        "                             -p, --target-precision override the values of every config file if set.\n"
+        "  -o, --compile-board %sfile%s  Validates the game and compiles it into a binary board %sfile%s instead of simulating it.\n"
+        "                             The board stores the die (side probabilities and alias table), the snakes and ladders and\n"
+        "                             the jump tables of the playing field in a versioned and checksummed layout ready to be memory mapped.\n"
+        "  -g, --board %sfile%s          Loads the game from a binary board %sfile%s compiled with -o, --compile-board instead of setting it up\n"
+        "                             from the arguments. The board is memory mapped read-only and used in place without parsing or validation.\n"
+        "                             Only the header and the layout of the sections are verified, hence the startup does not depend on the\n"
+        "                             board size and processes using the same board share it's memory. Use -V, --verify-board to verify the\n"
+        "                             checksum of the whole board. The options -x, -y, -s, -e, -d and snakes and ladders can't be combined with it.\n"
+        "  -V, --verify-board        Verifies the checksum of all sections of the board loaded with -g, --board before simulating. This reads\n"
+        "                             the whole board, hence the startup takes time proportional to the board size.\n"
+        "  -r, --emit-records %sfile%s   Writes the result of every simulation (index, number of dices, abortion and usage of each snake\n"
+        "                             and ladder) as one record to %sfile%s. The records are formatted by the workers and written by a separate\n"
+        "                             writer thread, hence the simulations don't wait for the file. Records are in the order the simulations finished.\n"
+        "  -R, --records-format %sval%s  The format of the records file which is either binary (fixed-width records of unsigned 64 bit integers\n"
+        "                             after a header, see include/records.h), csv or archive (the diced sides of every simulation compressed\n"
+        "                             with a Huffman code built from the die, see include/archive.h). The default is binary.\n"
+        "  -T, --records-trace       Additionally writes the sequence of diced sides of every simulation to the records file.\n"
+        "  -P, --replay %sindex%s@%sfile%s  Replays the simulation with the given %sindex%s from the trace archive %sfile%s written with -R archive\n"
+        "                             instead of simulating, printing every dice with the player's moves. The game must be the one the\n"
+        "                             archive was recorded on. Only the block of the simulation is decoded, hence any index is fetched quickly.\n"
+        "  -k, --checkpoint %sfile%s     Periodically pauses the workers between two batches and writes their partial results (counts, sums,\n"
+        "                             histograms, shortest dice sequences and random number streams) to %sfile%s. The checkpoint is written to a\n"
+        "                             temporary file which then replaces %sfile%s, hence a killed run always leaves a complete checkpoint.\n"
+        "  -K, --checkpoint-interval %sval%s\n"
+        "                            The number of seconds between two checkpoints which must be a decimal number >= %.3lf. The default is %.0lf.\n"
+        "  -u, --resume              Continues the simulations from the checkpoint file given with -k, --checkpoint. The game, -i, --iterations,\n"
+        "                             -l, --dice-limit and -S, --seed must be the same as in the run that wrote the checkpoint.\n"
+        "  -S, --seed %sval%s            Rolls every simulation with a random number stream derived from the seed %sval%s and it's index and\n"
+        "                             assigns the batches of simulations to the workers in a fixed order, hence the results are reproducible\n"
+        "                             with the same number of processors (bit-identical even if the run was resumed from a checkpoint).\n"
+        "  -n, --shard %sk%s/%sn%s           Runs only shard %sk%s of %sn%s of the simulations (0 <= %sk%s < %sn%s), i.e. the batches %sk%s, %sk%s + %sn%s, %sk%s + 2%sn%s, ...\n"
+        "                             of the seeded run, hence the shards can be run by separate processes or machines. Requires -O, --partial-out.\n"
+        "  -O, --partial-out %sfile%s    Writes the statistics of the run (or of it's shard) including the histogram and the Welford accumulators\n"
+        "                             to %sfile%s after simulating. Requires -S, --seed and can't be combined with -p or -t.\n"
+        "                             %ssals merge file...%s merges the files of all shards into the statistics of the whole run.\n"
+        "  -C, --cache %sdir%s           Loads the statistics of the game from the result cache directory %sdir%s (created if missing) instead of\n"
+        "                             simulating if they contain at least -i, --iterations simulations or reach -p, --target-precision.\n"
+        "                             Otherwise only the missing simulations are run and merged with the cached ones into the entry of the game\n"
+        "                             which is named after a canonical hash of the dimensions, sorted snakes and ladders, die, -e and -l.\n"
+        "  -D, --serve %sendpoint%s      Runs as daemon answering line-delimited JSON requests on the unix domain socket %sendpoint%s\n"
+        "                             (on stdin and stdout if %sendpoint%s is -) instead of simulating. A request like\n"
+        "                             %s{\"id\": 1, \"args\": \"-i 10000 1-16 13-45\"}%s is answered with one line containing it's statistics.\n"
+        "                             The games of recently requested arguments stay loaded and all requests share one pool of threads.\n"
+        "  -m, --timings             Measures the phases of the run (cli_parse, game_setup, simulator_create, simulate, stats_analyze and\n"
+        "                             stats_print) and the time every worker ran with the monotonic clock and prints them after the statistics\n"
+        "                             with the derived rates (configs parsed/s, games/s, dices/s and aggregated MB/s). If -f, --format is set\n"
+        "                             the timings are printed as csv or json document instead of the game, die and statistics.\n"
+        "  -H, --perf-counters       Counts hardware events (cycles, instructions, branches, branch misses, L1D and LLC read misses) of the\n"
+        "                             simulations and of every worker thread with perf_event_open (linux only) and prints them normalized per\n"
+        "                             game and per dice with the instructions per cycle. If the kernel denies access the game is simulated anyway.\n"
+        "  -A, --allocations         Prints the allocations, reallocations, frees, allocated bytes and the peak and live bytes of the arrays\n"
+        "                             and simulator objects of every subsystem (cli, game, simulator, stats) and the peak resident set size\n"
+        "                             on stderr at exit. Bytes still live at exit were not freed.\n"
+        "  -j, --workers %sval%s         The number of worker threads the simulations run on (also the number of configurations of a\n"
+        "                             batch run at once and the size of the thread pool of a daemon). The default is one per online processor.\n"
+        "  -G, --sal-density %sval%s     The number of snakes and ladders per cell (at most %g) %ssals generate%s places randomly on the playing field\n"
+        "                             of -x and -y without overlaps, writing the config to the given file (stdout if none) and compiling it\n"
+        "                             with -o. The same -S, --seed generates the same snakes and ladders. The default is %g.\n"
+        "  -L, --sal-lengths %sdist%s    The distribution of the lengths of the generated snakes and ladders, %sgeometric:mean%s or %suniform:max%s.\n"
+        "                             Without a length the mean or maximum is the width of the playing field. The default is geometric.\n"
+        "  -Q, --bench-die           Benchmarks the samplers (alias table, binary search over the cumulative probabilities) and random number\n"
+        "                             backends (erand48, nrand48) of the die of -s and -d instead of simulating. Measures the rolls per second\n"
+        "                             on one thread and on -j threads and tests -i rolls (default %lu) with a chi-square goodness-of-fit and a\n"
+        "                             serial correlation test. Printed as csv or json with -f, --format.\n"
         "\n",
         FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
         FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
@@ -479,7 +1191,35 @@ void cli_help() {
         FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
         FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), OPTVAL_ITERATIONS_MIN, OPTVAL_ITERATIONS_DEFAULT,
         FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), OPTVAL_DICE_LIMIT_MIN, OPTVAL_DICE_LIMIT_DEFAULT,
-        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), OPTVAL_BAR_LENGTH_MIN, OPTVAL_BAR_LENGTH_DEFAULT
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), OPTVAL_BAR_LENGTH_MIN, OPTVAL_BAR_LENGTH_DEFAULT,
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), OPTVAL_CHECKPOINT_INTERVAL_MIN, OPTVAL_CHECKPOINT_INTERVAL_DEFAULT,
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), OPTVAL_SAL_DENSITY_MAX, FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT), OPTVAL_SAL_DENSITY_DEFAULT,
+        FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE), FMT(FMTVAL_UNDERLINE), FMT(FMTVAL_NO_UNDERLINE),
+        DIEBENCH_ROLLS_DEFAULT
     );
 }
 
@@ -487,183 +1227,174 @@ cli_configfile_args_t cli_read_configfile(const char* filepath) {
     if (!filepath)
         return (cli_configfile_args_t){};
 
-    FILE* file = fopen(filepath, "r");
-    if (!file) {
+    int fd = open(filepath, O_RDONLY);
+    struct stat filestat;
+    if (fd < 0 || fstat(fd, &filestat) != 0) {
+        if (fd >= 0)
+            close(fd);
         fprintf(stderr, "%serror:%s unable to read config file '%s'\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
         exit(1);
     }
 
-    filepos_t pos = filepos_create(filepath);
+    // map regular files privately (copy-on-write) so the arguments can be tokenized in place without copying the content
     cli_configfile_args_t config_args = {};
+    if (S_ISREG(filestat.st_mode) && filestat.st_size > 0) {
+        void* content = mmap(0, filestat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (content != MAP_FAILED) {
+            config_args.content = content;
+            config_args.contentsize = filestat.st_size;
+            config_args.mapped = true;
+        }
+    }
+    // read files that can't be mapped (e.g. pipes) into memory instead
+    if (!config_args.mapped) {
+        array_t content = array_create(S_ISREG(filestat.st_mode) && filestat.st_size > 0 ? filestat.st_size : 0, sizeof(char), 0);
+        char buffer[CLI_CONFIGFILE_READ_BUFFER_SIZE];
+        ssize_t count;
+        while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+            if (!array_reserve(&content, content.size + count)) {
+                count = -1;
+                break;
+            }
+            memcpy((char*)content.data + content.size, buffer, count);
+            content.size += count;
+        }
+        if (count < 0) {
+            array_free(&content, 0);
+            close(fd);
+            fprintf(stderr, "%serror:%s unable to read config file '%s'\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+            exit(1);
+        }
+        config_args.content = content.data;
+        config_args.contentsize = content.size;
+    }
+    close(fd);
+
+    filepos_t pos = filepos_create(filepath);
     array_t args = array_create(0, sizeof(char*), 0);
-    array_t argsstr = array_create(0, sizeof(char), 0);
-    const char* arg;
-    size_t argpos;
-    bool startedarg = false;
     int error = 0;
 
     // add config filepath as argv[0] element (skipped during parsing in getopt_long function)
-    for (const char* filec = filepath; *filec; filec++) {
-        arg = array_add(&argsstr, filec);
-        if (!arg) {
-            error = 1;
-            fprintf(stderr, "%serror:%s unable to add filepath argument to args string at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos.filepath, pos.row, pos.col);
-            break;
-        }
-        if (!startedarg) {
-            argpos = arg - (char*)argsstr.data;
-            startedarg = true;
-        }
+    const char* filepatharg = filepath;
+    if (!array_add(&args, &filepatharg)) {
+        error = 1;
+        fprintf(stderr, "%serror:%s unable to add filepath argument reference to args at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos.filepath, pos.row, pos.col);
     }
-    if (!error) {
-        // add null-terminator to argument
-        char terminator = '\0';
-        if (!array_add(&argsstr, &terminator)) {
-            error = 4;
-            fprintf(stderr, "%serror:%s unable to add null-terminator to filepath argument at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos.filepath, pos.row, pos.col);
+
+    // tokenize the arguments in place and store where they start in the args array
+    size_t offset = 0;
+    size_t length = 0;
+    char* arg;
+    while (!error && (arg = cli_read_configfile_arg(config_args.content, config_args.contentsize, &offset, &length, &pos, &error))) {
+        // null-terminate the argument, only an argument that ends at the end of the content has no space left for it's null-terminator
+        if (arg + length < config_args.content + config_args.contentsize) {
+            arg[length] = '\0';
         } else {
-            // add index of filepath to args array
-            config_args.argc++;
-            size_t* argref = array_add(&args, &argpos);
-            if (!argref) {
-                error = 2;
-                fprintf(stderr, "%serror:%s unable to add filepath argument reference to args at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos.filepath, pos.row, pos.col);
-            } else {
-                // read arguments, add them to args string and store their index (where they start in argsstr) in args array
-                while ((arg = cli_read_configfile_arg(file, &argsstr, &pos, &error))) {
-                    config_args.argc++;
-                    argpos = arg - (char*)argsstr.data;
-                    argref = array_add(&args, &argpos);
-                    if (!argref) {
-                        error = 2;
-                        fprintf(stderr, "%serror:%s unable to add argument reference to args at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos.filepath, pos.row, pos.col);
-                        break;
-                    }
-                }
-                for (size_t i = 0; i < args.size; i++)
-                    ((char**)args.data)[i] += (size_t)argsstr.data;
-                config_args.argv = args.data;
+            config_args.tail = malloc(length + 1);
+            if (!config_args.tail) {
+                error = 3;
+                fprintf(stderr, "%serror:%s unable to add null-terminator to argument at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos.filepath, pos.row, pos.col);
+                break;
             }
+            memcpy(config_args.tail, arg, length);
+            config_args.tail[length] = '\0';
+            arg = config_args.tail;
+        }
+        if (!array_add(&args, &arg)) {
+            error = 2;
+            fprintf(stderr, "%serror:%s unable to add argument reference to args at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos.filepath, pos.row, pos.col);
         }
     }
-
-    fclose(file);
+    config_args.argc = args.size;
+    config_args.argv = args.data;
 
     if (error) {
-        array_free(&args, 0);
-        array_free(&argsstr, 0);
+        cli_configfile_args_free(&config_args);
         exit(1);
     }
 
     return config_args;
 }
 
-char* cli_read_configfile_arg(FILE* file, array_t* argsstr, filepos_t* pos, int* error) {
-    if (!file)
+void cli_configfile_args_free(cli_configfile_args_t* config_args) {
+    if (!config_args)
+        return;
+    if (config_args->mapped)
+        munmap(config_args->content, config_args->contentsize);
+    else
+        free(config_args->content);
+    free(config_args->tail);
+    free(config_args->argv);
+    *config_args = (cli_configfile_args_t){};
+}
+
+char* cli_read_configfile_arg(char* content, size_t size, size_t* offset, size_t* length, filepos_t* pos, int* error) {
+    if (!content || !offset || !length)
         return 0;
-    
+
     // skip starting whitespaces
-    char c;
-    while ((c = fgetc(file)) != EOF && iswhitespace(c))
-        filepos_advance(pos, c);
-    if (c == EOF)
+    size_t readpos = *offset;
+    while (readpos < size && iswhitespace(content[readpos]))
+        filepos_advance(pos, content[readpos++]);
+    if (readpos == size) {
+        *offset = readpos;
         return 0;
-    
+    }
+
     // setup static const data for managing modes
     static const char esc = '\\';
     static const char qu1 = '\'';
     static const char qu2 = '"';
-    
-    // read argument potentially with escaped characters (\) and quoted sections (", ')
-    array_t newarg;
-    array_t* arg = argsstr ? argsstr : &newarg;
-    if (!argsstr)
-        newarg = array_create(0, sizeof(char), 0);
-    size_t argstart = 0;
-    bool startedarg = false;
+
+    // readpos argument potentially with escaped characters (\) and quoted sections (", ')
+    // removed quotation marks and escape characters only shrink the argument, hence it is written in place behind the readpos position
+    char* arg = &content[readpos];
+    size_t writepos = readpos;
     char mode = 0;
-    do {
+    for (; readpos < size; readpos++) {
+        char c = content[readpos];
+        filepos_advance(pos, c);
         if (mode == esc) {
             mode = 0;
         } else if (mode == qu1 || mode == qu2) {
             if (c == mode) {
                 mode = 0;
-                filepos_advance(pos, c);
                 continue;
             }
         } else if (c == qu1 || c == qu2) {
             mode = c;
-            filepos_advance(pos, c);
             continue;
         } else if (c == esc) {
             mode = esc;
-            filepos_advance(pos, c);
             continue;
         } else if (iswhitespace(c)) {
-            filepos_advance(pos, c);
+            readpos++;
             break;
         }
-        char* addr = array_add(arg, &c);
-        if (!addr) {
-            if (error)
-                *error = 1;
-            if (pos)
-                fprintf(stderr, "%serror:%s unable to add char to argument at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos->filepath, pos->row, pos->col);
-            else
-                fprintf(stderr, "%serror:%s unable to add char to argument in configfile.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
-            if (!argsstr)
-                array_free(arg, 0);
-            return 0;
-        }
-        filepos_advance(pos, c);
-        if (!startedarg) {
-            argstart = addr - (char*)arg->data;
-            startedarg = true;
-        }
-    } while ((c = fgetc(file)) != EOF);
+        content[writepos++] = c;
+    }
+    *offset = readpos;
 
     // check for active escape mode or unclosed quoted section at the end of the argument
     if (mode == esc || mode == qu1 || mode == qu2) {
         if (mode == esc) {
             if (error)
-                *error = 2;
+                *error = 1;
             if (pos)
                 fprintf(stderr, "%serror:%s argument ended in escape mode at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos->filepath, pos->row, pos->col);
-            else
-                fprintf(stderr, "%serror:%s argument ended in escape mode in configfile.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
         } else {
             if (error)
-                *error = 3;
+                *error = 2;
             if (pos)
                 fprintf(stderr, "%serror:%s argument ended with unclosed quoted section at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos->filepath, pos->row, pos->col);
-            else
-                fprintf(stderr, "%serror:%s argument ended with unclosed quoted section in configfile.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
         }
-        if (!argsstr)
-            array_free(arg, 0);
-        return 0;
-    }
-
-    // add null-terminator to argument
-    char terminator = '\0';
-    char* termaddr = array_add(arg, &terminator);
-    if (!termaddr) {
-        if (error)
-            *error = 4;
-        if (pos)
-            fprintf(stderr, "%serror:%s unable to add null-terminator to argument at %s:%lu:%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), pos->filepath, pos->row, pos->col);
-        else
-            fprintf(stderr, "%serror:%s unable to add null-terminator to argument in configfile.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
-        if (!argsstr)
-            array_free(arg, 0);
         return 0;
     }
-    if (!startedarg)
-        argstart = termaddr - (char*)arg->data;
 
+    *length = &content[writepos] - arg;
     if (error)
         *error = 0;
-    return &((char*)arg->data)[argstart];
+    return arg;
 }
 
 uint64_t cli_parse_opt_uint64(char opt, uint64_t valmin, uint64_t valmax) {
@@ -694,9 +1425,41 @@ uint64_t cli_parse_opt_uint64(char opt, uint64_t valmin, uint64_t valmax) {
     return value;
 }
 
+double cli_parse_opt_double(char opt, double valmin, double valmax) {
+    double value = 0.0;
+    int error = strtodouble(optarg, &value);
+    switch (error) {
+        case 1:
+            fprintf(stderr, "%serror:%s -%c no string given.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), opt);
+            exit(1);
+        case 2:
+            fprintf(stderr, "%serror:%s -%c value out of range (%s).\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), opt, optarg);
+            exit(1);
+        case 3:
+        case 4:
+            fprintf(stderr, "%serror:%s -%c not a number '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), opt, optarg);
+            exit(1);
+        default:
+            break;
+    }
+    // negated comparisons to also reject nan
+    if (!(value >= valmin)) {
+        fprintf(stderr, "%serror:%s -%c %s less than minimum %lg.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), opt, optarg, valmin);
+        exit(1);
+    }
+    if (!(value <= valmax)) {
+        fprintf(stderr, "%serror:%s -%c %s greater than maximum %lg.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), opt, optarg, valmax);
+        exit(1);
+    }
+    return value;
+}
+
 void cli_read_sals(cli_args_t* args, int argc, char* argv[]) {
-    if (args && argc != 0)
+    if (args && argc != 0) {
         args->setargsflags |= CLIAFLAG_SNAKESANDLADDERS;
+        // reserve the snakes and ladders at once instead of growing the array while adding them
+        array_reserve(&args->snakesandladders, args->snakesandladders.size + argc);
+    }
     for (int i = 0; i < argc; i++) {
         int error = 0;
         snakeorladder_t sol = strtosol(argv[i], &error);
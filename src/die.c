@@ -7,21 +7,62 @@
 #include <stdlib.h>
 
 die_t die_create_empty() {
-    return (die_t){ array_create(0, sizeof(double), 0) };
+    return (die_t){ array_create(0, sizeof(double), 0), array_create(0, sizeof(die_alias_t), 0) };
 }
 
 die_t die_create(const distribution_t* distr) {
     if (!distr)
         return die_create_empty();
-    die_t die = { array_create(distr->weights.size, sizeof(double), 0) };
-    if (!die.sides.data)
-        die_create_empty();
+    size_t sidecount = distr->weights.size;
+    die_t die = { array_create(sidecount, sizeof(double), 0), array_create(sidecount, sizeof(die_alias_t), 0) };
+    if (sidecount == 0 || !die.sides.data || !die.alias.data) {
+        die_free(&die);
+        return die_create_empty();
+    }
     // calculate probabilities from weights
     size_t weightsum = 0;
-    for (size_t i = 0; i < distr->weights.size; i++)
+    for (size_t i = 0; i < sidecount; i++)
         weightsum += *(size_t*)array_getconst(&distr->weights, i);
-    for (size_t i = 0; i < distr->weights.size; i++)
+    if (weightsum == 0) {
+        die_free(&die);
+        return die_create_empty();
+    }
+    for (size_t i = 0; i < sidecount; i++)
         array_add(&die.sides, &(double){ *(size_t*)array_getconst(&distr->weights, i) / (double)weightsum });
+
+    // build alias table (Vose's alias method): sides with a scaled probability < 1 are filled up by sides with a scaled probability >= 1
+    size_t* worklist = malloc(sidecount * sizeof(*worklist));
+    double* scaled = malloc(sidecount * sizeof(*scaled));
+    if (!worklist || !scaled) {
+        free(worklist);
+        free(scaled);
+        die_free(&die);
+        return die_create_empty();
+    }
+    // the small sides are stacked from the front of the worklist and the large sides from the back
+    size_t smallcount = 0;
+    size_t largecount = 0;
+    for (size_t i = 0; i < sidecount; i++) {
+        scaled[i] = *(const double*)array_getconst(&die.sides, i) * sidecount;
+        if (scaled[i] < 1.0)
+            worklist[smallcount++] = i;
+        else
+            worklist[sidecount - ++largecount] = i;
+        array_add(&die.alias, &(die_alias_t){ 1.0, i });
+    }
+    while (smallcount != 0 && largecount != 0) {
+        size_t small = worklist[--smallcount];
+        size_t large = worklist[sidecount - largecount];
+        *(die_alias_t*)array_get(&die.alias, small) = (die_alias_t){ scaled[small], large };
+        scaled[large] -= 1.0 - scaled[small];
+        if (scaled[large] < 1.0) {
+            largecount--;
+            worklist[smallcount++] = large;
+        }
+    }
+    // remaining sides only differ from 1 by rounding errors, hence they always dice their own side (prob 1.0 set above)
+    free(worklist);
+    free(scaled);
     return die;
 }
 
@@ -29,6 +70,7 @@ void die_free(die_t* die) {
     if (!die)
         return;
     array_free(&die->sides, 0);
+    array_free(&die->alias, 0);
     *die = (die_t){};
 }
 
@@ -37,38 +79,19 @@ bool die_isempty(const die_t* die) {
 }
 
 size_t dice(const die_t* die) {
-    // thread-safely generate random double in interval [0,1) 
-    double random = tserand48();
-    // apply die side probabilities (distribution)
-    double offset = 0.0;
-    size_t side = 0;
-    for (; side < die->sides.size; side++) {
-        offset += *(double*)array_getconst(&die->sides, side);
-        if (random < offset)
-            return side + 1;
-    }
-    return side;
+    // thread-safely generate random double in interval [0,1)
+    return die_sample(die, tserand48());
 }
 
-void simulate_dices(const die_t* die, size_t iterations) {
-    printf("\n");
-    size_t* sides = malloc(die->sides.size * sizeof(*sides));
-    if (!sides) {
-        fprintf(stderr, "%serror:%s unable to simulate %lu dices.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), iterations);
-        exit(1);
-    }
-    for (size_t side = 1; side != die->sides.size + 1; side++)
-        sides[side - 1] = 0;
-    printf("simulating %lu dices\n", iterations);
-    tsnewseed48();
-    size_t it = 0;
-    for (; it < iterations; it++)
-        sides[dice(die) - 1]++;
-    for (size_t side = 1; side != die->sides.size + 1; side++)
-        printf("%s%3lu%s %12lu %10.6lf%%\n", FMT(FMTVAL_FG_BRIGHT_BLACK), side, FMT(FMTVAL_FG_DEFAULT), sides[side - 1], ((double)sides[side - 1] / (double)iterations) * 100.0);
-    printf("\n");
-    free(sides);
-
+size_t die_sample(const die_t* die, double random) {
+    // scale the random number to the interval [0,sides) and pick the column of it's integer part
+    random *= die->alias.size;
+    size_t column = (size_t)random;
+    if (column >= die->alias.size)
+        column = die->alias.size - 1;
+    // apply die side probabilities (distribution) by dicing either the column's side or it's alias depending on the fraction
+    const die_alias_t* entry = array_getconst(&die->alias, column);
+    return (random - column < entry->prob ? column : entry->alias) + 1;
 }
 
 void die_print(const die_t* die, size_t barlength) {
@@ -0,0 +1,328 @@
+#include "diebench.h"
+
+#include "cvts.h"
+#include "stopwatch.h"
+#include "tsrand48.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+diebench_sampler_info_t diebench_sampler_infos[DIEBENCH_SAMPLER_COUNT] = {
+    { "alias", diebench_sample_alias },
+    { "cdf"  , diebench_sample_cdf   }
+};
+
+diebench_backend_info_t diebench_backend_infos[DIEBENCH_BACKEND_COUNT] = {
+    { "erand48", 48, diebench_uniform_erand48 },
+    { "nrand48", 31, diebench_uniform_nrand48 }
+};
+
+diebench_t diebench_create(const die_t* die, size_t rolls, size_t threads, uint64_t seed) {
+    diebench_t bench = {
+        .die = die,
+        .cdf = array_create(die ? die->sides.size : 0, sizeof(double), 0),
+        .rolls = rolls > 0 ? rolls : 1,
+        .threads = threads > 0 ? threads : 1,
+        .seed = seed
+    };
+    if (!die || !bench.cdf.data)
+        return bench;
+    // the last side with a probability > 0 ends at exactly 1, hence rounding errors can't pick a side after it
+    size_t last = 0;
+    for (size_t i = 0; i < die->sides.size; i++)
+        if (*(const double*)array_getconst(&die->sides, i) > 0.0)
+            last = i;
+    double cumulative = 0.0;
+    for (size_t i = 0; i < die->sides.size; i++) {
+        cumulative += *(const double*)array_getconst(&die->sides, i);
+        array_add(&bench.cdf, &(double){ i >= last ? 1.0 : cumulative });
+    }
+    return bench;
+}
+
+void diebench_free(diebench_t* bench) {
+    if (!bench)
+        return;
+    array_free(&bench->cdf, 0);
+}
+
+size_t diebench_sample_alias(const diebench_t* bench, double random) {
+    return die_sample(bench->die, random);
+}
+
+size_t diebench_sample_cdf(const diebench_t* bench, double random) {
+    // find the first side whose cumulative probability is greater than the random number
+    const double* cdf = bench->cdf.data;
+    size_t low = 0;
+    size_t high = bench->cdf.size - 1;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (cdf[mid] > random)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low + 1;
+}
+
+double diebench_uniform_erand48() {
+    return tserand48();
+}
+
+double diebench_uniform_nrand48() {
+    return tsnrand48() * (1.0 / 2147483648.0);
+}
+
+double diebench_table_error(const diebench_t* bench, size_t sampler) {
+    if (!bench || !bench->die || sampler >= DIEBENCH_SAMPLER_COUNT || bench->cdf.size != bench->die->sides.size)
+        return INFINITY;
+    const size_t sidecount = bench->die->sides.size;
+    double* implied = calloc(sidecount, sizeof(*implied));
+    if (!implied)
+        return INFINITY;
+    if (sampler == 0) {
+        // every column is picked with probability 1 / sides and then dices it's own side or it's alias
+        for (size_t i = 0; i < sidecount; i++) {
+            const die_alias_t* entry = array_getconst(&bench->die->alias, i);
+            implied[i] += entry->prob / sidecount;
+            implied[entry->alias] += (1.0 - entry->prob) / sidecount;
+        }
+    } else {
+        const double* cdf = bench->cdf.data;
+        for (size_t i = 0; i < sidecount; i++)
+            implied[i] = cdf[i] - (i > 0 ? cdf[i - 1] : 0.0);
+    }
+    double error = 0.0;
+    for (size_t i = 0; i < sidecount; i++)
+        error = fmax(error, fabs(implied[i] - *(const double*)array_getconst(&bench->die->sides, i)));
+    free(implied);
+    return error;
+}
+
+int diebench_thread_run(diebench_thread_t* thread) {
+    if (!thread)
+        return 1;
+    const tsseed48_t newseed = tsderiveseed48(thread->bench->seed, thread->stream);
+    const tsseed48_t prevseed = tsseed48(&newseed);
+    size_t sink = 0;
+    for (size_t i = 0; i < thread->rolls; i++)
+        sink += thread->sample(thread->bench, thread->uniform());
+    thread->sink = sink;
+    tsseed48(&prevseed);
+    return 0;
+}
+
+double diebench_measure(const diebench_t* bench, size_t sampler, size_t backend, size_t threads) {
+    if (!bench || sampler >= DIEBENCH_SAMPLER_COUNT || backend >= DIEBENCH_BACKEND_COUNT)
+        return 0.0;
+    threads = threads > 0 ? threads : 1;
+    diebench_thread_t* workers = calloc(threads, sizeof(*workers));
+    if (!workers)
+        return 0.0;
+    for (size_t i = 0; i < threads; i++) {
+        workers[i] = (diebench_thread_t){
+            .bench = bench,
+            .sample = diebench_sampler_infos[sampler].sample,
+            .uniform = diebench_backend_infos[backend].uniform,
+            .rolls = bench->rolls / threads + (i < bench->rolls % threads),
+            .stream = i
+        };
+    }
+    // the calling thread rolls the first share itself
+    stopwatch_t stopwatch = stopwatch_start();
+    bool started = true;
+    for (size_t i = 1; i < threads; i++) {
+        workers[i].started = thrd_create(&workers[i].thread, (thrd_start_t)diebench_thread_run, &workers[i]) == thrd_success;
+        started = started && workers[i].started;
+    }
+    diebench_thread_run(&workers[0]);
+    for (size_t i = 1; i < threads; i++)
+        if (workers[i].started)
+            thrd_join(workers[i].thread, 0);
+    const double seconds = stopwatch_elapsed(&stopwatch);
+    free(workers);
+    return started && seconds > 0.0 ? bench->rolls / seconds : 0.0;
+}
+
+double diebench_chisquare_p(double chisquare, size_t df) {
+    if (df == 0 || !(chisquare > 0.0))
+        return 1.0;
+    if (isinf(chisquare))
+        return 0.0;
+    const double a = df / 2.0;
+    const double x = chisquare / 2.0;
+    const double prefactor = exp(-x + a * log(x) - lgamma(a));
+    double q = 0.0;
+    if (x < a + 1.0) {
+        // series of the lower incomplete gamma function P(a, x), Q = 1 - P
+        double term = 1.0 / a;
+        double sum = term;
+        for (size_t n = 1; n < 1000000 && fabs(term) > fabs(sum) * DBL_EPSILON; n++) {
+            term *= x / (a + n);
+            sum += term;
+        }
+        q = 1.0 - sum * prefactor;
+    } else {
+        // continued fraction of the upper incomplete gamma function Q(a, x) (modified Lentz's method)
+        double b = x + 1.0 - a;
+        double c = 1.0 / DBL_MIN;
+        double d = 1.0 / b;
+        double h = d;
+        for (size_t i = 1; i < 1000000; i++) {
+            const double an = -(double)i * (i - a);
+            b += 2.0;
+            d = an * d + b;
+            d = fabs(d) < DBL_MIN ? DBL_MIN : d;
+            c = b + an / c;
+            c = fabs(c) < DBL_MIN ? DBL_MIN : c;
+            d = 1.0 / d;
+            h *= d * c;
+            if (fabs(d * c - 1.0) <= DBL_EPSILON)
+                break;
+        }
+        q = prefactor * h;
+    }
+    return fmin(1.0, fmax(0.0, q));
+}
+
+bool diebench_test(const diebench_t* bench, diebench_result_t* result) {
+    if (!bench || !bench->die || !result || result->sampler >= DIEBENCH_SAMPLER_COUNT || result->backend >= DIEBENCH_BACKEND_COUNT)
+        return false;
+    const size_t sidecount = bench->die->sides.size;
+    size_t* counts = calloc(sidecount, sizeof(*counts));
+    if (!counts)
+        return false;
+    // the mean and variance of the die, hence the serial correlation of a correct sampler is 0 with variance 1 / rolls
+    double mean = 0.0;
+    double variance = 0.0;
+    for (size_t i = 0; i < sidecount; i++) {
+        const double prob = *(const double*)array_getconst(&bench->die->sides, i);
+        mean += prob * (i + 1);
+        variance += prob * (i + 1) * (i + 1);
+    }
+    variance -= mean * mean;
+
+    const diebench_sampler_fn_t sample = diebench_sampler_infos[result->sampler].sample;
+    const diebench_backend_fn_t uniform = diebench_backend_infos[result->backend].uniform;
+    const tsseed48_t newseed = tsderiveseed48(bench->seed, 0);
+    const tsseed48_t prevseed = tsseed48(&newseed);
+    double covariance = 0.0;
+    double previous = 0.0;
+    for (size_t i = 0; i < bench->rolls; i++) {
+        const size_t side = sample(bench, uniform());
+        counts[side - 1]++;
+        const double deviation = side - mean;
+        if (i > 0)
+            covariance += deviation * previous;
+        previous = deviation;
+    }
+    tsseed48(&prevseed);
+
+    // sides that can't be diced don't count as degree of freedom, but dicing one rejects the sampler
+    result->chisquare = 0.0;
+    result->df = 0;
+    for (size_t i = 0; i < sidecount; i++) {
+        const double expected = *(const double*)array_getconst(&bench->die->sides, i) * bench->rolls;
+        if (expected > 0.0) {
+            result->chisquare += (counts[i] - expected) * (counts[i] - expected) / expected;
+            result->df++;
+        } else if (counts[i] > 0) {
+            result->chisquare = INFINITY;
+        }
+    }
+    result->df = result->df > 0 ? result->df - 1 : 0;
+    result->chisquarep = diebench_chisquare_p(result->chisquare, result->df);
+    result->serial = bench->rolls > 1 && variance > DBL_EPSILON ? covariance / ((bench->rolls - 1) * variance) : 0.0;
+    result->serialp = erfc(fabs(result->serial) * sqrt(bench->rolls > 1 ? bench->rolls - 1 : 1) / sqrt(2.0));
+    result->passed = result->tableerror <= DIEBENCH_TABLE_ERROR_MAX && result->chisquarep >= DIEBENCH_ALPHA && result->serialp >= DIEBENCH_ALPHA;
+    free(counts);
+    return true;
+}
+
+bool diebench_run(diebench_t* bench) {
+    if (!bench || !bench->die || bench->cdf.size != bench->die->sides.size)
+        return false;
+    bool success = true;
+    for (size_t sampler = 0; sampler < DIEBENCH_SAMPLER_COUNT; sampler++) {
+        for (size_t backend = 0; backend < DIEBENCH_BACKEND_COUNT; backend++) {
+            diebench_result_t* result = &bench->results[sampler * DIEBENCH_BACKEND_COUNT + backend];
+            *result = (diebench_result_t){ .sampler = sampler, .backend = backend };
+            result->single = diebench_measure(bench, sampler, backend, 1);
+            result->multi = bench->threads > 1 ? diebench_measure(bench, sampler, backend, bench->threads) : result->single;
+            result->tableerror = diebench_table_error(bench, sampler);
+            success = diebench_test(bench, result) && result->single > 0.0 && result->multi > 0.0 && success;
+        }
+    }
+    return success;
+}
+
+size_t diebench_failed(const diebench_t* bench) {
+    if (!bench)
+        return 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < DIEBENCH_SAMPLER_COUNT * DIEBENCH_BACKEND_COUNT; i++)
+        if (!bench->results[i].passed)
+            failed++;
+    return failed;
+}
+
+void diebench_print(const diebench_t* bench) {
+    if (!bench)
+        return;
+    char multi[32];
+    snprintf(multi, sizeof(multi), "ROLLS/S (%lu)", bench->threads);
+    printf(
+        "Die benchmark\n"
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%-8s  %-8s  %4s  %14s  %14s  %9s  %10s  %10s  %8s  %6s%s \x1b(0x\x1b(B\n",
+        FMT(FMTVAL_BOLD), "SAMPLER", "BACKEND", "BITS", "ROLLS/S (1)", multi, "TABLE ERR", "CHI2 P", "SERIAL R", "SERIAL P", "RESULT", FMT(FMTVAL_NO_BOLD)
+    );
+    for (size_t i = 0; i < DIEBENCH_SAMPLER_COUNT * DIEBENCH_BACKEND_COUNT; i++) {
+        const diebench_result_t* result = &bench->results[i];
+        printf(
+            "  \x1b(0x\x1b(B %-8s  %-8s  %4lu  %14.0lf  %14.0lf  %9.2le  %10.4lf  %+10.6lf  %8.4lf  %s%6s%s \x1b(0x\x1b(B\n",
+            diebench_sampler_infos[result->sampler].name, diebench_backend_infos[result->backend].name, diebench_backend_infos[result->backend].bits,
+            result->single, result->multi, result->tableerror, result->chisquarep, result->serial, result->serialp,
+            result->passed ? "" : FMT(FMTVAL_FG_BRIGHT_RED), result->passed ? "ok" : "FAIL", result->passed ? "" : FMT(FMTVAL_FG_DEFAULT)
+        );
+    }
+    printf(
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "  %s%lu rolls of a %lu-sided die per measurement with seed %lu. alias and erand48 are the sampler and backend of the simulations.\n"
+        "  A combination fails if the probabilities implied by it's table deviate by more than %.0le or the chi-square goodness-of-fit\n"
+        "  or the lag-1 serial correlation test rejects it at alpha %.3lf.%s\n"
+        "\n",
+        FMT(FMTVAL_FG_BRIGHT_BLACK), bench->rolls, bench->die ? bench->die->sides.size : 0, bench->seed,
+        DIEBENCH_TABLE_ERROR_MAX, DIEBENCH_ALPHA, FMT(FMTVAL_FG_DEFAULT)
+    );
+}
+
+void diebench_print_report(FILE* file, const diebench_t* bench, report_format_t format) {
+    if (!file || !bench)
+        return;
+    if (format == REPORT_FORMAT_JSON)
+        fprintf(file, "[\n");
+    else
+        fprintf(file, "sampler,backend,bits,rolls,threads,single_rolls_per_s,multi_rolls_per_s,table_error,chi_square,df,chi_square_p,serial_r,serial_p,passed\n");
+    for (size_t i = 0; i < DIEBENCH_SAMPLER_COUNT * DIEBENCH_BACKEND_COUNT; i++) {
+        const diebench_result_t* result = &bench->results[i];
+        const char* sampler = diebench_sampler_infos[result->sampler].name;
+        const char* backend = diebench_backend_infos[result->backend].name;
+        const size_t bits = diebench_backend_infos[result->backend].bits;
+        if (format == REPORT_FORMAT_JSON) {
+            fprintf(file, "%s  { \"sampler\": \"%s\", \"backend\": \"%s\", \"bits\": %lu, \"rolls\": %lu, \"threads\": %lu, \"single_rolls_per_s\": %.3lf, "
+                "\"multi_rolls_per_s\": %.3lf, \"table_error\": %.6le, \"chi_square\": %.6lf, \"df\": %lu, \"chi_square_p\": %.6lf, \"serial_r\": %.9lf, "
+                "\"serial_p\": %.6lf, \"passed\": %s }",
+                i == 0 ? "" : ",\n", sampler, backend, bits, bench->rolls, bench->threads, result->single, result->multi,
+                isinf(result->tableerror) ? DBL_MAX : result->tableerror, isinf(result->chisquare) ? DBL_MAX : result->chisquare,
+                result->df, result->chisquarep, result->serial, result->serialp, result->passed ? "true" : "false");
+        } else {
+            fprintf(file, "%s,%s,%lu,%lu,%lu,%.3lf,%.3lf,%.6le,%.6lf,%lu,%.6lf,%.9lf,%.6lf,%s\n",
+                sampler, backend, bits, bench->rolls, bench->threads, result->single, result->multi, result->tableerror, result->chisquare,
+                result->df, result->chisquarep, result->serial, result->serialp, result->passed ? "true" : "false");
+        }
+    }
+    if (format == REPORT_FORMAT_JSON)
+        fprintf(file, "\n]\n");
+}
@@ -1,6 +1,5 @@
 #include "distribution.h"
 
-#include "str.h"
 #include "numbers.h"
 
 #include <stdbool.h>
@@ -49,34 +48,33 @@ distribution_t strtodistr(const char* str, int* error) {
         if (strcmp(str, distr_preset_infos[i].name) == 0)
             return distr_create(i);
 
-    // convert string to distribution weights
-    distribution_t distr = distr_create_empty();
-    char* strdup = strduplicate(str);
-    if (!strdup) {
-        if (error)
-            *error = 2;
-        return distr_create_empty();
-    }
-    twostrs_t twostrs = (twostrs_t){ 0, strdup };
-    do {
-        twostrs = strsplitnext(twostrs.strs[1], ',');
+    // reserve the weights at once and parse them in place between the commas
+    size_t weightcount = 1;
+    for (const char* c = str; *c; c++)
+        if (*c == ',')
+            weightcount++;
+    distribution_t distr = (distribution_t){ DISTR_PRESET_NONE, array_create(weightcount, sizeof(size_t), 0) };
+    const char* weightstr = str;
+    while (true) {
+        const char* comma = strchr(weightstr, ',');
         size_t weight = 0;
-        int err = strtouint64(twostrs.strs[0], &weight);
+        int err = strntouint64(weightstr, comma ? (size_t)(comma - weightstr) : strlen(weightstr), &weight);
         if (err) {
             if (error)
                 *error = err + 1;
-            free(strdup);
             distr_free(&distr);
             return distr_create_empty();
         }
         if (!array_add(&distr.weights, &weight)) {
             if (error)
                 *error = 7;
-            free(strdup);
             distr_free(&distr);
             return distr_create_empty();
         }
-    } while (twostrs.strs[1]);
+        if (!comma)
+            break;
+        weightstr = comma + 1;
+    }
 
     return distr;
 }
@@ -161,12 +159,12 @@ distribution_t distr_preset_build_uniform(size_t die_sides, int* error) {
 distribution_t distr_preset_build_twodice(size_t die_sides, int* error) {
     if (die_sides == 0) {
         if (error)
-            *error = 2;
+            *error = 3;
         return distr_create_empty();
     }
     if (die_sides % 2 != 0) {
         if (error)
-            *error = 3;
+            *error = 2;
         return distr_create_empty();
     }
     distribution_t distr = distr_create(DISTR_PRESET_TWODICE);
@@ -205,7 +203,7 @@ distribution_t distr_preset_build_upstairs(size_t die_sides, int* error) {
 }
 
 distribution_t distr_preset_build_downstairs(size_t die_sides, int* error) {
-    distribution_t distr = distr_create(DISTR_PRESET_UPSTAIRS);
+    distribution_t distr = distr_create(DISTR_PRESET_DOWNSTAIRS);
     size_t weight = die_sides;
     for (size_t i = 0; i < die_sides; i++, weight--) {
         if (!array_add(&distr.weights, &weight)) {
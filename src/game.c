@@ -1,90 +1,348 @@
 #include "game.h"
 
-#include "assetmanager.h"
+#include "board.h"
 #include "cli.h"
 #include "cvts.h"
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
-game_t game_setup(cli_args_t* cli_args) {
-    game_t game = {};
-    if (!cli_args)
-        return game;
-    assetmanager_add(&game, (deallocator_fn_t)game_free);
+game_occupancy_t game_occupancy_create(size_t cellcount, size_t salcount) {
+    // hash the cells into four slots per snake or ladder (at most two cells each) unless the playing field has even less cells
+    size_t capacity = 16;
+    while (capacity < salcount * 4 && capacity <= SIZE_MAX / 2)
+        capacity *= 2;
+    game_occupancy_t occupancy = { .capacity = capacity, .hashed = cellcount > capacity || cellcount == 0 };
+    if (!occupancy.hashed)
+        occupancy.capacity = cellcount;
+    occupancy.owners = malloc(occupancy.capacity * sizeof(*occupancy.owners));
+    occupancy.cells = occupancy.hashed ? malloc(occupancy.capacity * sizeof(*occupancy.cells)) : 0;
+    if (occupancy.capacity == 0 || !occupancy.owners || (occupancy.hashed && !occupancy.cells)) {
+        game_occupancy_free(&occupancy);
+        return occupancy;
+    }
+    for (size_t i = 0; i < occupancy.capacity; i++) {
+        atomic_init(&occupancy.owners[i], SIZE_MAX);
+        if (occupancy.hashed)
+            atomic_init(&occupancy.cells[i], 0);
+    }
+    return occupancy;
+}
 
-    // set dimensions
-    game.width = cli_args->width;
-    game.height = cli_args->height;
-    if (game.width < GAME_WIDTH_MIN || game.height < GAME_HEIGHT_MIN) {
-        fprintf(stderr, "%serror:%s game has invalid dimensions %lux%lu. must be at least %lux%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), game.width, game.height, GAME_WIDTH_MIN, GAME_HEIGHT_MIN);
-        exit(1);
+void game_occupancy_free(game_occupancy_t* occupancy) {
+    if (!occupancy)
+        return;
+    free(occupancy->owners);
+    free(occupancy->cells);
+    *occupancy = (game_occupancy_t){};
+}
+
+_Atomic size_t* game_occupancy_slot(game_occupancy_t* occupancy, size_t cell, bool claim) {
+    if (!occupancy || occupancy->capacity == 0 || cell == 0)
+        return 0;
+    if (!occupancy->hashed)
+        return cell <= occupancy->capacity ? &occupancy->owners[cell - 1] : 0;
+    // probe the slots starting at the cell's hash (fibonacci hashing) until the cell's slot or an empty slot is found
+    size_t mask = occupancy->capacity - 1;
+    size_t hash = cell * 0x9e3779b97f4a7c15ull;
+    hash ^= hash >> 32;
+    for (size_t probe = 0, slot = hash & mask; probe < occupancy->capacity; probe++, slot = (slot + 1) & mask) {
+        size_t slotcell = atomic_load_explicit(&occupancy->cells[slot], memory_order_acquire);
+        if (slotcell == 0) {
+            if (!claim)
+                return 0;
+            // claim the empty slot unless another thread claimed it in the meantime (possibly for the same cell)
+            if (atomic_compare_exchange_strong(&occupancy->cells[slot], &slotcell, cell))
+                return &occupancy->owners[slot];
+        }
+        if (slotcell == cell)
+            return &occupancy->owners[slot];
+    }
+    return 0;
+}
+
+bool game_occupancy_occupy(game_occupancy_t* occupancy, size_t cell, size_t index) {
+    _Atomic size_t* owner = game_occupancy_slot(occupancy, cell, true);
+    if (!owner)
+        return false;
+    size_t current = atomic_load(owner);
+    while (index < current && !atomic_compare_exchange_weak(owner, &current, index));
+    return true;
+}
+
+int game_check_sol(size_t cellcount, const snakeorladder_t* sol) {
+    // check if sol starts or ends in a cell outside the playing field
+    if (sol->src == 0 || sol->src > cellcount)
+        return 2;
+    if (sol->dst == 0 || sol->dst > cellcount)
+        return 3;
+    // check if sol starts and ends in the same cell as itself
+    if (sol->src == sol->dst)
+        return 4;
+    // check if sol starts or ends in the last cell of the playing field
+    if (sol->src == cellcount)
+        return 5;
+    if (sol->dst == cellcount)
+        return 6;
+    return 0;
+}
+
+int game_check_thread_run(game_check_thread_t* thread) {
+    if (!thread)
+        return 1;
+    if (thread->occupy) {
+        // occupy the cells of the valid snakes and ladders up to the first one that doesn't lie on the playing field
+        // (the ones after it can't overlap with a snake or ladder before it, hence they don't matter)
+        for (size_t i = thread->first; i < thread->last; i++) {
+            const snakeorladder_t* sol = array_getconst(thread->sals, i);
+            int error = game_check_sol(thread->cellcount, sol);
+            if (error) {
+                thread->error = error;
+                thread->invalididx = i;
+                break;
+            }
+            if (!game_occupancy_occupy(thread->occupancy, sol->src, i) || !game_occupancy_occupy(thread->occupancy, sol->dst, i))
+                return 2;
+        }
+        return 0;
     }
-    size_t cellcount = game.width * game.height;
+    // a snake or ladder overlaps with one before it if a cell it occupies is owned by a smaller index
+    size_t last = thread->error ? thread->invalididx : thread->last;
+    for (size_t i = thread->first; i < last; i++) {
+        const snakeorladder_t* sol = array_getconst(thread->sals, i);
+        const _Atomic size_t* srcowner = game_occupancy_slot(thread->occupancy, sol->src, false);
+        const _Atomic size_t* dstowner = game_occupancy_slot(thread->occupancy, sol->dst, false);
+        size_t other = srcowner ? atomic_load(srcowner) : SIZE_MAX;
+        if (dstowner && atomic_load(dstowner) < other)
+            other = atomic_load(dstowner);
+        if (other < i) {
+            thread->error = 7;
+            thread->invalididx = i;
+            thread->otheridx = other;
+            break;
+        }
+    }
+    return 0;
+}
+
+int game_check_sals(size_t cellcount, const array_t* sals, size_t* invalididx, size_t* otheridx) {
+    if (!sals)
+        return 1;
+    if (sals->size == 0)
+        return 0;
+    game_occupancy_t occupancy = game_occupancy_create(cellcount, sals->size);
+    if (occupancy.capacity == 0)
+        return 8;
+
+    // split the snakes and ladders into one contiguous range per thread
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threadcount = sals->size / GAME_CHECK_PARALLEL_MIN_SALS;
+    if (cpus > 0 && threadcount > (size_t)cpus)
+        threadcount = cpus;
+    if (threadcount == 0)
+        threadcount = 1;
+    game_check_thread_t* threads = calloc(threadcount, sizeof(*threads));
+    if (!threads) {
+        game_occupancy_free(&occupancy);
+        return 8;
+    }
+    size_t rangesize = (sals->size + threadcount - 1) / threadcount;
+    for (size_t t = 0; t < threadcount; t++) {
+        size_t first = t * rangesize < sals->size ? t * rangesize : sals->size;
+        size_t last = first + rangesize < sals->size ? first + rangesize : sals->size;
+        threads[t] = (game_check_thread_t){ .sals = sals, .occupancy = &occupancy, .cellcount = cellcount, .first = first, .last = last };
+    }
+
+    // occupy all cells before detecting overlaps (each pass runs the first range and ranges whose thread couldn't be started on the calling thread)
+    int res = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t t = 0; t < threadcount; t++) {
+            threads[t].occupy = pass == 0;
+            threads[t].started = t != 0 && thrd_create(&threads[t].thread, (thrd_start_t)game_check_thread_run, &threads[t]) == thrd_success;
+        }
+        for (size_t t = 0; t < threadcount; t++)
+            if (!threads[t].started && game_check_thread_run(&threads[t]) != 0)
+                res = 8;
+        for (size_t t = 0; t < threadcount; t++) {
+            int threadres = 0;
+            if (threads[t].started && (thrd_join(threads[t].thread, &threadres) != thrd_success || threadres != 0))
+                res = 8;
+        }
+    }
+
+    // the first invalid snake or ladder is the first one found in the first range containing one
+    for (size_t t = 0; res == 0 && t < threadcount; t++) {
+        if (!threads[t].error)
+            continue;
+        res = threads[t].error;
+        if (invalididx)
+            *invalididx = threads[t].invalididx;
+        if (otheridx && res == 7)
+            *otheridx = threads[t].otheridx;
+    }
+    free(threads);
+    game_occupancy_free(&occupancy);
+    return res;
+}
+
+bool game_build_jumps(game_t* game, const array_t* sals) {
+    if (!game || !sals)
+        return false;
+    if (game->mapping)
+        return false;
+    array_free(&game->edges, 0);
+    array_free(&game->soldsts, 0);
+    array_free(&game->solidxs, 0);
+    size_t cellcount = game->width * game->height;
+    game->edges = array_create(sals->size, sizeof(edge_t), 0);
+    game->soldsts = array_create(sals->size, sizeof(size_t), 0);
+    game->solidxs = array_create(cellcount, sizeof(optional_size_t), 0);
+    if ((sals->size != 0 && (!game->edges.data || !game->soldsts.data)) || !game->solidxs.data)
+        return false;
+
+    // convert snakes and ladders from 1 to 0 based indexing and temporarily store each destination in the jump table of it's starting cell
+    for (size_t cell = 0; cell < cellcount; cell++)
+        array_add(&game->solidxs, &(optional_size_t){});
+    for (size_t i = 0; i < sals->size; i++) {
+        const snakeorladder_t* sol = array_getconst(sals, i);
+        array_add(&game->edges, &(edge_t){ sol->src - 1, sol->dst - 1 });
+        *(optional_size_t*)array_get(&game->solidxs, sol->src - 1) = (optional_size_t){ true, sol->dst - 1 };
+    }
+    // number the snakes and ladders in the order of their starting cells
+    for (size_t cell = 0; cell < cellcount; cell++) {
+        optional_size_t* solidx = array_get(&game->solidxs, cell);
+        if (!solidx->present)
+            continue;
+        array_add(&game->soldsts, &solidx->value);
+        solidx->value = game->soldsts.size - 1;
+    }
+    return true;
+}
+
+game_t game_create(size_t width, size_t height, const distribution_t* distribution, bool exact_ending, const array_t* sals) {
+    game_t game = {};
+    if (!distribution || !sals)
+        return game;
+    game.width = width;
+    game.height = height;
+    game.exact_ending = exact_ending;
+    const allocations_subsystem_t previous = allocations_set_subsystem(ALLOCATIONS_SUBSYSTEM_GAME);
 
     // create die from distribution
-    game.die = die_create(&cli_args->distribution);
+    game.die = die_create(distribution);
     if (die_isempty(&game.die)) {
-        fprintf(stderr, "%serror:%s unable to create die from distribution.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
-        exit(1);
+        game_free(&game);
+        allocations_set_subsystem(previous);
+        return game;
     }
 
-    // set if game must have exact ending
-    game.exact_ending = cli_args->exact_ending;
+    // create edge list and jump tables from snakes and ladders
+    if (!game_build_jumps(&game, sals))
+        game_free(&game);
+    allocations_set_subsystem(previous);
+    return game;
+}
+
+game_t game_setup(cli_args_t* cli_args) {
+    game_t game = {};
+    if (!cli_args)
+        return game;
+
+    // validate dimensions
+    if (cli_args->width < GAME_WIDTH_MIN || cli_args->height < GAME_HEIGHT_MIN) {
+        fprintf(stderr, "%serror:%s game has invalid dimensions %lux%lu. must be at least %lux%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args->width, cli_args->height, GAME_WIDTH_MIN, GAME_HEIGHT_MIN);
+        exit(1);
+    }
+    size_t cellcount = cli_args->width * cli_args->height;
 
     // validate snakes and ladders
     array_t* sals = &cli_args->snakesandladders;
-    for (size_t i = 0; i < sals->size; i++) {
-        const snakeorladder_t* sol = array_getconst(sals, i);
-        // check if sol starts or ends in a cell outside the playing field
-        if (sol->src == 0 || sol->src > cellcount) {
-            fprintf(stderr, "%serror:%s invalid %s %lu-%lu. starts in non-existant cell >%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, cellcount);
-            exit(1);
-        }
-        if (sol->dst == 0 || sol->dst > cellcount) {
-            fprintf(stderr, "%serror:%s invalid %s %lu-%lu. ends in a non-existant cell >%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, cellcount);
-            exit(1);
-        }
-        // check if sol starts and ends in the same cell as itself
-        if (sol->src == sol->dst) {
-            fprintf(stderr, "%serror:%s invalid snake or ladder %lu-%lu. starts and ends in the same cell.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src, sol->dst);
-            exit(1);
-        }
-        // check if sol starts or ends in the last cell of the playing field
-        if (sol->src == cellcount) {
-            fprintf(stderr, "%serror:%s invalid %s %lu-%lu. starts in the last cell %lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, cellcount);
-            exit(1);
-        }
-        if (sol->dst == cellcount) {
-            fprintf(stderr, "%serror:%s invalid %s %lu-%lu. ends in the last cell %lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, cellcount);
-            exit(1);
-        }
-        // check if sol overlaps with some other already existing sol (start/ends in the same cell as other sol)
-        for (size_t j = 0; j < i; j++) {
-            const snakeorladder_t* sol2 = array_getconst(sals, j);
-            if (sol->src == sol2->src || sol->src == sol2->dst || sol->dst == sol2->src || sol->dst == sol2->dst) {
+    size_t invalididx = 0;
+    size_t otheridx = 0;
+    int error = game_check_sals(cellcount, sals, &invalididx, &otheridx);
+    if (error) {
+        const snakeorladder_t* sol = array_getconst(sals, invalididx);
+        const snakeorladder_t* sol2 = array_getconst(sals, otheridx);
+        switch (error) {
+            case 2:
+                fprintf(stderr, "%serror:%s invalid %s %lu-%lu. starts in non-existant cell >%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, cellcount);
+                exit(1);
+            case 3:
+                fprintf(stderr, "%serror:%s invalid %s %lu-%lu. ends in a non-existant cell >%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, cellcount);
+                exit(1);
+            case 4:
+                fprintf(stderr, "%serror:%s invalid snake or ladder %lu-%lu. starts and ends in the same cell.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src, sol->dst);
+                exit(1);
+            case 5:
+                fprintf(stderr, "%serror:%s invalid %s %lu-%lu. starts in the last cell %lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, cellcount);
+                exit(1);
+            case 6:
+                fprintf(stderr, "%serror:%s invalid %s %lu-%lu. ends in the last cell %lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, cellcount);
+                exit(1);
+            case 7:
                 fprintf(stderr, "%serror:%s invalid %s %lu-%lu. overlaps with %s %lu-%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT),
                     sol->src > sol->dst ? "snake" : "ladder", sol->src, sol->dst, sol2->src > sol2->dst ? "snake" : "ladder", sol2->src, sol2->dst);
                 exit(1);
-            }
+            default:
+                fprintf(stderr, "%serror:%s unable to validate snakes and ladders.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+                exit(1);
         }
     }
-    // convert snakes and ladders from 1 to 0 based indexing
-    for (size_t i = 0; i < sals->size; i++) {
-        snakeorladder_t* sol = array_get(sals, i);
-        sol->src--;
-        sol->dst--;
+
+    // create die from distribution and graph from snakes and ladders
+    game = game_create(cli_args->width, cli_args->height, &cli_args->distribution, cli_args->exact_ending, sals);
+    if (game.width == 0) {
+        fprintf(stderr, "%serror:%s unable to create game from distribution and snakes and ladders.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+        exit(1);
     }
-    // create graph from snakes and ladders
-    game.adjmat = adjmat_create(cellcount, sals->size, sals->data);
-    
+
     return game;
 }
 
+int game_edge_compare(const void* a, const void* b) {
+    const edge_t* edgea = a;
+    const edge_t* edgeb = b;
+    if (edgea->from != edgeb->from)
+        return edgea->from < edgeb->from ? -1 : 1;
+    return edgea->to < edgeb->to ? -1 : edgea->to > edgeb->to;
+}
+
+uint64_t game_hash(const game_t* game, size_t dicelimit) {
+    if (!game)
+        return 0;
+
+    // sort a copy of the snakes and ladders, hence the order they were specified in doesn't change the hash
+    edge_t* edges = malloc((game->edges.size != 0 ? game->edges.size : 1) * sizeof(edge_t));
+    if (!edges)
+        return 0;
+    if (game->edges.size != 0)
+        memcpy(edges, game->edges.data, game->edges.size * sizeof(edge_t));
+    qsort(edges, game->edges.size, sizeof(edge_t), game_edge_compare);
+
+    // the probabilities of the die sides are already normalized by the sum of the weights
+    const uint64_t values[6] = { game->width, game->height, game->exact_ending, dicelimit, game->edges.size, game->die.sides.size };
+    uint64_t hash = board_checksum(BOARD_CHECKSUM_SEED, values, sizeof(values));
+    hash = board_checksum(hash, edges, game->edges.size * sizeof(edge_t));
+    hash = board_checksum(hash, game->die.sides.data, game->die.sides.size * sizeof(double));
+    free(edges);
+    return hash;
+}
+
 void game_free(game_t* game) {
     if (!game)
         return;
-    die_free(&game->die);
-    adjmat_free(&game->adjmat);
+    // the die and tables of a loaded board file reference it's memory mapping
+    if (game->mapping) {
+        munmap(game->mapping, game->mappingsize);
+    } else {
+        die_free(&game->die);
+        array_free(&game->edges, 0);
+        array_free(&game->soldsts, 0);
+        array_free(&game->solidxs, 0);
+    }
     *game = (game_t){};
 }
 
@@ -108,15 +366,14 @@ void game_print(const game_t* game) {
         size_t idx = ((i-1) / game->width) % 2 == 0
             ? (((i-1) / game->width + 1) * game->width - 1) - ((i-1) % game->width)
             : (i-1);
-        // find edge that starts or ends in current cell
+        // find edge that starts in current cell
         int hasedge = 0;
-        int32_t edge = 0;
-        for (size_t eidx = 0; eidx < game->adjmat.vertex_count; eidx++) {
-            if (game->adjmat.edges[idx * game->adjmat.vertex_count + eidx] > 0) {
-                hasedge = eidx < idx ? -1 : 1;
-                edge = eidx + 1;
-                break;
-            }
+        size_t edge = 0;
+        const optional_size_t* solidx = array_getconst(&game->solidxs, idx);
+        if (solidx && solidx->present) {
+            size_t soldst = *(const size_t*)array_getconst(&game->soldsts, solidx->value);
+            hasedge = soldst < idx ? -1 : 1;
+            edge = soldst + 1;
         }
         // print index of first cell in row at the beginning of the line
         if ((i-1) % game->width == game->width - 1)
@@ -130,7 +387,7 @@ void game_print(const game_t* game) {
             printf("%s", FMT(FMTVAL_FG_BRIGHT_YELLOW));
         else
             printf("%s", FMT(FMTVAL_FG_BRIGHT_CYAN));
-        printf("%5d", edge);
+        printf("%5lu", edge);
         printf("%s", FMT(FMTVAL_DEFAULT));
         // print index of last cell in row at the end of the line
         if ((i-1) % game->width == 0)
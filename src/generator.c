@@ -0,0 +1,184 @@
+#include "generator.h"
+
+#include "cli.h"
+#include "game.h"
+#include "numbers.h"
+#include "snakeorladder.h"
+#include "tsrand48.h"
+
+#include <math.h>
+#include <string.h>
+
+generator_lengths_info_t generator_lengths_infos[GENERATOR_LENGTHS_COUNT] = {
+    { "geometric" },
+    { "uniform" }
+};
+
+generator_lengths_t strtogenlengths(const char* str, int* error) {
+    const generator_lengths_t fallback = { GENERATOR_LENGTHS_GEOMETRIC, 0 };
+    if (!str) {
+        if (error)
+            *error = 1;
+        return fallback;
+    }
+    const char* colon = strchr(str, ':');
+    const size_t namelength = colon ? (size_t)(colon - str) : strlen(str);
+    for (size_t i = 0; i < GENERATOR_LENGTHS_COUNT; i++) {
+        if (strlen(generator_lengths_infos[i].name) != namelength || strncmp(str, generator_lengths_infos[i].name, namelength) != 0)
+            continue;
+        generator_lengths_t lengths = { (generator_lengths_kind_t)i, 0 };
+        uint64_t value = 0;
+        if (colon && (strtouint64(colon + 1, &value) != 0 || value == 0)) {
+            if (error)
+                *error = 3;
+            return fallback;
+        }
+        lengths.value = value;
+        if (error)
+            *error = 0;
+        return lengths;
+    }
+    if (error)
+        *error = 2;
+    return fallback;
+}
+
+size_t generator_draw_length(const generator_lengths_t* lengths) {
+    const double u = tserand48();
+    if (lengths->kind == GENERATOR_LENGTHS_UNIFORM)
+        return 1 + (size_t)(u * lengths->value);
+    if (lengths->value <= 1)
+        return 1;
+    // inverse transform of the geometric distribution on 1, 2, ... with success probability 1 / mean
+    const double length = 1.0 + floor(log1p(-u) / log1p(-1.0 / lengths->value));
+    return length < (double)SIZE_MAX / 2 ? (size_t)length : SIZE_MAX / 2;
+}
+
+generator_free_cells_t generator_free_cells_create(size_t cellcount, size_t removecount) {
+    // every removal stores at most one cell and two positions, the occupancies have four slots per key, hence they never fill up
+    const size_t listsize = cellcount > 0 ? cellcount - 1 : 0;
+    generator_free_cells_t freecells = {
+        .size = listsize,
+        .count = listsize,
+        .cells = game_occupancy_create(listsize, removecount),
+        .positions = game_occupancy_create(listsize, removecount * 2)
+    };
+    if (freecells.cells.capacity == 0 || freecells.positions.capacity == 0)
+        generator_free_cells_free(&freecells);
+    return freecells;
+}
+
+void generator_free_cells_free(generator_free_cells_t* freecells) {
+    if (!freecells)
+        return;
+    game_occupancy_free(&freecells->cells);
+    game_occupancy_free(&freecells->positions);
+    *freecells = (generator_free_cells_t){};
+}
+
+size_t generator_free_cells_lookup(game_occupancy_t* map, size_t key) {
+    _Atomic size_t* value = game_occupancy_slot(map, key, false);
+    return value && *value != SIZE_MAX ? *value : key;
+}
+
+bool generator_free_cells_contains(generator_free_cells_t* freecells, size_t cell) {
+    return cell != 0 && cell <= freecells->size && generator_free_cells_lookup(&freecells->positions, cell) <= freecells->count;
+}
+
+bool generator_free_cells_remove(generator_free_cells_t* freecells, size_t cell) {
+    // move the last free cell to the position of the removed one and the removed one behind the list
+    const size_t position = generator_free_cells_lookup(&freecells->positions, cell);
+    const size_t last = generator_free_cells_lookup(&freecells->cells, freecells->count);
+    _Atomic size_t* lastcell = game_occupancy_slot(&freecells->cells, position, true);
+    _Atomic size_t* lastposition = game_occupancy_slot(&freecells->positions, last, true);
+    _Atomic size_t* cellposition = game_occupancy_slot(&freecells->positions, cell, true);
+    if (!lastcell || !lastposition || !cellposition)
+        return false;
+    *lastcell = last;
+    *lastposition = position;
+    *cellposition = freecells->count;
+    freecells->count--;
+    return true;
+}
+
+int generator_generate(size_t width, size_t height, double density, const generator_lengths_t* lengths, uint64_t seed, array_t* sals) {
+    if (!lengths || !sals)
+        return 1;
+    if (!(density > 0.0 && density <= GENERATOR_DENSITY_MAX) || height == 0 || width > SIZE_MAX / height)
+        return 2;
+    const size_t cellcount = width * height;
+    const size_t count = (size_t)(density * cellcount + 0.5);
+    const generator_lengths_t drawn = { lengths->kind, lengths->value > 0 ? lengths->value : width };
+    generator_free_cells_t freecells = generator_free_cells_create(cellcount, count * 2);
+    if ((cellcount > 1 && freecells.count == 0) || !array_reserve(sals, sals->size + count)) {
+        generator_free_cells_free(&freecells);
+        return 3;
+    }
+
+    const tsseed48_t newseed = tsderiveseed48(seed, 0);
+    const tsseed48_t prevseed = tsseed48(&newseed);
+    int error = 0;
+    for (size_t i = 0; !error && i < count; i++) {
+        if (freecells.count < 2) {
+            error = 4;
+            break;
+        }
+        // the last cell is never a starting or ending cell, hence it is not in the list of free cells
+        const size_t src = generator_free_cells_lookup(&freecells.cells, 1 + (size_t)(tserand48() * freecells.count));
+        const size_t length = generator_draw_length(&drawn);
+        // take the drawn direction if the ending cell fits, the other one if not and the cell closest to the edge if neither fits
+        bool up = tserand48() < 0.5;
+        if (up ? length >= cellcount - src : length >= src)
+            up = !up;
+        size_t target = up ? (length < cellcount - src ? src + length : cellcount - 1) : (length < src ? src - length : 1);
+        if (!generator_free_cells_remove(&freecells, src)) {
+            error = 3;
+            break;
+        }
+
+        // take the nearest free cell around the ending cell, there is at least one
+        size_t dst = 0;
+        for (size_t offset = 0; dst == 0 && (offset < target || target + offset < cellcount); offset++) {
+            if (target + offset < cellcount && generator_free_cells_contains(&freecells, target + offset))
+                dst = target + offset;
+            else if (offset < target && generator_free_cells_contains(&freecells, target - offset))
+                dst = target - offset;
+        }
+        snakeorladder_t sol = { src, dst };
+        if (dst == 0)
+            error = 4;
+        else if (!generator_free_cells_remove(&freecells, dst) || !array_add(sals, &sol))
+            error = 3;
+    }
+    tsseed48(&prevseed);
+    generator_free_cells_free(&freecells);
+    return error;
+}
+
+bool generator_write_config(FILE* file, const cli_args_t* cli_args, const array_t* sals) {
+    if (!file || !cli_args || !sals)
+        return false;
+    fprintf(file, "-x %lu\n-y %lu\n-s %lu\n", cli_args->width, cli_args->height, cli_args->die_sides);
+    if (cli_args->exact_ending)
+        fprintf(file, "-e\n");
+    if (cli_args->setargsflags & CLIAFLAG_DISTRIBUTION) {
+        fprintf(file, "-d ");
+        if (cli_args->distribution.preset != DISTR_PRESET_NONE) {
+            fprintf(file, "%s", distr_preset_infos[cli_args->distribution.preset].name);
+        } else {
+            for (size_t i = 0; i < cli_args->distribution.weights.size; i++)
+                fprintf(file, "%s%lu", i == 0 ? "" : ",", *(const size_t*)array_getconst(&cli_args->distribution.weights, i));
+        }
+        fprintf(file, "\n");
+    }
+    if (cli_args->setargsflags & CLIAFLAG_ITERATIONS)
+        fprintf(file, "-i %lu\n", cli_args->iterations);
+    if (cli_args->setargsflags & CLIAFLAG_DICE_LIMIT)
+        fprintf(file, "-l %lu\n", cli_args->dicelimit);
+    fprintf(file, "\n");
+    for (size_t i = 0; i < sals->size; i++) {
+        const snakeorladder_t* sol = array_getconst(sals, i);
+        fprintf(file, "%lu-%lu%s", sol->src, sol->dst, i + 1 == sals->size || (i + 1) % GENERATOR_SALS_PER_LINE == 0 ? "\n" : " ");
+    }
+    return fflush(file) == 0 && !ferror(file);
+}
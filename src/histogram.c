@@ -0,0 +1,174 @@
+#include "histogram.h"
+
+#include "cvts.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+histogram_t histogram_create_empty() {
+    return (histogram_t){ .counts = array_create(0, sizeof(size_t), 0) };
+}
+
+histogram_t histogram_create(size_t maxvalue) {
+    size_t bucketcount = histogram_bucket_index(maxvalue) + 1;
+    histogram_t histogram = {
+        .maxvalue = maxvalue,
+        .counts = array_create(bucketcount, sizeof(size_t), 0)
+    };
+    size_t initcount = 0;
+    for (size_t i = 0; i < bucketcount; i++) {
+        if (!array_add(&histogram.counts, &initcount)) {
+            histogram_free(&histogram);
+            return histogram_create_empty();
+        }
+    }
+    return histogram;
+}
+
+void histogram_free(histogram_t* histogram) {
+    if (!histogram)
+        return;
+    array_free(&histogram->counts, 0);
+    *histogram = histogram_create_empty();
+}
+
+size_t histogram_bucket_index(size_t value) {
+    if (value < HISTOGRAM_EXACT_COUNT)
+        return value;
+    // the exponent of the highest set bit determines the power of two range, the following bits the bucket within the range
+    size_t exponent = 63 - __builtin_clzl(value);
+    size_t shift = exponent - (HISTOGRAM_EXACT_BITS - 1);
+    return HISTOGRAM_EXACT_COUNT + (exponent - HISTOGRAM_EXACT_BITS) * HISTOGRAM_SUBBUCKET_COUNT + ((value >> shift) - HISTOGRAM_SUBBUCKET_COUNT);
+}
+
+size_t histogram_bucket_low(size_t index) {
+    if (index < HISTOGRAM_EXACT_COUNT)
+        return index;
+    size_t range = (index - HISTOGRAM_EXACT_COUNT) / HISTOGRAM_SUBBUCKET_COUNT;
+    size_t mantissa = (index - HISTOGRAM_EXACT_COUNT) % HISTOGRAM_SUBBUCKET_COUNT + HISTOGRAM_SUBBUCKET_COUNT;
+    return mantissa << (range + 1);
+}
+
+size_t histogram_bucket_high(size_t index) {
+    if (index < HISTOGRAM_EXACT_COUNT)
+        return index;
+    size_t range = (index - HISTOGRAM_EXACT_COUNT) / HISTOGRAM_SUBBUCKET_COUNT;
+    size_t mantissa = (index - HISTOGRAM_EXACT_COUNT) % HISTOGRAM_SUBBUCKET_COUNT + HISTOGRAM_SUBBUCKET_COUNT;
+    // wraps around to the largest size_t value for the last bucket
+    return ((mantissa + 1) << (range + 1)) - 1;
+}
+
+bool histogram_add(histogram_t* histogram, size_t value) {
+    if (!histogram || value > histogram->maxvalue)
+        return false;
+    size_t* count = array_get(&histogram->counts, histogram_bucket_index(value));
+    if (!count)
+        return false;
+    (*count)++;
+    histogram->total++;
+    return true;
+}
+
+bool histogram_merge(histogram_t* dst, const histogram_t* src) {
+    if (!dst || !src || dst->maxvalue != src->maxvalue || dst->counts.size != src->counts.size)
+        return false;
+    for (size_t i = 0; i < src->counts.size; i++)
+        *(size_t*)array_get(&dst->counts, i) += *(const size_t*)array_getconst(&src->counts, i);
+    dst->total += src->total;
+    return true;
+}
+
+size_t histogram_quantile(const histogram_t* histogram, double q) {
+    if (!histogram || histogram->total == 0)
+        return 0;
+    if (q < 0.0)
+        q = 0.0;
+    if (q > 1.0)
+        q = 1.0;
+    // the rank of the value that is the quantile (at least the first value)
+    size_t rank = (size_t)(q * histogram->total + 0.5);
+    if (rank == 0)
+        rank = 1;
+    size_t cumulative = 0;
+    for (size_t i = 0; i < histogram->counts.size; i++) {
+        cumulative += *(const size_t*)array_getconst(&histogram->counts, i);
+        if (cumulative >= rank) {
+            size_t high = histogram_bucket_high(i);
+            return high > histogram->maxvalue ? histogram->maxvalue : high;
+        }
+    }
+    return histogram->maxvalue;
+}
+
+void histogram_print(const histogram_t* histogram, size_t rows, size_t barlength) {
+    if (!histogram || histogram->total == 0 || rows == 0)
+        return;
+
+    // setup colors
+    typedef struct color_t {
+        const char* fg;
+        const char* bg;
+    } color_t;
+    const color_t colors[] = {
+        { FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_BG_BRIGHT_BLACK)    },
+        { FMT(FMTVAL_FG_WHITE)       , FMT(FMTVAL_BG_WHITE)           }
+    };
+    size_t colorcount = sizeof(colors) / sizeof(*colors);
+    size_t color = 0;
+
+    // determine the range of printed values from the smallest recorded value up to the 99.9th percentile
+    size_t low = 0;
+    for (size_t i = 0; i < histogram->counts.size; i++) {
+        if (*(const size_t*)array_getconst(&histogram->counts, i) != 0) {
+            low = histogram_bucket_low(i);
+            break;
+        }
+    }
+    size_t high = histogram_quantile(histogram, 0.999);
+    if (high < low)
+        high = low;
+    if (rows > high - low + 1)
+        rows = high - low + 1;
+    size_t rowwidth = (high - low) / rows + 1;
+    rows = (high - low) / rowwidth + 1;
+
+    // sum up the bucket counts of each row (every bucket is assigned to the row it's smallest value lies in)
+    size_t* rowcounts = calloc(rows + 1, sizeof(*rowcounts));
+    if (!rowcounts) {
+        fprintf(stderr, "%swarning:%s unable to allocate rows to print histogram.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
+        return;
+    }
+    for (size_t i = 0; i < histogram->counts.size; i++) {
+        size_t count = *(const size_t*)array_getconst(&histogram->counts, i);
+        if (count == 0)
+            continue;
+        size_t value = histogram_bucket_low(i);
+        size_t row = value > high ? rows : (value < low ? 0 : (value - low) / rowwidth);
+        rowcounts[row] += count;
+    }
+
+    // determine barlen multiplier to streach the longest bar to be barlength characters long
+    size_t maxcount = 0;
+    for (size_t row = 0; row <= rows; row++)
+        if (maxcount < rowcounts[row])
+            maxcount = rowcounts[row];
+    double barstretch = maxcount != 0 ? (double)barlength / maxcount : 1.0;
+
+    // print rows
+    for (size_t row = 0; row < rows; row++) {
+        size_t rowlow = low + row * rowwidth;
+        size_t rowhigh = row + 1 == rows ? high : rowlow + rowwidth - 1;
+        double share = (double)rowcounts[row] / histogram->total;
+        if (rowlow == rowhigh)
+            printf("%s%9lu %9s %7.3lf%%%s %s%*s%s\n", colors[color].fg, rowlow, "", share * 100.0, FMT(FMTVAL_FG_DEFAULT), colors[color].bg, (int)(rowcounts[row] * barstretch), "", FMT(FMTVAL_BG_DEFAULT));
+        else
+            printf("%s%9lu-%-9lu %7.3lf%%%s %s%*s%s\n", colors[color].fg, rowlow, rowhigh, share * 100.0, FMT(FMTVAL_FG_DEFAULT), colors[color].bg, (int)(rowcounts[row] * barstretch), "", FMT(FMTVAL_BG_DEFAULT));
+        color = (color + 1) % colorcount;
+    }
+    if (rowcounts[rows] != 0) {
+        double share = (double)rowcounts[rows] / histogram->total;
+        printf("%s>%-18lu %7.3lf%%%s %s%*s%s\n", colors[color].fg, high, share * 100.0, FMT(FMTVAL_FG_DEFAULT), colors[color].bg, (int)(rowcounts[rows] * barstretch), "", FMT(FMTVAL_BG_DEFAULT));
+    }
+
+    free(rowcounts);
+}
@@ -0,0 +1,35 @@
+#include "interrupt.h"
+
+#include <signal.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// the number of the first received signal, 0 if none (lock-free, hence it may be written from the signal handler)
+static atomic_int interruptsignum = 0;
+
+bool interrupt_install() {
+    struct sigaction action = { .sa_handler = interrupt_handle };
+    sigemptyset(&action.sa_mask);
+    bool installed = sigaction(SIGINT, &action, 0) == 0;
+    installed = sigaction(SIGTERM, &action, 0) == 0 && installed;
+    return installed;
+}
+
+void interrupt_handle(int signum) {
+    int expected = 0;
+    if (atomic_compare_exchange_strong(&interruptsignum, &expected, signum))
+        return;
+    // the second signal: show the cursor, reset the text format and leave the line of the loading screen
+    static const char restore[] = "\x1b[?25h\x1b[0m\n";
+    ssize_t written = write(STDOUT_FILENO, restore, sizeof(restore) - 1);
+    (void)written;
+    _exit(INTERRUPT_EXIT_CODE_BASE + signum);
+}
+
+bool interrupt_requested() {
+    return atomic_load(&interruptsignum) != 0;
+}
+
+int interrupt_signal() {
+    return atomic_load(&interruptsignum);
+}
@@ -0,0 +1,609 @@
+#include "libsals.h"
+
+#include "cli.h"
+#include "distribution.h"
+#include "numbers.h"
+#include "report.h"
+#include "snakeorladder.h"
+#include "stopwatch.h"
+#include "tsrand48.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+libsals_opt_info_t libsals_opt_infos[LIBSALS_OPT_COUNT] = {
+    { 'h', "help"               , false, CLIAFLAG_HELP },
+    { 'c', "config-file"        , true , CLIAFLAG_CONFIGFILE },
+    { 'x', "width"              , true , CLIAFLAG_WIDTH },
+    { 'y', "height"             , true , CLIAFLAG_HEIGHT },
+    { 's', "die-sides"          , true , CLIAFLAG_DIE_SIDES },
+    { 'e', "exact-ending"       , false, CLIAFLAG_EXACT_ENDING },
+    { 'd', "distribution"       , true , CLIAFLAG_DISTRIBUTION },
+    { 'i', "iterations"         , true , CLIAFLAG_ITERATIONS },
+    { 'l', "dice-limit"         , true , CLIAFLAG_DICE_LIMIT },
+    { 'b', "bar-length"         , true , CLIAFLAG_BAR_LENGTH },
+    { 'p', "target-precision"   , true , CLIAFLAG_TARGET_PRECISION },
+    { 't', "time-limit"         , true , CLIAFLAG_TIME_LIMIT },
+    { 'w', "sweep"              , true , CLIAFLAG_SWEEP },
+    { 'f', "format"             , true , CLIAFLAG_REPORT_FORMAT },
+    { 'B', "batch"              , false, CLIAFLAG_BATCH },
+    { 'o', "compile-board"      , true , CLIAFLAG_COMPILE_BOARD },
+    { 'g', "board"              , true , CLIAFLAG_BOARD },
+    { 'r', "emit-records"       , true , CLIAFLAG_EMIT_RECORDS },
+    { 'R', "records-format"     , true , CLIAFLAG_RECORDS_FORMAT },
+    { 'T', "records-trace"      , false, CLIAFLAG_RECORDS_TRACE },
+    { 'P', "replay"             , true , CLIAFLAG_REPLAY },
+    { 'k', "checkpoint"         , true , CLIAFLAG_CHECKPOINT },
+    { 'K', "checkpoint-interval", true , CLIAFLAG_CHECKPOINT_INTERVAL },
+    { 'u', "resume"             , false, CLIAFLAG_RESUME },
+    { 'S', "seed"               , true , CLIAFLAG_SEED },
+    { 'n', "shard"              , true , CLIAFLAG_SHARD },
+    { 'O', "partial-out"        , true , CLIAFLAG_PARTIAL_OUT },
+    { 'D', "serve"              , true , CLIAFLAG_SERVE },
+    { 'C', "cache"              , true , CLIAFLAG_CACHE },
+    { 'm', "timings"            , false, CLIAFLAG_TIMINGS },
+    { 'H', "perf-counters"      , false, CLIAFLAG_PERF_COUNTERS },
+    { 'A', "allocations"        , false, CLIAFLAG_ALLOCATIONS },
+    { 'j', "workers"            , true , CLIAFLAG_WORKERS },
+    { 'G', "sal-density"        , true , CLIAFLAG_SAL_DENSITY },
+    { 'L', "sal-lengths"        , true , CLIAFLAG_SAL_LENGTHS },
+    { 'Q', "bench-die"          , false, CLIAFLAG_BENCH_DIE },
+    { 'V', "verify-board"       , false, CLIAFLAG_VERIFY_BOARD }
+};
+
+libsals_spec_t libsals_spec_create() {
+    return (libsals_spec_t){
+        .width = OPTVAL_WIDTH_DEFAULT,
+        .height = OPTVAL_HEIGHT_DEFAULT,
+        .diesides = OPTVAL_DIE_SIDES_DEFAULT,
+        .distribution = 0,
+        .exactending = OPTVAL_EXACT_ENDING_DEFAULT,
+        .sals = 0
+    };
+}
+
+libsals_options_t libsals_options_create() {
+    return (libsals_options_t){
+        .simcount = OPTVAL_ITERATIONS_DEFAULT,
+        .workers = OPTVAL_WORKERS_DEFAULT,
+        .dicelimit = OPTVAL_DICE_LIMIT_DEFAULT,
+        .targetprecision = OPTVAL_TARGET_PRECISION_DEFAULT,
+        .timelimit = OPTVAL_TIME_LIMIT_DEFAULT,
+        .seeded = false,
+        .seed = 0,
+        .executor = 0,
+        .cancel = 0
+    };
+}
+
+int libsals_parse_sals(const char* str, array_t* sals, size_t* invalididx) {
+    if (!str || !sals)
+        return 1;
+    size_t index = 0;
+    while (*str) {
+        // copy the next whitespace separated pair, hence it can be parsed as terminated string
+        while (isspace((unsigned char)*str))
+            str++;
+        if (!*str)
+            break;
+        const char* end = str;
+        while (*end && !isspace((unsigned char)*end))
+            end++;
+        char buffer[LIBSALS_SOL_LENGTH_MAX + 1];
+        int error = end - str > (ptrdiff_t)LIBSALS_SOL_LENGTH_MAX;
+        snakeorladder_t sol = {};
+        if (!error) {
+            memcpy(buffer, str, end - str);
+            buffer[end - str] = '\0';
+            sol = strtosol(buffer, &error);
+        }
+        if (error) {
+            if (invalididx)
+                *invalididx = index;
+            return 2;
+        }
+        if (!array_add(sals, &sol))
+            return 3;
+        str = end;
+        index++;
+    }
+    return 0;
+}
+
+game_t libsals_game_create(const libsals_spec_t* spec, int* error, size_t* invalididx) {
+    int tmp;
+    if (!error)
+        error = &tmp;
+    *error = 0;
+    game_t game = {};
+    if (!spec) {
+        *error = 1;
+        return game;
+    }
+    if (spec->width < GAME_WIDTH_MIN || spec->height < GAME_HEIGHT_MIN) {
+        *error = 2;
+        return game;
+    }
+
+    // build the distribution of the die and reject a weight sum of 0
+    // the error codes of parsing and building differ, hence only their allocation failures (7 and 4) are reported as such
+    int parseerror = 0;
+    int builderror = 0;
+    distribution_t distribution = spec->distribution ? strtodistr(spec->distribution, &parseerror) : distr_create(DISTR_PRESET_UNIFORM);
+    if (!parseerror)
+        builderror = distr_build(&distribution, spec->diesides);
+    bool iszero = true;
+    for (size_t i = 0; iszero && i < distribution.weights.size; i++)
+        if (*(const size_t*)array_getconst(&distribution.weights, i) != 0)
+            iszero = false;
+    if (parseerror || builderror || iszero) {
+        distr_free(&distribution);
+        *error = parseerror == 7 || builderror == 4 ? 6 : 3;
+        return game;
+    }
+
+    // parse and validate the snakes and ladders
+    array_t sals = array_create(0, sizeof(snakeorladder_t), 0);
+    int salserror = spec->sals ? libsals_parse_sals(spec->sals, &sals, invalididx) : 0;
+    if (salserror) {
+        *error = salserror == 2 ? 4 : 6;
+    } else {
+        salserror = game_check_sals(spec->width * spec->height, &sals, invalididx, 0);
+        if (salserror)
+            *error = salserror == 8 ? 6 : 5;
+        else {
+            game = game_create(spec->width, spec->height, &distribution, spec->exactending, &sals);
+            if (game.width == 0)
+                *error = 6;
+        }
+    }
+    array_free(&sals, 0);
+    distr_free(&distribution);
+    return game;
+}
+
+libsals_args_t libsals_args_create_empty() {
+    libsals_args_t args = {
+        .spec = libsals_spec_create(),
+        .options = libsals_options_create(),
+        .board = 0,
+        .preset = DISTR_PRESET_UNIFORM,
+        .setargsflags = CLIAFLAG_NONE,
+        .content = 0,
+        .argv = array_create(0, sizeof(char*), 0),
+        .sals = 0
+    };
+    args.error[0] = '\0';
+    return args;
+}
+
+void libsals_args_free(libsals_args_t* args) {
+    if (!args)
+        return;
+    free(args->content);
+    array_free(&args->argv, 0);
+    free(args->sals);
+    *args = libsals_args_create_empty();
+}
+
+int libsals_args_fail(libsals_args_t* args, int error, const char* format, ...) {
+    if (!args || !format)
+        return error;
+    va_list vargs;
+    va_start(vargs, format);
+    vsnprintf(args->error, sizeof(args->error), format, vargs);
+    va_end(vargs);
+    return error;
+}
+
+bool libsals_args_parse_uint64(libsals_args_t* args, const libsals_opt_info_t* opt, const char* str, uint64_t valmin, uint64_t valmax, uint64_t* value) {
+    if (!args || !opt || !value)
+        return false;
+    int error = strtouint64(str, value);
+    if (error == 2)
+        return !libsals_args_fail(args, 2, "-%c value out of range (%s).", opt->name, str);
+    if (error)
+        return !libsals_args_fail(args, 2, "-%c not a number '%s'.", opt->name, str ? str : "");
+    if (*value < valmin)
+        return !libsals_args_fail(args, 2, "-%c %lu less than minimum %lu.", opt->name, *value, valmin);
+    if (*value > valmax)
+        return !libsals_args_fail(args, 2, "-%c %lu greater than maximum %lu.", opt->name, *value, valmax);
+    return true;
+}
+
+bool libsals_args_parse_double(libsals_args_t* args, const libsals_opt_info_t* opt, const char* str, double valmin, double valmax, double* value) {
+    if (!args || !opt || !value)
+        return false;
+    int error = strtodouble(str, value);
+    if (error == 2)
+        return !libsals_args_fail(args, 2, "-%c value out of range (%s).", opt->name, str);
+    if (error)
+        return !libsals_args_fail(args, 2, "-%c not a number '%s'.", opt->name, str ? str : "");
+    // negated comparisons to also reject nan
+    if (!(*value >= valmin))
+        return !libsals_args_fail(args, 2, "-%c %s less than minimum %lg.", opt->name, str, valmin);
+    if (!(*value <= valmax))
+        return !libsals_args_fail(args, 2, "-%c %s greater than maximum %lg.", opt->name, str, valmax);
+    return true;
+}
+
+bool libsals_args_parse_opt(libsals_args_t* args, const libsals_opt_info_t* opt, const char* value, cli_args_flags_t supported, const char* context) {
+    if (!args || !opt)
+        return false;
+    // reject unsupported options before evaluating their value (e.g. reading a config file)
+    if (!(opt->flag & supported))
+        return !libsals_args_fail(args, 2, "option -%c, --%s is not supported%s%s.", opt->name, opt->longname, context ? " " : "", context ? context : "");
+    args->setargsflags |= opt->flag;
+    switch (opt->name) {
+        case 'x':
+            return libsals_args_parse_uint64(args, opt, value, OPTVAL_WIDTH_MIN, OPTVAL_WIDTH_MAX, &args->spec.width);
+        case 'y':
+            return libsals_args_parse_uint64(args, opt, value, OPTVAL_HEIGHT_MIN, OPTVAL_HEIGHT_MAX, &args->spec.height);
+        case 's':
+            return libsals_args_parse_uint64(args, opt, value, OPTVAL_DIE_SIDES_MIN, OPTVAL_DIE_SIDES_MAX, &args->spec.diesides);
+        case 'e':
+            args->spec.exactending = true;
+            return true;
+        case 'd':
+        {
+            // the distribution is built once the die sides are known (see libsals_game_create), only it's syntax is checked here
+            int error = 0;
+            distribution_t distribution = strtodistr(value, &error);
+            args->preset = distribution.preset;
+            distr_free(&distribution);
+            if (error)
+                return !libsals_args_fail(args, 2, "invalid distribution '%s'.", value ? value : "");
+            args->spec.distribution = value;
+            return true;
+        }
+        case 'i':
+            return libsals_args_parse_uint64(args, opt, value, OPTVAL_ITERATIONS_MIN, OPTVAL_ITERATIONS_MAX, &args->options.simcount);
+        case 'l':
+            return libsals_args_parse_uint64(args, opt, value, OPTVAL_DICE_LIMIT_MIN, OPTVAL_DICE_LIMIT_MAX, &args->options.dicelimit);
+        case 'b':
+        {
+            // the bars are only drawn by the command line interface, hence the length is only checked
+            uint64_t barlength = 0;
+            return libsals_args_parse_uint64(args, opt, value, OPTVAL_BAR_LENGTH_MIN, OPTVAL_BAR_LENGTH_MAX, &barlength);
+        }
+        case 'p':
+            return libsals_args_parse_double(args, opt, value, OPTVAL_TARGET_PRECISION_MIN, OPTVAL_TARGET_PRECISION_MAX, &args->options.targetprecision);
+        case 'f':
+        {
+            int error = 0;
+            strtoreportformat(value, &error);
+            if (error)
+                return !libsals_args_fail(args, 2, "invalid format '%s'. must be one of csv, json.", value ? value : "");
+            return true;
+        }
+        case 'g':
+            args->board = value;
+            return true;
+        case 'S':
+            args->options.seeded = true;
+            return libsals_args_parse_uint64(args, opt, value, OPTVAL_SEED_MIN, OPTVAL_SEED_MAX, &args->options.seed);
+        default:
+            return !libsals_args_fail(args, 2, "option -%c, --%s is not supported%s%s.", opt->name, opt->longname, context ? " " : "", context ? context : "");
+    }
+}
+
+int libsals_args_parse(libsals_args_t* args, int argc, char* const argv[], cli_args_flags_t supported, const char* context) {
+    if (!args || (argc > 0 && !argv))
+        return 1;
+    array_t sals = array_create(0, sizeof(char), 0);
+    bool optionsended = false;
+    int error = 0;
+    for (int i = 0; !error && i < argc; i++) {
+        const char* arg = argv[i];
+
+        // every argument that is not an option is a snake or ladder
+        if (optionsended || arg[0] != '-' || arg[1] == '\0') {
+            int solerror = 0;
+            strtosol(arg, &solerror);
+            if (solerror) {
+                error = libsals_args_fail(args, 2, "invalid snake-or-ladder a-b '%s'.", arg);
+                break;
+            }
+            size_t length = strlen(arg);
+            char separator = ' ';
+            if ((sals.size != 0 && !array_add(&sals, &separator)) || !array_reserve(&sals, sals.size + length + 1)) {
+                error = libsals_args_fail(args, 3, "unable to add snake-or-ladder '%s'.", arg);
+                break;
+            }
+            memcpy((char*)sals.data + sals.size, arg, length);
+            sals.size += length;
+            args->setargsflags |= CLIAFLAG_SNAKESANDLADDERS;
+            continue;
+        }
+        if (strcmp(arg, "--") == 0) {
+            optionsended = true;
+            continue;
+        }
+
+        // long options are matched exactly or by an unambiguous prefix, their value is attached with '=' or the next argument
+        if (arg[1] == '-') {
+            const char* name = arg + 2;
+            size_t namelength = strcspn(name, "=");
+            const libsals_opt_info_t* opt = 0;
+            bool ambiguous = false;
+            for (size_t j = 0; j < LIBSALS_OPT_COUNT; j++) {
+                const libsals_opt_info_t* info = &libsals_opt_infos[j];
+                if (strncmp(info->longname, name, namelength) != 0)
+                    continue;
+                if (info->longname[namelength] == '\0') {
+                    opt = info;
+                    ambiguous = false;
+                    break;
+                }
+                ambiguous = opt != 0;
+                opt = info;
+            }
+            if (!opt || ambiguous || namelength == 0) {
+                error = libsals_args_fail(args, 2, "unknown option '%.*s'.", (int)(namelength + 2), arg);
+                break;
+            }
+            const char* value = 0;
+            if (name[namelength] == '=') {
+                if (!opt->hasvalue) {
+                    error = libsals_args_fail(args, 2, "option '--%s' doesn't allow a value.", opt->longname);
+                    break;
+                }
+                value = name + namelength + 1;
+            } else if (opt->hasvalue) {
+                if (i + 1 == argc) {
+                    error = libsals_args_fail(args, 2, "missing value for option '%c'.", opt->name);
+                    break;
+                }
+                value = argv[++i];
+            }
+            if (!libsals_args_parse_opt(args, opt, value, supported, context))
+                error = 2;
+            continue;
+        }
+
+        // short options can be grouped, the value of the last one is the rest of the argument or the next argument
+        for (const char* c = arg + 1; !error && *c; c++) {
+            const libsals_opt_info_t* opt = 0;
+            for (size_t j = 0; !opt && j < LIBSALS_OPT_COUNT; j++)
+                if (libsals_opt_infos[j].name == *c)
+                    opt = &libsals_opt_infos[j];
+            if (!opt) {
+                error = libsals_args_fail(args, 2, "unknown option '%c'.", *c);
+                break;
+            }
+            const char* value = 0;
+            if (opt->hasvalue) {
+                if (c[1] != '\0') {
+                    value = c + 1;
+                } else if (i + 1 == argc) {
+                    error = libsals_args_fail(args, 2, "missing value for option '%c'.", opt->name);
+                    break;
+                } else {
+                    value = argv[++i];
+                }
+            }
+            if (!libsals_args_parse_opt(args, opt, value, supported, context))
+                error = 2;
+            if (opt->hasvalue)
+                break;
+        }
+    }
+
+    // the game of a compiled board is fixed, hence the options describing the game can't be applied
+    const cli_args_flags_t gameflags = CLIAFLAG_WIDTH | CLIAFLAG_HEIGHT | CLIAFLAG_DIE_SIDES | CLIAFLAG_EXACT_ENDING | CLIAFLAG_DISTRIBUTION | CLIAFLAG_SNAKESANDLADDERS;
+    if (!error && (args->setargsflags & CLIAFLAG_BOARD) && (args->setargsflags & gameflags))
+        error = libsals_args_fail(args, 2, "option -g, --board can't be combined with the options -x, -y, -s, -e, -d or snakes and ladders.");
+
+    // null-terminate the joined snakes and ladders
+    char terminator = '\0';
+    if (!error && sals.size != 0) {
+        if (array_add(&sals, &terminator)) {
+            free(args->sals);
+            args->sals = sals.data;
+            args->spec.sals = args->sals;
+            return 0;
+        }
+        error = libsals_args_fail(args, 3, "unable to add snakes and ladders.");
+    }
+    array_free(&sals, 0);
+    return error;
+}
+
+int libsals_args_parse_str(libsals_args_t* args, const char* str, size_t size, cli_args_flags_t supported, const char* context) {
+    if (!args || !str)
+        return 1;
+    // the content has room for the null-terminator of an argument that ends at it's end
+    free(args->content);
+    args->content = malloc(size + 1);
+    if (!args->content)
+        return libsals_args_fail(args, 3, "unable to allocate arguments.");
+    memcpy(args->content, str, size);
+    args->content[size] = '\0';
+    array_clear(&args->argv);
+
+    size_t offset = 0;
+    size_t length = 0;
+    int error = 0;
+    char* arg;
+    while ((arg = cli_read_configfile_arg(args->content, size, &offset, &length, 0, &error))) {
+        arg[length] = '\0';
+        if (!array_add(&args->argv, &arg))
+            return libsals_args_fail(args, 3, "unable to add argument.");
+    }
+    if (error == 1)
+        return libsals_args_fail(args, 2, "argument ended in escape mode.");
+    if (error)
+        return libsals_args_fail(args, 2, "argument ended with unclosed quoted section.");
+    return libsals_args_parse(args, args->argv.size, args->argv.data, supported, context);
+}
+
+game_t libsals_args_game_create(libsals_args_t* args, int* error) {
+    int tmp;
+    if (!error)
+        error = &tmp;
+    *error = 0;
+    if (!args) {
+        *error = 1;
+        return (game_t){};
+    }
+
+    // load compiled boards like the command line interface (see board_setup)
+    if (args->board) {
+        int boarderror = 0;
+        game_t game = board_load(args->board, &boarderror);
+        switch (boarderror) {
+            case 0:
+                break;
+            case 2:
+                *error = libsals_args_fail(args, 2, "unable to open board file '%s'.", args->board);
+                break;
+            case 3:
+                *error = libsals_args_fail(args, 2, "'%s' is not a board file.", args->board);
+                break;
+            case 4:
+                *error = libsals_args_fail(args, 2, "board file '%s' was compiled by an incompatible version or machine. compile it again.", args->board);
+                break;
+            case 5:
+                *error = libsals_args_fail(args, 2, "board file '%s' is corrupted.", args->board);
+                break;
+            default:
+                *error = libsals_args_fail(args, 2, "unable to load board file '%s'.", args->board);
+                break;
+        }
+        return game;
+    }
+
+    size_t invalididx = 0;
+    int gameerror = 0;
+    game_t game = libsals_game_create(&args->spec, &gameerror, &invalididx);
+    switch (gameerror) {
+        case 0:
+            break;
+        case 2:
+            *error = libsals_args_fail(args, 2, "invalid playing field %lux%lu. must be at least %lux%lu.", args->spec.width, args->spec.height, GAME_WIDTH_MIN, GAME_HEIGHT_MIN);
+            break;
+        case 3:
+            *error = libsals_args_fail(args, 2, "invalid distribution for a %lu-sided die.", args->spec.diesides);
+            break;
+        case 4:
+        case 5:
+        {
+            // find the invalid snake or ladder in the joined snakes and ladders
+            const char* sol = args->sals ? args->sals : "";
+            for (size_t i = 0; i < invalididx && *sol; i++)
+                sol += strcspn(sol, " ") + (sol[strcspn(sol, " ")] == ' ');
+            *error = libsals_args_fail(args, 2, "invalid snake-or-ladder '%.*s' on the %lux%lu playing field.", (int)strcspn(sol, " "), sol, args->spec.width, args->spec.height);
+            break;
+        }
+        default:
+            *error = libsals_args_fail(args, 3, "unable to create game.");
+            break;
+    }
+    return game;
+}
+
+int libsals_task_run(libsals_task_t* task) {
+    if (!task)
+        return 1;
+    atomic_size_t* pending = task->pending;
+    int res = worker_run(task->worker);
+    task->res = res;
+    atomic_fetch_sub(pending, 1);
+    return res;
+}
+
+bool libsals_task_step(libsals_task_t* task) {
+    if (!task || task->started || !task->worker)
+        return false;
+    worker_t* const worker = task->worker;
+    // seed the calling thread's generator like worker_run (continuing the stream of a restored worker)
+    if (!task->stepped) {
+        if (worker->hasseed)
+            tsseed48(&worker->seed);
+        else
+            tsnewseed48();
+        task->stepped = true;
+    }
+    size_t first;
+    size_t last;
+    if (task->res == 0 && worker_claim(worker, &first, &last)) {
+        stopwatch_t stopwatch = stopwatch_start();
+        task->res = worker_run_batch(worker, first, last);
+        worker->elapsed += stopwatch_elapsed(&stopwatch);
+        if (task->res == 0)
+            return true;
+    }
+    worker_finish(worker);
+    task->worker = 0;
+    atomic_fetch_sub(task->pending, 1);
+    return false;
+}
+
+int libsals_simulate(const game_t* game, const libsals_options_t* options, stats_t* stats) {
+    if (!game || !options || !stats || options->simcount == 0)
+        return 1;
+    simulator_t simulator;
+    if (!simulator_init(&simulator, game, options->simcount, options->workers, options->dicelimit, options->targetprecision, options->timelimit))
+        return 2;
+    if (options->seeded) {
+        simulator_seed(&simulator, options->seed);
+        simulator_shard(&simulator, 0, 1);
+    }
+    libsals_task_t* tasks = calloc(simulator.workers.size, sizeof(*tasks));
+    if (!tasks) {
+        simulator_free(&simulator);
+        return 3;
+    }
+
+    // run every worker as task on a new thread or the executor (or on the calling thread if that fails, so all simulations get claimed)
+    simulator_prepare(&simulator);
+    atomic_size_t pending = simulator.workers.size;
+    stopwatch_t stopwatch = stopwatch_start();
+    for (size_t i = 0; i < simulator.workers.size; i++) {
+        tasks[i] = (libsals_task_t){ .worker = array_get(&simulator.workers, i), .pending = &pending };
+        if (options->executor)
+            tasks[i].started = options->executor->submit(options->executor->context, (libsals_task_fn_t)libsals_task_run, &tasks[i]);
+        else
+            tasks[i].started = thrd_create(&tasks[i].thread, (thrd_start_t)libsals_task_run, &tasks[i]) == thrd_success;
+    }
+
+    // coordinate the workers by checking the stopping criteria until all tasks finished,
+    // the tasks that could not be started are run one after another in batches between the checks, hence the criteria apply to them too
+    size_t stepped = 0;
+    while (atomic_load(&pending) != 0) {
+        if (options->cancel && atomic_load(options->cancel) && !atomic_load(&simulator.stop)) {
+            simulator.interrupted = true;
+            atomic_store(&simulator.stop, true);
+        }
+        if (simulator.timelimit > 0.0 && stopwatch_elapsed(&stopwatch) >= simulator.timelimit)
+            atomic_store(&simulator.stop, true);
+        simulator_check_precision(&simulator);
+        while (stepped < simulator.workers.size && (tasks[stepped].started || !tasks[stepped].worker))
+            stepped++;
+        if (stepped < simulator.workers.size) {
+            libsals_task_step(&tasks[stepped]);
+            continue;
+        }
+        const struct timespec interval = { .tv_sec = 0, .tv_nsec = SIMULATOR_COORDINATOR_INTERVAL_NS };
+        thrd_sleep(&interval, 0);
+    }
+    simulator.elapsed = stopwatch_elapsed(&stopwatch);
+    int res = 0;
+    for (size_t i = 0; i < simulator.workers.size; i++) {
+        if (tasks[i].started && !options->executor)
+            thrd_join(tasks[i].thread, 0);
+        if (tasks[i].res != 0)
+            res = 4;
+    }
+    simulator_finish(&simulator);
+    free(tasks);
+
+    if (!res && !stats_collect(stats, &simulator))
+        res = 5;
+    simulator_free(&simulator);
+    return res;
+}
@@ -1,73 +1,33 @@
 #include "loadingscreen.h"
 
 #include "cvts.h"
+#include "stopwatch.h"
 
 #include <stdio.h>
+#include <unistd.h>
 
-loadingscreen_t loadingscreen_create(const char* msg) {
-    loadingscreen_t loadscreen = { .valid = true, .msg = msg };
-    int res = mtx_init(&loadscreen.mtx, mtx_timed);
-    switch (res) {
-        case thrd_success:
-            break;
-        case thrd_error:
-            fprintf(stderr, "%swarning:%s unable to create mutex for loading screen.\n"
-                            "         not rendering loading screen.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-            return (loadingscreen_t){};
-        default:
-            fprintf(stderr, "%swarning:%s unable to create mutex for loading screen for unexpected reason.\n"
-                            "         not rendering loading screen.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-            return (loadingscreen_t){};
-    }
-    res = cnd_init(&loadscreen.cnd);
-    switch (res) {
-        case thrd_success:
-            break;
-        case thrd_nomem:
-            fprintf(stderr, "%swarning:%s unable to allocate memory for condition for loading screen.\n"
-                            "         not rendering loading screen.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-            mtx_destroy(&loadscreen.mtx);
-            return (loadingscreen_t){};
-        case thrd_error:
-            fprintf(stderr, "%swarning:%s unable to create condition for loading screen.\n"
-                            "         not rendering loading screen.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-            mtx_destroy(&loadscreen.mtx);
-            return (loadingscreen_t){};
-        default:
-            fprintf(stderr, "%swarning:%s unable to create condition for loading screen for unexpected reason.\n"
-                            "         not rendering loading screen.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-            mtx_destroy(&loadscreen.mtx);
-            return (loadingscreen_t){};
-    }
+loadingscreen_t loadingscreen_create(const char* msg, loadingscreen_progress_fn_t progress, const void* source) {
+    loadingscreen_t loadscreen = { .valid = true, .msg = msg, .progress = progress, .source = source };
+    atomic_init(&loadscreen.stop, false);
     return loadscreen;
 }
 
 void loadingscreen_destroy(loadingscreen_t* loadscreen) {
     if (!loadscreen || !loadscreen->valid)
         return;
-    cnd_destroy(&loadscreen->cnd);
-    mtx_destroy(&loadscreen->mtx);
+    loadingscreen_stop(loadscreen);
     *loadscreen = (loadingscreen_t){};
 }
 
 bool loadingscreen_start(loadingscreen_t* loadscreen) {
     if (!loadscreen || !loadscreen->valid || loadscreen->running)
         return false;
-    int res = mtx_lock(&loadscreen->mtx);
-    switch (res) {
-        case thrd_success:
-            break;
-        case thrd_error:
-            fprintf(stderr, "%swarning:%s unable to lock mutex for loading screen.\n"
-                            "         not rendering loading screen\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-            break;
-        default:
-            fprintf(stderr, "%swarning:%s unable to lock mutex for loading screen for unexpected reason.\n"
-                            "         not rendering loading screen\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-            break;
-    }
+    // don't write control sequences into pipes and files
+    if (!isatty(STDOUT_FILENO))
+        return false;
+    atomic_store(&loadscreen->stop, false);
     loadscreen->running = true;
-    res = thrd_create(&loadscreen->thrd, (thrd_start_t)loadingscreen_run, loadscreen);
+    int res = thrd_create(&loadscreen->thrd, (thrd_start_t)loadingscreen_run, loadscreen);
     switch (res) {
         case thrd_success:
             return true;
@@ -84,29 +44,70 @@ bool loadingscreen_start(loadingscreen_t* loadscreen) {
                             "         not rendering loading screen\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
             break;
     }
-    res = mtx_unlock(&loadscreen->mtx);
-    switch (res) {
-        case thrd_success:
-            break;
-        case thrd_error:
-            fprintf(stderr, "%swarning:%s unable to unlock mutex for loading screen.\n"
-                            "         not rendering loading screen\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-        default:
-            fprintf(stderr, "%swarning:%s unable to unlock mutex for loading screen for unexpected reason.\n"
-                            "         not rendering loading screen\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-    }
+    loadscreen->running = false;
     return false;
 }
 
 bool loadingscreen_stop(loadingscreen_t* loadscreen) {
     if (!loadscreen || !loadscreen->valid || !loadscreen->running)
         return false;
-    cnd_signal(&loadscreen->cnd);
+    atomic_store(&loadscreen->stop, true);
     thrd_join(loadscreen->thrd, 0);
     loadscreen->running = false;
     return true;
 }
 
+void loadingscreen_format_count(char* buffer, size_t size, double value) {
+    if (!buffer || size == 0)
+        return;
+    const char* suffixes[] = { "", "k", "M", "G", "T" };
+    const size_t suffixcount = sizeof(suffixes) / sizeof(*suffixes);
+    size_t suffix = 0;
+    while (value >= 1000.0 && suffix + 1 < suffixcount) {
+        value /= 1000.0;
+        suffix++;
+    }
+    // print four significant digits (whole numbers without suffix)
+    int decimals = suffix == 0 || value >= 1000.0 ? 0 : value >= 100.0 ? 1 : value >= 10.0 ? 2 : 3;
+    snprintf(buffer, size, "%.*f%s", decimals, value, suffixes[suffix]);
+}
+
+void loadingscreen_print_progress(const loadingscreen_progress_t* progress, double elapsed, double gamerate, double dicerate) {
+    if (!progress)
+        return;
+    // the work ends at the total number of games or the time limit, whichever is reached first
+    double fraction = -1.0;
+    double remaining = -1.0;
+    if (progress->total > 0) {
+        fraction = (double)progress->games / progress->total;
+        if (gamerate > 0.0)
+            remaining = (progress->total > progress->games ? progress->total - progress->games : 0) / gamerate;
+    }
+    if (progress->timelimit > 0.0) {
+        double timefraction = elapsed / progress->timelimit;
+        double timeremaining = progress->timelimit > elapsed ? progress->timelimit - elapsed : 0.0;
+        if (timefraction > fraction)
+            fraction = timefraction;
+        if (remaining < 0.0 || timeremaining < remaining)
+            remaining = timeremaining;
+    }
+    char games[16];
+    char gamespersec[16];
+    char dicespersec[16];
+    loadingscreen_format_count(games, sizeof(games), progress->games);
+    loadingscreen_format_count(gamespersec, sizeof(gamespersec), gamerate);
+    loadingscreen_format_count(dicespersec, sizeof(dicespersec), dicerate);
+    if (fraction >= 0.0)
+        printf(" %5.1f%%", (fraction < 1.0 ? fraction : 1.0) * 100.0);
+    printf("  %s games  %s games/s  %s dices/s", games, gamespersec, dicespersec);
+    if (progress->games > 0)
+        printf("  avg %.2f dices", (double)progress->dices / progress->games);
+    if (remaining >= 0.0) {
+        size_t seconds = (size_t)(remaining + 0.5);
+        printf("  ETA %lu:%02lu:%02lu", seconds / 3600, seconds / 60 % 60, seconds % 60);
+    }
+}
+
 int loadingscreen_run(loadingscreen_t* loadscreen) {
     if (!loadscreen || !loadscreen->valid || !loadscreen->running)
         return 1;
@@ -128,32 +129,42 @@ int loadingscreen_run(loadingscreen_t* loadscreen) {
     };
     const int framecolorcount = sizeof(framecolors) / sizeof(*framecolors);
 
-    int res;
-    struct timespec timeout;
+    // the rates are measured over the last LOADINGSCREEN_RATE_WINDOW_FRAMES frames, hence they follow changes of the throughput
+    loadingscreen_progress_t progress = {};
+    loadingscreen_progress_t window[LOADINGSCREEN_RATE_WINDOW_FRAMES] = {};
+    double windowtimes[LOADINGSCREEN_RATE_WINDOW_FRAMES] = {};
+    size_t windowframes = 0;
+    stopwatch_t stopwatch = stopwatch_start();
+    const struct timespec interval = { .tv_sec = 0, .tv_nsec = LOADINGSCREEN_FRAME_INTERVAL_NS };
     int frame = 0;
     int framecolor = 1;
     cvts_cursor_hide();
-    do {
+    while (!atomic_load(&loadscreen->stop)) {
         cvts_set_text_format(framecolors[framecolor]);
         printf("\r%s%s%s%s", frames[frame], FMT(FMTVAL_FG_DEFAULT), loadscreen->msg ? " " : "", loadscreen->msg ? loadscreen->msg : "");
+        if (loadscreen->progress) {
+            double elapsed = stopwatch_elapsed(&stopwatch);
+            loadscreen->progress(loadscreen->source, &progress);
+            size_t oldest = windowframes < LOADINGSCREEN_RATE_WINDOW_FRAMES ? 0 : windowframes % LOADINGSCREEN_RATE_WINDOW_FRAMES;
+            double span = elapsed - windowtimes[oldest];
+            double gamerate = windowframes > 0 && span > 0.0 ? (progress.games - window[oldest].games) / span : 0.0;
+            double dicerate = windowframes > 0 && span > 0.0 ? (progress.dices - window[oldest].dices) / span : 0.0;
+            window[windowframes % LOADINGSCREEN_RATE_WINDOW_FRAMES] = progress;
+            windowtimes[windowframes % LOADINGSCREEN_RATE_WINDOW_FRAMES] = elapsed;
+            windowframes++;
+            loadingscreen_print_progress(&progress, elapsed, gamerate, dicerate);
+            cvts_erase_in_line(0);
+        }
         cvts_cursor_right(9999);
         fflush(stdout);
         frame = (frame + 1) % framecount;
         framecolor = (framecolor + 1) % framecolorcount;
-    
-        timespec_get(&timeout, TIME_UTC);
-        timeout.tv_nsec += 50000000l;
-        if (timeout.tv_nsec >= 1000000000l) {
-            timeout.tv_sec += 1l;
-            timeout.tv_nsec %= 1000000000l;
-        }
-        res = cnd_timedwait(&loadscreen->cnd, &loadscreen->mtx, &timeout);
-    } while (res == thrd_timedout);
-    printf("\r%s⠿%s\n", FMT(FMTVAL_FG_BRIGHT_GREEN), FMT(FMTVAL_FG_DEFAULT));
+        thrd_sleep(&interval, 0);
+    }
+    printf("\r%s⠿%s", FMT(FMTVAL_FG_BRIGHT_GREEN), FMT(FMTVAL_FG_DEFAULT));
+    cvts_erase_in_line(0);
+    printf("\n");
     cvts_cursor_show();
 
-    if (res != thrd_success)
-        fprintf(stderr, "%swarning:%s loading screen failed.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
-
     return 0;
 }
@@ -1,6 +1,12 @@
 #include "sals.h"
 
+#include "cvts.h"
+
+#include <stdlib.h>
+
 int main(int argc, char* argv[]) {
+    // account the allocations until the arguments tell whether they are printed, no other thread is running yet
+    allocations_enable(true);
     assetmanager_init();
 
     #ifdef DEBUG
@@ -10,35 +16,339 @@ int main(int argc, char* argv[]) {
     printf("}\n");
     #endif
 
+    // time the phases of the run with the monotonic clock (only printed if requested)
+    timings_t timings = timings_create();
+    assetmanager_add(&timings, (deallocator_fn_t)timings_free);
+    stopwatch_t stopwatch = stopwatch_start();
+
+    allocations_set_subsystem(ALLOCATIONS_SUBSYSTEM_CLI);
     cli_args_t cli_args = cli_parse(argc, argv);
+    assetmanager_add(&cli_args, (deallocator_fn_t)cli_args_free);
+    allocations_set_subsystem(ALLOCATIONS_SUBSYSTEM_OTHER);
+    allocations_enable(cli_args.allocations);
+    timings_add(&timings, TIMINGS_PHASE_CLI_PARSE, &stopwatch);
+    timings.configs = cli_args.configs;
+    // a timings report in a machine-readable format is the only output on stdout, hence it can be parsed as one csv or json document
+    const bool timingsreport = cli_args.timings && (cli_args.setargsflags & CLIAFLAG_REPORT_FORMAT);
     #ifdef DEBUG
     cli_args_print(&cli_args);
     #endif
 
-    game_t game = game_setup(&cli_args);
+    // print the allocations at exit, the assets are freed before returning from main hence the bytes still live were leaked
+    if (cli_args.allocations && atexit(allocations_print_exit) != 0)
+        fprintf(stderr, "%swarning:%s unable to register exit function, the allocations are not printed.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
 
-    printf("Snakes and Ladders Simulator\n\n");
+    // stop simulations at the first SIGINT or SIGTERM and print the statistics of the finished games, exit immediately at the second
+    if (!interrupt_install())
+        fprintf(stderr, "%swarning:%s unable to install signal handlers. interrupted simulations print no statistics.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
 
-    #ifdef DEBUG
-    printf("game adjmat\n");
-    adjmat_print(&game.adjmat);
-    #endif
+    // run as many simulations as needed to reach the target precision or time limit if no iteration count was specified
+    size_t simcount = cli_args.iterations;
+    if ((cli_args.setargsflags & (CLIAFLAG_TARGET_PRECISION | CLIAFLAG_TIME_LIMIT)) && !(cli_args.setargsflags & CLIAFLAG_ITERATIONS))
+        simcount = OPTVAL_ITERATIONS_MAX;
 
-    #ifdef DEBUG
-    printf("game\n");
-    #endif
-    game_print(&game);
+    // merge the partial statistics of the shards of a run and print them instead of simulating
+    if (cli_args.setargsflags & CLIAFLAG_MERGE) {
+        stats_t stats = partial_merge(&cli_args.mergefiles);
+        assetmanager_add(&stats, (deallocator_fn_t)stats_free);
+        stats_print(&stats);
+        assetmanager_free_all();
+        return 0;
+    }
 
-    die_print(&game.die, cli_args.barlength);
+    // generate random snakes and ladders and write them as config file instead of simulating (and compile them into a board file with -o)
+    if (cli_args.setargsflags & CLIAFLAG_GENERATE) {
+        tsnewseed48();
+        const uint64_t seed = cli_args.seeded ? cli_args.seed : ((uint64_t)tsnrand48() << 31) ^ (uint64_t)tsnrand48();
+        int error = generator_generate(cli_args.width, cli_args.height, cli_args.saldensity, &cli_args.sallengths, seed, &cli_args.snakesandladders);
+        if (error) {
+            fprintf(stderr, "%serror:%s unable to generate snakes and ladders. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT),
+                error == 2 ? "playing field too large" : error == 3 ? "unable to allocate snakes and ladders" : "the playing field has too few cells, lower -G or enlarge -x and -y");
+            exit(1);
+        }
+        cli_args.setargsflags |= CLIAFLAG_SNAKESANDLADDERS;
+        if (cli_args.generatefile || !cli_args.compileboard) {
+            FILE* file = cli_args.generatefile ? fopen(cli_args.generatefile, "w") : stdout;
+            bool written = file && generator_write_config(file, &cli_args, &cli_args.snakesandladders);
+            if (file && file != stdout && fclose(file) != 0)
+                written = false;
+            if (!written) {
+                fprintf(stderr, "%serror:%s unable to write generated config into '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args.generatefile ? cli_args.generatefile : "stdout");
+                exit(1);
+            }
+        }
+        // the config on stdout stays parseable, hence the summary goes to stderr
+        fprintf(cli_args.generatefile || cli_args.compileboard ? stdout : stderr, "generated %lu snakes and ladders on a %lux%lu board with seed %lu%s%s%s.\n",
+            cli_args.snakesandladders.size, cli_args.width, cli_args.height, seed,
+            cli_args.generatefile ? " into '" : "", cli_args.generatefile ? cli_args.generatefile : "", cli_args.generatefile ? "'" : "");
+        if (!cli_args.compileboard) {
+            assetmanager_free_all();
+            return 0;
+        }
+    }
 
-    #ifdef DEBUG
-    simulate_dices(&game.die, cli_args.iterations);
-    #endif
+    // benchmark the samplers and random number backends of the die instead of simulating
+    if (cli_args.setargsflags & CLIAFLAG_BENCH_DIE) {
+        die_t die = die_create(&cli_args.distribution);
+        assetmanager_add(&die, (deallocator_fn_t)die_free);
+        const size_t rolls = cli_args.setargsflags & CLIAFLAG_ITERATIONS ? cli_args.iterations : DIEBENCH_ROLLS_DEFAULT;
+        diebench_t bench = diebench_create(&die, rolls, simulator_worker_count(cli_args.workers, rolls), cli_args.seeded ? cli_args.seed : DIEBENCH_SEED);
+        assetmanager_add(&bench, (deallocator_fn_t)diebench_free);
+        if (die_isempty(&die) || !diebench_run(&bench)) {
+            fprintf(stderr, "%serror:%s unable to benchmark the die. unable to allocate the die, tables or threads.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        if (cli_args.setargsflags & CLIAFLAG_REPORT_FORMAT)
+            diebench_print_report(stdout, &bench, cli_args.reportformat);
+        else
+            diebench_print(&bench);
+        // a failed combination is reported by the exit code, hence scripts can check the die without parsing the results
+        const size_t failed = diebench_failed(&bench);
+        assetmanager_free_all();
+        return failed > 0 ? 1 : 0;
+    }
+
+    // answer requests on a unix domain socket or on stdin and stdout instead of simulating
+    if (cli_args.setargsflags & CLIAFLAG_SERVE) {
+        int error = 0;
+        serve_t server = serve_create(cli_args.serve, cli_args.workers, &error);
+        if (error) {
+            fprintf(stderr, "%serror:%s unable to serve '%s'. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args.serve,
+                error == 2 ? "unable to create unix domain socket" : error == 3 ? "another daemon listens on the socket" : error == 4 ? "unable to create pipe, mutex or condition"
+                : "unable to allocate thread pool");
+            exit(1);
+        }
+        assetmanager_add(&server, (deallocator_fn_t)serve_free);
+        int res = serve_run(&server);
+        if (res != 0) {
+            fprintf(stderr, "%serror:%s unable to serve requests. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT),
+                res == 3 ? "unable to start thread pool" : "unable to wait for requests");
+            exit(1);
+        }
+        assetmanager_free_all();
+        if (interrupt_requested())
+            return INTERRUPT_EXIT_CODE_BASE + interrupt_signal();
+        return 0;
+    }
+
+    // run the games of many config files and print one result table instead of simulating a single game
+    if (cli_args.setargsflags & CLIAFLAG_BATCH) {
+        batch_t batch = batch_create(&cli_args);
+        assetmanager_add(&batch, (deallocator_fn_t)batch_free);
+        if (batch_validate(&batch, &cli_args) != 0) {
+            fprintf(stderr, "%serror:%s unable to validate batch.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        if (batch_run(&batch, &cli_args) != 0) {
+            fprintf(stderr, "%serror:%s unable to run batch.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        batch_print(&batch, cli_args.reportformat);
+        assetmanager_free_all();
+        if (interrupt_requested()) {
+            fprintf(stderr, "%swarning:%s interrupted, the results are partial.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
+            return INTERRUPT_EXIT_CODE_BASE + interrupt_signal();
+        }
+        return 0;
+    }
+
+    // run every combination of the swept parameters and print one result table instead of simulating a single game
+    if (cli_args.sweepparams.size != 0) {
+        sweep_t sweep = sweep_create(&cli_args, simcount);
+        assetmanager_add(&sweep, (deallocator_fn_t)sweep_free);
+        if (sweep_run(&sweep) != 0) {
+            fprintf(stderr, "%serror:%s unable to run sweep.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        sweep_print(&sweep, cli_args.reportformat);
+        assetmanager_free_all();
+        if (interrupt_requested()) {
+            fprintf(stderr, "%swarning:%s interrupted, the results are partial.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
+            return INTERRUPT_EXIT_CODE_BASE + interrupt_signal();
+        }
+        return 0;
+    }
+
+    // load the game from a compiled board or set it up from the cli arguments
+    stopwatch = stopwatch_start();
+    allocations_set_subsystem(ALLOCATIONS_SUBSYSTEM_GAME);
+    game_t game = cli_args.board ? board_setup(cli_args.board, cli_args.verifyboard) : game_setup(&cli_args);
+    assetmanager_add(&game, (deallocator_fn_t)game_free);
+    allocations_set_subsystem(ALLOCATIONS_SUBSYSTEM_OTHER);
+    timings_add(&timings, TIMINGS_PHASE_GAME_SETUP, &stopwatch);
 
-    simulator_t simulator = simulate(&game, cli_args.iterations, cli_args.dicelimit);
+    // compile the validated game into a board file instead of simulating it
+    if (cli_args.compileboard) {
+        int error = board_compile(&game, cli_args.compileboard);
+        if (error) {
+            fprintf(stderr, "%serror:%s unable to compile board into '%s'. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args.compileboard,
+                error == 2 ? "board too large" : error == 3 ? "unable to create temporary file" : error == 5 ? "unable to replace file" : "unable to write file");
+            exit(1);
+        }
+        printf("compiled %lux%lu board with %lu snakes and ladders and a %lu-sided die into '%s'.\n", game.width, game.height, game.edges.size, game.die.sides.size, cli_args.compileboard);
+        assetmanager_free_all();
+        return 0;
+    }
 
+    // replay a simulation from a trace archive instead of simulating
+    if (cli_args.replay) {
+        archive_t archive = archive_setup(cli_args.replay, &game);
+        assetmanager_add(&archive, (deallocator_fn_t)archive_free);
+        array_t dices = array_create(0, sizeof(size_t), 0);
+        assetmanager_add(&dices, (deallocator_fn_t)array_free_full);
+        int error = archive_get(&archive, cli_args.replayindex, &dices);
+        if (error) {
+            fprintf(stderr, "%serror:%s unable to replay simulation %lu from trace archive '%s'. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args.replayindex, cli_args.replay,
+                error == 2 ? "simulation not in archive" : error == 3 ? "archive corrupted" : "unable to add diced side");
+            exit(1);
+        }
+        archive_replay(&game, cli_args.replayindex, &dices);
+        assetmanager_free_all();
+        return 0;
+    }
+
+    if (!timingsreport) {
+        printf("Snakes and Ladders Simulator\n\n");
+
+        #ifdef DEBUG
+        printf("game\n");
+        #endif
+        game_print(&game);
+
+        die_print(&game.die, cli_args.barlength);
+    }
+
+    // load the statistics of previous runs of the game from the result cache and only run the missing simulations
+    cache_t cache = cache_create_empty();
+    stats_t cached = stats_create();
+    if (cli_args.cache) {
+        int error = 0;
+        cache = cache_create(cli_args.cache, &game, cli_args.dicelimit, &error);
+        if (error) {
+            fprintf(stderr, "%serror:%s unable to open result cache '%s'. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args.cache,
+                error == 2 ? "unable to create directory" : "unable to hash game");
+            exit(1);
+        }
+        assetmanager_add(&cache, (deallocator_fn_t)cache_free);
+        assetmanager_add(&cached, (deallocator_fn_t)stats_free);
+        if (cache_load(&cache, &cached) == 3)
+            fprintf(stderr, "%swarning:%s ignoring corrupted cache entry '%s'. it is replaced after simulating.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), cache.filepath);
+        if (cache_satisfies(&cached, simcount, cli_args.targetprecision)) {
+            cached.targetprecision = cli_args.targetprecision;
+            stopwatch = stopwatch_start();
+            if (!timingsreport) {
+                stats_print(&cached);
+                printf("loaded statistics of %lu simulations from cache entry '%s'.\n", cached.sims, cache.filepath);
+            }
+            timings_add(&timings, TIMINGS_PHASE_STATS_PRINT, &stopwatch);
+            if (timingsreport)
+                timings_print_report(stdout, &timings, cli_args.reportformat);
+            else if (cli_args.timings)
+                timings_print(&timings);
+            assetmanager_free_all();
+            return 0;
+        }
+        // an unbounded run (time limit or target precision only) stays unbounded
+        if (simcount != OPTVAL_ITERATIONS_MAX)
+            simcount -= cached.sims;
+    }
+
+    // create the records file and start it's writer before simulating, hence an invalid path is reported before the simulations ran
+    records_t records = records_create_empty();
+    if (cli_args.records) {
+        int error = 0;
+        records = records_create(cli_args.records, cli_args.recordsformat, cli_args.recordstrace, &game, &error);
+        if (error) {
+            fprintf(stderr, "%serror:%s unable to create records file '%s'. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args.records,
+                error == 2 ? "unable to open file" : "unable to write header");
+            exit(1);
+        }
+        assetmanager_add(&records, (deallocator_fn_t)records_free);
+        if (!records_start(&records)) {
+            fprintf(stderr, "%serror:%s unable to start records writer thread.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+    }
+
+    checkpoint_t checkpoint = checkpoint_create(cli_args.checkpoint, cli_args.checkpointinterval, cli_args.resume);
+    stopwatch = stopwatch_start();
+    simulate_options_t options = simulate_options_create();
+    options.simcount = simcount;
+    options.workers = cli_args.workers;
+    options.dicelimit = cli_args.dicelimit;
+    options.targetprecision = cli_args.targetprecision;
+    options.timelimit = cli_args.timelimit;
+    options.records = cli_args.records ? &records : 0;
+    options.checkpoint = cli_args.checkpoint ? &checkpoint : 0;
+    options.seed = cli_args.seeded ? &cli_args.seed : 0;
+    options.shard = cli_args.shard;
+    options.shardcount = cli_args.shardcount;
+    options.progress = cli_args.cache ? &cached.dices : 0;
+    options.perfcounters = cli_args.perfcounters;
+    simulator_t simulator;
+    simulate(&simulator, &game, &options);
+    assetmanager_add(&simulator, (deallocator_fn_t)simulator_free);
+    // the simulator is created within simulate, hence it's setup time is moved to the simulator_create phase
+    timings_add(&timings, TIMINGS_PHASE_SIMULATE, &stopwatch);
+    timings.phases[TIMINGS_PHASE_SIMULATE] -= simulator.setupelapsed;
+    if (cli_args.timings && !timings_collect(&timings, &simulator))
+        fprintf(stderr, "%swarning:%s unable to collect the timings of the workers.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
+
+    // write the remaining records
+    if (cli_args.records && records_stop(&records) != 0) {
+        fprintf(stderr, "%serror:%s unable to write records file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args.records);
+        exit(1);
+    }
+
+    stopwatch = stopwatch_start();
     stats_t stats = stats_analyze(&simulator);
-    stats_print(&stats);
+    assetmanager_add(&stats, (deallocator_fn_t)stats_free);
+    timings_add(&timings, TIMINGS_PHASE_STATS_ANALYZE, &stopwatch);
+    const bool interrupted = simulator.interrupted;
+
+    // merge the cached statistics into the new ones and store them, hence the next run continues from all simulations
+    int cacheerror = 0;
+    size_t cachedsims = 0;
+    if (cli_args.cache && !interrupted)
+        cacheerror = cache_store(&cache, &stats, &cachedsims);
+    stopwatch = stopwatch_start();
+    if (!timingsreport)
+        stats_print(&stats);
+    timings_add(&timings, TIMINGS_PHASE_STATS_PRINT, &stopwatch);
+    if (cli_args.cache) {
+        if (interrupted)
+            fprintf(stderr, "%swarning:%s interrupted, the statistics are not stored in the cache.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
+        else if (cacheerror)
+            fprintf(stderr, "%swarning:%s unable to store statistics in cache entry '%s'. %s.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), cache.filepath,
+                cacheerror == 2 ? "unable to lock cache directory" : cacheerror == 3 ? "unable to merge cached statistics" : "unable to write cache entry");
+        else if (!timingsreport)
+            printf("merged %lu new simulations with %lu cached simulations into cache entry '%s'.\n", stats.sims - cachedsims, cachedsims, cache.filepath);
+    }
+
+    // write the partial statistics of the shard which are merged with the other shards by the merge subcommand
+    if (cli_args.partialout) {
+        int error = partial_write(cli_args.partialout, &stats, &simulator);
+        if (error) {
+            fprintf(stderr, "%serror:%s unable to write partial statistics file '%s'. %s.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), cli_args.partialout,
+                error == 2 ? "unable to create temporary file" : error == 4 ? "unable to replace file" : "unable to write file");
+            exit(1);
+        }
+        if (!timingsreport)
+            printf("wrote partial statistics of shard %lu/%lu into '%s'.\n", cli_args.shard, cli_args.shardcount, cli_args.partialout);
+    }
+
+    if (!timingsreport)
+        simulator_print_perfcounters(&simulator);
+
+    // print the timings after the statistics, as table or as machine-readable report (instead of the statistics)
+    if (timingsreport)
+        timings_print_report(stdout, &timings, cli_args.reportformat);
+    else if (cli_args.timings)
+        timings_print(&timings);
 
     assetmanager_free_all();
+
+    // report partial statistics with the exit code of a process terminated by the signal
+    if (interrupted)
+        return INTERRUPT_EXIT_CODE_BASE + interrupt_signal();
 }
@@ -1,7 +1,10 @@
 #include "numbers.h"
 
+#include "str.h"
+
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 int strtodouble(const char *str, double* value) {
     if (!str)
@@ -23,14 +26,28 @@ int strtodouble(const char *str, double* value) {
 int strtouint64(const char *str, uint64_t* value) {
     if (!str)
         return 1;
-    char *endptr;
-    errno = 0;
-    uint64_t val = strtoul(str, &endptr, 10);
-    if (errno == ERANGE)
-        return 2;
-    if (endptr == str)
+    return strntouint64(str, strlen(str), value);
+}
+
+int strntouint64(const char* str, size_t length, uint64_t* value) {
+    if (!str)
+        return 1;
+    // skip leading whitespaces and plus sign like strtoul
+    size_t i = 0;
+    while (i < length && iswhitespace(str[i]))
+        i++;
+    if (i < length && str[i] == '+')
+        i++;
+    if (i == length || str[i] < '0' || str[i] > '9')
         return 3;
-    if (*endptr != '\0')
+    uint64_t val = 0;
+    for (; i < length && str[i] >= '0' && str[i] <= '9'; i++) {
+        uint64_t digit = str[i] - '0';
+        if (val > (UINT64_MAX - digit) / 10)
+            return 2;
+        val = val * 10 + digit;
+    }
+    if (i != length)
         return 4;
     if (value)
         *value = val;
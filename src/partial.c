@@ -0,0 +1,247 @@
+#include "partial.h"
+
+#include "atomicfile.h"
+#include "board.h"
+#include "checkpoint.h"
+#include "cvts.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int partial_write(const char* filepath, const stats_t* stats, const simulator_t* simulator) {
+    if (!filepath || !stats || !simulator || !simulator->game || !simulator->seeded)
+        return 1;
+    const partial_header_t run = {
+        .fingerprint = checkpoint_fingerprint(simulator->game),
+        .seed = simulator->seed,
+        .simcount = simulator->simcount,
+        .dicelimit = simulator->dicelimit,
+        .shard = simulator->shard,
+        .shardcount = simulator->shardcount,
+    };
+    return partial_write_run(filepath, stats, &run);
+}
+
+int partial_write_run(const char* filepath, const stats_t* stats, const partial_header_t* run) {
+    if (!filepath || !stats || !run)
+        return 1;
+
+    // create temporary file next to the partial statistics file
+    atomicfile_t atomicfile;
+    if (!atomicfile_open(&atomicfile, filepath, 0))
+        return 2;
+    FILE* file = atomicfile.file;
+
+    // reserve the header which is written once the checksum of the sections is known
+    partial_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PARTIAL_MAGIC, PARTIAL_MAGIC_SIZE);
+    header.version = PARTIAL_VERSION;
+    header.byteorder = PARTIAL_BYTE_ORDER;
+    header.wordsize = sizeof(size_t);
+    header.flags = stats->interrupted ? PARTIAL_FLAG_INTERRUPTED : 0;
+    header.fingerprint = run->fingerprint;
+    header.seed = run->seed;
+    header.simcount = run->simcount;
+    header.dicelimit = run->dicelimit;
+    header.shard = run->shard;
+    header.shardcount = run->shardcount;
+    header.solcount = stats->sals.size;
+    header.bucketcount = stats->diceshist.counts.size;
+    header.sims = stats->sims;
+    header.wins = stats->wins;
+    header.losses = stats->losses;
+    header.histtotal = stats->diceshist.total;
+    header.shortestcount = stats->shortestdices.size;
+    header.shortestindex = stats->shortestindex;
+    header.elapsed = stats->elapsed;
+    header.dices = stats->dices;
+    header.salsuses = stats->salsuses;
+    header.snakesuses = stats->snakesuses;
+    header.laddersuses = stats->laddersuses;
+    board_writer_t writer = { .file = file, .size = 0, .checksum = BOARD_CHECKSUM_SEED, .pendingsize = 0, .failed = false };
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    writer.size = sizeof(header);
+
+    // write sections
+    success = success
+        && board_write(&writer, stats->diceshist.counts.data, stats->diceshist.counts.size * sizeof(size_t))
+        && board_write(&writer, stats->shortestdices.data, stats->shortestdices.size * sizeof(size_t))
+        && board_write(&writer, stats->sals.data, stats->sals.size * sizeof(solstats_t));
+
+    // write header with checksums
+    header.size = writer.size;
+    header.checksum = writer.checksum;
+    header.headerchecksum = board_checksum(BOARD_CHECKSUM_SEED, &header, offsetof(partial_header_t, headerchecksum));
+    success = success && !writer.failed && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // replace partial statistics file atomically
+    int error = atomicfile_commit(&atomicfile, success);
+    return error ? error + 1 : 0;
+}
+
+int partial_load(const char* filepath, partial_header_t* header, stats_t* stats) {
+    if (!filepath || !header || !stats)
+        return 1;
+
+    // map the partial statistics file read-only
+    int fd = open(filepath, O_RDONLY);
+    struct stat filestat;
+    if (fd < 0 || fstat(fd, &filestat) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return 2;
+    }
+    if (!S_ISREG(filestat.st_mode) || (uint64_t)filestat.st_size < sizeof(partial_header_t)) {
+        close(fd);
+        return 3;
+    }
+    size_t size = filestat.st_size;
+    void* mapping = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return 2;
+
+    // verify header and the size of the sections
+    memcpy(header, mapping, sizeof(*header));
+    const unsigned char* data = (const unsigned char*)mapping + sizeof(*header);
+    const size_t datasize = size - sizeof(*header);
+    int error = 0;
+    if (memcmp(header->magic, PARTIAL_MAGIC, PARTIAL_MAGIC_SIZE) != 0)
+        error = 3;
+    else if (header->version != PARTIAL_VERSION || header->byteorder != PARTIAL_BYTE_ORDER || header->wordsize != sizeof(size_t))
+        error = 4;
+    else if (header->headerchecksum != board_checksum(BOARD_CHECKSUM_SEED, header, offsetof(partial_header_t, headerchecksum))
+        || header->size != size || header->checksum != board_checksum(BOARD_CHECKSUM_SEED, data, datasize)
+        || header->shard >= header->shardcount || header->shortestcount > header->dicelimit
+        || datasize / sizeof(size_t) < header->bucketcount + header->shortestcount
+        || (datasize - (header->bucketcount + header->shortestcount) * sizeof(size_t)) / sizeof(solstats_t) != header->solcount
+        || (datasize - (header->bucketcount + header->shortestcount) * sizeof(size_t)) % sizeof(solstats_t) != 0)
+        error = 5;
+
+    // restore the histogram with the buckets of the dice limit
+    if (!error) {
+        histogram_free(&stats->diceshist);
+        stats->diceshist = histogram_create(header->dicelimit);
+        if (stats->diceshist.counts.size == 0)
+            error = 6;
+        else if (stats->diceshist.counts.size != header->bucketcount)
+            error = 5;
+    }
+    size_t offset = 0;
+    if (!error) {
+        memcpy(stats->diceshist.counts.data, data, header->bucketcount * sizeof(size_t));
+        stats->diceshist.total = header->histtotal;
+        offset += header->bucketcount * sizeof(size_t);
+    }
+
+    // restore the shortest dice sequence and the statistics about each snake or ladder
+    if (!error && (!array_reserve(&stats->shortestdices, header->shortestcount) || !array_reserve(&stats->sals, header->solcount)))
+        error = 6;
+    if (!error) {
+        memcpy(stats->shortestdices.data, data + offset, header->shortestcount * sizeof(size_t));
+        stats->shortestdices.size = header->shortestcount;
+        offset += header->shortestcount * sizeof(size_t);
+        memcpy(stats->sals.data, data + offset, header->solcount * sizeof(solstats_t));
+        stats->sals.size = header->solcount;
+    }
+    munmap(mapping, size);
+    if (error)
+        return error;
+
+    stats->interrupted = (header->flags & PARTIAL_FLAG_INTERRUPTED) != 0;
+    stats->dicelimit = header->dicelimit;
+    stats->elapsed = header->elapsed;
+    stats->sims = header->sims;
+    stats->wins = header->wins;
+    stats->losses = header->losses;
+    stats->shortestindex = header->shortestindex;
+    stats->dices = header->dices;
+    stats->salsuses = header->salsuses;
+    stats->snakesuses = header->snakesuses;
+    stats->laddersuses = header->laddersuses;
+    return 0;
+}
+
+stats_t partial_merge(const array_t* filepaths) {
+    if (!filepaths || filepaths->size == 0) {
+        fprintf(stderr, "%serror:%s no partial statistics files given.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+        exit(1);
+    }
+
+    // load the statistics of every shard into it's slot, the first file defines the run
+    partial_header_t run = {};
+    stats_t* shards = 0;
+    for (size_t i = 0; i < filepaths->size; i++) {
+        const char* filepath = *(char* const*)array_getconst(filepaths, i);
+        partial_header_t header;
+        stats_t stats = stats_create();
+        int error = partial_load(filepath, &header, &stats);
+        switch (error) {
+            case 0:
+                break;
+            case 2:
+                fprintf(stderr, "%serror:%s unable to open partial statistics file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+                exit(1);
+            case 3:
+                fprintf(stderr, "%serror:%s '%s' is not a partial statistics file.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+                exit(1);
+            case 4:
+                fprintf(stderr, "%serror:%s partial statistics file '%s' was written by an incompatible version or machine.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+                exit(1);
+            case 5:
+                fprintf(stderr, "%serror:%s partial statistics file '%s' is corrupted.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+                exit(1);
+            default:
+                fprintf(stderr, "%serror:%s unable to load partial statistics file '%s'.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath);
+                exit(1);
+        }
+        if (i == 0) {
+            run = header;
+            shards = calloc(run.shardcount, sizeof(stats_t));
+            if (!shards) {
+                fprintf(stderr, "%serror:%s unable to allocate the statistics of %lu shards.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), run.shardcount);
+                exit(1);
+            }
+        } else if (header.fingerprint != run.fingerprint || header.seed != run.seed || header.simcount != run.simcount || header.dicelimit != run.dicelimit
+            || header.shardcount != run.shardcount || header.solcount != run.solcount) {
+            fprintf(stderr, "%serror:%s partial statistics file '%s' belongs to another run than '%s'. the game, -i, --iterations, -l, --dice-limit, -S, --seed and the number of shards must be the same.\n",
+                FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), filepath, *(char* const*)array_getconst(filepaths, 0));
+            exit(1);
+        }
+        if (shards[header.shard].diceshist.counts.size != 0) {
+            fprintf(stderr, "%serror:%s shard %lu/%lu is given more than once ('%s').\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), header.shard, header.shardcount, filepath);
+            exit(1);
+        }
+        shards[header.shard] = stats;
+    }
+    for (size_t i = 0; i < run.shardcount; i++) {
+        if (shards[i].diceshist.counts.size == 0) {
+            fprintf(stderr, "%serror:%s shard %lu/%lu is missing. the partial statistics files of all %lu shards are needed.\n",
+                FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), i, run.shardcount, run.shardcount);
+            exit(1);
+        }
+    }
+
+    // merge the shards in the order of their index, the shards ran in parallel, hence the run took as long as the slowest shard
+    stats_t stats = shards[0];
+    for (size_t i = 1; i < run.shardcount; i++) {
+        if (!stats_merge(&stats, &shards[i])) {
+            fprintf(stderr, "%serror:%s unable to merge shard %lu/%lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), i, run.shardcount);
+            exit(1);
+        }
+        if (stats.elapsed < shards[i].elapsed)
+            stats.elapsed = shards[i].elapsed;
+        stats.interrupted = stats.interrupted || shards[i].interrupted;
+        stats_free(&shards[i]);
+    }
+    free(shards);
+    stats_finalize(&stats);
+    return stats;
+}
@@ -0,0 +1,164 @@
+// syscall is only declared for the default feature set
+#define _DEFAULT_SOURCE
+
+#include "perfcounters.h"
+
+#include "cvts.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+#define PERFCOUNTERS_CACHE_READ_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+perfcounters_event_info_t perfcounters_event_infos[PERFCOUNTERS_EVENT_COUNT] = {
+    { "cycles"         , PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES                                 },
+    { "instructions"   , PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS                               },
+    { "branches"       , PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS                        },
+    { "branch-misses"  , PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES                              },
+    { "L1D read misses", PERF_TYPE_HW_CACHE, PERFCOUNTERS_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)    },
+    { "LLC read misses", PERF_TYPE_HW_CACHE, PERFCOUNTERS_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL)     }
+};
+#else
+perfcounters_event_info_t perfcounters_event_infos[PERFCOUNTERS_EVENT_COUNT] = {
+    { "cycles"         , 0, 0 },
+    { "instructions"   , 0, 0 },
+    { "branches"       , 0, 0 },
+    { "branch-misses"  , 0, 0 },
+    { "L1D read misses", 0, 0 },
+    { "LLC read misses", 0, 0 }
+};
+#endif
+
+perfcounters_t perfcounters_create_empty() {
+    perfcounters_t counters = { .counted = {}, .values = {}, .games = 0, .dices = 0 };
+    for (size_t i = 0; i < PERFCOUNTERS_EVENT_COUNT; i++)
+        counters.fds[i] = -1;
+    return counters;
+}
+
+int perfcounters_open(perfcounters_t* counters, bool inherit) {
+    if (!counters)
+        return 1;
+#ifdef __linux__
+    int error = 4;
+    bool opened = false;
+    for (size_t i = 0; i < PERFCOUNTERS_EVENT_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = perfcounters_event_infos[i].type;
+        attr.config = perfcounters_event_infos[i].config;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = inherit;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // count the calling thread on any processor
+        counters->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counters->fds[i] >= 0) {
+            opened = true;
+            continue;
+        }
+        // unsupported events are skipped, the first other failure is reported if no event could be opened
+        if (errno == EACCES || errno == EPERM)
+            error = 3;
+        else if (errno != ENOENT && errno != ENODEV && errno != EOPNOTSUPP && errno != EINVAL && error == 4)
+            error = 5;
+    }
+    return opened ? 0 : error;
+#else
+    (void)inherit;
+    return 2;
+#endif
+}
+
+void perfcounters_stop(perfcounters_t* counters) {
+    if (!counters)
+        return;
+    for (size_t i = 0; i < PERFCOUNTERS_EVENT_COUNT; i++) {
+        if (counters->fds[i] < 0)
+            continue;
+        // the value followed by the time the event was enabled and the time it was counted
+        uint64_t values[3];
+        if (read(counters->fds[i], values, sizeof(values)) == (ssize_t)sizeof(values) && values[2] > 0) {
+            counters->values[i] += values[2] < values[1] ? (uint64_t)((double)values[0] * values[1] / values[2]) : values[0];
+            counters->counted[i] = true;
+        }
+        close(counters->fds[i]);
+        counters->fds[i] = -1;
+    }
+}
+
+void perfcounters_merge(perfcounters_t* dst, const perfcounters_t* src) {
+    if (!dst || !src)
+        return;
+    for (size_t i = 0; i < PERFCOUNTERS_EVENT_COUNT; i++) {
+        dst->values[i] += src->values[i];
+        dst->counted[i] = dst->counted[i] || src->counted[i];
+    }
+    dst->games += src->games;
+    dst->dices += src->dices;
+}
+
+double perfcounters_ratio(const perfcounters_t* counters, perfcounters_event_t numerator, perfcounters_event_t denominator) {
+    if (!counters || !counters->counted[numerator] || !counters->counted[denominator] || counters->values[denominator] == 0)
+        return NAN;
+    return (double)counters->values[numerator] / counters->values[denominator];
+}
+
+const char* perfcounters_strerror(int error) {
+    switch (error) {
+        case 0:
+            return "no error";
+        case 1:
+            return "no performance counters given";
+        case 2:
+            return "performance counters are only supported on linux";
+        case 3:
+            return "access denied by the kernel (lower /proc/sys/kernel/perf_event_paranoid to 2 or run with CAP_PERFMON)";
+        case 4:
+            return "no hardware events supported (e.g. a virtual machine without performance monitoring unit)";
+        default:
+            return "unable to open events";
+    }
+}
+
+void perfcounters_print(const perfcounters_t* counters) {
+    if (!counters)
+        return;
+    printf(
+        "Hardware performance counters\n"
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%-15s  %16s  %12s  %12s%s \x1b(0x\x1b(B\n",
+        FMT(FMTVAL_BOLD), "EVENT", "TOTAL", "PER GAME", "PER DICE", FMT(FMTVAL_NO_BOLD)
+    );
+    for (size_t i = 0; i < PERFCOUNTERS_EVENT_COUNT; i++) {
+        if (!counters->counted[i]) {
+            printf("  \x1b(0x\x1b(B %-15s  %16s  %12s  %12s \x1b(0x\x1b(B\n", perfcounters_event_infos[i].name, "n/a", "n/a", "n/a");
+            continue;
+        }
+        printf(
+            "  \x1b(0x\x1b(B %-15s  %16lu  %12.3lf  %12.3lf \x1b(0x\x1b(B\n",
+            perfcounters_event_infos[i].name, counters->values[i],
+            counters->games > 0 ? (double)counters->values[i] / counters->games : 0.0, counters->dices > 0 ? (double)counters->values[i] / counters->dices : 0.0
+        );
+    }
+    const double ipc = perfcounters_ratio(counters, PERFCOUNTERS_EVENT_INSTRUCTIONS, PERFCOUNTERS_EVENT_CYCLES);
+    const double branchmissrate = perfcounters_ratio(counters, PERFCOUNTERS_EVENT_BRANCH_MISSES, PERFCOUNTERS_EVENT_BRANCHES);
+    printf(
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "  %sCounted in user space over %lu games with %lu dices, n/a events are not supported by the processor or kernel.%s\n",
+        FMT(FMTVAL_FG_BRIGHT_BLACK), counters->games, counters->dices, FMT(FMTVAL_FG_DEFAULT)
+    );
+    if (!isnan(ipc))
+        printf("  %.3lf instructions per cycle.\n", ipc);
+    if (!isnan(branchmissrate))
+        printf("  %.3lf%% of the branches were mispredicted.\n", branchmissrate * 100.0);
+    printf("\n");
+}
@@ -0,0 +1,427 @@
+#include "records.h"
+
+#include "simulator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+records_format_info_t records_format_infos[RECORDS_FORMAT_COUNT] = {
+    { "binary" },
+    { "csv"     },
+    { "archive" }
+};
+
+records_format_t strtorecordsformat(const char* str, int* error) {
+    if (!str) {
+        if (error)
+            *error = 1;
+        return RECORDS_FORMAT_BINARY;
+    }
+    for (size_t i = 0; i < RECORDS_FORMAT_COUNT; i++) {
+        if (strcmp(str, records_format_infos[i].name) == 0) {
+            if (error)
+                *error = 0;
+            return i;
+        }
+    }
+    if (error)
+        *error = 2;
+    return RECORDS_FORMAT_BINARY;
+}
+
+records_buffer_t* records_buffer_create(records_producer_t* producer) {
+    records_buffer_t* buffer = calloc(1, sizeof(*buffer));
+    if (buffer) {
+        buffer->producer = producer;
+        buffer->blocks = array_create(0, sizeof(archive_block_t), 0);
+    }
+    return buffer;
+}
+
+void records_buffer_free(records_buffer_t* buffer) {
+    if (!buffer)
+        return;
+    free(buffer->data);
+    array_free(&buffer->blocks, 0);
+    free(buffer);
+}
+
+bool records_buffer_reserve(records_buffer_t* buffer, size_t size) {
+    if (!buffer)
+        return false;
+    if (buffer->capacity - buffer->size >= size)
+        return true;
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity - buffer->size < size) {
+        if (capacity > SIZE_MAX / 2)
+            return false;
+        capacity *= 2;
+    }
+    unsigned char* data = realloc(buffer->data, capacity);
+    if (!data)
+        return false;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+bool records_buffer_add(records_buffer_t* buffer, const void* data, size_t size) {
+    if (!data || !records_buffer_reserve(buffer, size))
+        return false;
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    return true;
+}
+
+bool records_buffer_add_value(records_buffer_t* buffer, records_format_t format, uint64_t value) {
+    if (format == RECORDS_FORMAT_BINARY)
+        return records_buffer_add(buffer, &value, sizeof(value));
+    // convert the value to decimal digits from the back
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[sizeof(digits) - ++count] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    return records_buffer_add(buffer, digits + sizeof(digits) - count, count);
+}
+
+records_t records_create_empty() {
+    return (records_t){
+        .file = 0,
+        .format = RECORDS_FORMAT_BINARY,
+        .trace = false,
+        .game = 0,
+        .queue = 0,
+        .done = false,
+        .failed = false,
+        .count = 0,
+        .offset = 0,
+        .index = array_create(0, sizeof(archive_block_t), 0),
+        .codebook = archive_codebook_create_empty(),
+        .started = false
+    };
+}
+
+records_t records_create(const char* filepath, records_format_t format, bool trace, const game_t* game, int* error) {
+    if (!filepath || !game) {
+        if (error)
+            *error = 1;
+        return records_create_empty();
+    }
+    records_t records = records_create_empty();
+    records.file = fopen(filepath, format == RECORDS_FORMAT_CSV ? "w" : "wb");
+    if (!records.file) {
+        if (error)
+            *error = 2;
+        return records_create_empty();
+    }
+    records.format = format;
+    records.trace = trace || format == RECORDS_FORMAT_ARCHIVE;
+    records.game = game;
+    // only the writer thread writes to the file, hence a large buffer keeps the number of system calls low
+    setvbuf(records.file, 0, _IOFBF, RECORDS_FILE_BUFFER_SIZE);
+
+    // write the header into a buffer and the buffer into the file
+    records_buffer_t* header = records_buffer_create(0);
+    bool success = header != 0;
+    if (format == RECORDS_FORMAT_BINARY) {
+        records_header_t fileheader = {
+            .version = RECORDS_VERSION,
+            .byteorder = RECORDS_BYTE_ORDER,
+            .flags = trace ? RECORDS_FLAG_TRACE : 0,
+            .reserved = 0,
+            .edgecount = game->soldsts.size,
+            .recordsize = (3 + game->soldsts.size) * sizeof(uint64_t)
+        };
+        memcpy(fileheader.magic, RECORDS_MAGIC, RECORDS_MAGIC_SIZE);
+        success = success && records_buffer_add(header, &fileheader, sizeof(fileheader));
+    } else if (format == RECORDS_FORMAT_ARCHIVE) {
+        // the header is rewritten once the blocks are written, the code lengths are followed by zero padding up to the first block
+        records.codebook = archive_codebook_create(&game->die);
+        archive_header_t archiveheader = archive_header_create(game);
+        success = success && records.codebook.lengths.size == game->die.sides.size
+            && records_buffer_add(header, &archiveheader, sizeof(archiveheader))
+            && records_buffer_add(header, records.codebook.lengths.data, records.codebook.lengths.size)
+            && records_buffer_reserve(header, archiveheader.blocksoffset - header->size);
+        if (success) {
+            memset(header->data + header->size, 0, archiveheader.blocksoffset - header->size);
+            header->size = archiveheader.blocksoffset;
+        }
+    } else {
+        const char* columns = "simulation,dices,aborted";
+        success = success && records_buffer_add(header, columns, strlen(columns));
+    }
+    // the snakes and ladders in the order of the usage counts (1 based cell indices)
+    for (size_t i = 0; success && format != RECORDS_FORMAT_ARCHIVE && i < game->solidxs.size; i++) {
+        const optional_size_t* solidx = array_getconst(&game->solidxs, i);
+        if (!solidx->present)
+            continue;
+        uint64_t src = i + 1;
+        uint64_t dst = *(const size_t*)array_getconst(&game->soldsts, solidx->value) + 1;
+        if (format == RECORDS_FORMAT_CSV)
+            success = records_buffer_add(header, ",", 1) && records_buffer_add_value(header, format, src) && records_buffer_add(header, "-", 1);
+        else
+            success = records_buffer_add_value(header, format, src);
+        success = success && records_buffer_add_value(header, format, dst);
+    }
+    if (format == RECORDS_FORMAT_CSV)
+        success = success && records_buffer_add(header, trace ? ",trace\n" : "\n", trace ? 7 : 1);
+    success = success && fwrite(header->data, 1, header->size, records.file) == header->size;
+    if (success)
+        records.offset = header->size;
+    records_buffer_free(header);
+    if (!success) {
+        records_free(&records);
+        if (error)
+            *error = 3;
+        return records;
+    }
+
+    if (error)
+        *error = 0;
+    return records;
+}
+
+void records_free(records_t* records) {
+    if (!records)
+        return;
+    if (records->file)
+        fclose(records->file);
+    array_free(&records->index, 0);
+    archive_codebook_free(&records->codebook);
+    *records = records_create_empty();
+}
+
+bool records_start(records_t* records) {
+    if (!records || !records->file)
+        return false;
+    atomic_store(&records->done, false);
+    records->started = thrd_create(&records->thread, (thrd_start_t)records_writer_run, records) == thrd_success;
+    return records->started;
+}
+
+int records_stop(records_t* records) {
+    if (!records)
+        return 1;
+    atomic_store(&records->done, true);
+    // write the remaining buffers on the calling thread if the writer thread was not started
+    if (records->started)
+        thrd_join(records->thread, 0);
+    else
+        records_writer_run(records);
+    records->started = false;
+    if (records->file && records->format == RECORDS_FORMAT_ARCHIVE && !atomic_load(&records->failed) && !records_finish_archive(records))
+        atomic_store(&records->failed, true);
+    if (records->file && fflush(records->file) != 0)
+        atomic_store(&records->failed, true);
+    return atomic_load(&records->failed) ? 2 : 0;
+}
+
+int records_writer_run(records_t* records) {
+    if (!records)
+        return 1;
+    const struct timespec interval = { .tv_sec = 0, .tv_nsec = RECORDS_WRITER_INTERVAL_NS };
+    while (true) {
+        // check whether the records are done before taking the queue, so buffers pushed before are still written
+        bool done = atomic_load(&records->done);
+        records_buffer_t* taken = atomic_exchange(&records->queue, 0);
+        if (!taken) {
+            if (done)
+                break;
+            thrd_sleep(&interval, 0);
+            continue;
+        }
+        // reverse the taken buffers into the order they were pushed
+        records_buffer_t* ordered = 0;
+        while (taken) {
+            records_buffer_t* next = taken->next;
+            taken->next = ordered;
+            ordered = taken;
+            taken = next;
+        }
+        while (ordered) {
+            records_buffer_t* buffer = ordered;
+            ordered = ordered->next;
+            // discard the buffers after writing failed, they still have to be returned so the producers don't wait forever
+            if (!atomic_load(&records->failed)) {
+                if (fwrite(buffer->data, 1, buffer->size, records->file) == buffer->size) {
+                    records->count += buffer->count;
+                    // index the written blocks by their offset in the archive
+                    for (size_t i = 0; i < buffer->blocks.size; i++) {
+                        archive_block_t block = *(const archive_block_t*)array_getconst(&buffer->blocks, i);
+                        block.offset += records->offset;
+                        if (!array_add(&records->index, &block))
+                            atomic_store(&records->failed, true);
+                    }
+                    records->offset += buffer->size;
+                } else {
+                    atomic_store(&records->failed, true);
+                }
+            }
+            buffer->size = 0;
+            buffer->count = 0;
+            array_clear(&buffer->blocks);
+            // return the buffer to the free list of it's producer
+            records_buffer_t* head = atomic_load(&buffer->producer->free);
+            do {
+                buffer->next = head;
+            } while (!atomic_compare_exchange_weak(&buffer->producer->free, &head, buffer));
+        }
+    }
+    return 0;
+}
+
+records_producer_t records_producer_create_empty() {
+    return (records_producer_t){
+        .records = 0,
+        .free = 0,
+        .spare = 0,
+        .current = 0,
+        .buffercount = 0
+    };
+}
+
+void records_producer_free(records_producer_t* producer) {
+    if (!producer)
+        return;
+    records_buffer_free(producer->current);
+    records_buffer_t* lists[2] = { producer->spare, atomic_exchange(&producer->free, 0) };
+    for (size_t i = 0; i < 2; i++) {
+        while (lists[i]) {
+            records_buffer_t* next = lists[i]->next;
+            records_buffer_free(lists[i]);
+            lists[i] = next;
+        }
+    }
+    *producer = records_producer_create_empty();
+}
+
+records_buffer_t* records_producer_acquire(records_producer_t* producer) {
+    if (!producer)
+        return 0;
+    const struct timespec interval = { .tv_sec = 0, .tv_nsec = RECORDS_PRODUCER_INTERVAL_NS };
+    while (true) {
+        // take all buffers returned by the writer at once (only the producer takes from it's free list, hence no ABA problem)
+        if (!producer->spare)
+            producer->spare = atomic_exchange(&producer->free, 0);
+        if (producer->spare) {
+            records_buffer_t* buffer = producer->spare;
+            producer->spare = buffer->next;
+            buffer->next = 0;
+            return buffer;
+        }
+        if (producer->buffercount < RECORDS_PRODUCER_BUFFERS) {
+            records_buffer_t* buffer = records_buffer_create(producer);
+            if (buffer)
+                producer->buffercount++;
+            return buffer;
+        }
+        // all buffers are queued, wait until the writer returns one
+        thrd_sleep(&interval, 0);
+    }
+}
+
+bool records_producer_add(records_producer_t* producer, const simulation_t* simulation, size_t index) {
+    if (!producer || !producer->records)
+        return true;
+    if (!simulation)
+        return false;
+    if (!producer->current && !(producer->current = records_producer_acquire(producer)))
+        return false;
+
+    records_buffer_t* const buffer = producer->current;
+    const records_format_t format = producer->records->format;
+    if (format == RECORDS_FORMAT_ARCHIVE)
+        return records_producer_add_trace(producer, simulation, index);
+    const bool csv = format == RECORDS_FORMAT_CSV;
+    const size_t oldsize = buffer->size;
+
+    // reserve the worst case size of the record (20 digits and a separator per value in CSV format) to append without reallocating
+    size_t valuecount = 3 + simulation->soluses.size + (producer->records->trace ? simulation->dices.size : 0);
+    bool success = valuecount <= SIZE_MAX / 21 && records_buffer_reserve(buffer, valuecount * (csv ? 21 : sizeof(uint64_t)) + 1);
+    success = success
+        && records_buffer_add_value(buffer, format, index) && (!csv || records_buffer_add(buffer, ",", 1))
+        && records_buffer_add_value(buffer, format, simulation->dices.size) && (!csv || records_buffer_add(buffer, ",", 1))
+        && records_buffer_add_value(buffer, format, simulation->aborted);
+    for (size_t i = 0; success && i < simulation->soluses.size; i++)
+        success = (!csv || records_buffer_add(buffer, ",", 1)) && records_buffer_add_value(buffer, format, *(const size_t*)array_getconst(&simulation->soluses, i));
+    if (producer->records->trace) {
+        if (csv)
+            success = success && records_buffer_add(buffer, ",", 1);
+        for (size_t i = 0; success && i < simulation->dices.size; i++)
+            success = (!csv || i == 0 || records_buffer_add(buffer, " ", 1)) && records_buffer_add_value(buffer, format, *(const size_t*)array_getconst(&simulation->dices, i));
+    }
+    if (csv)
+        success = success && records_buffer_add(buffer, "\n", 1);
+
+    // drop an incomplete record
+    if (!success) {
+        buffer->size = oldsize;
+        return false;
+    }
+    buffer->count++;
+    return true;
+}
+
+void records_producer_flush(records_producer_t* producer, bool force) {
+    if (!producer || !producer->records || !producer->current || producer->current->count == 0)
+        return;
+    if (!force && producer->current->size < RECORDS_BUFFER_SIZE)
+        return;
+    records_buffer_t* buffer = producer->current;
+    producer->current = 0;
+    // push the buffer onto the queue (the writer only takes the whole queue, hence pushing is free of the ABA problem)
+    records_buffer_t* head = atomic_load(&producer->records->queue);
+    do {
+        buffer->next = head;
+    } while (!atomic_compare_exchange_weak(&producer->records->queue, &head, buffer));
+}
+
+bool records_producer_add_trace(records_producer_t* producer, const simulation_t* simulation, size_t index) {
+    records_buffer_t* const buffer = producer->current;
+    // continue the last block if the simulation directly follows it (the simulations of a worker's batch are consecutive)
+    archive_block_t* block = buffer->blocks.size != 0 ? array_get(&buffer->blocks, buffer->blocks.size - 1) : 0;
+    if (!block || block->first + block->count != index || block->count >= ARCHIVE_BLOCK_SIMS) {
+        const archive_block_t newblock = { .first = index, .count = 0, .offset = buffer->size, .size = 0 };
+        if (!(block = array_add(&buffer->blocks, &newblock)))
+            return false;
+    }
+    if (!archive_encode(buffer, &producer->records->codebook, &simulation->dices)) {
+        // drop the trace and the block if it became empty
+        buffer->size = block->offset + block->size;
+        if (block->count == 0)
+            buffer->blocks.size--;
+        return false;
+    }
+    block->count++;
+    block->size = buffer->size - block->offset;
+    buffer->count++;
+    return true;
+}
+
+int records_block_compare(const void* a, const void* b) {
+    const archive_block_t* blocka = a;
+    const archive_block_t* blockb = b;
+    return blocka->first < blockb->first ? -1 : blocka->first > blockb->first;
+}
+
+bool records_finish_archive(records_t* records) {
+    if (!records || !records->file || !records->game)
+        return false;
+    // pad the blocks, append the index ordered by the first simulations and rewrite the header
+    const unsigned char padding[ARCHIVE_ALIGNMENT] = { 0 };
+    archive_header_t header = archive_header_create(records->game);
+    const size_t paddingsize = (ARCHIVE_ALIGNMENT - records->offset % ARCHIVE_ALIGNMENT) % ARCHIVE_ALIGNMENT;
+    if (fwrite(padding, 1, paddingsize, records->file) != paddingsize)
+        return false;
+    header.indexoffset = records->offset + paddingsize;
+    qsort(records->index.data, records->index.size, sizeof(archive_block_t), records_block_compare);
+    if (fwrite(records->index.data, sizeof(archive_block_t), records->index.size, records->file) != records->index.size)
+        return false;
+    header.simcount = records->count;
+    header.blockcount = records->index.size;
+    header.size = header.indexoffset + records->index.size * sizeof(archive_block_t);
+    records->offset = header.size;
+    return fseek(records->file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, records->file) == 1;
+}
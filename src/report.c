@@ -0,0 +1,117 @@
+#include "report.h"
+
+#include <stdio.h>
+#include <string.h>
+
+report_format_info_t report_format_infos[REPORT_FORMAT_COUNT] = {
+    { "csv"  },
+    { "json" }
+};
+
+// The names of the statistics columns printed by report_print_stats
+static const char* const report_stats_columns[] = {
+    "sims", "wins", "losses", "win_rate", "dices_min", "dices_max", "dices_avg", "dices_stddev", "dices_ci95", "dices_p50", "dices_p90", "dices_p99"
+};
+
+report_format_t strtoreportformat(const char* str, int* error) {
+    if (!str) {
+        if (error)
+            *error = 1;
+        return REPORT_FORMAT_CSV;
+    }
+    for (size_t i = 0; i < REPORT_FORMAT_COUNT; i++) {
+        if (strcmp(str, report_format_infos[i].name) == 0) {
+            if (error)
+                *error = 0;
+            return i;
+        }
+    }
+    if (error)
+        *error = 2;
+    return REPORT_FORMAT_CSV;
+}
+
+void report_print_json_string(FILE* file, const char* str) {
+    if (!str) {
+        fprintf(file, "null");
+        return;
+    }
+    fprintf(file, "\"");
+    for (; *str; str++) {
+        switch (*str) {
+            case '"':
+                fprintf(file, "\\\"");
+                break;
+            case '\\':
+                fprintf(file, "\\\\");
+                break;
+            case '\n':
+                fprintf(file, "\\n");
+                break;
+            case '\t':
+                fprintf(file, "\\t");
+                break;
+            default:
+                if ((unsigned char)*str < 0x20)
+                    fprintf(file, "\\u%04x", (unsigned char)*str);
+                else
+                    fprintf(file, "%c", *str);
+                break;
+        }
+    }
+    fprintf(file, "\"");
+}
+
+void report_print_csv_string(FILE* file, const char* str) {
+    if (!str)
+        return;
+    if (!strpbrk(str, ",\"\r\n")) {
+        fprintf(file, "%s", str);
+        return;
+    }
+    fprintf(file, "\"");
+    for (; *str; str++) {
+        if (*str == '"')
+            fprintf(file, "\"\"");
+        else
+            fprintf(file, "%c", *str);
+    }
+    fprintf(file, "\"");
+}
+
+void report_print_stats_header(FILE* file) {
+    for (size_t i = 0; i < sizeof(report_stats_columns) / sizeof(*report_stats_columns); i++)
+        fprintf(file, ",%s", report_stats_columns[i]);
+}
+
+void report_print_stats(FILE* file, const stats_t* stats, report_format_t format) {
+    const size_t columncount = sizeof(report_stats_columns) / sizeof(*report_stats_columns);
+    if (!stats) {
+        for (size_t i = 0; i < columncount; i++) {
+            if (format == REPORT_FORMAT_JSON)
+                fprintf(file, ", \"%s\": null", report_stats_columns[i]);
+            else
+                fprintf(file, ",");
+        }
+        return;
+    }
+    // the values in the same order as report_stats_columns
+    size_t p50 = histogram_quantile(&stats->diceshist, 0.5);
+    size_t p90 = histogram_quantile(&stats->diceshist, 0.9);
+    size_t p99 = histogram_quantile(&stats->diceshist, 0.99);
+    if (format == REPORT_FORMAT_JSON) {
+        const char* const* c = report_stats_columns;
+        fprintf(file,
+            ", \"%s\": %lu, \"%s\": %lu, \"%s\": %lu, \"%s\": %.3lf, \"%s\": %lu, \"%s\": %lu"
+            ", \"%s\": %.6lf, \"%s\": %.6lf, \"%s\": %.6lf, \"%s\": %lu, \"%s\": %lu, \"%s\": %lu",
+            c[0], stats->sims, c[1], stats->wins, c[2], stats->losses, c[3], stats->winrate, c[4], stats->dices.min, c[5], stats->dices.max,
+            c[6], stats->dices.avg, c[7], stats->dices.stddev, c[8], stats->dices.ci95, c[9], p50, c[10], p90, c[11], p99
+        );
+    } else {
+        fprintf(file,
+            ",%lu,%lu,%lu,%.3lf,%lu,%lu,%.6lf,%.6lf,%.6lf,%lu,%lu,%lu",
+            stats->sims, stats->wins, stats->losses, stats->winrate, stats->dices.min, stats->dices.max,
+            stats->dices.avg, stats->dices.stddev, stats->dices.ci95, p50, p90, p99
+        );
+    }
+}
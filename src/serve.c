@@ -0,0 +1,868 @@
+#include "serve.h"
+
+#include "cvts.h"
+#include "interrupt.h"
+#include "libsals.h"
+#include "report.h"
+#include "str.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+void serve_request_free(serve_request_t* request) {
+    if (!request)
+        return;
+    free(request->id);
+    free(request->args);
+    *request = (serve_request_t){};
+}
+
+bool serve_parse_json_hex(const char* str, uint32_t* codepoint) {
+    if (!str || !codepoint)
+        return false;
+    *codepoint = 0;
+    for (size_t i = 0; i < 4; i++) {
+        char c = str[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else
+            return false;
+        *codepoint = *codepoint << 4 | digit;
+    }
+    return true;
+}
+
+const char* serve_parse_json_string(const char* str, array_t* value) {
+    if (!str || *str != '"')
+        return 0;
+    for (str++; *str != '"'; str++) {
+        char c = *str;
+        // control characters (including the null-terminator of an unterminated string) must be escaped
+        if ((unsigned char)c < 0x20)
+            return 0;
+        if (c == '\\') {
+            switch (*++str) {
+                case '"': case '\\': case '/': c = *str; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u':
+                {
+                    // decode the code point (combining surrogate pairs) and encode it as UTF-8
+                    uint32_t codepoint = 0;
+                    if (!serve_parse_json_hex(str + 1, &codepoint))
+                        return 0;
+                    str += 4;
+                    if (codepoint >= 0xd800 && codepoint < 0xdc00) {
+                        uint32_t low = 0;
+                        if (str[1] != '\\' || str[2] != 'u' || !serve_parse_json_hex(str + 3, &low) || low < 0xdc00 || low >= 0xe000)
+                            return 0;
+                        codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+                        str += 6;
+                    } else if ((codepoint >= 0xdc00 && codepoint < 0xe000) || codepoint == 0) {
+                        return 0;
+                    }
+                    char bytes[4];
+                    size_t count = 0;
+                    if (codepoint < 0x80) {
+                        bytes[count++] = codepoint;
+                    } else if (codepoint < 0x800) {
+                        bytes[count++] = 0xc0 | codepoint >> 6;
+                        bytes[count++] = 0x80 | (codepoint & 0x3f);
+                    } else if (codepoint < 0x10000) {
+                        bytes[count++] = 0xe0 | codepoint >> 12;
+                        bytes[count++] = 0x80 | (codepoint >> 6 & 0x3f);
+                        bytes[count++] = 0x80 | (codepoint & 0x3f);
+                    } else {
+                        bytes[count++] = 0xf0 | codepoint >> 18;
+                        bytes[count++] = 0x80 | (codepoint >> 12 & 0x3f);
+                        bytes[count++] = 0x80 | (codepoint >> 6 & 0x3f);
+                        bytes[count++] = 0x80 | (codepoint & 0x3f);
+                    }
+                    for (size_t i = 0; value && i < count; i++)
+                        if (!array_add(value, &bytes[i]))
+                            return 0;
+                    continue;
+                }
+                default:
+                    return 0;
+            }
+        }
+        if (value && !array_add(value, &c))
+            return 0;
+    }
+    return str + 1;
+}
+
+const char* serve_skip_json_value(const char* str, size_t depth) {
+    if (!str || depth > SERVE_JSON_DEPTH_MAX)
+        return 0;
+    if (*str == '"')
+        return serve_parse_json_string(str, 0);
+
+    // skip the members of objects and the elements of arrays
+    if (*str == '{' || *str == '[') {
+        const char close = *str == '{' ? '}' : ']';
+        str += 1 + strspn(str + 1, SERVE_JSON_WHITESPACE);
+        if (*str == close)
+            return str + 1;
+        while (true) {
+            if (close == '}') {
+                str = serve_parse_json_string(str, 0);
+                if (!str)
+                    return 0;
+                str += strspn(str, SERVE_JSON_WHITESPACE);
+                if (*str != ':')
+                    return 0;
+                str += 1 + strspn(str + 1, SERVE_JSON_WHITESPACE);
+            }
+            str = serve_skip_json_value(str, depth + 1);
+            if (!str)
+                return 0;
+            str += strspn(str, SERVE_JSON_WHITESPACE);
+            if (*str == close)
+                return str + 1;
+            if (*str != ',')
+                return 0;
+            str += 1 + strspn(str + 1, SERVE_JSON_WHITESPACE);
+        }
+    }
+
+    // skip literals and numbers
+    const char* const literals[] = { "true", "false", "null" };
+    for (size_t i = 0; i < sizeof(literals) / sizeof(*literals); i++) {
+        size_t length = strlen(literals[i]);
+        if (strncmp(str, literals[i], length) == 0)
+            return str + length;
+    }
+    if (*str == '-')
+        str++;
+    if (*str < '0' || *str > '9')
+        return 0;
+    while (*str >= '0' && *str <= '9')
+        str++;
+    if (*str == '.') {
+        if (*++str < '0' || *str > '9')
+            return 0;
+        while (*str >= '0' && *str <= '9')
+            str++;
+    }
+    if (*str == 'e' || *str == 'E') {
+        if (*++str == '+' || *str == '-')
+            str++;
+        if (*str < '0' || *str > '9')
+            return 0;
+        while (*str >= '0' && *str <= '9')
+            str++;
+    }
+    return str;
+}
+
+int serve_parse_request(const char* line, serve_request_t* request) {
+    if (!line || !request)
+        return 1;
+    *request = (serve_request_t){};
+    array_t args = array_create(0, sizeof(char), 0);
+    bool hasargs = false;
+    bool invalidargs = false;
+    int error = 0;
+
+    const char* str = line + strspn(line, SERVE_JSON_WHITESPACE);
+    if (*str != '{')
+        error = 2;
+    else
+        str += 1 + strspn(str + 1, SERVE_JSON_WHITESPACE);
+    for (bool first = true; !error && *str != '}'; first = false) {
+        if (!first) {
+            if (*str != ',') {
+                error = 2;
+                break;
+            }
+            str += 1 + strspn(str + 1, SERVE_JSON_WHITESPACE);
+        }
+
+        // read the member's key
+        array_t key = array_create(0, sizeof(char), 0);
+        str = serve_parse_json_string(str, &key);
+        if (str) {
+            str += strspn(str, SERVE_JSON_WHITESPACE);
+            str = *str == ':' ? str + 1 + strspn(str + 1, SERVE_JSON_WHITESPACE) : 0;
+        }
+        if (!str) {
+            array_free(&key, 0);
+            error = 2;
+            break;
+        }
+
+        // decode the arguments, copy the JSON text of the id and skip the other members
+        // arguments that are not a string are skipped and rejected after the object, hence an id behind them is still echoed
+        const char* value = str;
+        if (key.size == 4 && memcmp(key.data, "args", 4) == 0) {
+            if (*str != '"') {
+                invalidargs = true;
+                str = serve_skip_json_value(str, 0);
+            } else {
+                array_clear(&args);
+                str = serve_parse_json_string(str, &args);
+                hasargs = str != 0;
+            }
+        } else {
+            str = serve_skip_json_value(str, 0);
+            if (str && key.size == 2 && memcmp(key.data, "id", 2) == 0) {
+                if (*value == '{' || *value == '[') {
+                    error = 3;
+                } else {
+                    free(request->id);
+                    request->id = malloc(str - value + 1);
+                    if (request->id) {
+                        memcpy(request->id, value, str - value);
+                        request->id[str - value] = '\0';
+                    } else {
+                        error = 4;
+                    }
+                }
+            }
+        }
+        array_free(&key, 0);
+        if (!error && !str)
+            error = 2;
+        if (!error)
+            str += strspn(str, SERVE_JSON_WHITESPACE);
+    }
+    if (!error && str[1 + strspn(str + 1, SERVE_JSON_WHITESPACE)] != '\0')
+        error = 2;
+    if (!error && (invalidargs || !hasargs))
+        error = 3;
+
+    // null-terminate the arguments
+    char terminator = '\0';
+    if (!error && !array_add(&args, &terminator))
+        error = 4;
+    if (error) {
+        // the id parsed before the error is kept, hence the error response can be matched to the request
+        array_free(&args, 0);
+        return error;
+    }
+    request->args = args.data;
+    return 0;
+}
+
+void serve_board_free(serve_board_t* board) {
+    if (!board)
+        return;
+    free(board->args);
+    free(board->error);
+    game_free(&board->game);
+    free(board);
+}
+
+serve_board_t* serve_board_load(const char* args) {
+    if (!args)
+        return 0;
+    serve_board_t* board = calloc(1, sizeof(*board));
+    if (!board)
+        return 0;
+    board->args = strduplicate(args);
+    if (!board->args) {
+        free(board);
+        return 0;
+    }
+
+    // parse and validate the arguments in the daemon, hence it's game is kept between requests
+    libsals_args_t parsed = libsals_args_create_empty();
+    int error = libsals_args_parse_str(&parsed, args, strlen(args), SERVE_SUPPORTED_FLAGS, "in the requests of a daemon");
+    if (!error)
+        board->game = libsals_args_game_create(&parsed, &error);
+    if (error) {
+        board->error = strduplicate(parsed.error[0] ? parsed.error : "arguments do not describe a game");
+    } else {
+        board->dicelimit = parsed.options.dicelimit;
+        board->targetprecision = parsed.options.targetprecision;
+        board->simcount = parsed.options.simcount;
+        if ((parsed.setargsflags & CLIAFLAG_TARGET_PRECISION) && !(parsed.setargsflags & CLIAFLAG_ITERATIONS))
+            board->simcount = OPTVAL_ITERATIONS_MAX;
+        board->seeded = parsed.options.seeded;
+        board->seed = parsed.options.seed;
+    }
+    libsals_args_free(&parsed);
+    return board;
+}
+
+serve_board_t* serve_board_get(serve_t* server, const char* args, bool* cached) {
+    if (!server || !args || !cached)
+        return 0;
+    for (size_t i = 0; i < server->boards.size; i++) {
+        serve_board_t* board = *(serve_board_t**)array_get(&server->boards, i);
+        if (strcmp(board->args, args) == 0) {
+            board->lastused = server->requests;
+            *cached = true;
+            return board;
+        }
+    }
+    *cached = false;
+
+    // evict the least recently used board that is not simulated by a running job
+    if (server->boards.size >= SERVE_CACHE_CAPACITY) {
+        size_t evicted = server->boards.size;
+        for (size_t i = 0; i < server->boards.size; i++) {
+            serve_board_t* board = *(serve_board_t**)array_get(&server->boards, i);
+            if (board->jobs == 0 && (evicted == server->boards.size || board->lastused < (*(serve_board_t**)array_get(&server->boards, evicted))->lastused))
+                evicted = i;
+        }
+        if (evicted != server->boards.size) {
+            serve_board_free(*(serve_board_t**)array_get(&server->boards, evicted));
+            array_rmv(&server->boards, evicted);
+        }
+    }
+
+    serve_board_t* board = serve_board_load(args);
+    if (!board)
+        return 0;
+    board->lastused = server->requests;
+    if (!array_add(&server->boards, &board)) {
+        serve_board_free(board);
+        return 0;
+    }
+    return board;
+}
+
+serve_client_t* serve_client_create(int fd, FILE* out, bool owned) {
+    serve_client_t* client = malloc(sizeof(*client));
+    if (!client)
+        return 0;
+    *client = (serve_client_t){
+        .fd = fd,
+        .out = out,
+        .owned = owned,
+        .input = array_create(0, sizeof(char), 0),
+        .ended = false,
+        .broken = false,
+        .jobs = 0
+    };
+    return client;
+}
+
+void serve_client_free(serve_client_t* client) {
+    if (!client)
+        return;
+    // closing the stream closes the socket it was opened on as well
+    if (client->owned && client->out)
+        fclose(client->out);
+    else if (client->owned && client->fd >= 0)
+        close(client->fd);
+    array_free(&client->input, 0);
+    free(client);
+}
+
+void serve_job_free(serve_job_t* job) {
+    if (!job)
+        return;
+    free(job->id);
+    simulator_finish(&job->simulator);
+    simulator_free(&job->simulator);
+    array_free(&job->finished, 0);
+    free(job);
+}
+
+void serve_respond(serve_client_t* client, const char* id, const char* status, const char* error, bool cached, double elapsed, const stats_t* stats) {
+    if (!client || client->broken)
+        return;
+    fprintf(client->out, "{ \"id\": %s, \"status\": ", id ? id : "null");
+    report_print_json_string(client->out, status);
+    fprintf(client->out, ", \"error\": ");
+    if (error)
+        report_print_json_string(client->out, error);
+    else
+        fprintf(client->out, "null");
+    fprintf(client->out, ", \"cached\": %s, \"elapsed\": %.6lf", cached ? "true" : "false", elapsed);
+    report_print_stats(client->out, stats, REPORT_FORMAT_JSON);
+    fprintf(client->out, " }\n");
+    if (fflush(client->out) != 0 || ferror(client->out))
+        client->broken = true;
+}
+
+serve_t serve_create_empty() {
+    return (serve_t){
+        .endpoint = 0,
+        .pid = 0,
+        .listenfd = -1,
+        .wakefds = { -1, -1 },
+        .clients = array_create(0, sizeof(serve_client_t*), 0),
+        .boards = array_create(0, sizeof(serve_board_t*), 0),
+        .jobs = array_create(0, sizeof(serve_job_t*), 0),
+        .seed = 0,
+        .requests = 0,
+        .stopping = false,
+        .hassync = false,
+        .threads = 0,
+        .threadcount = 0
+    };
+}
+
+serve_t serve_create(const char* endpoint, size_t workers, int* error) {
+    serve_t server = serve_create_empty();
+    if (!endpoint) {
+        if (error)
+            *error = 1;
+        return server;
+    }
+    server.endpoint = endpoint;
+    server.pid = getpid();
+    server.seed = (uint64_t)time(0) ^ (uint64_t)server.pid << 32;
+    int err = 0;
+
+    // a client closing it's connection while a response is written must not terminate the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    // listen on the unix domain socket, replacing a stale socket whose daemon exited without removing it
+    if (strcmp(endpoint, SERVE_STDIO_ENDPOINT) != 0) {
+        struct sockaddr_un address = { .sun_family = AF_UNIX };
+        if (strlen(endpoint) >= sizeof(address.sun_path)) {
+            err = 2;
+        } else {
+            strcpy(address.sun_path, endpoint);
+            server.listenfd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (server.listenfd < 0)
+                err = 2;
+        }
+        if (!err && bind(server.listenfd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+            err = 2;
+            if (errno == EADDRINUSE) {
+                int probefd = socket(AF_UNIX, SOCK_STREAM, 0);
+                if (probefd >= 0 && connect(probefd, (struct sockaddr*)&address, sizeof(address)) == 0)
+                    err = 3;
+                else if (probefd >= 0 && errno == ECONNREFUSED && unlink(endpoint) == 0 && bind(server.listenfd, (struct sockaddr*)&address, sizeof(address)) == 0)
+                    err = 0;
+                if (probefd >= 0)
+                    close(probefd);
+            }
+        }
+        if (!err && listen(server.listenfd, SERVE_BACKLOG) != 0) {
+            unlink(endpoint);
+            err = 2;
+        }
+        if (err && server.listenfd >= 0) {
+            close(server.listenfd);
+            server.listenfd = -1;
+        }
+    }
+
+    // create the pipe the threads of the pool wake the daemon with when a job finished
+    if (!err) {
+        if (pipe(server.wakefds) != 0) {
+            server.wakefds[0] = server.wakefds[1] = -1;
+            err = 4;
+        } else if (fcntl(server.wakefds[0], F_SETFL, O_NONBLOCK) != 0 || fcntl(server.wakefds[1], F_SETFL, O_NONBLOCK) != 0) {
+            err = 4;
+        }
+    }
+    if (!err) {
+        bool hasmtx = mtx_init(&server.mtx, mtx_plain) == thrd_success;
+        server.hassync = hasmtx && cnd_init(&server.cnd) == thrd_success;
+        if (hasmtx && !server.hassync)
+            mtx_destroy(&server.mtx);
+        if (!server.hassync)
+            err = 4;
+    }
+    if (err) {
+        serve_free(&server);
+        if (error)
+            *error = err;
+        return server;
+    }
+
+    // allocate the pool with one thread per worker (or online processor), a job has at most that many workers
+    server.threadcount = simulator_worker_count(workers, SIZE_MAX);
+    server.threads = calloc(server.threadcount, sizeof(*server.threads));
+    if (!server.threads) {
+        serve_free(&server);
+        err = 5;
+    }
+    if (error)
+        *error = err;
+    return server;
+}
+
+bool serve_start(serve_t* server) {
+    if (!server || !server->threads)
+        return false;
+    for (size_t i = 0; i < server->threadcount; i++) {
+        server->threads[i] = (serve_thread_t){ .server = server, .index = i, .last = 0 };
+        server->threads[i].started = thrd_create(&server->threads[i].thread, (thrd_start_t)serve_thread_run, &server->threads[i]) == thrd_success;
+        if (!server->threads[i].started)
+            return false;
+    }
+    return true;
+}
+
+void serve_free(serve_t* server) {
+    if (!server)
+        return;
+    // stop the running jobs and wait until the threads of the pool exited
+    if (server->hassync) {
+        mtx_lock(&server->mtx);
+        for (size_t i = 0; i < server->jobs.size; i++)
+            atomic_store(&(*(serve_job_t**)array_get(&server->jobs, i))->simulator.stop, true);
+        server->stopping = true;
+        cnd_broadcast(&server->cnd);
+        mtx_unlock(&server->mtx);
+    }
+    for (size_t i = 0; server->threads && i < server->threadcount; i++)
+        if (server->threads[i].started)
+            thrd_join(server->threads[i].thread, 0);
+    free(server->threads);
+
+    for (size_t i = 0; i < server->jobs.size; i++)
+        serve_job_free(*(serve_job_t**)array_get(&server->jobs, i));
+    array_free(&server->jobs, 0);
+    for (size_t i = 0; i < server->boards.size; i++)
+        serve_board_free(*(serve_board_t**)array_get(&server->boards, i));
+    array_free(&server->boards, 0);
+    for (size_t i = 0; i < server->clients.size; i++)
+        serve_client_free(*(serve_client_t**)array_get(&server->clients, i));
+    array_free(&server->clients, 0);
+    if (server->hassync) {
+        cnd_destroy(&server->cnd);
+        mtx_destroy(&server->mtx);
+    }
+    if (server->wakefds[0] >= 0)
+        close(server->wakefds[0]);
+    if (server->wakefds[1] >= 0)
+        close(server->wakefds[1]);
+    if (server->listenfd >= 0) {
+        close(server->listenfd);
+        unlink(server->endpoint);
+    }
+    *server = serve_create_empty();
+}
+
+serve_job_t* serve_next_job(serve_t* server, const serve_thread_t* thread) {
+    if (!server || !thread)
+        return 0;
+    // take the first job after the one the thread ran it's last batch of, start over with the oldest job if there is none
+    serve_job_t* next = 0;
+    for (size_t i = 0; i < server->jobs.size; i++) {
+        serve_job_t* job = *(serve_job_t**)array_get(&server->jobs, i);
+        if (thread->index >= job->finished.size || *(bool*)array_get(&job->finished, thread->index))
+            continue;
+        if (job->number > thread->last)
+            return job;
+        if (!next)
+            next = job;
+    }
+    return next;
+}
+
+int serve_thread_run(serve_thread_t* thread) {
+    if (!thread)
+        return 1;
+    serve_t* const server = thread->server;
+    mtx_lock(&server->mtx);
+    while (true) {
+        serve_job_t* job = serve_next_job(server, thread);
+        if (!job) {
+            if (server->stopping)
+                break;
+            cnd_wait(&server->cnd, &server->mtx);
+            continue;
+        }
+        thread->last = job->number;
+        mtx_unlock(&server->mtx);
+
+        // run one batch of the job's worker with the worker's own stream of random numbers
+        worker_t* worker = array_get(&job->simulator.workers, thread->index);
+        tsseed48(&worker->seed);
+        size_t first = 0;
+        size_t last = 0;
+        const bool claimed = worker_claim(worker, &first, &last);
+        const int res = claimed ? worker_run_batch(worker, first, last) : 0;
+        if (res != 0)
+            atomic_store(&job->simulator.stop, true);
+        if (claimed && res == 0) {
+            worker->seed = tsgetseed48();
+            worker->hasseed = true;
+        } else {
+            worker_finish(worker);
+        }
+
+        mtx_lock(&server->mtx);
+        if (res != 0)
+            job->failed = true;
+        if (!claimed || res != 0) {
+            *(bool*)array_get(&job->finished, thread->index) = true;
+            // wake the daemon to answer the request, if the pipe is full the daemon is woken anyway
+            if (++job->finishedcount == job->finished.size) {
+                char byte = 0;
+                if (write(server->wakefds[1], &byte, 1) < 0) {}
+            }
+        }
+    }
+    mtx_unlock(&server->mtx);
+    return 0;
+}
+
+void serve_handle_request(serve_t* server, serve_client_t* client, const char* line) {
+    if (!server || !client || !line)
+        return;
+    stopwatch_t stopwatch = stopwatch_start();
+    server->requests++;
+    serve_request_t request;
+    int error = serve_parse_request(line, &request);
+    if (error) {
+        serve_respond(client, request.id, "invalid", error == 2 ? "request is not a JSON object" : error == 3 ? "member args missing or not a string, or member id not a scalar"
+            : "unable to allocate request", false, stopwatch_elapsed(&stopwatch), 0);
+        serve_request_free(&request);
+        return;
+    }
+
+    bool cached = false;
+    serve_board_t* board = serve_board_get(server, request.args, &cached);
+    if (!board || board->error) {
+        serve_respond(client, request.id, board ? "invalid" : "failed", board ? board->error : "unable to load board", cached, stopwatch_elapsed(&stopwatch), 0);
+        serve_request_free(&request);
+        return;
+    }
+
+    // create the job and hand it to the thread pool
+    serve_job_t* job = malloc(sizeof(*job));
+    if (job) {
+        *job = (serve_job_t){
+            .number = server->requests,
+            .client = client,
+            .board = board,
+            .id = request.id,
+            .cached = cached,
+            .stopwatch = stopwatch,
+            .simulator = simulator_create_empty(),
+            .finishedcount = 0,
+            .failed = false
+        };
+        request.id = 0;
+        simulator_init(&job->simulator, &board->game, board->simcount, server->threadcount, board->dicelimit, board->targetprecision, 0.0);
+        // the threads of the pool outlive the jobs, hence the workers of unseeded jobs get their own streams of random numbers
+        // instead of reseeding the threads with the time (see tsnewseed48)
+        if (board->seeded) {
+            simulator_seed(&job->simulator, board->seed);
+            simulator_shard(&job->simulator, 0, 1);
+        } else {
+            for (size_t i = 0; i < job->simulator.workers.size; i++) {
+                worker_t* worker = array_get(&job->simulator.workers, i);
+                worker->seed = tsderiveseed48(server->seed, job->number * server->threadcount + i);
+                worker->hasseed = true;
+            }
+        }
+        simulator_prepare(&job->simulator);
+        job->finished = array_create(job->simulator.workers.size, sizeof(bool), 0);
+        bool unfinished = false;
+        for (size_t i = 0; i < job->simulator.workers.size; i++)
+            if (!array_add(&job->finished, &unfinished))
+                break;
+    }
+    mtx_lock(&server->mtx);
+    bool added = job && job->finished.size == job->simulator.workers.size && array_add(&server->jobs, &job);
+    if (added)
+        cnd_broadcast(&server->cnd);
+    mtx_unlock(&server->mtx);
+    if (!added) {
+        serve_respond(client, job ? job->id : request.id, "failed", "unable to create job", cached, stopwatch_elapsed(&stopwatch), 0);
+        serve_job_free(job);
+        serve_request_free(&request);
+        return;
+    }
+    client->jobs++;
+    board->jobs++;
+    serve_request_free(&request);
+}
+
+void serve_collect(serve_t* server) {
+    if (!server)
+        return;
+    // take the jobs whose workers finished out of the pool, the threads don't reference them anymore
+    array_t finished = array_create(0, sizeof(serve_job_t*), 0);
+    mtx_lock(&server->mtx);
+    for (size_t i = 0; i < server->jobs.size; i++) {
+        serve_job_t* job = *(serve_job_t**)array_get(&server->jobs, i);
+        if (job->finishedcount == job->finished.size && array_add(&finished, &job))
+            array_rmv(&server->jobs, i--);
+    }
+    mtx_unlock(&server->mtx);
+
+    // answer the finished jobs in the order of their arrival
+    for (size_t i = 0; i < finished.size; i++) {
+        serve_job_t* job = *(serve_job_t**)array_get(&finished, i);
+        job->simulator.elapsed = stopwatch_elapsed(&job->stopwatch);
+        stats_t stats = stats_create();
+        if (job->failed) {
+            serve_respond(job->client, job->id, "failed", "unable to run simulations", job->cached, job->simulator.elapsed, 0);
+        } else if (!stats_collect(&stats, &job->simulator)) {
+            serve_respond(job->client, job->id, "failed", "unable to collect statistics", job->cached, job->simulator.elapsed, 0);
+        } else {
+            stats.interrupted = job->simulator.interrupted;
+            serve_respond(job->client, job->id, job->simulator.interrupted ? "interrupted" : "ok", 0, job->cached, job->simulator.elapsed, &stats);
+        }
+        stats_free(&stats);
+        job->client->jobs--;
+        job->board->jobs--;
+        serve_job_free(job);
+    }
+    array_free(&finished, 0);
+}
+
+void serve_read_client(serve_t* server, serve_client_t* client) {
+    if (!server || !client || client->ended)
+        return;
+    char buffer[SERVE_READ_BUFFER_SIZE];
+    ssize_t count = read(client->fd, buffer, sizeof(buffer));
+    if (count < 0 && (errno == EINTR || errno == EAGAIN))
+        return;
+    if (count <= 0) {
+        // handle a last request that is not terminated by a line break
+        client->ended = true;
+        if (client->input.size == 0)
+            return;
+        buffer[0] = '\n';
+        count = 1;
+    }
+
+    // handle every complete request line, empty lines are skipped
+    for (ssize_t i = 0; i < count; i++) {
+        if (buffer[i] != '\n') {
+            if (client->input.size < SERVE_REQUEST_SIZE_MAX && !array_add(&client->input, &buffer[i])) {
+                serve_respond(client, 0, "failed", "unable to allocate request", false, 0.0, 0);
+                client->ended = true;
+                return;
+            }
+            continue;
+        }
+        char terminator = '\0';
+        if (client->input.size >= SERVE_REQUEST_SIZE_MAX)
+            serve_respond(client, 0, "invalid", "request too large", false, 0.0, 0);
+        else if (client->input.size != 0 && array_add(&client->input, &terminator))
+            serve_handle_request(server, client, client->input.data);
+        array_clear(&client->input);
+    }
+}
+
+int serve_run(serve_t* server) {
+    if (!server || !server->threads)
+        return 1;
+    if (!serve_start(server))
+        return 3;
+
+    // serve stdin and stdout as the only client
+    if (server->listenfd < 0) {
+        serve_client_t* client = serve_client_create(STDIN_FILENO, stdout, false);
+        if (!client || !array_add(&server->clients, &client)) {
+            serve_client_free(client);
+            return 2;
+        }
+    }
+
+    array_t fds = array_create(0, sizeof(struct pollfd), 0);
+    array_t polled = array_create(0, sizeof(serve_client_t*), 0);
+    bool interrupted = false;
+    int res = 0;
+    while (true) {
+        // stop all running jobs at the first SIGINT or SIGTERM and answer them with their partial statistics
+        if (!interrupted && interrupt_requested()) {
+            interrupted = true;
+            mtx_lock(&server->mtx);
+            for (size_t i = 0; i < server->jobs.size; i++) {
+                serve_job_t* job = *(serve_job_t**)array_get(&server->jobs, i);
+                job->simulator.interrupted = true;
+                atomic_store(&job->simulator.stop, true);
+            }
+            mtx_unlock(&server->mtx);
+            for (size_t i = 0; i < server->clients.size; i++)
+                (*(serve_client_t**)array_get(&server->clients, i))->ended = true;
+        }
+        serve_collect(server);
+
+        // stop the jobs of clients that can't receive their responses and close clients without requests
+        bool precision = false;
+        for (size_t i = 0; i < server->jobs.size; i++) {
+            serve_job_t* job = *(serve_job_t**)array_get(&server->jobs, i);
+            if (job->client->broken)
+                atomic_store(&job->simulator.stop, true);
+            else if (job->simulator.targetprecision > 0.0 && !simulator_check_precision(&job->simulator))
+                precision = true;
+        }
+        for (size_t i = 0; i < server->clients.size; i++) {
+            serve_client_t* client = *(serve_client_t**)array_get(&server->clients, i);
+            if ((client->ended || client->broken) && client->jobs == 0) {
+                serve_client_free(client);
+                array_rmv(&server->clients, i--);
+            }
+        }
+        if (server->clients.size == 0 && (server->listenfd < 0 || interrupted))
+            break;
+
+        // wait for requests, connections and finished jobs, check the target precisions of the running jobs in the coordinator interval
+        array_clear(&fds);
+        array_clear(&polled);
+        bool added = array_add(&fds, &(struct pollfd){ server->wakefds[0], POLLIN, 0 });
+        if (server->listenfd >= 0 && !interrupted)
+            added = added && array_add(&fds, &(struct pollfd){ server->listenfd, POLLIN, 0 });
+        for (size_t i = 0; added && i < server->clients.size; i++) {
+            serve_client_t* client = *(serve_client_t**)array_get(&server->clients, i);
+            if (!client->ended && !client->broken)
+                added = array_add(&fds, &(struct pollfd){ client->fd, POLLIN, 0 }) && array_add(&polled, &client);
+        }
+        if (!added) {
+            res = 2;
+            break;
+        }
+        int timeout = precision ? SIMULATOR_COORDINATOR_INTERVAL_NS / 1000000 : SERVE_IDLE_INTERVAL_MS;
+        if (poll(fds.data, fds.size, timeout) < 0) {
+            if (errno == EINTR)
+                continue;
+            res = 2;
+            break;
+        }
+
+        // drain the wake pipe, the finished jobs are collected in the next iteration
+        char buffer[SERVE_READ_BUFFER_SIZE];
+        struct pollfd* wakefd = array_get(&fds, 0);
+        if (wakefd->revents)
+            while (read(server->wakefds[0], buffer, sizeof(buffer)) > 0);
+        size_t clientsoffset = 1;
+        if (server->listenfd >= 0 && !interrupted) {
+            clientsoffset = 2;
+            struct pollfd* listenfd = array_get(&fds, 1);
+            if (listenfd->revents & POLLIN) {
+                int fd = accept(server->listenfd, 0, 0);
+                FILE* out = fd >= 0 ? fdopen(fd, "w") : 0;
+                serve_client_t* client = out ? serve_client_create(fd, out, true) : 0;
+                if (!client || !array_add(&server->clients, &client)) {
+                    if (client)
+                        serve_client_free(client);
+                    else if (out)
+                        fclose(out);
+                    else if (fd >= 0)
+                        close(fd);
+                }
+            }
+        }
+        for (size_t i = 0; i < polled.size; i++)
+            if (((struct pollfd*)array_get(&fds, clientsoffset + i))->revents)
+                serve_read_client(server, *(serve_client_t**)array_get(&polled, i));
+    }
+    array_free(&fds, 0);
+    array_free(&polled, 0);
+    return res;
+}
@@ -1,22 +1,28 @@
 #include "simulator.h"
 
-#include "assetmanager.h"
+#include "checkpoint.h"
 #include "cvts.h"
+#include "interrupt.h"
 #include "loadingscreen.h"
+#include "stopwatch.h"
 #include "tsrand48.h"
 
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
 
 simulation_t simulation_create_empty() {
     return (simulation_t){};
 }
 
-simulation_t simulation_create(simulator_t* simulator) {
+simulation_t simulation_create(const simulator_t* simulator) {
     if (!simulator)
         return simulation_create_empty();
     simulation_t sim = {
         .simulator = simulator,
-        .soluses = array_create(simulator->soldsts.size, sizeof(size_t), 0),
+        .soluses = array_create(simulator->game->soldsts.size, sizeof(size_t), 0),
         .dices = array_create(0, sizeof(size_t), 0)
     };
     size_t inituseval = 0;
@@ -37,122 +43,609 @@ void simulation_free(simulation_t* simulation) {
     *simulation = simulation_create_empty();
 }
 
+void simulation_reset(simulation_t* simulation) {
+    if (!simulation)
+        return;
+    simulation->aborted = false;
+    simulation->playerpos = 0;
+    for (size_t i = 0; i < simulation->soluses.size; i++)
+        *(size_t*)array_get(&simulation->soluses, i) = 0;
+    array_clear(&simulation->dices);
+}
+
+worker_t worker_create_empty() {
+    return (worker_t){ .sim = simulation_create_empty(), .stats = stats_create(), .records = records_producer_create_empty(), .perf = perfcounters_create_empty() };
+}
+
+worker_t worker_create(simulator_t* simulator) {
+    if (!simulator)
+        return worker_create_empty();
+    worker_t worker = {
+        .simulator = simulator,
+        .sim = simulation_create(simulator),
+        .stats = stats_create(),
+        .records = records_producer_create_empty(),
+        .perf = perfcounters_create_empty()
+    };
+    if (worker.sim.soluses.size != simulator->game->soldsts.size || !stats_init(&worker.stats, simulator)) {
+        worker_free(&worker);
+        return worker_create_empty();
+    }
+    return worker;
+}
+
+void worker_free(worker_t* worker) {
+    if (!worker)
+        return;
+    simulation_free(&worker->sim);
+    stats_free(&worker->stats);
+    records_producer_free(&worker->records);
+    *worker = worker_create_empty();
+}
+
+bool worker_claim(worker_t* worker, size_t* first, size_t* last) {
+    if (!worker || !first || !last)
+        return false;
+    simulator_t* const simulator = worker->simulator;
+    if (atomic_load(&simulator->pause))
+        worker_pause(worker);
+    if (atomic_load(&simulator->stop))
+        return false;
+    if (simulator->seeded) {
+        // continue the worker's own batch (the rest of it if it was interrupted)
+        *first = worker->next;
+        if (*first >= simulator->simcount)
+            return false;
+        *last = (*first / SIMULATOR_BATCH_SIZE + 1) * SIMULATOR_BATCH_SIZE;
+    } else {
+        *first = atomic_fetch_add(&simulator->nextsim, SIMULATOR_BATCH_SIZE);
+        if (*first >= simulator->simcount)
+            return false;
+        *last = *first + SIMULATOR_BATCH_SIZE;
+    }
+    if (*last > simulator->simcount)
+        *last = simulator->simcount;
+    return true;
+}
+
+void worker_pause(worker_t* worker) {
+    if (!worker)
+        return;
+    simulator_t* const simulator = worker->simulator;
+    worker->seed = tsgetseed48();
+    worker->hasseed = true;
+    const struct timespec interval = { .tv_sec = 0, .tv_nsec = SIMULATOR_PAUSE_INTERVAL_NS };
+    atomic_fetch_add(&simulator->pausedworkers, 1);
+    while (atomic_load(&simulator->pause))
+        thrd_sleep(&interval, 0);
+    atomic_fetch_sub(&simulator->pausedworkers, 1);
+}
+
+int worker_run_batch(worker_t* worker, size_t first, size_t last) {
+    if (!worker)
+        return 1;
+    simulator_t* const simulator = worker->simulator;
+    int res = 0;
+    valstats_t batchdices = valstats_create();
+    size_t i = first;
+    for (; i < last && res == 0 && !atomic_load_explicit(&simulator->stop, memory_order_relaxed); i++) {
+        // roll the die of a seeded simulation with the stream of it's index
+        if (simulator->seeded) {
+            tsseed48_t seed = tsderiveseed48(simulator->seed, i);
+            tsseed48(&seed);
+        }
+        // discard the simulation if it was interrupted
+        worker->sim.index = i;
+        if (simulation_run(&worker->sim) != 0)
+            break;
+        valstats_add(&batchdices, worker->sim.dices.size);
+        if (worker->counter) {
+            atomic_fetch_add_explicit(&worker->counter->games, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&worker->counter->dices, worker->sim.dices.size, memory_order_relaxed);
+        }
+        if (!stats_add(&worker->stats, &worker->sim))
+            res = 2;
+        else if (!records_producer_add(&worker->records, &worker->sim, i))
+            res = 3;
+    }
+    // continue with the interrupted simulation or the worker's next batch
+    if (simulator->seeded)
+        worker->next = i < last ? i : (first / SIMULATOR_BATCH_SIZE + simulator->workers.size * simulator->shardcount) * SIMULATOR_BATCH_SIZE;
+    // hand the records off to the writer once enough batches were collected
+    records_producer_flush(&worker->records, false);
+    if (res != 0)
+        return res;
+    // publish the finished batch and stop the other workers right away once the target precision is reached
+    // instead of waiting for the coordinator's next check
+    if (simulator->targetprecision > 0.0) {
+        mtx_lock(&simulator->progressmtx);
+        valstats_merge(&simulator->progress, &batchdices);
+        const bool reached = simulator_precision_reached(&simulator->progress, simulator->targetprecision);
+        mtx_unlock(&simulator->progressmtx);
+        if (reached)
+            atomic_store(&simulator->stop, true);
+    }
+    return 0;
+}
+
+void worker_finish(worker_t* worker) {
+    if (!worker)
+        return;
+    records_producer_flush(&worker->records, true);
+    worker->seed = tsgetseed48();
+    worker->hasseed = true;
+    atomic_fetch_sub(&worker->simulator->activeworkers, 1);
+}
+
+int worker_run(worker_t* worker) {
+    if (!worker)
+        return 1;
+
+    // seed thread local rand48 random number generator for the die (continuing the stream of a restored worker)
+    if (worker->hasseed)
+        tsseed48(&worker->seed);
+    else
+        tsnewseed48();
+
+    // count the hardware events of the worker's thread (the simulator already reported if they can't be counted)
+    const size_t gamesbefore = worker->stats.sims;
+    const size_t dicesbefore = worker->stats.dices.sum;
+    if (worker->simulator->perfcounters)
+        perfcounters_open(&worker->perf, false);
+
+    // claim batches of simulations until all simulations were claimed or the simulator was stopped
+    stopwatch_t stopwatch = stopwatch_start();
+    int res = 0;
+    size_t first;
+    size_t last;
+    while (res == 0 && worker_claim(worker, &first, &last))
+        res = worker_run_batch(worker, first, last);
+    worker->elapsed += stopwatch_elapsed(&stopwatch);
+
+    if (worker->simulator->perfcounters) {
+        perfcounters_stop(&worker->perf);
+        worker->perf.games += worker->stats.sims - gamesbefore;
+        worker->perf.dices += worker->stats.dices.sum - dicesbefore;
+    }
+
+    worker_finish(worker);
+    return res;
+}
+
 simulator_t simulator_create_empty() {
     return (simulator_t){ 
         .game = 0,
         .dicelimit = 0,
-        .soldsts = array_create(0, sizeof(size_t), 0),
-        .solidxs = array_create(0, sizeof(optional_size_t), 0),
-        .sims = array_create(0, sizeof(simulation_t), 0)
+        .simcount = 0,
+        .targetprecision = 0.0,
+        .timelimit = 0.0,
+        .elapsed = 0.0,
+        .setupelapsed = 0.0,
+        .nextsim = 0,
+        .stop = false,
+        .pause = false,
+        .pausedworkers = 0,
+        .seeded = false,
+        .seed = 0,
+        .shard = 0,
+        .shardcount = 1,
+        .activeworkers = 0,
+        .hasprogressmtx = false,
+        .progress = valstats_create(),
+        .counters = 0,
+        .workers = array_create(0, sizeof(worker_t), 0),
+        .records = 0,
+        .perfcounters = false,
+        .perf = perfcounters_create_empty()
     };
 }
 
-simulator_t simulator_create(const game_t* game, size_t simcount, size_t dicelimit) {
+bool simulator_init(simulator_t* simulator, const game_t* game, size_t simcount, size_t workers, size_t dicelimit, double targetprecision, double timelimit) {
+    if (!simulator)
+        return false;
+    *simulator = simulator_create_empty();
     if (!game || simcount == 0)
-        return simulator_create_empty();
-
-    simulator_t simulator = (simulator_t){
-        .game = game,
-        .dicelimit = dicelimit,
-        .soldsts = array_create(0, sizeof(size_t), 0),
-        .solidxs = array_create(game->adjmat.vertex_count, sizeof(optional_size_t), 0),
-        .sims = array_create(simcount, sizeof(simulation_t), 0)
-    };
+        return false;
 
-    // store the game's snakes and ladders in the simulator's soldsts and solidxs arrays
-    const adjmat_t* adjmat = &simulator.game->adjmat;
-    for (size_t cell = 0; cell < adjmat->vertex_count; cell++) {
-        // determine optional snake or ladder destination from current cell
-        optional_size_t solidx = {};
-        size_t soldst = 0;
-        for (size_t j = 0; !solidx.present && j < adjmat->vertex_count; j++) {
-            if (adjmat->edges[cell * adjmat->vertex_count + j] > 0) {
-                solidx = (optional_size_t){ true, simulator.soldsts.size };
-                soldst = j;
-            }
-        }
-        // add snake or ladder index for current cell to solidxs array and if present add snake or ladder destination to soldsts array
-        if (!array_add(&simulator.solidxs, &solidx) || (solidx.present && !array_add(&simulator.soldsts, &soldst)))
-            simulator_free(&simulator);
-    }
+    size_t workercount = simulator_worker_count(workers, simcount);
+    // the simulator, it's workers and their simulations are accounted to the simulator subsystem (their statistics to the stats subsystem)
+    const allocations_subsystem_t previous = allocations_set_subsystem(ALLOCATIONS_SUBSYSTEM_SIMULATOR);
+    simulator->game = game;
+    simulator->dicelimit = dicelimit;
+    simulator->simcount = simcount;
+    simulator->targetprecision = targetprecision;
+    simulator->timelimit = timelimit;
+    simulator->workers = array_create(workercount, sizeof(worker_t), 0);
 
-    // initialize simulations
-    for (size_t i = 0; i < simcount; i++) {
-        simulation_t sim = simulation_create(&simulator);
-        if (!array_add(&simulator.sims, &sim)) {
-            simulation_free(&sim);
-            simulator_free(&simulator);
+    // initialize workers referencing the given simulator
+    for (size_t i = 0; i < workercount; i++) {
+        worker_t worker = worker_create(simulator);
+        worker.next = i * SIMULATOR_BATCH_SIZE;
+        if (!worker.simulator || !array_add(&simulator->workers, &worker)) {
+            worker_free(&worker);
+            simulator_free(simulator);
+            allocations_set_subsystem(previous);
+            return false;
         }
     }
 
-    return simulator;
+    allocations_set_subsystem(previous);
+    return true;
+}
+
+void simulator_seed(simulator_t* simulator, uint64_t seed) {
+    if (!simulator)
+        return;
+    simulator->seeded = true;
+    simulator->seed = seed;
+}
+
+void simulator_shard(simulator_t* simulator, size_t shard, size_t shardcount) {
+    if (!simulator || !simulator->seeded || shard >= shardcount)
+        return;
+    simulator->shard = shard;
+    simulator->shardcount = shardcount;
+    // worker i starts with the i-th batch of the shard
+    for (size_t i = 0; i < simulator->workers.size; i++)
+        ((worker_t*)array_get(&simulator->workers, i))->next = (i * shardcount + shard) * SIMULATOR_BATCH_SIZE;
 }
 
 void simulator_free(simulator_t* simulator) {
     if (!simulator)
         return;
-    array_free(&simulator->soldsts, 0);
-    array_free(&simulator->solidxs, 0);
-    array_free(&simulator->sims, (element_fn_t)simulation_free);
+    array_free(&simulator->workers, (element_fn_t)worker_free);
     *simulator = simulator_create_empty();
 }
 
-simulator_t simulate(const game_t* game, size_t simcount, size_t dicelimit) {
+size_t simulator_worker_count(size_t workers, size_t simcount) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t workercount = workers > 0 ? workers : cpus > 0 ? (size_t)cpus : 1;
+    return workercount < simcount ? workercount : simcount;
+}
+
+void simulator_pause(simulator_t* simulator) {
+    if (!simulator)
+        return;
+    atomic_store(&simulator->pause, true);
+    // a worker that did not finish yet either pauses before claiming it's next batch or finishes,
+    // the paused workers can't continue until the flag is cleared, hence the counts are equal exactly when all are paused or finished
+    const struct timespec interval = { .tv_sec = 0, .tv_nsec = SIMULATOR_PAUSE_INTERVAL_NS };
+    while (atomic_load(&simulator->pausedworkers) != atomic_load(&simulator->activeworkers))
+        thrd_sleep(&interval, 0);
+}
+
+void simulator_continue(simulator_t* simulator) {
+    if (!simulator)
+        return;
+    atomic_store(&simulator->pause, false);
+}
+
+bool simulator_precision_reached(const valstats_t* progress, double targetprecision) {
+    if (!progress || targetprecision <= 0.0 || progress->count < SIMULATOR_PRECISION_MIN_SIMS)
+        return false;
+    valstats_t finalized = *progress;
+    valstats_finalize(&finalized);
+    return finalized.ci95 <= targetprecision;
+}
+
+bool simulator_check_precision(simulator_t* simulator) {
+    if (!simulator || simulator->targetprecision <= 0.0)
+        return false;
+    mtx_lock(&simulator->progressmtx);
+    const bool reached = simulator_precision_reached(&simulator->progress, simulator->targetprecision);
+    mtx_unlock(&simulator->progressmtx);
+    if (!reached)
+        return false;
+    atomic_store(&simulator->stop, true);
+    return true;
+}
+
+void simulator_prepare(simulator_t* simulator) {
+    if (!simulator)
+        return;
+    for (size_t i = 0; i < simulator->workers.size; i++) {
+        worker_t* worker = array_get(&simulator->workers, i);
+        worker->simulator = simulator;
+        worker->sim.simulator = simulator;
+        worker->records.records = simulator->records;
+    }
+    // pad the progress counters of every worker to it's own cache line (the size is a multiple of the alignment as required by aligned_alloc)
+    simulator->counters = simulator->workers.size > 0
+        ? allocations_aligned_alloc(ALLOCATIONS_SUBSYSTEM_SIMULATOR, SIMULATOR_CACHE_LINE_SIZE, simulator->workers.size * sizeof(simulator_counter_t)) : 0;
+    for (size_t i = 0; simulator->counters && i < simulator->workers.size; i++) {
+        worker_t* worker = array_get(&simulator->workers, i);
+        atomic_init(&simulator->counters[i].games, worker->stats.sims);
+        atomic_init(&simulator->counters[i].dices, worker->stats.dices.sum);
+        worker->counter = &simulator->counters[i];
+    }
+    simulator->hasprogressmtx = mtx_init(&simulator->progressmtx, mtx_plain) == thrd_success;
+    if (!simulator->hasprogressmtx && simulator->targetprecision > 0.0) {
+        fprintf(stderr, "%swarning:%s unable to initialize progress mutex, ignoring target precision.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT));
+        simulator->targetprecision = 0.0;
+    }
+    atomic_store(&simulator->activeworkers, simulator->workers.size);
+}
+
+void simulator_finish(simulator_t* simulator) {
+    if (!simulator)
+        return;
+    for (size_t i = 0; simulator->counters && i < simulator->workers.size; i++)
+        ((worker_t*)array_get(&simulator->workers, i))->counter = 0;
+    allocations_free(ALLOCATIONS_SUBSYSTEM_SIMULATOR, simulator->counters, simulator->workers.size * sizeof(simulator_counter_t));
+    simulator->counters = 0;
+    if (!simulator->hasprogressmtx)
+        return;
+    mtx_destroy(&simulator->progressmtx);
+    simulator->hasprogressmtx = false;
+}
+
+void simulator_read_progress(const simulator_t* simulator, loadingscreen_progress_t* progress) {
+    if (!simulator || !progress)
+        return;
+    *progress = (loadingscreen_progress_t){ .timelimit = simulator->timelimit };
+    // a shard only runs every shardcount-th batch of the simulations
+    if (simulator->simcount != SIZE_MAX)
+        progress->total = simulator->shardcount > 1 ? (simulator->simcount + simulator->shardcount - 1) / simulator->shardcount : simulator->simcount;
+    for (size_t i = 0; simulator->counters && i < simulator->workers.size; i++) {
+        progress->games += atomic_load_explicit(&simulator->counters[i].games, memory_order_relaxed);
+        progress->dices += atomic_load_explicit(&simulator->counters[i].dices, memory_order_relaxed);
+    }
+}
+
+int simulator_pool_thread_run(simulator_pool_thread_t* thread) {
+    if (!thread)
+        return 1;
+    int res = 0;
+    for (size_t i = 0; i < thread->simulators->size; i++) {
+        simulator_t* simulator = *(simulator_t* const*)array_getconst(thread->simulators, i);
+        if (thread->index >= simulator->workers.size)
+            continue;
+        if (worker_run(array_get(&simulator->workers, thread->index)) != 0)
+            res = 2;
+    }
+    return res;
+}
+
+int simulator_pool_run(const array_t* simulators) {
+    if (!simulators)
+        return 1;
+
+    // prepare the simulators and determine the size of the thread pool
+    size_t threadcount = 0;
+    for (size_t i = 0; i < simulators->size; i++) {
+        simulator_t* simulator = *(simulator_t* const*)array_getconst(simulators, i);
+        simulator_prepare(simulator);
+        if (threadcount < simulator->workers.size)
+            threadcount = simulator->workers.size;
+    }
+    const size_t threadsize = (threadcount ? threadcount : 1) * sizeof(simulator_pool_thread_t);
+    simulator_pool_thread_t* threads = allocations_calloc(ALLOCATIONS_SUBSYSTEM_SIMULATOR, threadcount ? threadcount : 1, sizeof(*threads));
+    if (!threads) {
+        for (size_t i = 0; i < simulators->size; i++)
+            simulator_finish(*(simulator_t* const*)array_getconst(simulators, i));
+        return 2;
+    }
+
+    // start the thread pool
+    for (size_t i = 0; i < threadcount; i++) {
+        threads[i] = (simulator_pool_thread_t){ .simulators = simulators, .index = i };
+        threads[i].started = thrd_create(&threads[i].thread, (thrd_start_t)simulator_pool_thread_run, &threads[i]) == thrd_success;
+        // run the thread's workers on the calling thread if it could not be started so all simulations get claimed
+        if (!threads[i].started) {
+            fprintf(stderr, "%swarning:%s unable to start pool thread %lu.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i);
+            simulator_pool_thread_run(&threads[i]);
+        }
+    }
+
+    // coordinate the workers by checking the stopping criteria of all simulators and signals until all workers finished
+    const struct timespec interval = { .tv_sec = 0, .tv_nsec = SIMULATOR_COORDINATOR_INTERVAL_NS };
+    bool active = true;
+    while (active) {
+        active = false;
+        const bool interrupted = interrupt_requested();
+        for (size_t i = 0; i < simulators->size; i++) {
+            simulator_t* simulator = *(simulator_t* const*)array_getconst(simulators, i);
+            if (atomic_load(&simulator->activeworkers) == 0)
+                continue;
+            // stop every unfinished simulator at the next game boundary
+            if (interrupted) {
+                simulator->interrupted = true;
+                atomic_store(&simulator->stop, true);
+                continue;
+            }
+            if (!simulator_check_precision(simulator))
+                active = true;
+        }
+        if (active)
+            thrd_sleep(&interval, 0);
+    }
+
+    // wait until all threads finished
+    for (size_t i = 0; i < threadcount; i++) {
+        if (!threads[i].started)
+            continue;
+        int threadres = 0;
+        thrd_join(threads[i].thread, &threadres);
+        if (threadres != 0)
+            fprintf(stderr, "%swarning:%s pool thread %lu unexpectedly returned %d.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i, threadres);
+    }
+    allocations_free(ALLOCATIONS_SUBSYSTEM_SIMULATOR, threads, threadsize);
+
+    for (size_t i = 0; i < simulators->size; i++)
+        simulator_finish(*(simulator_t* const*)array_getconst(simulators, i));
+    return 0;
+}
+
+simulate_options_t simulate_options_create() {
+    return (simulate_options_t){
+        .simcount = 0,
+        .workers = 0,
+        .dicelimit = 0,
+        .targetprecision = 0.0,
+        .timelimit = 0.0,
+        .records = 0,
+        .checkpoint = 0,
+        .seed = 0,
+        .shard = 0,
+        .shardcount = 1,
+        .progress = 0,
+        .perfcounters = false
+    };
+}
+
+void simulate(simulator_t* simulator, const game_t* game, const simulate_options_t* options) {
+    if (!simulator)
+        return;
+    if (!options) {
+        *simulator = simulator_create_empty();
+        return;
+    }
     // create simulator and loading screen
-    simulator_t simulator = simulator_create(game, simcount, dicelimit);
-    assetmanager_add(&simulator, (deallocator_fn_t)simulator_free);
+    stopwatch_t setupstopwatch = stopwatch_start();
+    simulator_init(simulator, game, options->simcount, options->workers, options->dicelimit, options->targetprecision, options->timelimit);
+    simulator->records = options->records;
+    if (options->progress)
+        simulator->progress = *options->progress;
+    if (options->seed) {
+        simulator_seed(simulator, *options->seed);
+        simulator_shard(simulator, options->shard, options->shardcount);
+    }
+    checkpoint_t* const checkpoint = options->checkpoint && options->checkpoint->filepath ? options->checkpoint : 0;
+
+    // continue the simulations from the checkpoint (the elapsed time of the simulator is restored as well)
+    if (checkpoint && checkpoint->resume)
+        checkpoint_resume(checkpoint, simulator);
+    const double elapsedbefore = simulator->elapsed;
     #ifdef DEBUG
-    simulator_print(&simulator, 0, false);
+    simulator_print(simulator, 0, false);
     #endif
-    loadingscreen_t loadscreen = loadingscreen_create("Simulating");
+    loadingscreen_t loadscreen = loadingscreen_create("Simulating", (loadingscreen_progress_fn_t)simulator_read_progress, simulator);
 
-    // start rendering loading screen
+    // prepare workers and publishing of their progress
+    simulator_prepare(simulator);
+    simulator->setupelapsed = stopwatch_elapsed(&setupstopwatch);
+
+    // start rendering loading screen (after the progress counters were prepared)
     loadingscreen_start(&loadscreen);
 
-    // start simulations
-    for (size_t i = 0; i < simulator.sims.size; i++) {
-        simulation_t* sim = array_get(&simulator.sims, i);
-        int simres = thrd_create(&sim->thread, (thrd_start_t)simulation_run, sim);
-        switch (simres) {
+    // count the hardware events of the calling thread and the worker threads started afterwards
+    size_t gamesbefore = 0;
+    size_t dicesbefore = 0;
+    for (size_t i = 0; i < simulator->workers.size; i++) {
+        const worker_t* worker = array_getconst(&simulator->workers, i);
+        gamesbefore += worker->stats.sims;
+        dicesbefore += worker->stats.dices.sum;
+    }
+    if (options->perfcounters) {
+        int perferror = perfcounters_open(&simulator->perf, true);
+        if (perferror)
+            fprintf(stderr, "%swarning:%s unable to count hardware events. %s. simulating without performance counters.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT),
+                perfcounters_strerror(perferror));
+        simulator->perfcounters = perferror == 0;
+    }
+
+    // start the clock for the time limit and throughput
+    stopwatch_t stopwatch = stopwatch_start();
+
+    // start workers
+    for (size_t i = 0; i < simulator->workers.size; i++) {
+        worker_t* worker = array_get(&simulator->workers, i);
+        int workerres = thrd_create(&worker->thread, (thrd_start_t)worker_run, worker);
+        switch (workerres) {
             case thrd_success:
                 break;
             case thrd_nomem:
-                fprintf(stderr, "%swarning:%s unable to allocate memory for simulation thread %lu.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i);
+                fprintf(stderr, "%swarning:%s unable to allocate memory for worker thread %lu.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i);
                 break;
             case thrd_error:
-                fprintf(stderr, "%swarning:%s unable to start simulation thread %lu.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i);
+                fprintf(stderr, "%swarning:%s unable to start worker thread %lu.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i);
                 break;
             default:
-                fprintf(stderr, "%swarning:%s unable to start simulation thread %lu for unexpected reason.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i);
+                fprintf(stderr, "%swarning:%s unable to start worker thread %lu for unexpected reason.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i);
                 break;
         }
+        worker->started = workerres == thrd_success;
+        // run the worker on the calling thread if it's thread could not be started so all simulations get claimed
+        if (!worker->started)
+            worker_run(worker);
     }
 
-    // wait until all simulations finished
-    for (size_t i = 0; i < simulator.sims.size; i++) {
-        simulation_t* sim = array_get(&simulator.sims, i);
-        int simres = 0;
-        thrd_join(sim->thread, &simres);
-        switch (simres) {
+    // coordinate workers by checking the stopping criteria and signals and taking checkpoints until all workers finished
+    while (atomic_load(&simulator->activeworkers) != 0 && !simulator_check_precision(simulator)) {
+        // stop the workers at the next game boundary, the finished games are analyzed as partial statistics
+        if (interrupt_requested()) {
+            simulator->interrupted = true;
+            atomic_store(&simulator->stop, true);
+            break;
+        }
+        long sleepns = SIMULATOR_COORDINATOR_INTERVAL_NS;
+        double elapsed = elapsedbefore + stopwatch_elapsed(&stopwatch);
+        if (checkpoint && elapsed - checkpoint->last >= checkpoint->interval) {
+            simulator_pause(simulator);
+            checkpoint_take(checkpoint, simulator, elapsedbefore + stopwatch_elapsed(&stopwatch));
+            simulator_continue(simulator);
+        }
+        if (simulator->timelimit > 0.0) {
+            double remaining = simulator->timelimit - elapsed;
+            if (remaining <= 0.0) {
+                atomic_store(&simulator->stop, true);
+                break;
+            }
+            // wake up right at the deadline if it is closer than the next regular check
+            if (remaining * 1e9 < sleepns)
+                sleepns = (long)(remaining * 1e9) + 1;
+        }
+        const struct timespec interval = { .tv_sec = 0, .tv_nsec = sleepns };
+        thrd_sleep(&interval, 0);
+    }
+
+    // wait until all workers finished
+    for (size_t i = 0; i < simulator->workers.size; i++) {
+        worker_t* worker = array_get(&simulator->workers, i);
+        if (!worker->started)
+            continue;
+        int workerres = 0;
+        thrd_join(worker->thread, &workerres);
+        switch (workerres) {
             case 0:
                 break;
             default:
-                fprintf(stderr, "%swarning:%s simulation thread %lu unexpectedly returned %d.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i, simres);
+                fprintf(stderr, "%swarning:%s worker thread %lu unexpectedly returned %d.\n", FMT(FMTVAL_FG_YELLOW), FMT(FMTVAL_FG_DEFAULT), i, workerres);
                 break;
         }
     }
 
+    // stop the clock
+    simulator->elapsed = elapsedbefore + stopwatch_elapsed(&stopwatch);
+
+    // the events of the finished worker threads were added to the inherited events
+    if (simulator->perfcounters) {
+        perfcounters_stop(&simulator->perf);
+        for (size_t i = 0; i < simulator->workers.size; i++) {
+            const worker_t* worker = array_getconst(&simulator->workers, i);
+            simulator->perf.games += worker->stats.sims;
+            simulator->perf.dices += worker->stats.dices.sum;
+        }
+        simulator->perf.games -= gamesbefore;
+        simulator->perf.dices -= dicesbefore;
+    }
+
+    // take the final checkpoint, hence resuming continues after the last finished simulation (or reproduces the results if all finished)
+    if (checkpoint)
+        checkpoint_take(checkpoint, simulator, simulator->elapsed);
+
     // stop rendering loading screen
     loadingscreen_stop(&loadscreen);
 
+    simulator_finish(simulator);
+
 #ifdef DEBUG
-    simulator_print(&simulator, 0, false);
+    simulator_print(simulator, 0, false);
 #endif
 
     // free loading screen
     loadingscreen_destroy(&loadscreen);
 
-    return simulator;
 }
 
 int simulation_run(simulation_t* simulation) {
@@ -162,14 +655,17 @@ int simulation_run(simulation_t* simulation) {
     // define helper variables
     const simulator_t* const simulator = simulation->simulator;
     const game_t* const game = simulator->game;
-    const size_t lastcell = game->adjmat.vertex_count;
+    const size_t lastcell = game->width * game->height;
 
-    // seed thread local rand48 random number generator for the die
-    tsnewseed48();
+    // reset state of a previous run
+    simulation_reset(simulation);
 
     // start with player position outside the playing field (1 based index, i.e. first cell has index 1)
     simulation->playerpos = 0;
     while (simulation->playerpos != lastcell && simulation->dices.size < simulator->dicelimit) {
+        // interrupt long games if the simulator was stopped
+        if ((simulation->dices.size & (SIMULATOR_STOP_CHECK_DICES - 1)) == SIMULATOR_STOP_CHECK_DICES - 1 && simulator->stop)
+            return 2;
         // roll the die
         size_t side = dice(&game->die);
         array_add(&simulation->dices, &side);
@@ -183,10 +679,10 @@ int simulation_run(simulation_t* simulation) {
         // move player
         simulation->playerpos += side;
         // check for presence of snake or ladder (0 based index, hence playerpos - 1)
-        const optional_size_t* const solidx = array_getconst(&simulator->solidxs, simulation->playerpos - 1);
+        const optional_size_t* const solidx = array_getconst(&simulator->game->solidxs, simulation->playerpos - 1);
         if (solidx->present) {
             // use snake or ladder
-            simulation->playerpos = *(const size_t*)array_getconst(&simulator->soldsts, solidx->value) + 1;
+            simulation->playerpos = *(const size_t*)array_getconst(&simulator->game->soldsts, solidx->value) + 1;
             // track usage of snake or ladder
             (*(size_t*)array_get(&simulation->soluses, solidx->value))++;
         }
@@ -207,17 +703,29 @@ void simulator_print(const simulator_t* simulator, uint32_t indent, bool indentf
         "%*ssimulator = {\n"
         "%*s  game      = game_t @ %p,\n"
         "%*s  dicelimit =  %lu,\n"
+        "%*s  simcount  =  %lu,\n"
+        "%*s  precision =  %lf,\n"
+        "%*s  timelimit =  %lf,\n"
+        "%*s  elapsed   =  %lf,\n"
+        "%*s  nextsim   =  %lu,\n"
+        "%*s  stop      =  %s,\n"
         "%*s  soldsts   = [%lu] {",
         indentfirst ? indent : 0, "",
         indent, "", simulator->game,
         indent, "", simulator->dicelimit,
-        indent, "", simulator->soldsts.size
+        indent, "", simulator->simcount,
+        indent, "", simulator->targetprecision,
+        indent, "", simulator->timelimit,
+        indent, "", simulator->elapsed,
+        indent, "", (size_t)simulator->nextsim,
+        indent, "", simulator->stop ? "true" : "false",
+        indent, "", simulator->game->soldsts.size
     );
-    if (simulator->soldsts.size != 0) {
+    if (simulator->game->soldsts.size != 0) {
         printf("\n");
-        for (size_t i = 0; i < simulator->soldsts.size; i++) {
-            const size_t* soldst = array_getconst(&simulator->soldsts, i);
-            printf("%*s    [%lu] %lu%s\n", indent, "", i, *soldst, i != simulator->soldsts.size - 1 ? "," : "");
+        for (size_t i = 0; i < simulator->game->soldsts.size; i++) {
+            const size_t* soldst = array_getconst(&simulator->game->soldsts, i);
+            printf("%*s    [%lu] %lu%s\n", indent, "", i, *soldst, i != simulator->game->soldsts.size - 1 ? "," : "");
         }
         printf("%*s  ", indent, "");
     }
@@ -225,33 +733,82 @@ void simulator_print(const simulator_t* simulator, uint32_t indent, bool indentf
         "%*s},\n"
         "%*s  solidxs   = [%lu] {",
         indent, "",
-        indent, "", simulator->solidxs.size
+        indent, "", simulator->game->solidxs.size
     );
-    if (simulator->solidxs.size != 0) {
+    if (simulator->game->solidxs.size != 0) {
         printf("\n");
-        for (size_t i = 0; i < simulator->solidxs.size; i++) {
-            const optional_size_t* idx = array_getconst(&simulator->solidxs, i);
-            printf("%*s    [%lu] %s%lu%s%s\n", indent, "", i, idx->present ? FMT(FMTVAL_FG_DEFAULT) : FMT(FMTVAL_FG_BRIGHT_BLACK), idx->value, FMT(FMTVAL_FG_DEFAULT), i != simulator->solidxs.size - 1 ? "," : "");
+        for (size_t i = 0; i < simulator->game->solidxs.size; i++) {
+            const optional_size_t* idx = array_getconst(&simulator->game->solidxs, i);
+            printf("%*s    [%lu] %s%lu%s%s\n", indent, "", i, idx->present ? FMT(FMTVAL_FG_DEFAULT) : FMT(FMTVAL_FG_BRIGHT_BLACK), idx->value, FMT(FMTVAL_FG_DEFAULT), i != simulator->game->solidxs.size - 1 ? "," : "");
         }
         printf("%*s  ", indent, "");
     }
     printf(
         "%*s},\n"
-        "%*s  sims      = [%lu] {",
+        "%*s  workers   = [%lu] {",
         indent, "",
-        indent, "", simulator->sims.size
+        indent, "", simulator->workers.size
     );
-    if (simulator->sims.size != 0) {
+    if (simulator->workers.size != 0) {
         printf("\n");
-        for (size_t i = 0; i < simulator->sims.size; i++) {
-            printf("%*s    [%lu] ", indent, "", i);
-            simulation_print(array_getconst(&simulator->sims, i), indent + 4, false);
+        for (size_t i = 0; i < simulator->workers.size; i++) {
+            const worker_t* worker = array_getconst(&simulator->workers, i);
+            printf(
+                "%*s    [%lu] worker = {\n"
+                "%*s      thread  = %lu,\n"
+                "%*s      started = %s,\n"
+                "%*s      sims    = %lu,\n"
+                "%*s      ",
+                indent, "", i,
+                indent, "", worker->thread,
+                indent, "", worker->started ? "true" : "false",
+                indent, "", worker->stats.sims,
+                indent, ""
+            );
+            simulation_print(&worker->sim, indent + 6, false);
+            printf("%*s    }%s\n", indent, "", i != simulator->workers.size - 1 ? "," : "");
         }
         printf("%*s  ", indent, "");
     }
     printf("}\n%*s}\n", indent, "");
 }
 
+void simulator_print_perfcounters(const simulator_t* simulator) {
+    if (!simulator || !simulator->perfcounters)
+        return;
+    perfcounters_print(&simulator->perf);
+    printf(
+        "Worker performance counters\n"
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%6s  %12s  %8s  %12s  %14s  %14s%s \x1b(0x\x1b(B\n",
+        FMT(FMTVAL_BOLD), "WORKER", "INSTR/DICE", "IPC", "BRANCH MISS", "L1D MISS/DICE", "LLC MISS/DICE", FMT(FMTVAL_NO_BOLD)
+    );
+    for (size_t i = 0; i < simulator->workers.size; i++) {
+        // print n/a for the events that were not counted
+        const perfcounters_t* perf = &((const worker_t*)array_getconst(&simulator->workers, i))->perf;
+        double values[5] = {
+            perf->counted[PERFCOUNTERS_EVENT_INSTRUCTIONS] && perf->dices > 0 ? (double)perf->values[PERFCOUNTERS_EVENT_INSTRUCTIONS] / perf->dices : NAN,
+            perfcounters_ratio(perf, PERFCOUNTERS_EVENT_INSTRUCTIONS, PERFCOUNTERS_EVENT_CYCLES),
+            perfcounters_ratio(perf, PERFCOUNTERS_EVENT_BRANCH_MISSES, PERFCOUNTERS_EVENT_BRANCHES) * 100.0,
+            perf->counted[PERFCOUNTERS_EVENT_L1D_MISSES] && perf->dices > 0 ? (double)perf->values[PERFCOUNTERS_EVENT_L1D_MISSES] / perf->dices : NAN,
+            perf->counted[PERFCOUNTERS_EVENT_LLC_MISSES] && perf->dices > 0 ? (double)perf->values[PERFCOUNTERS_EVENT_LLC_MISSES] / perf->dices : NAN
+        };
+        const int widths[5] = { 12, 8, 11, 14, 14 };
+        printf("  \x1b(0x\x1b(B %6lu", i);
+        for (size_t j = 0; j < 5; j++) {
+            if (isnan(values[j]))
+                printf("  %*s%s", widths[j], "n/a", j == 2 ? " " : "");
+            else
+                printf("  %*.3lf%s", widths[j], values[j], j == 2 ? "%" : "");
+        }
+        printf(" \x1b(0x\x1b(B\n");
+    }
+    printf(
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "\n"
+    );
+}
+
 void simulation_print(const simulation_t* simulation, uint32_t indent, bool indentfirst) {
     if (!simulation) {
         printf("%*ssimulation = %s\n", indentfirst ? indent : 0, "", (char*)0);
@@ -260,23 +817,21 @@ void simulation_print(const simulation_t* simulation, uint32_t indent, bool inde
     printf(
         "%*ssimulation = {\n"
         "%*s  simulator = simulator_t @ %p,\n"
-        "%*s  thread    = %lu,\n"
         "%*s  aborted   = %s,\n"
         "%*s  playerpos = %lu,\n"
         "%*s  soluses   = [%lu] {",
         indentfirst ? indent : 0, "",
         indent, "", simulation->simulator,
-        indent, "", simulation->thread,
         indent, "", simulation->aborted ? "true" : "false",
         indent, "", simulation->playerpos,
         indent, "", simulation->soluses.size
     );
     if (simulation->soluses.size != 0) {
         printf("\n");
-        for (size_t i = 0; i < simulation->simulator->solidxs.size; i++) {
-            const optional_size_t* idx = (optional_size_t*)array_getconst(&simulation->simulator->solidxs, i);
+        for (size_t i = 0; i < simulation->simulator->game->solidxs.size; i++) {
+            const optional_size_t* idx = (optional_size_t*)array_getconst(&simulation->simulator->game->solidxs, i);
             if (idx->present) {
-                snakeorladder_t sol = (snakeorladder_t){ i + 1, *(size_t*)array_getconst(&simulation->simulator->soldsts, idx->value) + 1 };
+                snakeorladder_t sol = (snakeorladder_t){ i + 1, *(size_t*)array_getconst(&simulation->simulator->game->soldsts, idx->value) + 1 };
                 const size_t* uses = array_getconst(&simulation->soluses, idx->value);
                 printf("%*s    [%lu] %lu-%lu %lu%s\n", indent, "", idx->value, sol.src, sol.dst, *uses, idx->value != simulation->soluses.size - 1 ? "," : "");
             }
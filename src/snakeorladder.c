@@ -1,9 +1,8 @@
 #include "snakeorladder.h"
 
-#include "str.h"
 #include "numbers.h"
 
-#include <stdlib.h>
+#include <string.h>
 
 bool issnake(snakeorladder_t* sol) {
     return sol ? sol->src > sol->dst : false;
@@ -19,48 +18,37 @@ snakeorladder_t strtosol(const char* str, int* error) {
             *error = 1;
         return (snakeorladder_t){};
     }
-    char* strdup = strduplicate(str);
-    if (!strdup) {
-        if (error)
-            *error = 2;
-        return (snakeorladder_t){};
-    }
-    twostrs_t twostrs = strsplitnext(strdup, '-');
-    if (!twostrs.strs[1]) {
+    // parse both numbers in place around the split character
+    const char* split = strchr(str, '-');
+    if (!split) {
         if (error)
             *error = 3;
-        free(strdup);
         return (snakeorladder_t){};
     }
     snakeorladder_t sol = {};
-    int err = strtouint64(twostrs.strs[0], &sol.src);
+    int err = strntouint64(str, split - str, &sol.src);
     if (err != 0) {
         if (error)
             *error = err + 2;
-        free(strdup);
         return (snakeorladder_t){};
     }
     if (sol.src == 0) {
         if (error)
             *error = 7;
-        free(strdup);
         return (snakeorladder_t){};
     }
-    err = strtouint64(twostrs.strs[1], &sol.dst);
+    err = strtouint64(split + 1, &sol.dst);
     if (err != 0) {
         if (error)
             *error = err + 6;
-        free(strdup);
         return (snakeorladder_t){};
     }
     if (sol.dst == 0) {
         if (error)
             *error = 11;
-        free(strdup);
         return (snakeorladder_t){};
     }
     if (error)
         *error = 0;
-    free(strdup);
     return sol;
 }
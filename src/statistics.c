@@ -1,146 +1,264 @@
 #include "statistics.h"
 
-#include "assetmanager.h"
 #include "cvts.h"
 #include "loadingscreen.h"
+#include "simulator.h"
 
 #include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+valstats_t valstats_create() {
+    return (valstats_t){ .min = ULONG_MAX };
+}
+
+void valstats_add(valstats_t* valstats, size_t value) {
+    if (!valstats)
+        return;
+    valstats->count++;
+    valstats->sum += value;
+    if (valstats->min > value)
+        valstats->min = value;
+    if (valstats->max < value)
+        valstats->max = value;
+    double delta = value - valstats->mean;
+    valstats->mean += delta / valstats->count;
+    valstats->m2 += delta * (value - valstats->mean);
+}
+
+void valstats_merge(valstats_t* dst, const valstats_t* src) {
+    if (!dst || !src || src->count == 0)
+        return;
+    // combine welford accumulators (Chan et al.)
+    size_t count = dst->count + src->count;
+    double delta = src->mean - dst->mean;
+    dst->mean += delta * src->count / count;
+    dst->m2 += src->m2 + delta * delta * ((double)dst->count * src->count / count);
+    dst->count = count;
+    dst->sum += src->sum;
+    if (dst->min > src->min)
+        dst->min = src->min;
+    if (dst->max < src->max)
+        dst->max = src->max;
+}
+
+void valstats_finalize(valstats_t* valstats) {
+    if (!valstats)
+        return;
+    if (valstats->count == 0) {
+        valstats->min = 0;
+        valstats->avg = 0.0;
+        return;
+    }
+    valstats->avg = (double)valstats->sum / valstats->count;
+    valstats->var = valstats->count > 1 ? valstats->m2 / (valstats->count - 1) : 0.0;
+    valstats->stddev = sqrt(valstats->var);
+    valstats->ci95 = STATS_CI95_Z * valstats->stddev / sqrt((double)valstats->count);
+}
+
 stats_t stats_create() {
-    return (stats_t){
-        .dices = (valstats_t){ .min = ULONG_MAX },
+    // the arrays of the statistics are accounted to the stats subsystem whichever subsystem creates them
+    const allocations_subsystem_t previous = allocations_set_subsystem(ALLOCATIONS_SUBSYSTEM_STATS);
+    stats_t stats = {
+        .dices = valstats_create(),
+        .diceshist = histogram_create_empty(),
         .shortestdices = array_create(0, sizeof(size_t), 0),
-        .sals = array_create(0, sizeof(valstats_t), 0),
+        .salsuses = valstats_create(),
+        .snakesuses = valstats_create(),
+        .laddersuses = valstats_create(),
+        .sals = array_create(0, sizeof(solstats_t), 0),
     };
+    allocations_set_subsystem(previous);
+    return stats;
 }
 
 void stats_free(stats_t* stats) {
     if (!stats)
         return;
+    histogram_free(&stats->diceshist);
     array_free(&stats->shortestdices, 0);
     array_free(&stats->sals, 0);
     *stats = stats_create();
 }
 
-stats_t stats_analyze(const simulator_t* simulator) {
-    if (!simulator) {
-        fprintf(stderr, "%serror:%s no simulator given statistical analysis.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
-        exit(1);
-    }
-    if (simulator->sims.size == 0) {
-        fprintf(stderr, "%serror:%s simulator has no simulations.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
-        exit(1);
-    }
-    
-    // create statistics
-    stats_t stats = stats_create();
+bool stats_init(stats_t* stats, const simulator_t* simulator) {
+    if (!stats || !simulator)
+        return false;
 
-    // add stats to asset manager
-    if (!assetmanager_add(&stats, (deallocator_fn_t)stats_free)) {
-        fprintf(stderr, "%serror:%s unable to add stats to asset manager.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
-        exit(1);
-    }
+    // stopping criteria
+    stats->targetprecision = simulator->targetprecision;
+    stats->timelimit = simulator->timelimit;
+    stats->interrupted = simulator->interrupted;
+
+    // dice limit and histogram of the number of dices which can't exceed the dice limit
+    stats->dicelimit = simulator->dicelimit;
+    histogram_free(&stats->diceshist);
+    stats->diceshist = histogram_create(simulator->dicelimit);
+    if (stats->diceshist.counts.size == 0)
+        return false;
 
     // prepare snakes and ladders stats array
-    stats.sals = array_create(simulator->soldsts.size, sizeof(solstats_t), 0);
-    for (size_t i = 0; i < simulator->solidxs.size; i++) {
-        const optional_size_t* idx = (optional_size_t*)array_getconst(&simulator->solidxs, i);
+    array_free(&stats->sals, 0);
+    if (!array_reserve(&stats->sals, simulator->game->soldsts.size))
+        return false;
+    for (size_t i = 0; i < simulator->game->solidxs.size; i++) {
+        const optional_size_t* idx = (optional_size_t*)array_getconst(&simulator->game->solidxs, i);
         if (idx->present) {
-            solstats_t solstats = (solstats_t){ .sol = { i + 1, *(size_t*)array_getconst(&simulator->soldsts, idx->value) + 1 } };
-            if (!array_add(&stats.sals, &solstats)) {
-                fprintf(stderr, "%serror:%s unable to add stats about snake or ladder %lu to stats array.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), stats.sals.size);
-                exit(1);
-            }
+            solstats_t solstats = (solstats_t){ .sol = { i + 1, *(size_t*)array_getconst(&simulator->game->soldsts, idx->value) + 1 }, .uses = valstats_create() };
+            if (!array_add(&stats->sals, &solstats))
+                return false;
         }
     }
+    return true;
+}
 
-    // number of run simulations and dice limit
-    stats.sims = simulator->sims.size;
-    stats.dicelimit = simulator->dicelimit;
+bool stats_add(stats_t* stats, const simulation_t* simulation) {
+    if (!stats || !simulation || simulation->soluses.size != stats->sals.size)
+        return false;
 
-    for (size_t i = 0; i < simulator->sims.size; i++) {
-        const simulation_t* sim = array_getconst(&simulator->sims, i);
+    // wins and losses
+    stats->sims++;
+    if (simulation->aborted)
+        stats->losses++;
+    else
+        stats->wins++;
 
-        // wins and losses
-        if (sim->aborted)
-            stats.losses++;
-        else
-            stats.wins++;
-            
-        // number of dices
-        stats.dices.sum += sim->dices.size;
-        if (stats.dices.min > sim->dices.size)
-            stats.dices.min = sim->dices.size;
-        if (stats.dices.max < sim->dices.size)
-            stats.dices.max = sim->dices.size;
-            
-        // shortest dice sequence
-        if (!sim->aborted && (stats.shortestdices.size == 0 || stats.shortestdices.size > sim->dices.size))
-            array_copy(&stats.shortestdices, &sim->dices);
-            
-        // snakes and ladders
-        size_t simsalsuses = 0;
-        size_t simsnakesuses = 0;
-        size_t simladdersuses = 0;
-
-        for (size_t i = 0; i < sim->soluses.size; i++) {
-            // individual snake or ladder
-            solstats_t* solstats = (solstats_t*)array_get(&stats.sals, i);
-            size_t uses = *(const size_t*)array_getconst(&sim->soluses, i);
-            solstats->uses.sum += uses;
-            if (solstats->uses.min > uses)
-                solstats->uses.min = uses;
-            if (solstats->uses.max < uses)
-                solstats->uses.max = uses;
-
-            // all snakes and ladders in simulation
-            simsalsuses += uses;
-            if (solstats->sol.src > solstats->sol.dst)
-                simsnakesuses += uses;
-            else if (solstats->sol.src < solstats->sol.dst)
-                simladdersuses += uses;
-        }
+    // number of dices
+    valstats_add(&stats->dices, simulation->dices.size);
+    if (!histogram_add(&stats->diceshist, simulation->dices.size))
+        return false;
 
-        // all snakes and ladders in all simulations
-        stats.salsuses.sum += simsalsuses;
-        if (stats.salsuses.min > simsalsuses)
-            stats.salsuses.min = simsalsuses;
-        if (stats.salsuses.max < simsalsuses)
-            stats.salsuses.max = simsalsuses;
-
-        // all snakes in all simulations
-        stats.snakesuses.sum += simsnakesuses;
-        if (stats.snakesuses.min > simsnakesuses)
-            stats.snakesuses.min = simsnakesuses;
-        if (stats.snakesuses.max < simsnakesuses)
-            stats.snakesuses.max = simsnakesuses;
-
-        // all ladders in all simulations
-        stats.laddersuses.sum += simladdersuses;
-        if (stats.laddersuses.min > simladdersuses)
-            stats.laddersuses.min = simladdersuses;
-        if (stats.laddersuses.max < simladdersuses)
-            stats.laddersuses.max = simladdersuses;
+    // shortest dice sequence (ties are broken by the index, hence the result does not depend on which worker ran which simulation)
+    if (!simulation->aborted && (stats->shortestdices.size == 0 || stats->shortestdices.size > simulation->dices.size
+        || (stats->shortestdices.size == simulation->dices.size && stats->shortestindex > simulation->index))) {
+        if (!array_copy(&stats->shortestdices, &simulation->dices))
+            return false;
+        stats->shortestindex = simulation->index;
     }
 
+    // snakes and ladders
+    size_t simsalsuses = 0;
+    size_t simsnakesuses = 0;
+    size_t simladdersuses = 0;
+    for (size_t i = 0; i < simulation->soluses.size; i++) {
+        // individual snake or ladder
+        solstats_t* solstats = (solstats_t*)array_get(&stats->sals, i);
+        size_t uses = *(const size_t*)array_getconst(&simulation->soluses, i);
+        valstats_add(&solstats->uses, uses);
+
+        // all snakes and ladders in simulation
+        simsalsuses += uses;
+        if (solstats->sol.src > solstats->sol.dst)
+            simsnakesuses += uses;
+        else if (solstats->sol.src < solstats->sol.dst)
+            simladdersuses += uses;
+    }
+    valstats_add(&stats->salsuses, simsalsuses);
+    valstats_add(&stats->snakesuses, simsnakesuses);
+    valstats_add(&stats->laddersuses, simladdersuses);
+
+    return true;
+}
+
+bool stats_merge(stats_t* dst, const stats_t* src) {
+    if (!dst || !src || dst->sals.size != src->sals.size)
+        return false;
+
+    // wins and losses
+    dst->sims += src->sims;
+    dst->wins += src->wins;
+    dst->losses += src->losses;
+
+    // number of dices
+    valstats_merge(&dst->dices, &src->dices);
+    if (!histogram_merge(&dst->diceshist, &src->diceshist))
+        return false;
+
+    // shortest dice sequence
+    if (src->shortestdices.size != 0 && (dst->shortestdices.size == 0 || dst->shortestdices.size > src->shortestdices.size
+        || (dst->shortestdices.size == src->shortestdices.size && dst->shortestindex > src->shortestindex))) {
+        if (!array_copy(&dst->shortestdices, &src->shortestdices))
+            return false;
+        dst->shortestindex = src->shortestindex;
+    }
+
+    // snakes and ladders
+    for (size_t i = 0; i < src->sals.size; i++)
+        valstats_merge(&((solstats_t*)array_get(&dst->sals, i))->uses, &((const solstats_t*)array_getconst(&src->sals, i))->uses);
+    valstats_merge(&dst->salsuses, &src->salsuses);
+    valstats_merge(&dst->snakesuses, &src->snakesuses);
+    valstats_merge(&dst->laddersuses, &src->laddersuses);
+
+    return true;
+}
+
+void stats_finalize(stats_t* stats) {
+    if (!stats)
+        return;
+
     // averages
-    stats.dices.avg = (double)stats.dices.sum / stats.sims;
-    for (size_t i = 0; i < stats.sals.size; i++) {
-        solstats_t* solstats = (solstats_t*)array_get(&stats.sals, i);
-        solstats->uses.avg = (double)solstats->uses.sum / stats.sims;
+    valstats_finalize(&stats->dices);
+    for (size_t i = 0; i < stats->sals.size; i++)
+        valstats_finalize(&((solstats_t*)array_get(&stats->sals, i))->uses);
+    valstats_finalize(&stats->salsuses);
+    valstats_finalize(&stats->snakesuses);
+    valstats_finalize(&stats->laddersuses);
+
+    // rates
+    stats->winrate = stats->sims != 0 ? (double)stats->wins / stats->sims * 100.0 : 0.0;
+    stats->lossrate = stats->sims != 0 ? (double)stats->losses / stats->sims * 100.0 : 0.0;
+    stats->throughput = stats->elapsed > 0.0 ? stats->sims / stats->elapsed : 0.0;
+    if (stats->salsuses.sum != 0) {
+        stats->snakesuserate = (double)stats->snakesuses.sum / stats->salsuses.sum * 100.0;
+        stats->laddersuserate = (double)stats->laddersuses.sum / stats->salsuses.sum * 100.0;
+    }
+}
+
+bool stats_collect(stats_t* stats, const simulator_t* simulator) {
+    if (!stats || !simulator)
+        return false;
+
+    // prepare dices histogram and snakes and ladders stats array
+    if (!stats_init(stats, simulator))
+        return false;
+
+    // merge the partial statistics of all workers
+    for (size_t i = 0; i < simulator->workers.size; i++) {
+        const worker_t* worker = array_getconst(&simulator->workers, i);
+        if (!stats_merge(stats, &worker->stats))
+            return false;
+    }
+
+    // averages, rates and throughput
+    stats->elapsed = simulator->elapsed;
+    stats_finalize(stats);
+    return true;
+}
+
+size_t stats_size(const stats_t* stats) {
+    if (!stats)
+        return 0;
+    return sizeof(*stats) + stats->diceshist.counts.size * sizeof(size_t) + stats->shortestdices.size * sizeof(size_t) + stats->sals.size * sizeof(solstats_t);
+}
+
+stats_t stats_analyze(const simulator_t* simulator) {
+    if (!simulator) {
+        fprintf(stderr, "%serror:%s no simulator given statistical analysis.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+        exit(1);
+    }
+    if (simulator->simcount == 0 || simulator->workers.size == 0) {
+        fprintf(stderr, "%serror:%s simulator has no simulations.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+        exit(1);
     }
-    stats.salsuses.avg = (double)stats.salsuses.sum / stats.sims;
-    stats.snakesuses.avg = (double)stats.snakesuses.sum / stats.sims;
-    stats.laddersuses.avg = (double)stats.laddersuses.sum / stats.sims;
     
-    // rates and averages
-    stats.winrate = (double)stats.wins / stats.sims * 100.0;
-    stats.lossrate = (double)stats.losses / stats.sims * 100.0;
-    if (stats.salsuses.sum != 0) {
-        stats.snakesuserate = (double)stats.snakesuses.sum / stats.salsuses.sum * 100.0;
-        stats.laddersuserate = (double)stats.laddersuses.sum / stats.salsuses.sum * 100.0;
+    // create statistics
+    stats_t stats = stats_create();
+
+    // merge and finalize the partial statistics of all workers
+    if (!stats_collect(&stats, simulator)) {
+        fprintf(stderr, "%serror:%s unable to collect statistics of %lu workers for %lu snakes and ladders.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), simulator->workers.size, simulator->game->soldsts.size);
+        exit(1);
     }
 
     return stats;
@@ -151,25 +269,58 @@ void stats_print(const stats_t* stats) {
         return;
     printf(
         "\n"
-        "Simulated %lu games with a dice limit of %lu\n"
+        "Simulated %lu games with a dice limit of %lu%s\n"
         "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
         "  \x1b(0x\x1b(B %s%9s  %9s  %9s  %9s%s \x1b(0x\x1b(B\n"
         "  \x1b(0x\x1b(B %9lu  %9lu  %8.3lf%%  %8.3lf%% \x1b(0x\x1b(B\n"
         "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
         "\n"
         "Dices\n"
-        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
-        "  \x1b(0x\x1b(B %s%9s  %9s  %9s  %9s%s \x1b(0x\x1b(B\n"
-        "  \x1b(0x\x1b(B %9lu  %9lu  %9lu  %9.3lf \x1b(0x\x1b(B\n"
-        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
-        "\n",
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%9s  %9s  %9s  %9s  %9s  %9s%s \x1b(0x\x1b(B\n"
+        "  \x1b(0x\x1b(B %9lu  %9lu  %9lu  %9.3lf  %9.3lf  %9.3lf \x1b(0x\x1b(B\n"
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "  %sCI95 is the half-width of the 95%% confidence interval of the average (AVG +- CI95).%s\n",
         stats->sims,
         stats->dicelimit,
+        stats->interrupted ? " (partial)" : "",
         FMT(FMTVAL_BOLD), "WINS", "LOSSES", "WIN RATE", "LOSS RATE", FMT(FMTVAL_NO_BOLD),
         stats->wins, stats->losses, stats->winrate, stats->lossrate,
-        FMT(FMTVAL_BOLD), "SUM", "MIN", "MAX", "AVG", FMT(FMTVAL_NO_BOLD),
-        stats->dices.sum, stats->dices.min, stats->dices.max, stats->dices.avg
+        FMT(FMTVAL_BOLD), "SUM", "MIN", "MAX", "AVG", "STDDEV", "CI95", FMT(FMTVAL_NO_BOLD),
+        stats->dices.sum, stats->dices.min, stats->dices.max, stats->dices.avg, stats->dices.stddev, stats->dices.ci95,
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT)
     );
+    if (stats->dices.avg != 0.0) {
+        // number of simulations needed for a confidence interval half-width of 1% of the average: n = (z * stddev / (0.01 * avg))^2
+        double precision = STATS_REQUIRED_PRECISION * stats->dices.avg;
+        double needed = ceil(pow(STATS_CI95_Z * stats->dices.stddev / precision, 2.0));
+        printf("  %s%.0lf simulations are needed for a CI95 of %.3lf (%.0lf%% of AVG).%s\n", FMT(FMTVAL_FG_BRIGHT_BLACK), needed < 1.0 ? 1.0 : needed, precision, STATS_REQUIRED_PRECISION * 100.0, FMT(FMTVAL_FG_DEFAULT));
+    }
+    if (stats->targetprecision > 0.0) {
+        if (stats->dices.ci95 <= stats->targetprecision && stats->sims >= SIMULATOR_PRECISION_MIN_SIMS)
+            printf("  Target precision CI95 <= %.3lf reached after %lu simulations.\n", stats->targetprecision, stats->sims);
+        else
+            printf("  %sTarget precision CI95 <= %.3lf not reached within %lu simulations.%s\n", FMT(FMTVAL_FG_YELLOW), stats->targetprecision, stats->sims, FMT(FMTVAL_FG_DEFAULT));
+    }
+    if (stats->timelimit > 0.0)
+        printf("  Ran %lu simulations in %.3lf s of a %.3lf s time limit (%.0lf simulations/s).\n", stats->sims, stats->elapsed, stats->timelimit, stats->throughput);
+    if (stats->interrupted)
+        printf("  %sInterrupted after %lu simulations in %.3lf s (%.0lf simulations/s), the statistics are partial.%s\n", FMT(FMTVAL_FG_YELLOW), stats->sims, stats->elapsed, stats->throughput, FMT(FMTVAL_FG_DEFAULT));
+    printf("\n");
+    printf(
+        "Dices percentiles\n"
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%9s  %9s  %9s  %9s  %9s%s \x1b(0x\x1b(B\n"
+        "  \x1b(0x\x1b(B %9lu  %9lu  %9lu  %9lu  %9lu \x1b(0x\x1b(B\n"
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "\n"
+        "Dices distribution\n",
+        FMT(FMTVAL_BOLD), "P50", "P90", "P99", "P99.9", "P100", FMT(FMTVAL_NO_BOLD),
+        histogram_quantile(&stats->diceshist, 0.5), histogram_quantile(&stats->diceshist, 0.9), histogram_quantile(&stats->diceshist, 0.99),
+        histogram_quantile(&stats->diceshist, 0.999), histogram_quantile(&stats->diceshist, 1.0)
+    );
+    histogram_print(&stats->diceshist, STATS_HISTOGRAM_ROWS, STATS_HISTOGRAM_BAR_LENGTH);
+    printf("\n");
     if (stats->shortestdices.size == 0) {
         printf("No shortest dice sequence because all simulations failed to win.\n");
     } else {
@@ -182,38 +333,38 @@ void stats_print(const stats_t* stats) {
     printf(
         "\n"
         "General snakes and ladders usages\n"
-        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
-        "  \x1b(0x\x1b(B %s%-7s  %9s  %9s  %9s  %9s%s \x1b(0x\x1b(B\n"
-        "  \x1b(0x\x1b(B %s%-7s%s  %9lu  %9lu  %9lu  %9.3lf \x1b(0x\x1b(B\n"
-        "  \x1b(0x\x1b(B %s%-7s%s  %9lu  %9lu  %9lu  %9.3lf \x1b(0x\x1b(B\n"
-        "  \x1b(0x\x1b(B %s%-7s%s  %9lu  %9lu  %9lu  %9.3lf \x1b(0x\x1b(B\n"
-        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%-7s  %9s  %9s  %9s  %9s  %9s  %9s%s \x1b(0x\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%-7s%s  %9lu  %9lu  %9lu  %9.3lf  %9.3lf  %9.3lf \x1b(0x\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%-7s%s  %9lu  %9lu  %9lu  %9.3lf  %9.3lf  %9.3lf \x1b(0x\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%-7s%s  %9lu  %9lu  %9lu  %9.3lf  %9.3lf  %9.3lf \x1b(0x\x1b(B\n"
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
         "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
         "  \x1b(0x\x1b(B %s%11s  %12s%s \x1b(0x\x1b(B\n"
         "  \x1b(0x\x1b(B %10.3lf%%  %11.3lf%% \x1b(0x\x1b(B\n"
         "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
         "\n"
         "Individual snake or ladder usages\n"
-        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
-        "  \x1b(0x\x1b(B %s%17s     %9s   %9s   %9s   %9s%s \x1b(0x\x1b(B\n",
-        FMT(FMTVAL_BOLD), "", "SUM", "MIN", "MAX", "AVG", FMT(FMTVAL_NO_BOLD),
-        FMT(FMTVAL_BOLD), "ALL", FMT(FMTVAL_NO_BOLD), stats->salsuses.sum, stats->salsuses.min, stats->salsuses.max, stats->salsuses.avg,
-        FMT(FMTVAL_BOLD), "SNAKES", FMT(FMTVAL_NO_BOLD), stats->snakesuses.sum, stats->snakesuses.min, stats->snakesuses.max, stats->snakesuses.avg,
-        FMT(FMTVAL_BOLD), "LADDERS", FMT(FMTVAL_NO_BOLD), stats->laddersuses.sum, stats->laddersuses.min, stats->laddersuses.max, stats->laddersuses.avg,
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%17s     %9s   %9s   %9s   %9s   %9s   %9s%s \x1b(0x\x1b(B\n",
+        FMT(FMTVAL_BOLD), "", "SUM", "MIN", "MAX", "AVG", "STDDEV", "CI95", FMT(FMTVAL_NO_BOLD),
+        FMT(FMTVAL_BOLD), "ALL", FMT(FMTVAL_NO_BOLD), stats->salsuses.sum, stats->salsuses.min, stats->salsuses.max, stats->salsuses.avg, stats->salsuses.stddev, stats->salsuses.ci95,
+        FMT(FMTVAL_BOLD), "SNAKES", FMT(FMTVAL_NO_BOLD), stats->snakesuses.sum, stats->snakesuses.min, stats->snakesuses.max, stats->snakesuses.avg, stats->snakesuses.stddev, stats->snakesuses.ci95,
+        FMT(FMTVAL_BOLD), "LADDERS", FMT(FMTVAL_NO_BOLD), stats->laddersuses.sum, stats->laddersuses.min, stats->laddersuses.max, stats->laddersuses.avg, stats->laddersuses.stddev, stats->laddersuses.ci95,
         FMT(FMTVAL_BOLD), "SNAKES RATE", "LADDERS RATE", FMT(FMTVAL_NO_BOLD),
         stats->snakesuserate, stats->laddersuserate,
-        FMT(FMTVAL_BOLD), "SNAKE OR LADDER", "SUM", "MIN", "MAX", "AVG", FMT(FMTVAL_NO_BOLD)
+        FMT(FMTVAL_BOLD), "SNAKE OR LADDER", "SUM", "MIN", "MAX", "AVG", "STDDEV", "CI95", FMT(FMTVAL_NO_BOLD)
     );
     for (size_t i = 0; i < stats->sals.size; i++) {
         const solstats_t* solstats = (const solstats_t*)array_getconst(&stats->sals, i);
         printf(
-            "  \x1b(0x\x1b(B %s%9lu-%-9lu%s   %9lu   %9lu   %9lu   %9.3lf \x1b(0x\x1b(B\n",
+            "  \x1b(0x\x1b(B %s%9lu-%-9lu%s   %9lu   %9lu   %9lu   %9.3lf   %9.3lf   %9.3lf \x1b(0x\x1b(B\n",
             solstats->sol.src > solstats->sol.dst ? FMT(FMTVAL_FG_BRIGHT_CYAN) : FMT(FMTVAL_FG_BRIGHT_YELLOW), solstats->sol.src, solstats->sol.dst, FMT(FMTVAL_FG_DEFAULT),
-            solstats->uses.sum, solstats->uses.min, solstats->uses.max, solstats->uses.avg
+            solstats->uses.sum, solstats->uses.min, solstats->uses.max, solstats->uses.avg, solstats->uses.stddev, solstats->uses.ci95
         );
     }
     printf(
-        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
         "\n"
     );
 }
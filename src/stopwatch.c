@@ -0,0 +1,15 @@
+#include "stopwatch.h"
+
+stopwatch_t stopwatch_start() {
+    stopwatch_t stopwatch = {};
+    clock_gettime(CLOCK_MONOTONIC, &stopwatch.start);
+    return stopwatch;
+}
+
+double stopwatch_elapsed(const stopwatch_t* stopwatch) {
+    if (!stopwatch)
+        return 0.0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - stopwatch->start.tv_sec) + (double)(now.tv_nsec - stopwatch->start.tv_nsec) / 1e9;
+}
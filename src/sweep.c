@@ -0,0 +1,421 @@
+#include "sweep.h"
+
+#include "cli.h"
+#include "cvts.h"
+#include "numbers.h"
+#include "stopwatch.h"
+#include "str.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+sweep_param_info_t sweep_param_infos[SWEEP_PARAM_COUNT] = {
+    { "width"        },
+    { "height"       },
+    { "die-sides"    },
+    { "distribution" },
+    { "exact-ending" }
+};
+
+void sweep_param_free(sweep_param_t* param) {
+    if (!param)
+        return;
+    array_free(&param->values, 0);
+    *param = (sweep_param_t){};
+}
+
+sweep_param_t strtosweepparam(const char* str, int* error) {
+    sweep_param_t param = { SWEEP_PARAM_WIDTH, array_create(0, sizeof(size_t), 0) };
+    if (!str) {
+        if (error)
+            *error = 1;
+        return param;
+    }
+    char* strdup = strduplicate(str);
+    if (!strdup) {
+        if (error)
+            *error = 2;
+        return param;
+    }
+
+    // split name and values
+    twostrs_t namevalues = strsplitnext(strdup, '=');
+    if (!namevalues.strs[1]) {
+        if (error)
+            *error = 3;
+        free(strdup);
+        return param;
+    }
+    size_t kind = 0;
+    for (; kind < SWEEP_PARAM_COUNT && strcmp(namevalues.strs[0], sweep_param_infos[kind].name) != 0; kind++);
+    if (kind == SWEEP_PARAM_COUNT) {
+        if (error)
+            *error = 4;
+        free(strdup);
+        return param;
+    }
+    param.kind = kind;
+
+    // parse comma separated values
+    int err = 0;
+    twostrs_t twostrs = (twostrs_t){ { 0, namevalues.strs[1] } };
+    do {
+        twostrs = strsplitnext(twostrs.strs[1], ',');
+        char* value = twostrs.strs[0];
+        size_t first = 0;
+        size_t last = 0;
+        switch (param.kind) {
+            case SWEEP_PARAM_WIDTH:
+            case SWEEP_PARAM_HEIGHT:
+            case SWEEP_PARAM_DIE_SIDES:
+            {
+                // single value or inclusive range a..b
+                char* range = strstr(value, "..");
+                if (range)
+                    *range = '\0';
+                if (strtouint64(value, &first) != 0 || (range && strtouint64(range + 2, &last) != 0)) {
+                    err = 5;
+                    break;
+                }
+                if (!range)
+                    last = first;
+                else if (first > last)
+                    err = 6;
+                break;
+            }
+            case SWEEP_PARAM_DISTRIBUTION:
+            {
+                for (first = 1; first < DISTR_PRESET_COUNT && strcmp(value, distr_preset_infos[first].name) != 0; first++);
+                if (first == DISTR_PRESET_COUNT)
+                    err = 5;
+                last = first;
+                break;
+            }
+            case SWEEP_PARAM_EXACT_ENDING:
+            {
+                if (strcmp(value, "on") == 0)
+                    first = 1;
+                else if (strcmp(value, "off") != 0)
+                    err = 5;
+                last = first;
+                break;
+            }
+        }
+        for (size_t v = first; err == 0 && v <= last; v++) {
+            if (!array_add(&param.values, &v))
+                err = 7;
+            // prevent endless loop if the range ends at the largest value
+            if (v == last)
+                break;
+        }
+    } while (err == 0 && twostrs.strs[1]);
+
+    free(strdup);
+    if (err) {
+        if (error)
+            *error = err;
+        array_clear(&param.values);
+        return param;
+    }
+    if (error)
+        *error = 0;
+    return param;
+}
+
+void sweep_board_free(sweep_board_t* board) {
+    if (!board)
+        return;
+    game_free(&board->game);
+    *board = (sweep_board_t){};
+}
+
+void sweep_die_free(sweep_die_t* die) {
+    if (!die)
+        return;
+    die_free(&die->die);
+    *die = (sweep_die_t){};
+}
+
+void sweep_variant_free(sweep_variant_t* variant) {
+    if (!variant)
+        return;
+    simulator_free(&variant->simulator);
+    stats_free(&variant->stats);
+    *variant = (sweep_variant_t){};
+}
+
+sweep_board_t* sweep_get_board(sweep_t* sweep, size_t width, size_t height, const array_t* sals) {
+    if (!sweep || !sals)
+        return 0;
+    for (size_t i = 0; i < sweep->boards.size; i++) {
+        sweep_board_t* board = array_get(&sweep->boards, i);
+        if (board->width == width && board->height == height)
+            return board;
+    }
+
+    // validate the snakes and ladders on a playing field of the given dimensions and build it's jump tables
+    sweep_board_t board = { .width = width, .height = height, .game = { .width = width, .height = height } };
+    size_t cellcount = width * height;
+    if (width < GAME_WIDTH_MIN || height < GAME_HEIGHT_MIN) {
+        board.error = "invalid dimensions";
+    } else {
+        switch (game_check_sals(cellcount, sals, 0, 0)) {
+            case 0:
+                if (!game_build_jumps(&board.game, sals))
+                    board.error = "unable to create playing field";
+                break;
+            case 2:
+            case 3:
+                board.error = "snake or ladder outside of the playing field";
+                break;
+            case 4:
+                board.error = "snake or ladder starts and ends in the same cell";
+                break;
+            case 5:
+            case 6:
+                board.error = "snake or ladder starts or ends in the last cell";
+                break;
+            case 7:
+                board.error = "overlapping snakes or ladders";
+                break;
+            default:
+                board.error = "unable to validate snakes and ladders";
+                break;
+        }
+    }
+    sweep_board_t* cached = array_add(&sweep->boards, &board);
+    if (!cached)
+        sweep_board_free(&board);
+    return cached;
+}
+
+sweep_die_t* sweep_get_die(sweep_t* sweep, size_t die_sides, distr_preset_t preset, const array_t* weights) {
+    if (!sweep || !weights)
+        return 0;
+    for (size_t i = 0; i < sweep->dies.size; i++) {
+        sweep_die_t* die = array_get(&sweep->dies, i);
+        if (die->die_sides == die_sides && die->preset == preset)
+            return die;
+    }
+
+    // build the distribution for the given die sides and create the die from it
+    sweep_die_t die = { .die_sides = die_sides, .preset = preset, .die = die_create_empty() };
+    distribution_t distr = distr_create(preset);
+    if (preset == DISTR_PRESET_NONE && !array_copy(&distr.weights, weights)) {
+        die.error = "unable to copy distribution";
+    } else {
+        switch (distr_build(&distr, die_sides)) {
+            case 0:
+                break;
+            case 3:
+                die.error = "more weights than die sides";
+                break;
+            case 5:
+                die.error = "die sides must be even";
+                break;
+            case 6:
+                die.error = "die sides must not be 0";
+                break;
+            default:
+                die.error = "unable to build distribution";
+                break;
+        }
+    }
+    if (!die.error) {
+        bool iszero = true;
+        for (size_t i = 0; iszero && i < distr.weights.size; i++)
+            if (*(const size_t*)array_getconst(&distr.weights, i) != 0)
+                iszero = false;
+        if (iszero)
+            die.error = "distribution weight sum is 0";
+    }
+    if (!die.error) {
+        die_free(&die.die);
+        die.die = die_create(&distr);
+        if (die_isempty(&die.die))
+            die.error = "unable to create die";
+    }
+    distr_free(&distr);
+
+    sweep_die_t* cached = array_add(&sweep->dies, &die);
+    if (!cached)
+        sweep_die_free(&die);
+    return cached;
+}
+
+sweep_t sweep_create_empty() {
+    return (sweep_t){
+        .boards = array_create(0, sizeof(sweep_board_t), 0),
+        .dies = array_create(0, sizeof(sweep_die_t), 0),
+        .variants = array_create(0, sizeof(sweep_variant_t), 0),
+        .elapsed = 0.0
+    };
+}
+
+sweep_t sweep_create(const cli_args_t* cli_args, size_t simcount) {
+    sweep_t sweep = sweep_create_empty();
+    if (!cli_args)
+        return sweep;
+
+    // determine the iteration order of the parameters (swept parameters in the given order followed by the fixed parameters)
+    const sweep_param_t* swept[SWEEP_PARAM_COUNT] = {};
+    sweep_param_kind_t order[SWEEP_PARAM_COUNT];
+    size_t ordercount = 0;
+    for (size_t i = 0; i < cli_args->sweepparams.size; i++) {
+        const sweep_param_t* param = array_getconst(&cli_args->sweepparams, i);
+        if (swept[param->kind] || param->values.size == 0)
+            continue;
+        swept[param->kind] = param;
+        order[ordercount++] = param->kind;
+    }
+    for (size_t kind = 0; kind < SWEEP_PARAM_COUNT; kind++)
+        if (!swept[kind])
+            order[ordercount++] = kind;
+    const size_t fixed[SWEEP_PARAM_COUNT] = {
+        [SWEEP_PARAM_WIDTH] = cli_args->width,
+        [SWEEP_PARAM_HEIGHT] = cli_args->height,
+        [SWEEP_PARAM_DIE_SIDES] = cli_args->die_sides,
+        [SWEEP_PARAM_DISTRIBUTION] = cli_args->distribution.preset,
+        [SWEEP_PARAM_EXACT_ENDING] = cli_args->exact_ending
+    };
+    size_t variantcount = 1;
+    for (size_t kind = 0; kind < SWEEP_PARAM_COUNT; kind++)
+        if (swept[kind])
+            variantcount *= swept[kind]->values.size;
+
+    // create variants for every combination of the swept parameters (the last parameter in the order varies fastest)
+    if (!array_reserve(&sweep.variants, variantcount)) {
+        fprintf(stderr, "%serror:%s unable to allocate %lu sweep variants.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), variantcount);
+        exit(1);
+    }
+    for (size_t v = 0; v < variantcount; v++) {
+        size_t values[SWEEP_PARAM_COUNT];
+        size_t rest = v;
+        for (size_t i = ordercount; i-- > 0;) {
+            sweep_param_kind_t kind = order[i];
+            if (!swept[kind]) {
+                values[kind] = fixed[kind];
+                continue;
+            }
+            values[kind] = *(const size_t*)array_getconst(&swept[kind]->values, rest % swept[kind]->values.size);
+            rest /= swept[kind]->values.size;
+        }
+        sweep_variant_t variant = {
+            .width = values[SWEEP_PARAM_WIDTH],
+            .height = values[SWEEP_PARAM_HEIGHT],
+            .die_sides = values[SWEEP_PARAM_DIE_SIDES],
+            .distribution = values[SWEEP_PARAM_DISTRIBUTION],
+            .exact_ending = values[SWEEP_PARAM_EXACT_ENDING],
+            .simulator = simulator_create_empty(),
+            .stats = stats_create()
+        };
+        // reference the cached playing field and die (their handles are copied, the memory stays owned by the cache)
+        const sweep_board_t* board = sweep_get_board(&sweep, variant.width, variant.height, &cli_args->snakesandladders);
+        const sweep_die_t* die = sweep_get_die(&sweep, variant.die_sides, variant.distribution, &cli_args->distribution.weights);
+        if (!board || !die) {
+            fprintf(stderr, "%serror:%s unable to cache playing field or die for sweep.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT));
+            exit(1);
+        }
+        variant.error = board->error ? board->error : die->error;
+        if (!variant.error) {
+            variant.game = board->game;
+            variant.game.die = die->die;
+            variant.game.exact_ending = variant.exact_ending;
+        }
+        array_add(&sweep.variants, &variant);
+    }
+
+    // create the simulators now that the variants (and therefore their games) don't move anymore
+    for (size_t v = 0; v < sweep.variants.size; v++) {
+        sweep_variant_t* variant = array_get(&sweep.variants, v);
+        if (variant->error)
+            continue;
+        if (!simulator_init(&variant->simulator, &variant->game, simcount, cli_args->workers, cli_args->dicelimit, cli_args->targetprecision, 0.0)) {
+            fprintf(stderr, "%serror:%s unable to create simulator for sweep variant %lu.\n", FMT(FMTVAL_FG_BRIGHT_RED), FMT(FMTVAL_FG_DEFAULT), v);
+            exit(1);
+        }
+        // every variant rolls the same streams, hence the differences between the variants are not blurred by the randomness
+        if (cli_args->seeded)
+            simulator_seed(&variant->simulator, cli_args->seed);
+    }
+
+    return sweep;
+}
+
+void sweep_free(sweep_t* sweep) {
+    if (!sweep)
+        return;
+    array_free(&sweep->variants, (element_fn_t)sweep_variant_free);
+    array_free(&sweep->boards, (element_fn_t)sweep_board_free);
+    array_free(&sweep->dies, (element_fn_t)sweep_die_free);
+    *sweep = sweep_create_empty();
+}
+
+int sweep_run(sweep_t* sweep) {
+    if (!sweep)
+        return 1;
+
+    // run the simulators of all valid variants on one shared thread pool
+    array_t simulators = array_create(sweep->variants.size, sizeof(simulator_t*), 0);
+    for (size_t v = 0; v < sweep->variants.size; v++) {
+        sweep_variant_t* variant = array_get(&sweep->variants, v);
+        simulator_t* simulator = &variant->simulator;
+        if (!variant->error && !array_add(&simulators, &simulator)) {
+            array_free(&simulators, 0);
+            return 2;
+        }
+    }
+    stopwatch_t stopwatch = stopwatch_start();
+    int error = simulator_pool_run(&simulators);
+    sweep->elapsed = stopwatch_elapsed(&stopwatch);
+    array_free(&simulators, 0);
+    if (error)
+        return 2;
+
+    // collect the statistics of every variant
+    for (size_t v = 0; v < sweep->variants.size; v++) {
+        sweep_variant_t* variant = array_get(&sweep->variants, v);
+        if (variant->error)
+            continue;
+        if (!stats_collect(&variant->stats, &variant->simulator))
+            variant->error = "unable to collect statistics";
+    }
+
+    return 0;
+}
+
+void sweep_print(const sweep_t* sweep, report_format_t format) {
+    if (!sweep)
+        return;
+    if (format == REPORT_FORMAT_JSON) {
+        printf("[\n");
+        for (size_t v = 0; v < sweep->variants.size; v++) {
+            const sweep_variant_t* variant = array_getconst(&sweep->variants, v);
+            printf(
+                "  { \"width\": %lu, \"height\": %lu, \"die_sides\": %lu, \"distribution\": \"%s\", \"exact_ending\": %s, \"status\": \"%s\", \"error\": ",
+                variant->width, variant->height, variant->die_sides, variant->distribution != DISTR_PRESET_NONE ? distr_preset_infos[variant->distribution].name : "custom",
+                variant->exact_ending ? "true" : "false", variant->error ? "invalid" : variant->stats.interrupted ? "interrupted" : "ok"
+            );
+            report_print_json_string(stdout, variant->error);
+            report_print_stats(stdout, variant->error ? 0 : &variant->stats, format);
+            printf(" }%s\n", v != sweep->variants.size - 1 ? "," : "");
+        }
+        printf("]\n");
+        return;
+    }
+    printf("width,height,die_sides,distribution,exact_ending,status,error");
+    report_print_stats_header(stdout);
+    printf("\n");
+    for (size_t v = 0; v < sweep->variants.size; v++) {
+        const sweep_variant_t* variant = array_getconst(&sweep->variants, v);
+        printf(
+            "%lu,%lu,%lu,%s,%s,%s,",
+            variant->width, variant->height, variant->die_sides, variant->distribution != DISTR_PRESET_NONE ? distr_preset_infos[variant->distribution].name : "custom",
+            variant->exact_ending ? "on" : "off", variant->error ? "invalid" : variant->stats.interrupted ? "interrupted" : "ok"
+        );
+        report_print_csv_string(stdout, variant->error);
+        report_print_stats(stdout, variant->error ? 0 : &variant->stats, format);
+        printf("\n");
+    }
+}
@@ -0,0 +1,189 @@
+#include "timings.h"
+
+#include "cvts.h"
+
+#include <math.h>
+#include <stdio.h>
+
+timings_phase_info_t timings_phase_infos[TIMINGS_PHASE_COUNT] = {
+    { "cli_parse"        },
+    { "game_setup"       },
+    { "simulator_create" },
+    { "simulate"         },
+    { "stats_analyze"    },
+    { "stats_print"      }
+};
+
+timings_t timings_create() {
+    return (timings_t){
+        .phases = {},
+        .configs = 0,
+        .games = 0,
+        .dices = 0,
+        .aggregatedbytes = 0,
+        .workers = array_create(0, sizeof(timings_worker_t), 0)
+    };
+}
+
+void timings_free(timings_t* timings) {
+    if (!timings)
+        return;
+    array_free(&timings->workers, 0);
+    *timings = timings_create();
+}
+
+void timings_add(timings_t* timings, timings_phase_t phase, const stopwatch_t* stopwatch) {
+    if (!timings || !stopwatch)
+        return;
+    timings->phases[phase] += stopwatch_elapsed(stopwatch);
+}
+
+bool timings_collect(timings_t* timings, const simulator_t* simulator) {
+    if (!timings || !simulator)
+        return false;
+    timings->phases[TIMINGS_PHASE_SIMULATOR_CREATE] += simulator->setupelapsed;
+    if (!array_reserve(&timings->workers, timings->workers.size + simulator->workers.size))
+        return false;
+    for (size_t i = 0; i < simulator->workers.size; i++) {
+        const worker_t* worker = array_getconst(&simulator->workers, i);
+        timings_worker_t workertimings = { .elapsed = worker->elapsed, .games = worker->stats.sims, .dices = worker->stats.dices.sum };
+        array_add(&timings->workers, &workertimings);
+        timings->games += worker->stats.sims;
+        timings->dices += worker->stats.dices.sum;
+        timings->aggregatedbytes += stats_size(&worker->stats);
+    }
+    return true;
+}
+
+double timings_total(const timings_t* timings) {
+    if (!timings)
+        return 0.0;
+    double total = 0.0;
+    for (size_t i = 0; i < TIMINGS_PHASE_COUNT; i++)
+        total += timings->phases[i];
+    return total;
+}
+
+void timings_print(const timings_t* timings) {
+    if (!timings)
+        return;
+    const double total = timings_total(timings);
+    const double simulate = timings->phases[TIMINGS_PHASE_SIMULATE];
+    printf(
+        "Timings\n"
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%-16s  %10s  %7s  %22s%s \x1b(0x\x1b(B\n",
+        FMT(FMTVAL_BOLD), "PHASE", "SECONDS", "SHARE", "RATE", FMT(FMTVAL_NO_BOLD)
+    );
+    for (size_t i = 0; i < TIMINGS_PHASE_COUNT; i++) {
+        // the rate of the work the phase is about, the simulation gets a second row for the dices
+        const double seconds = timings->phases[i];
+        char rate[32] = "";
+        if (i == TIMINGS_PHASE_CLI_PARSE && seconds > 0.0)
+            snprintf(rate, sizeof(rate), "%.0lf configs/s", timings->configs / seconds);
+        else if (i == TIMINGS_PHASE_SIMULATE && seconds > 0.0)
+            snprintf(rate, sizeof(rate), "%.0lf games/s", timings->games / seconds);
+        else if (i == TIMINGS_PHASE_STATS_ANALYZE && seconds > 0.0)
+            snprintf(rate, sizeof(rate), "%.1lf MB/s", timings->aggregatedbytes / 1e6 / seconds);
+        printf(
+            "  \x1b(0x\x1b(B %-16s  %10.6lf  %6.2lf%%  %22s \x1b(0x\x1b(B\n",
+            timings_phase_infos[i].name, seconds, total > 0.0 ? seconds / total * 100.0 : 0.0, rate
+        );
+        if (i == TIMINGS_PHASE_SIMULATE && seconds > 0.0) {
+            snprintf(rate, sizeof(rate), "%.0lf dices/s", timings->dices / seconds);
+            printf("  \x1b(0x\x1b(B %-16s  %10s  %7s  %22s \x1b(0x\x1b(B\n", "", "", "", rate);
+        }
+    }
+    printf(
+        "  \x1b(0x\x1b(B %s%-16s  %10.6lf  %6.2lf%%  %22s%s \x1b(0x\x1b(B\n"
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "  %s%lu games, %lu dices, %lu configs, %lu bytes of partial statistics aggregated.%s\n"
+        "\n",
+        FMT(FMTVAL_BOLD), "TOTAL", total, total > 0.0 ? 100.0 : 0.0, "", FMT(FMTVAL_NO_BOLD),
+        FMT(FMTVAL_FG_BRIGHT_BLACK), timings->games, timings->dices, timings->configs, timings->aggregatedbytes, FMT(FMTVAL_FG_DEFAULT)
+    );
+    if (timings->workers.size == 0)
+        return;
+    printf(
+        "Worker timings\n"
+        "  \x1b(0lqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqk\x1b(B\n"
+        "  \x1b(0x\x1b(B %s%6s  %10s  %10s  %12s  %12s  %14s  %7s%s \x1b(0x\x1b(B\n",
+        FMT(FMTVAL_BOLD), "WORKER", "SECONDS", "GAMES", "DICES", "GAMES/S", "DICES/S", "BUSY", FMT(FMTVAL_NO_BOLD)
+    );
+    for (size_t i = 0; i < timings->workers.size; i++) {
+        const timings_worker_t* worker = array_getconst(&timings->workers, i);
+        printf(
+            "  \x1b(0x\x1b(B %6lu  %10.6lf  %10lu  %12lu  %12.0lf  %14.0lf  %6.2lf%% \x1b(0x\x1b(B\n",
+            i, worker->elapsed, worker->games, worker->dices, worker->elapsed > 0.0 ? worker->games / worker->elapsed : 0.0,
+            worker->elapsed > 0.0 ? worker->dices / worker->elapsed : 0.0, simulate > 0.0 ? worker->elapsed / simulate * 100.0 : 0.0
+        );
+    }
+    printf(
+        "  \x1b(0mqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqj\x1b(B\n"
+        "  %sBUSY is the share of the simulate phase the worker was running (lower shares indicate an imbalance or startup delay).%s\n"
+        "\n",
+        FMT(FMTVAL_FG_BRIGHT_BLACK), FMT(FMTVAL_FG_DEFAULT)
+    );
+}
+
+void timings_print_report_row(FILE* file, const char* kind, const char* name, double seconds, const double rates[4], report_format_t format, bool first) {
+    const char* const columns[4] = { "configs_per_s", "games_per_s", "dices_per_s", "mb_per_s" };
+    if (format == REPORT_FORMAT_JSON) {
+        fprintf(file, "%s  { \"kind\": \"%s\", \"name\": ", first ? "" : ",\n", kind);
+        report_print_json_string(file, name);
+        fprintf(file, ", \"seconds\": %.9lf", seconds);
+        for (size_t i = 0; i < 4; i++) {
+            if (isnan(rates[i]))
+                fprintf(file, ", \"%s\": null", columns[i]);
+            else
+                fprintf(file, ", \"%s\": %.3lf", columns[i], rates[i]);
+        }
+        fprintf(file, " }");
+        return;
+    }
+    fprintf(file, "%s,", kind);
+    report_print_csv_string(file, name);
+    fprintf(file, ",%.9lf", seconds);
+    for (size_t i = 0; i < 4; i++) {
+        if (isnan(rates[i]))
+            fprintf(file, ",");
+        else
+            fprintf(file, ",%.3lf", rates[i]);
+    }
+    fprintf(file, "\n");
+}
+
+void timings_print_report(FILE* file, const timings_t* timings, report_format_t format) {
+    if (!file || !timings)
+        return;
+    if (format == REPORT_FORMAT_JSON)
+        fprintf(file, "[\n");
+    else
+        fprintf(file, "kind,name,seconds,configs_per_s,games_per_s,dices_per_s,mb_per_s\n");
+    for (size_t i = 0; i < TIMINGS_PHASE_COUNT; i++) {
+        const double seconds = timings->phases[i];
+        double rates[4] = { NAN, NAN, NAN, NAN };
+        if (i == TIMINGS_PHASE_CLI_PARSE && seconds > 0.0)
+            rates[0] = timings->configs / seconds;
+        if (i == TIMINGS_PHASE_SIMULATE && seconds > 0.0) {
+            rates[1] = timings->games / seconds;
+            rates[2] = timings->dices / seconds;
+        }
+        if (i == TIMINGS_PHASE_STATS_ANALYZE && seconds > 0.0)
+            rates[3] = timings->aggregatedbytes / 1e6 / seconds;
+        timings_print_report_row(file, "phase", timings_phase_infos[i].name, seconds, rates, format, i == 0);
+    }
+    for (size_t i = 0; i < timings->workers.size; i++) {
+        const timings_worker_t* worker = array_getconst(&timings->workers, i);
+        double rates[4] = { NAN, NAN, NAN, NAN };
+        if (worker->elapsed > 0.0) {
+            rates[1] = worker->games / worker->elapsed;
+            rates[2] = worker->dices / worker->elapsed;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%lu", i);
+        timings_print_report_row(file, "worker", name, worker->elapsed, rates, format, false);
+    }
+    if (format == REPORT_FORMAT_JSON)
+        fprintf(file, "\n]\n");
+}
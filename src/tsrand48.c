@@ -23,6 +23,22 @@ tsseed48_t tsnewseed48() {
     return seed_prev;
 }
 
+tsseed48_t tsgetseed48() {
+    return seed;
+}
+
+tsseed48_t tsderiveseed48(uint64_t base, uint64_t stream) {
+    uint64_t value = base + (stream + 1) * 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return (tsseed48_t){ {
+        value & 0xffff,
+        (value >> 16) & 0xffff,
+        (value >> 32) & 0xffff
+    } };
+}
+
 double tserand48() {
     return erand48(seed.xsubi);
 }